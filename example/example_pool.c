@@ -0,0 +1,37 @@
+#include <ayaztub/data_structures/pool.h>
+#include <stdio.h>
+
+struct request {
+    int id;
+    char path[120];
+};
+
+POOL_DECL(struct request, request)
+
+int main(void) {
+    struct pool *pool = request_pool_create();
+    if (!pool) {
+        fprintf(stderr, "Failed to create the request pool\n");
+        return 1;
+    }
+
+    struct request *requests[1000];
+    for (int i = 0; i < 1000; i++) {
+        requests[i] = request_pool_alloc(pool);
+        requests[i]->id = i;
+        snprintf(requests[i]->path, sizeof(requests[i]->path), "/item/%d", i);
+    }
+
+    for (int i = 0; i < 1000; i++)
+        request_pool_free(pool, requests[i]);
+
+    struct pool_stats stats;
+    pool_flush(pool);
+    pool_get_stats(pool, &stats);
+    printf("object size: %zu, slabs: %zu (empty: %zu)\n", stats.object_size,
+           stats.slabs, stats.empty_slabs);
+    printf("released slabs: %zu\n", pool_trim(pool));
+
+    pool_destroy(pool);
+    return 0;
+}
@@ -1,7 +1,8 @@
 #ifndef __AYAZTUB_H__
 #define __AYAZTUB_H__
 
-// #include <ayaztub/data_structures.h>
+#include <ayaztub/concurrency.h>
+#include <ayaztub/data_structures.h>
 #include <ayaztub/core_utils.h>
 
 #endif // __AYAZTUB_H__
@@ -0,0 +1,9 @@
+#ifndef __AYAZTUB__CONCURRENCY_H__
+#define __AYAZTUB__CONCURRENCY_H__
+
+#include <ayaztub/concurrency/ebr.h>
+#include <ayaztub/concurrency/sync.h>
+#include <ayaztub/concurrency/thread_pool.h>
+#include <ayaztub/concurrency/timer_wheel.h>
+
+#endif // __AYAZTUB__CONCURRENCY_H__
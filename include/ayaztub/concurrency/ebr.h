@@ -0,0 +1,178 @@
+/**
+ * @file ebr.h
+ * @brief Epoch-based memory reclamation for lock-free data structures in C99.
+ *
+ * Lock-free readers may still hold a pointer to an object that a writer just
+ * unlinked, so the writer cannot free it right away. With epoch-based
+ * reclamation (EBR), readers wrap their accesses in ebr_enter()/ebr_exit()
+ * critical sections and writers hand unlinked objects to ebr_retire(). An
+ * object is freed once every thread has left the critical sections that could
+ * have seen it.
+ *
+ * - Entering a critical section costs a store and a fence on a thread-local
+ *   record: readers never write shared memory.
+ * - Retired objects are kept in per-thread lists, one per epoch, and freed in
+ *   batches every EBR_BATCH_SIZE retirements.
+ * - Objects retired by exiting threads are adopted by the remaining ones.
+ *
+ * Objects are retired either intrusively (an `struct ebr_node` embedded in the
+ * object, no allocation) or through ebr_retire_ptr() which takes its
+ * bookkeeping node from an internal slab pool.
+ *
+ * @warning Critical sections must be short and must not block: a thread stuck
+ * in a critical section prevents every retired object from being freed.
+ *
+ * @code
+ * // usage example: RCU-style configuration swap
+ * #include <ayaztub/concurrency/ebr.h>
+ *
+ * struct config {
+ *     struct ebr_node ebr; // first member, freed through it
+ *     int level;
+ * };
+ *
+ * static struct config *current_config;
+ *
+ * static void config_free(struct ebr_node *node) {
+ *     free(node);
+ * }
+ *
+ * int config_level(void) {
+ *     ebr_enter();
+ *     struct config *config =
+ *         __atomic_load_n(&current_config, __ATOMIC_ACQUIRE);
+ *     int level = config->level;
+ *     ebr_exit();
+ *     return level;
+ * }
+ *
+ * void config_set_level(int level) {
+ *     struct config *config = malloc(sizeof(struct config));
+ *     config->level = level;
+ *     struct config *old =
+ *         __atomic_exchange_n(&current_config, config, __ATOMIC_ACQ_REL);
+ *     if (old)
+ *         ebr_retire(&old->ebr, config_free);
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CONCURRENCY__EBR_H__
+#define __AYAZTUB__CONCURRENCY__EBR_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @def EBR_BATCH_SIZE
+ * @brief Number of retirements of a thread between two reclamation attempts.
+ */
+#ifndef EBR_BATCH_SIZE
+#    define EBR_BATCH_SIZE 64
+#endif // EBR_BATCH_SIZE
+
+struct ebr_node;
+
+/**
+ * @typedef ebr_free_t
+ * @brief Function releasing a retired object from its embedded node.
+ */
+typedef void (*ebr_free_t)(struct ebr_node *node);
+
+/**
+ * @typedef ebr_free_ptr_t
+ * @brief Function releasing a pointer retired with ebr_retire_ptr().
+ */
+typedef void (*ebr_free_ptr_t)(void *ptr, void *ctx);
+
+/**
+ * @struct ebr_node
+ * @brief Reclamation bookkeeping embedded in retired objects.
+ */
+struct ebr_node {
+    struct ebr_node *next; /**< Internal use */
+    ebr_free_t free; /**< Internal use */
+};
+
+/**
+ * @brief Enters a read-side critical section.
+ *
+ * Objects reachable when entering remain valid until the matching ebr_exit().
+ * Critical sections can be nested.
+ */
+void ebr_enter(void);
+
+/**
+ * @brief Exits a read-side critical section.
+ */
+void ebr_exit(void);
+
+/**
+ * @brief Retires an object embedding an ebr_node.
+ *
+ * The object must already be unreachable for new readers. free_fn is called
+ * on the node (by any thread) once no reader can still see the object.
+ *
+ * @param node The node embedded in the object.
+ * @param free_fn The function releasing the object.
+ */
+void ebr_retire(struct ebr_node *node, ebr_free_t free_fn) NONNULL;
+
+/**
+ * @brief Retires any pointer, with a bookkeeping node from a slab pool.
+ *
+ * @param ptr The object to retire.
+ * @param free_fn The function releasing the object.
+ * @param ctx User context given to free_fn.
+ * @return `true` on success, `false` if the bookkeeping node could not be
+ * allocated (the object was not retired).
+ */
+bool ebr_retire_ptr(void *ptr, ebr_free_ptr_t free_fn, void *ctx)
+    NONNULL_POSITIONS(2) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Tries to advance the epoch and frees the objects that became safe.
+ *
+ * This is done automatically every EBR_BATCH_SIZE retirements.
+ */
+void ebr_collect(void);
+
+/**
+ * @brief Waits until every object retired so far by the calling thread (and
+ * by exited threads) is freed.
+ *
+ * @warning Must not be called inside a critical section (it would wait
+ * forever for itself): it returns immediately in that case.
+ */
+void ebr_synchronize(void);
+
+/**
+ * @brief Gets the number of objects retired by the calling thread and not
+ * freed yet.
+ *
+ * @return The number of pending objects.
+ */
+size_t ebr_pending(void);
+
+// ---------- ebr_retire_ptr() callbacks ---------- //
+
+/**
+ * @brief Releases a pointer with free() (ctx is ignored).
+ */
+void ebr_free_malloc(void *ptr, void *ctx);
+
+/**
+ * @brief Gives an object back to the `struct pool *` given as ctx.
+ */
+void ebr_free_pool_object(void *ptr, void *ctx) NONNULL;
+
+/**
+ * @brief Destroys the `struct arena *` given as ptr (ctx is ignored).
+ *
+ * Useful to retire a whole arena-allocated structure at once (e.g. a
+ * configuration swapped RCU-style).
+ */
+void ebr_free_arena(void *ptr, void *ctx);
+
+#endif // __AYAZTUB__CONCURRENCY__EBR_H__
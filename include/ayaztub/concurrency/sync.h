@@ -0,0 +1,403 @@
+/**
+ * @file sync.h
+ * @brief Lightweight synchronization primitives (futex mutex, read-mostly
+ * RW lock, seqlock, ticket and MCS spinlocks) in C99.
+ *
+ * - `struct sync_mutex`: 4 bytes mutex, spins briefly then parks on a futex
+ *   (Linux). Uncontended lock/unlock are a single atomic operation each.
+ * - `struct sync_rwlock`: reader-writer lock biased towards readers. Readers
+ *   only touch one of SYNC_RWLOCK_SLOTS per-thread counters, writers wait for
+ *   every counter to drain. Writes are expensive, use it for read-mostly data.
+ * - `struct seqlock`: readers never write shared memory and retry if a write
+ *   happened meanwhile. Ideal for small, frequently read configuration.
+ * - `struct ticket_lock`: fair (FIFO) spinlock for very short sections.
+ * - `struct mcs_lock`: queue spinlock, each waiter spins on its own node, for
+ *   short sections under heavy contention.
+ *
+ * Every lock counts its acquisitions and contended acquisitions (and futex
+ * sleeps for the parking locks) unless SYNC_NO_STATS is defined, see
+ * `struct sync_stats`.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/concurrency/sync.h>
+ *
+ * static struct sync_mutex lock = SYNC_MUTEX_INITIALIZER;
+ * static struct seqlock config_lock = SEQLOCK_INITIALIZER;
+ * static int config_level;
+ * static int counter;
+ *
+ * void increment(void) {
+ *     sync_mutex_lock(&lock);
+ *     counter++;
+ *     sync_mutex_unlock(&lock);
+ * }
+ *
+ * int read_level(void) {
+ *     unsigned seq;
+ *     int level;
+ *     do {
+ *         seq = seqlock_read_begin(&config_lock);
+ *         level = __atomic_load_n(&config_level, __ATOMIC_RELAXED);
+ *     } while (seqlock_read_retry(&config_lock, seq));
+ *     return level;
+ * }
+ *
+ * void write_level(int level) {
+ *     seqlock_write_lock(&config_lock);
+ *     __atomic_store_n(&config_level, level, __ATOMIC_RELAXED);
+ *     seqlock_write_unlock(&config_lock);
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CONCURRENCY__SYNC_H__
+#define __AYAZTUB__CONCURRENCY__SYNC_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def SYNC_SPIN_COUNT
+ * @brief Number of spins before parking (sync_mutex) or yielding the CPU.
+ */
+#ifndef SYNC_SPIN_COUNT
+#    define SYNC_SPIN_COUNT 100
+#endif // SYNC_SPIN_COUNT
+
+/**
+ * @def SYNC_RWLOCK_SLOTS
+ * @brief Number of reader counters of a sync_rwlock (each on a cache line).
+ */
+#ifndef SYNC_RWLOCK_SLOTS
+#    define SYNC_RWLOCK_SLOTS 16
+#endif // SYNC_RWLOCK_SLOTS
+
+/**
+ * @struct sync_stats
+ * @brief Contention counters of a lock (zero if SYNC_NO_STATS is defined).
+ */
+struct sync_stats {
+    uint64_t acquisitions; /**< Successful lock operations */
+    uint64_t contentions; /**< Acquisitions that found the lock taken */
+    uint64_t sleeps; /**< Futex waits (parking locks only) */
+};
+
+/**
+ * @brief Hints the CPU that the caller is spinning.
+ */
+static inline void sync_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#ifdef SYNC_NO_STATS
+#    define SYNC_STAT_ADD(stats, field) (void)(stats)
+#    define SYNC_STAT_ADD_LOCKED(stats, field) (void)(stats)
+#else // SYNC_NO_STATS
+/* Concurrent increment. */
+#    define SYNC_STAT_ADD(stats, field)                                        \
+        __atomic_add_fetch(&(stats)->field, 1, __ATOMIC_RELAXED)
+/* Increment by the lock owner (no atomic read-modify-write needed). */
+#    define SYNC_STAT_ADD_LOCKED(stats, field)                                 \
+        __atomic_store_n(                                                      \
+            &(stats)->field,                                                   \
+            __atomic_load_n(&(stats)->field, __ATOMIC_RELAXED) + 1,            \
+            __ATOMIC_RELAXED)
+#endif // SYNC_NO_STATS
+
+/**
+ * @brief Reads a snapshot of lock counters.
+ *
+ * @param stats The counters of a lock (e.g. `&lock.stats`).
+ * @return The counters.
+ */
+struct sync_stats sync_stats_read(const struct sync_stats *stats) NONNULL;
+
+// ---------- Futex Mutex ---------- //
+
+/**
+ * @struct sync_mutex
+ * @brief Adaptive futex mutex (zero-initialized or SYNC_MUTEX_INITIALIZER).
+ */
+struct sync_mutex {
+    uint32_t state; /**< 0: unlocked, 1: locked, 2: locked with waiters */
+    struct sync_stats stats; /**< Contention counters */
+};
+
+/**
+ * @def SYNC_MUTEX_INITIALIZER
+ * @brief Static initializer of a sync_mutex.
+ */
+#define SYNC_MUTEX_INITIALIZER { 0, { 0, 0, 0 } }
+
+/**
+ * @brief Contended path of sync_mutex_lock() (internal use).
+ */
+void sync_mutex_lock_slow(struct sync_mutex *mutex) NONNULL;
+
+/**
+ * @brief Wakes a thread sleeping on a mutex (internal use).
+ */
+void sync_mutex_wake(struct sync_mutex *mutex) NONNULL;
+
+/**
+ * @brief Tries to lock a mutex without waiting.
+ *
+ * @param mutex The mutex to lock.
+ * @return `true` if the mutex was locked, `false` if it is already taken.
+ */
+static inline bool sync_mutex_trylock(struct sync_mutex *mutex) {
+    uint32_t unlocked = 0;
+    if (!__atomic_compare_exchange_n(&mutex->state, &unlocked, 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return false;
+    SYNC_STAT_ADD_LOCKED(&mutex->stats, acquisitions);
+    return true;
+}
+
+/**
+ * @brief Locks a mutex, spinning for a while then sleeping if it is taken.
+ *
+ * @param mutex The mutex to lock.
+ */
+static inline void sync_mutex_lock(struct sync_mutex *mutex) {
+    if (!sync_mutex_trylock(mutex))
+        sync_mutex_lock_slow(mutex);
+}
+
+/**
+ * @brief Unlocks a mutex locked by the calling thread.
+ *
+ * @param mutex The mutex to unlock.
+ */
+static inline void sync_mutex_unlock(struct sync_mutex *mutex) {
+    if (__atomic_exchange_n(&mutex->state, 0, __ATOMIC_RELEASE) == 2)
+        sync_mutex_wake(mutex);
+}
+
+// ---------- Read-Mostly RW Lock ---------- //
+
+/**
+ * @struct sync_rwlock
+ * @brief Reader-biased RW lock (zero-initialized or SYNC_RWLOCK_INITIALIZER).
+ */
+struct sync_rwlock {
+    struct {
+        unsigned long readers;
+        uint64_t reads;
+        char _pad[64 - sizeof(unsigned long) - sizeof(uint64_t)];
+    } slots[SYNC_RWLOCK_SLOTS]; /**< Internal use */
+    uint32_t writer; /**< Internal use: 1 while a writer is in or waiting */
+    struct sync_mutex writers; /**< Internal use: serializes writers */
+    struct sync_stats stats; /**< Internal use, see sync_rwlock_stats() */
+};
+
+/**
+ * @def SYNC_RWLOCK_INITIALIZER
+ * @brief Static initializer of a sync_rwlock.
+ */
+#define SYNC_RWLOCK_INITIALIZER                                                \
+    { { { 0, 0, { 0 } } }, 0, SYNC_MUTEX_INITIALIZER, { 0, 0, 0 } }
+
+/**
+ * @brief Takes the lock for reading (shared).
+ *
+ * @param lock The lock.
+ */
+void sync_rwlock_read_lock(struct sync_rwlock *lock) NONNULL;
+
+/**
+ * @brief Releases a read lock taken by the calling thread.
+ *
+ * @param lock The lock.
+ */
+void sync_rwlock_read_unlock(struct sync_rwlock *lock) NONNULL;
+
+/**
+ * @brief Takes the lock for writing (exclusive).
+ *
+ * @param lock The lock.
+ */
+void sync_rwlock_write_lock(struct sync_rwlock *lock) NONNULL;
+
+/**
+ * @brief Releases the write lock.
+ *
+ * @param lock The lock.
+ */
+void sync_rwlock_write_unlock(struct sync_rwlock *lock) NONNULL;
+
+/**
+ * @brief Reads the counters of a RW lock (read and write acquisitions).
+ *
+ * Read acquisitions are counted per reader slot so that readers never write
+ * a shared cache line.
+ *
+ * @param lock The lock.
+ * @return The counters.
+ */
+struct sync_stats sync_rwlock_stats(const struct sync_rwlock *lock) NONNULL;
+
+// ---------- Seqlock ---------- //
+
+/**
+ * @struct seqlock
+ * @brief Sequence lock (zero-initialized or SEQLOCK_INITIALIZER).
+ *
+ * @warning Data read under a seqlock may be modified concurrently: read it
+ * with relaxed atomic loads (and write it with relaxed atomic stores), and
+ * only use the values read once seqlock_read_retry() returned `false`.
+ */
+struct seqlock {
+    uint32_t sequence; /**< Odd while a write is in progress */
+    struct sync_mutex writers; /**< Serializes writers */
+};
+
+/**
+ * @def SEQLOCK_INITIALIZER
+ * @brief Static initializer of a seqlock.
+ */
+#define SEQLOCK_INITIALIZER { 0, SYNC_MUTEX_INITIALIZER }
+
+/**
+ * @brief Starts a read section.
+ *
+ * @param lock The seqlock.
+ * @return The sequence to give to seqlock_read_retry().
+ */
+static inline unsigned seqlock_read_begin(const struct seqlock *lock) {
+    uint32_t sequence;
+    while ((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 1)
+        sync_cpu_relax();
+    return sequence;
+}
+
+/**
+ * @brief Ends a read section.
+ *
+ * @param lock The seqlock.
+ * @param sequence The value returned by seqlock_read_begin().
+ * @return `true` if a write happened during the section (read again),
+ * `false` if the values read are consistent.
+ */
+static inline bool seqlock_read_retry(const struct seqlock *lock,
+                                      unsigned sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+/**
+ * @brief Starts a write section (writers are mutually exclusive).
+ *
+ * @param lock The seqlock.
+ */
+static inline void seqlock_write_lock(struct seqlock *lock) {
+    sync_mutex_lock(&lock->writers);
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Ends a write section.
+ *
+ * @param lock The seqlock.
+ */
+static inline void seqlock_write_unlock(struct seqlock *lock) {
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELEASE);
+    sync_mutex_unlock(&lock->writers);
+}
+
+// ---------- Ticket Spinlock ---------- //
+
+/**
+ * @struct ticket_lock
+ * @brief FIFO spinlock (zero-initialized or TICKET_LOCK_INITIALIZER).
+ */
+struct ticket_lock {
+    uint32_t next; /**< Next ticket to hand out */
+    uint32_t owner; /**< Ticket allowed in the critical section */
+    struct sync_stats stats; /**< Contention counters */
+};
+
+/**
+ * @def TICKET_LOCK_INITIALIZER
+ * @brief Static initializer of a ticket_lock.
+ */
+#define TICKET_LOCK_INITIALIZER { 0, 0, { 0, 0, 0 } }
+
+/**
+ * @brief Contended path of ticket_lock_acquire() (internal use).
+ */
+void ticket_lock_wait(struct ticket_lock *lock, uint32_t ticket) NONNULL;
+
+/**
+ * @brief Locks a ticket lock, spinning until the caller's turn.
+ *
+ * @param lock The lock.
+ */
+static inline void ticket_lock_acquire(struct ticket_lock *lock) {
+    uint32_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+        ticket_lock_wait(lock, ticket);
+    SYNC_STAT_ADD_LOCKED(&lock->stats, acquisitions);
+}
+
+/**
+ * @brief Unlocks a ticket lock.
+ *
+ * @param lock The lock.
+ */
+static inline void ticket_lock_release(struct ticket_lock *lock) {
+    __atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+// ---------- MCS Spinlock ---------- //
+
+/**
+ * @struct mcs_node
+ * @brief Queue node of a MCS lock waiter, owned by the caller (usually on
+ * its stack) until the lock is released.
+ */
+struct mcs_node {
+    struct mcs_node *next; /**< Internal use */
+    bool locked; /**< Internal use */
+};
+
+/**
+ * @struct mcs_lock
+ * @brief Queue spinlock (zero-initialized or MCS_LOCK_INITIALIZER).
+ */
+struct mcs_lock {
+    struct mcs_node *tail; /**< Internal use */
+    struct sync_stats stats; /**< Contention counters */
+};
+
+/**
+ * @def MCS_LOCK_INITIALIZER
+ * @brief Static initializer of a mcs_lock.
+ */
+#define MCS_LOCK_INITIALIZER { NULL, { 0, 0, 0 } }
+
+/**
+ * @brief Locks a MCS lock.
+ *
+ * @param lock The lock.
+ * @param node The caller's queue node, to give to mcs_lock_release().
+ */
+void mcs_lock_acquire(struct mcs_lock *lock, struct mcs_node *node) NONNULL;
+
+/**
+ * @brief Unlocks a MCS lock.
+ *
+ * @param lock The lock.
+ * @param node The node given to mcs_lock_acquire().
+ */
+void mcs_lock_release(struct mcs_lock *lock, struct mcs_node *node) NONNULL;
+
+#endif // __AYAZTUB__CONCURRENCY__SYNC_H__
@@ -0,0 +1,223 @@
+/**
+ * @file thread_pool.h
+ * @brief Work-stealing thread pool with futures and parallel loops in C99.
+ *
+ * Each worker owns a Chase-Lev deque: tasks submitted by a worker are pushed
+ * to and popped from the bottom of its own deque without contention, while
+ * idle workers steal the oldest tasks from the top of randomly chosen victims.
+ * Tasks submitted from outside the pool go through a shared injection queue.
+ *
+ * - thread_pool_submit() runs a function asynchronously.
+ * - thread_pool_async() also returns a future to wait for the result, and
+ *   task_future_then() chains continuations on a future.
+ * - thread_pool_parallel_for() splits a range in halves down to a grain size:
+ *   the first half is processed locally and the second one is exposed to
+ *   thieves, so idle workers always steal the biggest pieces of work.
+ *
+ * Workers are named `<name>-<index>` for the logger thread prefix (and the
+ * system thread name on Linux) and can be pinned to CPUs.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/concurrency/thread_pool.h>
+ *
+ * static void *square(void *arg) {
+ *     uintptr_t value = (uintptr_t)arg;
+ *     return (void *)(value * value);
+ * }
+ *
+ * static void scale(size_t begin, size_t end, void *ctx) {
+ *     double *values = ctx;
+ *     for (size_t i = begin; i < end; i++)
+ *         values[i] *= 2.0;
+ * }
+ *
+ * int main(void) {
+ *     struct thread_pool *pool = thread_pool_create(NULL);
+ *     if (!pool)
+ *         return 1;
+ *
+ *     struct task_future *future = thread_pool_async(pool, square, (void *)7);
+ *     printf("7 * 7 = %lu\n", (unsigned long)task_future_wait(future));
+ *     task_future_destroy(future);
+ *
+ *     static double values[1000000];
+ *     thread_pool_parallel_for(pool, 0, 1000000, 0, scale, values);
+ *
+ *     thread_pool_destroy(pool);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CONCURRENCY__THREAD_POOL_H__
+#define __AYAZTUB__CONCURRENCY__THREAD_POOL_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @struct thread_pool
+ * @brief Opaque work-stealing thread pool.
+ */
+struct thread_pool;
+
+/**
+ * @struct task_future
+ * @brief Opaque result of an asynchronous task.
+ */
+struct task_future;
+
+/**
+ * @typedef task_func_t
+ * @brief Function run by a task, its return value is the future result.
+ */
+typedef void *(*task_func_t)(void *arg);
+
+/**
+ * @typedef task_then_t
+ * @brief Continuation called with the result of the previous task.
+ */
+typedef void *(*task_then_t)(void *result, void *ctx);
+
+/**
+ * @typedef parallel_for_func_t
+ * @brief Function processing the indices [begin, end) of a parallel loop.
+ */
+typedef void (*parallel_for_func_t)(size_t begin, size_t end, void *ctx);
+
+/**
+ * @struct thread_pool_options
+ * @brief Options of thread_pool_create() (zeroed fields use the default).
+ */
+struct thread_pool_options {
+    size_t threads; /**< Number of workers (default: online CPUs) */
+    bool pin_threads; /**< Pin worker i to the i-th allowed CPU (Linux) */
+    const char *name; /**< Worker name prefix (default: "worker") */
+};
+
+/**
+ * @brief Creates a thread pool and starts its workers.
+ *
+ * @param options The pool options (NULL for the defaults).
+ * @return The new pool, or NULL on failure.
+ */
+struct thread_pool *
+thread_pool_create(const struct thread_pool_options *options)
+    WARN_UNUSED_RESULT;
+
+/**
+ * @brief Waits for every submitted task, then stops and frees the pool.
+ *
+ * @param pool The pool to destroy (can be NULL).
+ *
+ * @warning Must not be called from a worker of the pool.
+ */
+void thread_pool_destroy(struct thread_pool *pool);
+
+/**
+ * @brief Gets the number of workers of a pool.
+ *
+ * @param pool The pool to inspect.
+ * @return The number of workers.
+ */
+size_t thread_pool_size(const struct thread_pool *pool) NONNULL;
+
+/**
+ * @brief Gets the index of the calling worker.
+ *
+ * @param pool The pool of the worker.
+ * @return The worker index in [0, thread_pool_size()), or -1 if the calling
+ * thread is not a worker of this pool.
+ */
+long thread_pool_worker_index(const struct thread_pool *pool) NONNULL;
+
+/**
+ * @brief Runs a function asynchronously.
+ *
+ * @param pool The pool to run the task on.
+ * @param func The task function (its result is ignored).
+ * @param arg The task argument.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool thread_pool_submit(struct thread_pool *pool, task_func_t func, void *arg)
+    NONNULL_POSITIONS(1, 2) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Runs a function asynchronously and returns its future.
+ *
+ * @param pool The pool to run the task on.
+ * @param func The task function.
+ * @param arg The task argument.
+ * @return The task future (to release with task_future_destroy()), or NULL
+ * on allocation failure.
+ */
+struct task_future *thread_pool_async(struct thread_pool *pool,
+                                      task_func_t func, void *arg)
+    NONNULL_POSITIONS(1, 2) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Calls func on sub-ranges of [begin, end) in parallel and waits for
+ * all of them.
+ *
+ * The calling thread takes part in the loop.
+ *
+ * @param pool The pool to run the loop on.
+ * @param begin The first index.
+ * @param end The index after the last one.
+ * @param grain The maximum number of indices of a sub-range (0 to choose it
+ * from the range size and the number of workers).
+ * @param func The function processing a sub-range.
+ * @param ctx User context given to func.
+ */
+void thread_pool_parallel_for(struct thread_pool *pool, size_t begin,
+                              size_t end, size_t grain,
+                              parallel_for_func_t func, void *ctx)
+    NONNULL_POSITIONS(1, 5);
+
+// ---------- Futures ---------- //
+
+/**
+ * @brief Waits for a task and gets its result.
+ *
+ * Workers waiting for a future run other tasks in the meantime.
+ *
+ * @param future The future to wait for.
+ * @return The task result.
+ */
+void *task_future_wait(struct task_future *future) NONNULL;
+
+/**
+ * @brief Checks whether the task of a future completed, without blocking.
+ *
+ * @param future The future to check.
+ * @param result Output task result if completed (can be NULL).
+ * @return `true` if the task completed, `false` otherwise.
+ */
+bool task_future_ready(struct task_future *future, void **result)
+    NONNULL_POSITIONS(1);
+
+/**
+ * @brief Schedules a continuation after the task of a future.
+ *
+ * @param future The future to continue.
+ * @param func The continuation, called with the result of the task.
+ * @param ctx User context given to func.
+ * @return The continuation future (to release with task_future_destroy()), or
+ * NULL on allocation failure.
+ */
+struct task_future *task_future_then(struct task_future *future,
+                                     task_then_t func, void *ctx)
+    NONNULL_POSITIONS(1, 2) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Releases a future.
+ *
+ * The task keeps running if it did not complete yet.
+ *
+ * @param future The future to release (can be NULL).
+ */
+void task_future_destroy(struct task_future *future);
+
+#endif // __AYAZTUB__CONCURRENCY__THREAD_POOL_H__
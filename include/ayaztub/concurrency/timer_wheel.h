@@ -0,0 +1,273 @@
+/**
+ * @file timer_wheel.h
+ * @brief Hierarchical timing wheel and timer thread in C99.
+ *
+ * A timing wheel (G. Varghese and T. Lauck, "Hashed and Hierarchical Timing
+ * Wheels") keeps timers in slots indexed by their expiry tick: adding and
+ * cancelling a timer are O(1), whatever the number of pending timers. The
+ * wheel has TIMER_WHEEL_LEVELS levels of 64 slots, each level covering 64
+ * times the range of the previous one, so any 64 bits delay is supported.
+ * Timers of the upper levels are moved to lower levels as the time gets
+ * closer to their expiry.
+ *
+ * - `struct timer_wheel` is driven by the caller: timer_wheel_advance() moves
+ *   the time forward by a number of ticks and runs the expired timers in one
+ *   batch. It is NOT thread-safe.
+ * - `struct timer_thread` runs a wheel on a background thread with a tick in
+ *   milliseconds, sleeping until the next timer may expire. Its functions are
+ *   thread-safe.
+ *
+ * Timers are intrusive: `struct timer` is allocated by the caller (usually
+ * inside the object it times out) and must stay valid while pending.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/concurrency/timer_wheel.h>
+ *
+ * static void flush(struct timer *timer, void *ctx) {
+ *     (void)timer;
+ *     fflush(ctx);
+ * }
+ *
+ * int main(void) {
+ *     struct timer_thread *timers = timer_thread_create(0);
+ *     if (!timers)
+ *         return 1;
+ *
+ *     struct timer periodic_flush;
+ *     timer_init(&periodic_flush, flush, stdout);
+ *     timer_thread_add(timers, &periodic_flush, 100, 100); // every 100ms
+ *
+ *     // ...
+ *
+ *     timer_thread_cancel(timers, &periodic_flush);
+ *     timer_thread_destroy(timers);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CONCURRENCY__TIMER_WHEEL_H__
+#define __AYAZTUB__CONCURRENCY__TIMER_WHEEL_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def TIMER_WHEEL_LEVELS
+ * @brief Number of levels of a timing wheel (64 slots each, 11 levels cover
+ * 64 bits delays).
+ */
+#define TIMER_WHEEL_LEVELS 11
+
+/**
+ * @def TIMER_THREAD_DEFAULT_TICK_MS
+ * @brief Tick of a timer thread created with a tick of 0.
+ */
+#ifndef TIMER_THREAD_DEFAULT_TICK_MS
+#    define TIMER_THREAD_DEFAULT_TICK_MS 1
+#endif // TIMER_THREAD_DEFAULT_TICK_MS
+
+struct timer;
+
+/**
+ * @typedef timer_func_t
+ * @brief Function called when a timer expires.
+ *
+ * @param timer The expired timer (already re-armed if it is periodic).
+ * @param ctx The context given to timer_init().
+ */
+typedef void (*timer_func_t)(struct timer *timer, void *ctx);
+
+/**
+ * @struct timer
+ * @brief Intrusive timer, initialized with timer_init().
+ */
+struct timer {
+    struct timer *next; /**< Internal use */
+    struct timer **pprev; /**< Internal use: NULL while not pending */
+    uint64_t expires; /**< Internal use: expiry tick */
+    uint64_t period; /**< Internal use: 0 for one-shot timers */
+    unsigned slot; /**< Internal use */
+    timer_func_t func; /**< Expiry callback */
+    void *ctx; /**< Expiry callback context */
+};
+
+/**
+ * @brief Initializes a timer (not pending).
+ *
+ * @param timer The timer to initialize.
+ * @param func The function called on expiry.
+ * @param ctx User context given to func.
+ */
+static inline void timer_init(struct timer *timer, timer_func_t func,
+                              void *ctx) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->period = 0;
+    timer->slot = 0;
+    timer->func = func;
+    timer->ctx = ctx;
+}
+
+/**
+ * @brief Checks whether a timer is waiting for its expiry.
+ *
+ * @param timer The timer.
+ * @return `true` if the timer is pending, `false` otherwise.
+ *
+ * @warning Only meaningful for timers of a timer_wheel, or when called from
+ * the timer thread for timers of a timer_thread.
+ */
+static inline bool timer_pending(const struct timer *timer) {
+    return timer->pprev != NULL;
+}
+
+// ---------- Timing Wheel ---------- //
+
+/**
+ * @struct timer_wheel
+ * @brief Opaque hierarchical timing wheel.
+ */
+struct timer_wheel;
+
+/**
+ * @brief Creates a timing wheel, with its time at tick 0.
+ *
+ * @return The new wheel, or NULL on allocation failure.
+ */
+struct timer_wheel *timer_wheel_create(void) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Destroys a timing wheel. Pending timers are dropped without being
+ * called.
+ *
+ * @param wheel The wheel to destroy (can be NULL).
+ */
+void timer_wheel_destroy(struct timer_wheel *wheel);
+
+/**
+ * @brief Arms a timer (re-arms it if it is already pending).
+ *
+ * @param wheel The wheel.
+ * @param timer The timer to arm.
+ * @param delay The number of ticks before the expiry (0 expires on the next
+ * tick). Expiries past the last tick (UINT64_MAX) are clamped to it, so once
+ * the wheel reached the last tick, the timer stays pending until cancelled.
+ * @param period The number of ticks between two expiries of a periodic
+ * timer, 0 for a one-shot timer.
+ */
+void timer_wheel_add(struct timer_wheel *wheel, struct timer *timer,
+                     uint64_t delay, uint64_t period) NONNULL;
+
+/**
+ * @brief Cancels a timer.
+ *
+ * @param wheel The wheel.
+ * @param timer The timer to cancel.
+ * @return `true` if the timer was pending, `false` otherwise.
+ */
+bool timer_wheel_cancel(struct timer_wheel *wheel, struct timer *timer)
+    NONNULL;
+
+/**
+ * @brief Moves the time forward and runs the expired timers.
+ *
+ * Timers expiring during the same call run in no particular order. Callbacks
+ * may add and cancel timers (including the expired one).
+ *
+ * @param wheel The wheel.
+ * @param ticks The number of ticks to move forward.
+ * @return The number of timer callbacks called.
+ */
+size_t timer_wheel_advance(struct timer_wheel *wheel, uint64_t ticks) NONNULL;
+
+/**
+ * @brief Gets the current time of a wheel.
+ *
+ * @param wheel The wheel.
+ * @return The number of ticks elapsed since the creation of the wheel.
+ */
+uint64_t timer_wheel_now(const struct timer_wheel *wheel) NONNULL;
+
+/**
+ * @brief Gets a lower bound of the delay before the next expiry.
+ *
+ * The bound is exact when the next timer is less than 64 ticks away.
+ * Advancing the wheel by less than this delay never runs any timer.
+ *
+ * @param wheel The wheel.
+ * @return The number of ticks, or UINT64_MAX if no timer is pending.
+ */
+uint64_t timer_wheel_next_expiry(const struct timer_wheel *wheel) NONNULL;
+
+/**
+ * @brief Gets the number of pending timers of a wheel.
+ *
+ * @param wheel The wheel.
+ * @return The number of pending timers.
+ */
+size_t timer_wheel_count(const struct timer_wheel *wheel) NONNULL;
+
+// ---------- Timer Thread ---------- //
+
+/**
+ * @struct timer_thread
+ * @brief Opaque timing wheel driven by a background thread.
+ */
+struct timer_thread;
+
+/**
+ * @brief Creates a timer thread.
+ *
+ * The thread is named "timer" for the logger thread prefix (and the system
+ * thread name on Linux).
+ *
+ * @param tick_ms The wheel tick in milliseconds (0 for
+ * TIMER_THREAD_DEFAULT_TICK_MS). Delays are rounded up to a tick.
+ * @return The new timer thread, or NULL on failure.
+ */
+struct timer_thread *timer_thread_create(unsigned tick_ms) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Stops and destroys a timer thread. Pending timers are dropped
+ * without being called.
+ *
+ * @param timers The timer thread to destroy (can be NULL).
+ *
+ * @warning Must not be called from a timer callback.
+ */
+void timer_thread_destroy(struct timer_thread *timers);
+
+/**
+ * @brief Arms a timer (re-arms it if it is already pending).
+ *
+ * Callbacks run on the timer thread, one at a time, with the wheel locked:
+ * they may add and cancel timers but must be short.
+ *
+ * @param timers The timer thread.
+ * @param timer The timer to arm.
+ * @param delay_ms The delay before the expiry in milliseconds.
+ * @param period_ms The period of a periodic timer in milliseconds, 0 for a
+ * one-shot timer.
+ */
+void timer_thread_add(struct timer_thread *timers, struct timer *timer,
+                      uint64_t delay_ms, uint64_t period_ms) NONNULL;
+
+/**
+ * @brief Cancels a timer.
+ *
+ * Once this function returned, the callback of the timer is not running
+ * (unless it is called from this very callback) and will not run again.
+ *
+ * @param timers The timer thread.
+ * @param timer The timer to cancel.
+ * @return `true` if the timer was pending, `false` otherwise.
+ */
+bool timer_thread_cancel(struct timer_thread *timers, struct timer *timer)
+    NONNULL;
+
+#endif // __AYAZTUB__CONCURRENCY__TIMER_WHEEL_H__
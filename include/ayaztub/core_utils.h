@@ -3,7 +3,12 @@
 
 #include <ayaztub/core_utils/util_attributes.h>
 #include <ayaztub/core_utils/assert.h>
+#include <ayaztub/core_utils/bits.h>
+#include <ayaztub/core_utils/io.h>
 #include <ayaztub/core_utils/logger.h>
+#include <ayaztub/core_utils/lz4.h>
 #include <ayaztub/core_utils/debug.h>
+#include <ayaztub/core_utils/sort.h>
+#include <ayaztub/core_utils/str.h>
 
 #endif // __AYAZTUB__CORE_UTILS_H__
@@ -0,0 +1,85 @@
+/**
+ * @file bits.h
+ * @brief Bit scan helpers shared by the SIMD and bitmap code of the library.
+ *
+ * Each helper uses the GCC/Clang builtin when available (a single
+ * instruction on most targets), and a portable loop otherwise.
+ */
+#ifndef __AYAZTUB__CORE_UTILS__BITS_H__
+#define __AYAZTUB__CORE_UTILS__BITS_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Index of the lowest set bit of a 32 bits mask.
+ *
+ * @param mask The mask, not 0.
+ * @return The number of trailing zero bits.
+ */
+static inline unsigned bits_ctz32(uint32_t mask) {
+#ifdef __GNUC__
+    return (unsigned)__builtin_ctz(mask);
+#else // __GNUC__
+    unsigned n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * @brief Index of the lowest set bit of a 64 bits mask.
+ *
+ * @param mask The mask, not 0.
+ * @return The number of trailing zero bits.
+ */
+static inline unsigned bits_ctz64(uint64_t mask) {
+#ifdef __GNUC__
+    return (unsigned)__builtin_ctzll(mask);
+#else // __GNUC__
+    unsigned n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * @brief Index of the highest set bit of a 64 bits mask (floor of log2).
+ *
+ * @param mask The mask, not 0.
+ * @return The index of the highest set bit.
+ */
+static inline unsigned bits_log2_64(uint64_t mask) {
+#ifdef __GNUC__
+    return 63 - (unsigned)__builtin_clzll(mask);
+#else // __GNUC__
+    unsigned n = 0;
+    while (mask >>= 1)
+        n++;
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * @brief Number of set bits of a 64 bits mask.
+ *
+ * @param mask The mask.
+ * @return The number of set bits.
+ */
+static inline unsigned bits_popcount64(uint64_t mask) {
+#ifdef __GNUC__
+    return (unsigned)__builtin_popcountll(mask);
+#else // __GNUC__
+    unsigned n = 0;
+    for (; mask; mask &= mask - 1)
+        n++;
+    return n;
+#endif // __GNUC__
+}
+
+#endif // __AYAZTUB__CORE_UTILS__BITS_H__
@@ -0,0 +1,289 @@
+/**
+ * @file io.h
+ * @brief Memory mapped file reading, SIMD line iteration and chunked writing.
+ *
+ * - `struct mapped_file`: read-only memory mapping of a whole file. Reading
+ *   it costs no copy and no system call per line, and the kernel is told the
+ *   access pattern with madvise() (sequential read-ahead, prefetch, huge
+ *   pages). mapped_file_refresh() extends the mapping when the file grew
+ *   (to follow a log file being written).
+ * - `struct line_iter`: splits a buffer in lines. The newlines of 64 bytes
+ *   are found at once (with SSE2 or AVX2, define IO_NO_SIMD to force the
+ *   portable code) into a bit mask, so short lines cost a few instructions
+ *   each instead of a memchr() call.
+ * - `struct chunk_writer`: buffered writer to a file descriptor, writing in
+ *   large chunks (IO_CHUNK_SIZE by default). Unlike stdio, the buffer can be
+ *   formatted into directly (chunk_writer_reserve()), and a write larger
+ *   than the buffer bypasses it.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/core_utils/io.h>
+ *
+ * int main(void) {
+ *     struct mapped_file file;
+ *     if (!mapped_file_open(&file, "app.log", MAPPED_FILE_SEQUENTIAL))
+ *         return 1;
+ *
+ *     struct chunk_writer out;
+ *     if (!chunk_writer_open(&out, "errors.log", false, 0))
+ *         return 1;
+ *
+ *     struct line_iter iter;
+ *     struct strview line;
+ *     line_iter_init(&iter, file.data, file.size);
+ *     while (line_iter_next(&iter, &line)) {
+ *         if (strview_find(line, STRVIEW_LIT("[ERROR]")) != STRVIEW_NPOS)
+ *             chunk_writer_write_line(&out, line);
+ *     }
+ *
+ *     bool ok = chunk_writer_close(&out);
+ *     mapped_file_close(&file);
+ *     return ok ? 0 : 1;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CORE_UTILS__IO_H__
+#define __AYAZTUB__CORE_UTILS__IO_H__
+
+#include <ayaztub/core_utils/str.h>
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def IO_CHUNK_SIZE
+ * @brief Default buffer size of a chunk writer.
+ */
+#ifndef IO_CHUNK_SIZE
+#    define IO_CHUNK_SIZE (1 << 20)
+#endif // IO_CHUNK_SIZE
+
+// ---------- Memory Mapped Files ---------- //
+
+/**
+ * @enum mapped_file_advice
+ * @brief Access pattern hints of a mapped file (can be combined with |).
+ *
+ * The hints are best effort: a hint the system does not support is ignored.
+ */
+enum mapped_file_advice {
+    MAPPED_FILE_NORMAL = 0, /**< No hint */
+    MAPPED_FILE_SEQUENTIAL = 1 << 0, /**< Aggressive read-ahead */
+    MAPPED_FILE_RANDOM = 1 << 1, /**< No read-ahead */
+    MAPPED_FILE_WILLNEED = 1 << 2, /**< Start reading the pages now */
+    MAPPED_FILE_DONTNEED = 1 << 3, /**< Pages can be dropped (already read) */
+    MAPPED_FILE_HUGEPAGE = 1 << 4, /**< Map with transparent huge pages */
+};
+
+/**
+ * @struct mapped_file
+ * @brief Read-only memory mapped file.
+ */
+struct mapped_file {
+    const char *data; /**< Contents of the file */
+    size_t size; /**< Size of the mapping */
+    int fd; /**< Internal use */
+    unsigned advice; /**< Internal use: advice of the whole mapping */
+};
+
+/**
+ * @brief Maps a file for reading.
+ *
+ * @param file The mapped file to initialize.
+ * @param path The path of the file.
+ * @param advice The access pattern of the whole file (mapped_file_advice
+ * flags).
+ * @return `true` on success, `false` on error (errno is set).
+ */
+bool mapped_file_open(struct mapped_file *file, const char *path,
+                      unsigned advice) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Gives the access pattern of a range of a mapped file.
+ *
+ * For instance, a sequential scan can ask for the next megabytes with
+ * MAPPED_FILE_WILLNEED and release the previous ones with
+ * MAPPED_FILE_DONTNEED.
+ *
+ * @param file The mapped file.
+ * @param offset The start of the range (rounded down to a page).
+ * @param length The length of the range.
+ * @param advice The access pattern (mapped_file_advice flags).
+ * @return `true` on success, `false` if a hint was rejected.
+ */
+bool mapped_file_advise(const struct mapped_file *file, size_t offset,
+                        size_t length, unsigned advice) NONNULL;
+
+/**
+ * @brief Extends the mapping to the current size of the file.
+ *
+ * The data pointer may change: views of the previous mapping are invalid.
+ *
+ * @param file The mapped file.
+ * @return `true` on success (grown or unchanged), `false` on error.
+ */
+bool mapped_file_refresh(struct mapped_file *file) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Unmaps a file.
+ *
+ * @param file The mapped file.
+ */
+void mapped_file_close(struct mapped_file *file) NONNULL;
+
+// ---------- Line Iteration ---------- //
+
+/**
+ * @struct line_iter
+ * @brief Iterator over the lines of a buffer.
+ */
+struct line_iter {
+    const char *data; /**< Internal use */
+    size_t size; /**< Internal use */
+    size_t start; /**< Offset of the next line */
+    size_t block; /**< Internal use: offset of the current 64 bytes */
+    uint64_t newlines; /**< Internal use: unread newlines of the block */
+};
+
+/**
+ * @brief Initializes a line iterator.
+ *
+ * @param iter The iterator to initialize.
+ * @param data The buffer (not necessarily null terminated).
+ * @param size The size of the buffer.
+ */
+void line_iter_init(struct line_iter *iter, const char *data, size_t size)
+    NONNULL_POSITIONS(1);
+
+/**
+ * @brief Gets the next line.
+ *
+ * Lines do not include their '\n'. The last line is returned even if it does
+ * not end with a '\n', but an empty last line is not.
+ *
+ * @param iter The iterator.
+ * @param line Output line.
+ * @return `true` if a line was found, `false` at the end of the buffer.
+ */
+bool line_iter_next(struct line_iter *iter, struct strview *line) NONNULL;
+
+/**
+ * @brief Finds the first '\n' of a buffer.
+ *
+ * @param data The buffer.
+ * @param size The size of the buffer.
+ * @return The offset of the '\n', or size if there is none.
+ */
+size_t io_find_newline(const char *data, size_t size) PURE;
+
+/**
+ * @brief Counts the '\n' of a buffer.
+ *
+ * @param data The buffer.
+ * @param size The size of the buffer.
+ * @return The number of '\n'.
+ */
+size_t io_count_newlines(const char *data, size_t size) PURE;
+
+// ---------- Chunked Writer ---------- //
+
+/**
+ * @struct chunk_writer
+ * @brief Buffered writer to a file descriptor.
+ */
+struct chunk_writer {
+    int fd; /**< File descriptor */
+    bool owned; /**< Internal use: fd closed by chunk_writer_close() */
+    bool failed; /**< A write failed: later writes are ignored */
+    char *buffer; /**< Internal use */
+    size_t size; /**< Internal use: buffered bytes */
+    size_t capacity; /**< Internal use */
+    uint64_t written; /**< Number of bytes written to the file */
+};
+
+/**
+ * @brief Opens a file for writing (created if needed).
+ *
+ * @param writer The writer to initialize.
+ * @param path The path of the file.
+ * @param append `true` to append to the file, `false` to truncate it.
+ * @param chunk_size The buffer size (0 for IO_CHUNK_SIZE).
+ * @return `true` on success, `false` on error.
+ */
+bool chunk_writer_open(struct chunk_writer *writer, const char *path,
+                       bool append, size_t chunk_size)
+    NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Initializes a writer on an open file descriptor.
+ *
+ * @param writer The writer to initialize.
+ * @param fd The file descriptor (not closed by chunk_writer_close()).
+ * @param chunk_size The buffer size (0 for IO_CHUNK_SIZE).
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool chunk_writer_init_fd(struct chunk_writer *writer, int fd,
+                          size_t chunk_size) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Writes the buffered bytes to the file.
+ *
+ * @param writer The writer.
+ * @return `true` on success, `false` if a write failed (now or before).
+ */
+bool chunk_writer_flush(struct chunk_writer *writer) NONNULL;
+
+/**
+ * @brief Writes bytes.
+ *
+ * @param writer The writer.
+ * @param data The bytes.
+ * @param size The number of bytes.
+ * @return `true` on success, `false` if a write failed (now or before).
+ */
+bool chunk_writer_write(struct chunk_writer *writer, const void *data,
+                        size_t size) NONNULL_POSITIONS(1);
+
+/**
+ * @brief Writes a line and its '\n'.
+ *
+ * @param writer The writer.
+ * @param line The line.
+ * @return `true` on success, `false` if a write failed (now or before).
+ */
+bool chunk_writer_write_line(struct chunk_writer *writer,
+                             struct strview line) NONNULL;
+
+/**
+ * @brief Gets room for at least size bytes in the buffer, to format into.
+ *
+ * @param writer The writer.
+ * @param size The number of bytes (at most the buffer size).
+ * @return The room, to commit with chunk_writer_commit(), or NULL if a write
+ * failed or size is larger than the buffer.
+ */
+char *chunk_writer_reserve(struct chunk_writer *writer, size_t size) NONNULL;
+
+/**
+ * @brief Adds bytes written in the room given by chunk_writer_reserve().
+ *
+ * @param writer The writer.
+ * @param size The number of bytes written (at most the reserved size).
+ */
+static inline void chunk_writer_commit(struct chunk_writer *writer,
+                                       size_t size) {
+    writer->size += size;
+}
+
+/**
+ * @brief Flushes and releases a writer, closing its file if it opened it.
+ *
+ * @param writer The writer.
+ * @return `true` on success, `false` if a write failed (now or before).
+ */
+bool chunk_writer_close(struct chunk_writer *writer) NONNULL;
+
+#endif // __AYAZTUB__CORE_UTILS__IO_H__
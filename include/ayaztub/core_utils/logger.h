@@ -82,8 +82,10 @@
 
 #include <ayaztub/core_utils/util_attributes.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 /**
  * @def SOURCE_PATH_SIZE
@@ -190,6 +192,99 @@ DESTRUCTOR void logger_deinit(void);
 void logger_set_format_options(bool show_date, bool show_thread,
                                bool log_trace_on_fatal);
 
+/**
+ * @def LOGGER_THREAD_NAME_SIZE
+ * @brief Maximum size of a thread name (including the null byte).
+ */
+#define LOGGER_THREAD_NAME_SIZE 16
+
+/**
+ * @brief Names the calling thread in its log messages.
+ *
+ * Named threads are shown as `[name]` instead of their thread id.
+ *
+ * @param name The thread name, truncated to LOGGER_THREAD_NAME_SIZE - 1
+ * characters (NULL to go back to the thread id).
+ */
+void logger_set_thread_name(const char *const name);
+
+// ---------- Context ---------- //
+
+/**
+ * @def LOGGER_CONTEXT_DEPTH
+ * @brief Maximum number of context entries of a thread.
+ */
+#define LOGGER_CONTEXT_DEPTH 8
+
+/**
+ * @def LOGGER_CONTEXT_SIZE
+ * @brief Size of the rendered context of a thread (including the null byte).
+ */
+#define LOGGER_CONTEXT_SIZE 256
+
+/**
+ * @brief Adds a key-value pair to the records of the calling thread.
+ *
+ * Until the matching logger_context_pop(), every record logged by the thread
+ * shows its context after the thread: `{request_id=42 user=bob} message`. The
+ * context lives in a thread local buffer, rendered once by the push: records
+ * only copy it, without allocation nor formatting.
+ *
+ * @param key The key.
+ * @param value The value.
+ * @return `true` on success, `false` if the context is full (more than
+ * LOGGER_CONTEXT_DEPTH entries or LOGGER_CONTEXT_SIZE bytes). The entry is
+ * then left out, but must still be popped.
+ */
+bool logger_context_push(const char *const key, const char *const value)
+    NONNULL NULL_TERMINATED_STRING_ARG(1) NULL_TERMINATED_STRING_ARG(2);
+
+/**
+ * @brief Adds a key-value pair with a formatted value, see
+ * logger_context_push().
+ *
+ * @param key The key.
+ * @param fmt Format string of the value.
+ * @param ... Format arguments.
+ * @return `true` on success, `false` if the context is full.
+ */
+bool logger_context_pushf(const char *const key, const char *const fmt, ...)
+    NONNULL_POSITIONS(1, 2) FORMAT(printf, 2, 3)
+    NULL_TERMINATED_STRING_ARG(1);
+
+/**
+ * @brief Removes the last pair pushed by the calling thread.
+ *
+ * Does nothing on an empty context.
+ */
+void logger_context_pop(void);
+
+/**
+ * @brief Removes every pair of the calling thread (for example, between two
+ * tasks of a thread pool worker).
+ */
+void logger_context_clear(void);
+
+/**
+ * @def LOGGER_CONTEXT(key, value)
+ * @brief Runs the following statement (or block) with a key-value pair in
+ * the context of the thread.
+ *
+ * @code
+ * LOGGER_CONTEXT("request_id", id) {
+ *     LOG(LOG_INFO, "started"); // {request_id=...} started
+ *     handle(request);
+ * }
+ * @endcode
+ *
+ * @warning The pair is popped when the statement ends normally: leaving it
+ * with return, break or goto leaves the pair in the context.
+ */
+#define LOGGER_CONTEXT(key, value)                                             \
+    for (int logger_context_once_ =                                            \
+             (logger_context_push((key), (value)), 1);                         \
+         logger_context_once_; logger_context_once_ = 0, logger_context_pop())
+
 /**
  * @brief Sets the current log level.
  *
@@ -263,6 +358,375 @@ bool logger_set_log_fileno(FILE *file) NONNULL FD_ARG_WRITE(1);
  */
 void logger_close_file(void);
 
+// ---------- Time Index ---------- //
+
+/**
+ * @def LOGGER_INDEX_SUFFIX
+ * @brief Suffix of the time index of a log file (`app.log` -> `app.log.idx`).
+ */
+#define LOGGER_INDEX_SUFFIX ".idx"
+
+/**
+ * @brief Enables the time index of the log files.
+ *
+ * Log files opened afterwards with logger_set_log_file() get a sidecar index
+ * file (see LOGGER_INDEX_SUFFIX). The index is a sparse list of (time, file
+ * offset) entries: an entry is written before the first record of the file,
+ * then every `every_records` records or `every_bytes` bytes, whichever comes
+ * first. Times never decrease along the index.
+ *
+ * Time-range queries binary search the index with logger_index_lookup() and
+ * only read the part of the log file between the returned offsets.
+ *
+ * @param every_records Records between two entries (0 for no record limit).
+ * @param every_bytes Bytes between two entries (0 for no byte limit).
+ *
+ * @note Both 0 disables the index (the default). The entries are 64 bits
+ * integers in the native byte order of the writer.
+ *
+ * @note Compressed log files (see logger_set_compression()) have no index.
+ */
+void logger_set_index(size_t every_records, size_t every_bytes);
+
+/**
+ * @brief Finds the range of a log file holding a time range, with its index.
+ *
+ * The records logged in [since, until] are between the offsets begin and end
+ * of the log file: begin is the offset of the last entry before since (0 if
+ * none), end the offset of the first entry after until (UINT64_MAX if none).
+ *
+ * @param index_path Path of the index file.
+ * @param since Start of the time range.
+ * @param until End of the time range (inclusive).
+ * @param begin Output start offset in the log file.
+ * @param end Output end offset in the log file.
+ * @return `true` on success, `false` if the index cannot be read or is not a
+ * logger index.
+ */
+bool logger_index_lookup(const char *const index_path, time_t since,
+                         time_t until, uint64_t *begin, uint64_t *end)
+    NONNULL WARN_UNUSED_RESULT NULL_TERMINATED_STRING_ARG(1);
+
+// ---------- Compression ---------- //
+
+/**
+ * @def LOGGER_COMPRESSION_FRAME
+ * @brief Suggested frame size of compressed log files.
+ */
+#define LOGGER_COMPRESSION_FRAME (64 * 1024)
+
+/**
+ * @brief Compresses the log files.
+ *
+ * Log files opened afterwards with logger_set_log_file() are a sequence of
+ * independent LZ4 frames (see lz4.h), each one holding frame_size bytes of
+ * whole records: `lz4 -dc app.log` prints the log. Since frames are
+ * independent, a crash only loses the frame being filled, and a reader can
+ * start at any frame.
+ *
+ * Records are compressed by the thread writing the file: with
+ * logger_start_async() (or a shared ring collector), log calls do not pay for
+ * the compression.
+ *
+ * @param frame_size Uncompressed bytes per frame (0 disables the compression,
+ * the default), clamped to [4KB, LZ4_FRAME_MAX_SIZE].
+ *
+ * @note The pending frame is written when full, by logger_flush(),
+ * logger_close_file() and after a fatal backtrace: until then, its records
+ * are only in memory.
+ */
+void logger_set_compression(size_t frame_size);
+
+// ---------- Framed Records ---------- //
+
+/**
+ * @struct logger_record
+ * @brief A framed record, see logger_record_read().
+ */
+struct logger_record {
+    uint64_t writer; /**< Pid of the process that wrote the record */
+    uint64_t sequence; /**< Position among the records of the writer, from 1
+                            (again from 1 each time it opens the file) */
+    const char *text; /**< The line, with its newline (not 0 terminated) */
+    size_t size; /**< Size of the line */
+};
+
+/**
+ * @struct logger_recovery
+ * @brief Result of the scan of a framed log file, see logger_recover().
+ */
+struct logger_recovery {
+    uint64_t records; /**< Valid records */
+    uint64_t sequence; /**< Sequence of the last valid record (0 if none) */
+    uint64_t skipped; /**< Invalid bytes between valid records */
+    uint64_t valid_size; /**< End of the last valid record */
+    uint64_t file_size; /**< Size of the file before the recovery */
+};
+
+/**
+ * @brief Frames the records of the log files.
+ *
+ * Log files opened afterwards with logger_set_log_file() hold framed records
+ * instead of plain lines: a 24 bytes header (magic number, line size, pid of
+ * the writer, sequence number), the line, then the CRC32C of both (see
+ * logger_crc32c()). A torn or partially written record, after a crash, is
+ * detected by its checksum; a stale or duplicated one by its sequence number.
+ *
+ * Several processes may append to the same framed file (forked children,
+ * workers opening it): each one numbers its own records, and every record is
+ * appended whole. Opening a framed file never modifies it, as other processes
+ * may be writing to it: the readers skip the torn records (see
+ * logger_recover()). A file that does not start with a record is not opened.
+ *
+ * @param framed `true` to frame the records (default `false`).
+ *
+ * @note Integers are in the native byte order of the writer. Compressed log
+ * files (see logger_set_compression()) are not framed. The time index still
+ * points at record starts.
+ */
+void logger_set_framing(bool framed);
+
+/**
+ * @brief Finds the last valid record of a framed log file.
+ *
+ * Reads the records from the start of the file. Invalid bytes (a truncated
+ * record, a wrong checksum) and records going back in the sequence of their
+ * writer are skipped, up to the next valid record.
+ *
+ * @param filename Path of the log file.
+ * @param truncate `true` to cut the file after the last valid record. Only
+ * for a file no process writes to (offline), as it would cut the records
+ * being appended.
+ * @param recovery Output: the result of the scan.
+ * @return `true` on success, `false` if the file cannot be read (or
+ * truncated) or is not empty and does not start with a valid record (it is
+ * then left as is).
+ */
+bool logger_recover(const char *const filename, bool truncate,
+                    struct logger_recovery *recovery)
+    NONNULL WARN_UNUSED_RESULT NULL_TERMINATED_STRING_ARG(1);
+
+/**
+ * @brief Reads the framed record at the start of a buffer.
+ *
+ * @param data The framed records (a mapped log file for example).
+ * @param size Size of the buffer.
+ * @param record Output: the record, pointing into data.
+ * @return The size of the framed record (where the next one starts), 0 if
+ * the record is invalid or truncated.
+ */
+size_t logger_record_read(const void *data, size_t size,
+                          struct logger_record *record)
+    NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief CRC32C (Castagnoli) checksum of framed records.
+ *
+ * Uses the SSE4.2 crc32 instruction when the build targets it (-msse4.2 or
+ * -march), a lookup table otherwise (or with LOGGER_NO_SIMD).
+ *
+ * @param data The data.
+ * @param size Size of the data.
+ * @param crc 0, or the checksum of the previous data to continue it.
+ * @return The checksum.
+ */
+uint32_t logger_crc32c(const void *data, size_t size, uint32_t crc) PURE;
+
+// ---------- Asynchronous File Sink ---------- //
+
+/**
+ * @def LOGGER_ASYNC_CAPACITY
+ * @brief Default number of queued records of the asynchronous file sink.
+ */
+#define LOGGER_ASYNC_CAPACITY 1024
+
+/**
+ * @def LOGGER_ASYNC_PRIORITY_CAPACITY
+ * @brief Default number of queued ERROR and FATAL records.
+ */
+#define LOGGER_ASYNC_PRIORITY_CAPACITY 64
+
+/**
+ * @def LOGGER_ASYNC_REPORT_MS
+ * @brief Default period of the dropped records reports, in milliseconds.
+ */
+#define LOGGER_ASYNC_REPORT_MS 1000
+
+/**
+ * @enum logger_overflow
+ * @brief Behavior of log calls when the asynchronous queue is full.
+ */
+enum logger_overflow {
+    LOGGER_BLOCK, /**< Wait for room: nothing is lost */
+    LOGGER_DROP_NEWEST, /**< Drop the record being logged */
+    LOGGER_DROP_OLDEST, /**< Drop the oldest queued record */
+    LOGGER_SPILL, /**< Write the record to the overflow file instead */
+};
+
+/**
+ * @struct logger_async_options
+ * @brief Options of the asynchronous file sink (zero fields are defaults).
+ */
+struct logger_async_options {
+    size_t capacity; /**< Queued records (LOGGER_ASYNC_CAPACITY) */
+    size_t priority_capacity; /**< Queued ERROR and FATAL records
+                                   (LOGGER_ASYNC_PRIORITY_CAPACITY) */
+    enum logger_overflow overflow; /**< Full queue behavior (LOGGER_BLOCK) */
+    const char *spill_file; /**< Overflow file (required by LOGGER_SPILL) */
+    unsigned report_ms; /**< Dropped records report period
+                             (LOGGER_ASYNC_REPORT_MS) */
+};
+
+/**
+ * @struct logger_async_stats
+ * @brief Counters of the asynchronous file sink.
+ */
+struct logger_async_stats {
+    uint64_t written; /**< Records written by the writer thread */
+    uint64_t dropped; /**< Records dropped (LOGGER_DROP_*, no log file) */
+    uint64_t spilled; /**< Records written to the overflow file */
+    uint64_t blocked; /**< Log calls that waited for room */
+};
+
+/**
+ * @brief Starts writing the log file from a background thread.
+ *
+ * Log calls then only format their record and queue it, so that a slow or
+ * stalled disk does not slow the logging threads down. When the queue is
+ * full, options->overflow decides between waiting and losing (or moving) the
+ * record.
+ *
+ * ERROR and FATAL records have their own queue (the priority lane): they are
+ * never dropped nor spilled, and a flood of less severe records cannot take
+ * their room. On a full priority lane, log calls wait. Records of both queues
+ * are written in the order of the log calls. The backtraces of fatal errors
+ * are written after the queued records, synchronously.
+ *
+ * If records were dropped or spilled, the writer thread logs a WARN record
+ * with the counts, at most once per options->report_ms, and a last one when
+ * stopped.
+ *
+ * @param options The options (NULL for the defaults).
+ * @return `true` on success, `false` if already started, on invalid options
+ * (LOGGER_SPILL without spill_file) or if the overflow file or the thread
+ * cannot be created.
+ *
+ * @note The callback is still called by the log calls, under the logger lock
+ * that the writer thread holds while writing: with a callback, a stalled
+ * disk also stalls the log calls.
+ */
+bool logger_start_async(const struct logger_async_options *options)
+    WARN_UNUSED_RESULT;
+
+/**
+ * @brief Waits until the queued records are written to the log file.
+ *
+ * Also writes the pending frame of a compressed log file (see
+ * logger_set_compression()).
+ */
+void logger_flush(void);
+
+/**
+ * @brief Writes the queued records and stops the writer thread.
+ *
+ * The logger writes synchronously again. Called by logger_deinit().
+ */
+void logger_stop_async(void);
+
+/**
+ * @brief Reads the counters of the asynchronous file sink.
+ *
+ * @return The counters since logger_start_async().
+ */
+struct logger_async_stats logger_async_stats_read(void);
+
+// ---------- Multi-Process Shared Ring ---------- //
+
+/**
+ * @def LOGGER_SHM_SLOTS
+ * @brief Default number of records of a shared ring.
+ */
+#define LOGGER_SHM_SLOTS 4096
+
+/**
+ * @def LOGGER_SHM_POLL_MS
+ * @brief Longest sleep of an idle collector, in milliseconds.
+ */
+#define LOGGER_SHM_POLL_MS 10
+
+/**
+ * @struct logger_shm_stats
+ * @brief Counters of a shared ring.
+ */
+struct logger_shm_stats {
+    uint64_t written; /**< Records written by this process' collector */
+    uint64_t dropped; /**< Records dropped on a full ring (all processes) */
+    uint64_t lost; /**< Records skipped by this process' collector, their
+                        writer process died while writing them */
+};
+
+/**
+ * @brief Creates a shared memory ring and sends the records of this process
+ * to it.
+ *
+ * A ring gathers the records of several processes (prefork servers) in a
+ * single ordered stream, written by one collector (see
+ * logger_shm_start_collector()). Log calls append their record to the ring
+ * without lock nor system call, instead of writing the log file. The callback
+ * is still called by the log calls. When the ring is full, records are
+ * dropped and counted, and the collector logs the count; ERROR and FATAL
+ * records and backtraces are written directly to the log file instead.
+ *
+ * Child processes forked afterwards use the ring too. Other processes attach
+ * to a named ring with logger_shm_attach().
+ *
+ * @param name The POSIX shared memory name (`/name`), or NULL for an anonymous
+ * ring shared with the forked children only.
+ * @param slots The number of records (rounded up to a power of two, 0 for
+ * LOGGER_SHM_SLOTS).
+ * @return `true` on success, `false` if a ring is already used or on error
+ * (errno is set, EEXIST if the name exists).
+ */
+bool logger_shm_create(const char *const name, size_t slots)
+    WARN_UNUSED_RESULT;
+
+/**
+ * @brief Sends the records of this process to an existing named ring.
+ *
+ * @param name The name given to logger_shm_create().
+ * @return `true` on success, `false` if a ring is already used or on error.
+ */
+bool logger_shm_attach(const char *const name) NONNULL WARN_UNUSED_RESULT
+    NULL_TERMINATED_STRING_ARG(1);
+
+/**
+ * @brief Starts the collector thread of the ring in this process.
+ *
+ * The collector writes the records of the ring, in order, to the log file
+ * (and its time index) of this process. It polls the ring, sleeping up to
+ * LOGGER_SHM_POLL_MS when idle. A ring has one collector at a time.
+ *
+ * @return `true` on success, `false` without ring, if another live process
+ * collects the ring, or if the thread cannot be created.
+ */
+bool logger_shm_start_collector(void) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Stops using the ring.
+ *
+ * The collector of this process (if any) writes the remaining records first.
+ * The creator of a named ring also removes the name. Called by
+ * logger_deinit().
+ */
+void logger_shm_detach(void);
+
+/**
+ * @brief Reads the counters of the ring.
+ *
+ * @return The counters (zero without ring).
+ */
+struct logger_shm_stats logger_shm_stats_read(void);
+
 /**
  * @brief Sets a callback function to handle log messages.
  *
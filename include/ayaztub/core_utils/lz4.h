@@ -0,0 +1,157 @@
+/**
+ * @file lz4.h
+ * @brief LZ4 block and frame compression, without dependency.
+ *
+ * - Blocks: the LZ4 block format (literals and matches of the 64KB before).
+ *   The compressor is the fast greedy one (one hash table lookup per
+ *   position, skipping faster over incompressible data); the decompressor
+ *   checks every length and offset, so corrupted input is rejected.
+ * - Frames: the LZ4 frame format (magic number 0x184D2204), compatible with
+ *   the `lz4` command line tool and the reference library. Frames are
+ *   independent, so a file made of frames can be cut at any frame boundary
+ *   and a truncated file only loses its last frame. The compressor writes a
+ *   frame of one block with its content size; the decompressor also reads the
+ *   frames of other encoders (several blocks, linked blocks, checksums, which
+ *   are verified) and skips the skippable frames.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/core_utils/lz4.h>
+ *
+ * int main(void) {
+ *     const char text[] = "abcabcabcabcabcabcabcabcabcabcabcabc";
+ *     char frame[128];
+ *     size_t size = lz4_frame_compress(text, sizeof(text), frame,
+ *                                      sizeof(frame));
+ *     if (!size)
+ *         return 1; // frame too small (see lz4_frame_bound())
+ *
+ *     char copy[sizeof(text)];
+ *     size_t consumed;
+ *     size_t produced;
+ *     if (!lz4_frame_decompress(frame, size, copy, sizeof(copy), &consumed,
+ *                               &produced))
+ *         return 1;
+ *     return produced == sizeof(text) ? 0 : 1;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CORE_UTILS__LZ4_H__
+#define __AYAZTUB__CORE_UTILS__LZ4_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def LZ4_FRAME_MAX_SIZE
+ * @brief Largest content of a frame written by lz4_frame_compress().
+ */
+#define LZ4_FRAME_MAX_SIZE (4 << 20)
+
+// ---------- Blocks ---------- //
+
+/**
+ * @brief Largest compressed size of a block.
+ *
+ * @param size The uncompressed size.
+ * @return The buffer size lz4_compress_block() needs.
+ */
+static inline size_t lz4_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+/**
+ * @brief Compresses a block.
+ *
+ * @param src The data.
+ * @param size The size of the data (below 2GB).
+ * @param dst The output.
+ * @param capacity The size of the output, at least lz4_compress_bound(size).
+ * @return The compressed size, 0 if capacity is too small.
+ */
+size_t lz4_compress_block(const void *src, size_t size, void *dst,
+                          size_t capacity) NONNULL_POSITIONS(3);
+
+/**
+ * @brief Decompresses a block.
+ *
+ * @param src The compressed block.
+ * @param size The size of the compressed block.
+ * @param dst The output.
+ * @param capacity The size of the output.
+ * @param produced Output: the decompressed size.
+ * @return `true` on success, `false` if the block is corrupted or does not
+ * fit.
+ */
+bool lz4_decompress_block(const void *src, size_t size, void *dst,
+                          size_t capacity, size_t *produced)
+    NONNULL_POSITIONS(5) WARN_UNUSED_RESULT;
+
+// ---------- Frames ---------- //
+
+/**
+ * @brief Largest size of a frame.
+ *
+ * @param size The uncompressed size (at most LZ4_FRAME_MAX_SIZE).
+ * @return The buffer size lz4_frame_compress() needs.
+ */
+static inline size_t lz4_frame_bound(size_t size) {
+    return lz4_compress_bound(size) + 23; // header, block size and end mark
+}
+
+/**
+ * @brief Compresses data in a single frame.
+ *
+ * Incompressible data is stored as is, so a frame is at most 23 bytes larger
+ * than its content.
+ *
+ * @param src The data.
+ * @param size The size of the data (at most LZ4_FRAME_MAX_SIZE).
+ * @param dst The output.
+ * @param capacity The size of the output, at least lz4_frame_bound(size).
+ * @return The frame size, 0 if size or capacity is invalid.
+ */
+size_t lz4_frame_compress(const void *src, size_t size, void *dst,
+                          size_t capacity) NONNULL_POSITIONS(3);
+
+/**
+ * @brief Decompresses the frame at the start of a buffer.
+ *
+ * @param src The frames.
+ * @param size The size of the buffer.
+ * @param dst The output.
+ * @param capacity The size of the output.
+ * @param consumed Output: the size of the frame (where the next one starts).
+ * @param produced Output: the decompressed size (0 for a skippable frame).
+ * @return `true` on success, `false` if the frame is truncated, corrupted,
+ * needs a dictionary, or does not fit.
+ */
+bool lz4_frame_decompress(const void *src, size_t size, void *dst,
+                          size_t capacity, size_t *consumed, size_t *produced)
+    NONNULL_POSITIONS(5, 6) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Reads the content size of a frame, if the encoder stored it.
+ *
+ * @param src The frame.
+ * @param size The size of the buffer.
+ * @param content_size Output: the decompressed size.
+ * @return `true` if the header is valid and holds the content size.
+ */
+bool lz4_frame_content_size(const void *src, size_t size,
+                            uint64_t *content_size) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief XXH32 hash (used by the frame checksums).
+ *
+ * @param data The data.
+ * @param size The size of the data.
+ * @param seed The seed.
+ * @return The hash.
+ */
+uint32_t lz4_xxh32(const void *data, size_t size, uint32_t seed) PURE;
+
+#endif // __AYAZTUB__CORE_UTILS__LZ4_H__
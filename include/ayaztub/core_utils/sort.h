@@ -0,0 +1,381 @@
+/**
+ * @file sort.h
+ * @brief Radix, pattern-defeating quick and parallel sorts in C99.
+ *
+ * qsort() calls its comparator through a function pointer for every
+ * comparison and moves elements byte by byte. This library provides faster
+ * alternatives:
+ *
+ * - SORT_DECL() generates a pattern-defeating quicksort (O. Peters, pdqsort)
+ *   for a given element type and ordering, in the same way heap.h generates
+ *   its heaps: the comparison is inlined, elements are moved with plain
+ *   assignments, already sorted or reversed runs are detected, and the worst
+ *   case falls back to heapsort (O(n log n)).
+ * - radix_sort_<type>() sorts arrays of primitive keys (every type of
+ *   debug.h: char, schar, uchar, short, ushort, int, uint, long, ulong,
+ *   llong, ullong, float, double) with a least significant digit radix sort,
+ *   in O(n) with one byte per pass. Passes where all keys share the same
+ *   byte are skipped. The _kv variants move a `size_t` payload (usually an
+ *   index into the sorted records) along with every key, and are stable.
+ * - parallel_sort_<type>() sorts large arrays of primitive keys on a thread
+ *   pool (see thread_pool.h) with a sample sort: keys are scattered in
+ *   parallel to buckets delimited by sampled splitters, then the buckets are
+ *   radix sorted in parallel.
+ *
+ * Floats are sorted in IEEE 754 total order: -NaN < -inf < ... < -0.0 <
+ * +0.0 < ... < +inf < +NaN.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/core_utils/sort.h>
+ *
+ * struct event {
+ *     uint64_t time;
+ *     const char *name;
+ * };
+ *
+ * #define event_less(a, b) ((a).time < (b).time)
+ *
+ * SORT_DECL(struct event, event, event_less)
+ *
+ * int main(void) {
+ *     struct event events[] = { { 30, "c" }, { 10, "a" }, { 20, "b" } };
+ *     event_sort(events, 3);
+ *
+ *     double values[] = { 2.5, -1.0, 0.0 };
+ *     radix_sort_double(values, 3);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CORE_UTILS__SORT_H__
+#define __AYAZTUB__CORE_UTILS__SORT_H__
+
+#include <ayaztub/concurrency/thread_pool.h>
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @def SORT_INSERTION_THRESHOLD
+ * @brief Ranges up to this size are sorted with an insertion sort.
+ */
+#ifndef SORT_INSERTION_THRESHOLD
+#    define SORT_INSERTION_THRESHOLD 24
+#endif // SORT_INSERTION_THRESHOLD
+
+/**
+ * @def SORT_NINTHER_THRESHOLD
+ * @brief Ranges above this size choose their pivot as a median of medians.
+ */
+#ifndef SORT_NINTHER_THRESHOLD
+#    define SORT_NINTHER_THRESHOLD 128
+#endif // SORT_NINTHER_THRESHOLD
+
+/**
+ * @def SORT_PARTIAL_INSERTION_LIMIT
+ * @brief Number of moves after which a nearly sorted range is partitioned.
+ */
+#ifndef SORT_PARTIAL_INSERTION_LIMIT
+#    define SORT_PARTIAL_INSERTION_LIMIT 8
+#endif // SORT_PARTIAL_INSERTION_LIMIT
+
+/**
+ * @def SORT_PARALLEL_THRESHOLD
+ * @brief Arrays smaller than this are sorted by parallel_sort_<type>() on the
+ * calling thread only.
+ */
+#ifndef SORT_PARALLEL_THRESHOLD
+#    define SORT_PARALLEL_THRESHOLD (1 << 16)
+#endif // SORT_PARALLEL_THRESHOLD
+
+/**
+ * @def sort_default_less(a, b)
+ * @brief Default ordering of SORT_DECL(), for arithmetic types.
+ */
+#define sort_default_less(a, b) ((a) < (b))
+
+/**
+ * @def SORT_DECL(type, name, less_func)
+ * @brief Generates `void name##_sort(type *array, size_t count)`.
+ *
+ * The sort is not stable: equal elements may be reordered.
+ *
+ * @param type The element type.
+ * @param name The prefix of the generated functions.
+ * @param less_func A function or macro `bool less_func(type a, type b)`
+ * defining a strict weak ordering.
+ *
+ * Example usage:
+ * @code
+ * SORT_DECL(int, int_desc, int_greater) // name: int_desc_sort()
+ * @endcode
+ */
+#define SORT_DECL(type, name, less_func)                                       \
+    static inline void name##_swap(type *a, type *b) {                         \
+        type tmp = *a;                                                         \
+        *a = *b;                                                               \
+        *b = tmp;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline void name##_insertion_sort(type *array, size_t count) {      \
+        for (size_t i = 1; i < count; ++i) {                                   \
+            type value = array[i];                                             \
+            size_t j = i;                                                      \
+            for (; j > 0 && less_func(value, array[j - 1]); --j)               \
+                array[j] = array[j - 1];                                       \
+            array[j] = value;                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* Insertion sort giving up after SORT_PARTIAL_INSERTION_LIMIT moves. */   \
+    static inline bool name##_partial_insertion_sort(type *array,              \
+                                                     size_t count) {           \
+        size_t moves = 0;                                                      \
+        for (size_t i = 1; i < count; ++i) {                                   \
+            type value = array[i];                                             \
+            size_t j = i;                                                      \
+            for (; j > 0 && less_func(value, array[j - 1]); --j)               \
+                array[j] = array[j - 1];                                       \
+            array[j] = value;                                                  \
+            moves += i - j;                                                    \
+            if (moves > SORT_PARTIAL_INSERTION_LIMIT)                          \
+                return false;                                                  \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_sift_down(type *array, size_t count,             \
+                                        size_t index) {                        \
+        type value = array[index];                                             \
+        for (;;) {                                                             \
+            size_t child = 2 * index + 1;                                      \
+            if (child >= count)                                                \
+                break;                                                         \
+            if (child + 1 < count                                              \
+                && less_func(array[child], array[child + 1]))                  \
+                child++;                                                       \
+            if (!less_func(value, array[child]))                               \
+                break;                                                         \
+            array[index] = array[child];                                       \
+            index = child;                                                     \
+        }                                                                      \
+        array[index] = value;                                                  \
+    }                                                                          \
+                                                                               \
+    static inline void name##_heap_sort(type *array, size_t count) {           \
+        for (size_t i = count / 2; i-- > 0;)                                   \
+            name##_sift_down(array, count, i);                                 \
+        for (size_t end = count; end-- > 1;) {                                 \
+            name##_swap(&array[0], &array[end]);                               \
+            name##_sift_down(array, end, 0);                                   \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void name##_sort3(type *a, type *b, type *c) {               \
+        if (less_func(*b, *a))                                                 \
+            name##_swap(a, b);                                                 \
+        if (less_func(*c, *b)) {                                               \
+            name##_swap(b, c);                                                 \
+            if (less_func(*b, *a))                                             \
+                name##_swap(a, b);                                             \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* Partitions around array[0]: [0, mid) < pivot <= (mid, count). */        \
+    static inline size_t name##_partition_right(type *array, size_t count,     \
+                                                bool *already_partitioned) {   \
+        type pivot = array[0];                                                 \
+        size_t first = 1;                                                      \
+        size_t last = count;                                                   \
+        while (first < last && less_func(array[first], pivot))                 \
+            first++;                                                           \
+        while (last > first && !less_func(array[last - 1], pivot))             \
+            last--;                                                            \
+        *already_partitioned = first >= last;                                  \
+        while (first < last) {                                                 \
+            name##_swap(&array[first++], &array[--last]);                      \
+            while (first < last && less_func(array[first], pivot))             \
+                first++;                                                       \
+            while (last > first && !less_func(array[last - 1], pivot))         \
+                last--;                                                        \
+        }                                                                      \
+        size_t mid = first - 1;                                                \
+        array[0] = array[mid];                                                 \
+        array[mid] = pivot;                                                    \
+        return mid;                                                            \
+    }                                                                          \
+                                                                               \
+    /* Partitions around array[0]: [0, mid] <= pivot < (mid, count). */        \
+    static inline size_t name##_partition_left(type *array, size_t count) {    \
+        type pivot = array[0];                                                 \
+        size_t first = 1;                                                      \
+        size_t last = count;                                                   \
+        while (last > first && less_func(pivot, array[last - 1]))              \
+            last--;                                                            \
+        while (first < last && !less_func(pivot, array[first]))                \
+            first++;                                                           \
+        while (first < last) {                                                 \
+            name##_swap(&array[first++], &array[--last]);                      \
+            while (last > first && less_func(pivot, array[last - 1]))          \
+                last--;                                                        \
+            while (first < last && !less_func(pivot, array[first]))            \
+                first++;                                                       \
+        }                                                                      \
+        size_t mid = first - 1;                                                \
+        array[0] = array[mid];                                                 \
+        array[mid] = pivot;                                                    \
+        return mid;                                                            \
+    }                                                                          \
+                                                                               \
+    /* leftmost: array[-1] is not a previous pivot (not <= every element). */  \
+    static inline void name##_sort_loop(type *array, size_t count,             \
+                                        unsigned bad_allowed, bool leftmost) { \
+        while (count > SORT_INSERTION_THRESHOLD) {                             \
+            size_t half = count / 2;                                           \
+            if (count > SORT_NINTHER_THRESHOLD) {                              \
+                name##_sort3(&array[0], &array[half], &array[count - 1]);      \
+                name##_sort3(&array[1], &array[half - 1], &array[count - 2]);  \
+                name##_sort3(&array[2], &array[half + 1], &array[count - 3]);  \
+                name##_sort3(&array[half - 1], &array[half],                   \
+                             &array[half + 1]);                                \
+                name##_swap(&array[0], &array[half]);                          \
+            } else {                                                           \
+                name##_sort3(&array[half], &array[0], &array[count - 1]);      \
+            }                                                                  \
+                                                                               \
+            /* pivot equal to the previous one: skip the equal elements */     \
+            if (!leftmost && !less_func(array[-1], array[0])) {                \
+                size_t mid = name##_partition_left(array, count);              \
+                array += mid + 1;                                              \
+                count -= mid + 1;                                              \
+                continue;                                                      \
+            }                                                                  \
+                                                                               \
+            bool already_partitioned;                                          \
+            size_t mid =                                                       \
+                name##_partition_right(array, count, &already_partitioned);    \
+            size_t left = mid;                                                 \
+            size_t right = count - mid - 1;                                    \
+            if (left < count / 8 || right < count / 8) {                       \
+                if (--bad_allowed == 0) {                                      \
+                    name##_heap_sort(array, count);                            \
+                    return;                                                    \
+                }                                                              \
+                /* break the patterns that gave a bad pivot */                 \
+                if (left >= SORT_INSERTION_THRESHOLD) {                        \
+                    name##_swap(&array[0], &array[left / 4]);                  \
+                    name##_swap(&array[mid - 1], &array[mid - left / 4]);      \
+                }                                                              \
+                if (right >= SORT_INSERTION_THRESHOLD) {                       \
+                    name##_swap(&array[mid + 1], &array[mid + 1 + right / 4]); \
+                    name##_swap(&array[count - 1], &array[count - right / 4]); \
+                }                                                              \
+            } else if (already_partitioned                                     \
+                       && name##_partial_insertion_sort(array, left)           \
+                       && name##_partial_insertion_sort(array + mid + 1,       \
+                                                        right)) {              \
+                return;                                                        \
+            }                                                                  \
+                                                                               \
+            name##_sort_loop(array, left, bad_allowed, leftmost);              \
+            array += mid + 1;                                                  \
+            count = right;                                                     \
+            leftmost = false;                                                  \
+        }                                                                      \
+        name##_insertion_sort(array, count);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void name##_sort(type *array, size_t count) {                \
+        unsigned bad_allowed = 1;                                              \
+        for (size_t n = count; n > 1; n >>= 1)                                 \
+            bad_allowed++;                                                     \
+        name##_sort_loop(array, count, bad_allowed, true);                     \
+    }
+
+/**
+ * @def SORT_PRIMITIVE_FUNC_DECL(type, name)
+ * @brief Declares the radix and parallel sorts of a primitive type.
+ *
+ * - `void radix_sort_<name>(type *array, size_t count)` sorts keys with a
+ *   radix sort (in place with the pdqsort if out of memory).
+ * - `bool radix_sort_<name>_kv(type *keys, size_t *values, size_t count)`
+ *   sorts keys and moves their values along, with a stable radix sort. It
+ *   returns `false` on allocation failure, with the arrays unchanged.
+ * - `void parallel_sort_<name>(struct thread_pool *pool, type *array,
+ *   size_t count)` sorts keys on a thread pool (the calling thread, which
+ *   can be a worker of the pool, takes part), or on the calling thread only
+ *   below SORT_PARALLEL_THRESHOLD keys or if out of memory.
+ *
+ * @param type The key type.
+ * @param name The suffix of the functions.
+ */
+#define SORT_PRIMITIVE_FUNC_DECL(type, name)                                   \
+    void radix_sort_##name(type *array, size_t count);                         \
+    bool radix_sort_##name##_kv(type *keys, size_t *values, size_t count)      \
+        WARN_UNUSED_RESULT;                                                    \
+    void parallel_sort_##name(struct thread_pool *pool, type *array,           \
+                              size_t count) NONNULL_POSITIONS(1);
+
+SORT_PRIMITIVE_FUNC_DECL(char, char)
+SORT_PRIMITIVE_FUNC_DECL(signed char, schar)
+SORT_PRIMITIVE_FUNC_DECL(unsigned char, uchar)
+SORT_PRIMITIVE_FUNC_DECL(short, short)
+SORT_PRIMITIVE_FUNC_DECL(unsigned short, ushort)
+SORT_PRIMITIVE_FUNC_DECL(int, int)
+SORT_PRIMITIVE_FUNC_DECL(unsigned int, uint)
+SORT_PRIMITIVE_FUNC_DECL(long, long)
+SORT_PRIMITIVE_FUNC_DECL(unsigned long, ulong)
+SORT_PRIMITIVE_FUNC_DECL(long long, llong)
+SORT_PRIMITIVE_FUNC_DECL(unsigned long long, ullong)
+SORT_PRIMITIVE_FUNC_DECL(float, float)
+SORT_PRIMITIVE_FUNC_DECL(double, double)
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+/**
+ * @def radix_sort(array, count)
+ * @brief Calls the radix_sort_<type>() of the array type.
+ *
+ * @warning This macro is only defined for C11 or newer.
+ */
+#    define radix_sort(array, count)                                           \
+        _Generic((array),                                                      \
+            char *: radix_sort_char,                                           \
+            signed char *: radix_sort_schar,                                   \
+            unsigned char *: radix_sort_uchar,                                 \
+            short *: radix_sort_short,                                         \
+            unsigned short *: radix_sort_ushort,                               \
+            int *: radix_sort_int,                                             \
+            unsigned int *: radix_sort_uint,                                   \
+            long *: radix_sort_long,                                           \
+            unsigned long *: radix_sort_ulong,                                 \
+            long long *: radix_sort_llong,                                     \
+            unsigned long long *: radix_sort_ullong,                           \
+            float *: radix_sort_float,                                         \
+            double *: radix_sort_double)(array, count)
+
+/**
+ * @def parallel_sort(pool, array, count)
+ * @brief Calls the parallel_sort_<type>() of the array type.
+ *
+ * @warning This macro is only defined for C11 or newer.
+ */
+#    define parallel_sort(pool, array, count)                                  \
+        _Generic((array),                                                      \
+            char *: parallel_sort_char,                                        \
+            signed char *: parallel_sort_schar,                                \
+            unsigned char *: parallel_sort_uchar,                              \
+            short *: parallel_sort_short,                                      \
+            unsigned short *: parallel_sort_ushort,                            \
+            int *: parallel_sort_int,                                          \
+            unsigned int *: parallel_sort_uint,                                \
+            long *: parallel_sort_long,                                        \
+            unsigned long *: parallel_sort_ulong,                              \
+            long long *: parallel_sort_llong,                                  \
+            unsigned long long *: parallel_sort_ullong,                        \
+            float *: parallel_sort_float,                                      \
+            double *: parallel_sort_double)(pool, array, count)
+#endif // __STDC_VERSION__ >= 201112L
+
+#endif // __AYAZTUB__CORE_UTILS__SORT_H__
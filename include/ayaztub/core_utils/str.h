@@ -0,0 +1,451 @@
+/**
+ * @file str.h
+ * @brief String views and string builder with SIMD search in C99.
+ *
+ * - `struct strview`: non-owning (pointer, size) slice of characters. Views do
+ *   not need to be null terminated, so sub-strings and split tokens never
+ *   copy. strview_find(), strview_find_any_of() and the case-insensitive
+ *   comparisons process 16 bytes at once with SSE2 (define STR_NO_SIMD to
+ *   force the portable scalar code).
+ * - `struct strbuf`: growable, always null terminated string builder. It grows
+ *   geometrically with the allocator given at initialization (malloc() by
+ *   default): on top of arena_allocator(), appends to the last allocation of
+ *   the arena grow in place. Integers and floating point numbers are appended
+ *   without going through printf().
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/core_utils/str.h>
+ *
+ * int main(void) {
+ *     struct strview rest = strview_from_cstr("level=debug, file=app.log");
+ *     struct strview token;
+ *     while (strview_split(&rest, ',', &token)) {
+ *         token = strview_trim(token);
+ *         size_t eq = strview_find_char(token, '=');
+ *         if (eq != STRVIEW_NPOS
+ *             && strview_eq_nocase(strview_prefix(token, eq),
+ *                                  STRVIEW_LIT("LEVEL")))
+ *             printf("level: " STRVIEW_FMT "\n",
+ *                    STRVIEW_ARG(strview_substr(token, eq + 1, SIZE_MAX)));
+ *     }
+ *
+ *     struct strbuf buf;
+ *     strbuf_init(&buf, NULL);
+ *     if (strbuf_append_cstr(&buf, "answer: ")
+ *         && strbuf_append_int(&buf, 42)
+ *         && strbuf_append_char(&buf, ' ')
+ *         && strbuf_append_double(&buf, 3.14159, 2))
+ *         puts(strbuf_cstr(&buf)); // answer: 42 3.14
+ *     strbuf_deinit(&buf);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__CORE_UTILS__STR_H__
+#define __AYAZTUB__CORE_UTILS__STR_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <ayaztub/data_structures/allocator.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @def STRBUF_MIN_CAPACITY
+ * @brief Minimum capacity of a string builder once it allocates.
+ */
+#ifndef STRBUF_MIN_CAPACITY
+#    define STRBUF_MIN_CAPACITY 32
+#endif // STRBUF_MIN_CAPACITY
+
+// ---------- String Views ---------- //
+
+/**
+ * @struct strview
+ * @brief Non-owning slice of characters (not necessarily null terminated).
+ */
+struct strview {
+    const char *data; /**< First character */
+    size_t size; /**< Number of characters */
+};
+
+/**
+ * @def STRVIEW_NPOS
+ * @brief Position returned by the search functions when nothing is found.
+ */
+#define STRVIEW_NPOS SIZE_MAX
+
+/**
+ * @def STRVIEW_LIT(literal)
+ * @brief View of a string literal (its size is computed at compile time).
+ */
+#define STRVIEW_LIT(literal)                                                   \
+    ((struct strview){ "" literal, sizeof(literal) - 1 })
+
+/**
+ * @def STRVIEW_FMT
+ * @brief printf() format of a view, to use with STRVIEW_ARG().
+ */
+#define STRVIEW_FMT "%.*s"
+
+/**
+ * @def STRVIEW_ARG(view)
+ * @brief printf() arguments of a view, to use with STRVIEW_FMT.
+ */
+#define STRVIEW_ARG(view) (int)(view).size, (view).data
+
+/**
+ * @brief Creates a view of a memory range.
+ *
+ * @param data The first character.
+ * @param size The number of characters.
+ * @return The view.
+ */
+static inline struct strview strview_make(const char *data, size_t size) {
+    struct strview view = { data, size };
+    return view;
+}
+
+/**
+ * @brief Creates a view of a null terminated string.
+ *
+ * @param cstr The string (NULL gives an empty view).
+ * @return The view, without the null terminator.
+ */
+static inline struct strview strview_from_cstr(const char *cstr) {
+    return strview_make(cstr ? cstr : "", cstr ? strlen(cstr) : 0);
+}
+
+/**
+ * @brief Gets a sub-view, clamped to the view bounds.
+ *
+ * @param view The view.
+ * @param pos The position of the first character.
+ * @param count The maximum number of characters (SIZE_MAX for the rest).
+ * @return The sub-view.
+ */
+static inline struct strview strview_substr(struct strview view, size_t pos,
+                                            size_t count) {
+    if (pos > view.size)
+        pos = view.size;
+    if (count > view.size - pos)
+        count = view.size - pos;
+    return strview_make(view.data + pos, count);
+}
+
+/**
+ * @brief Gets the first characters of a view.
+ *
+ * @param view The view.
+ * @param count The number of characters (clamped to the view size).
+ * @return The prefix.
+ */
+static inline struct strview strview_prefix(struct strview view,
+                                            size_t count) {
+    return strview_substr(view, 0, count);
+}
+
+/**
+ * @brief Checks whether two views hold the same characters.
+ *
+ * @param a The first view.
+ * @param b The second view.
+ * @return `true` if they are equal, `false` otherwise.
+ */
+static inline bool strview_eq(struct strview a, struct strview b) {
+    return a.size == b.size && (!a.size || !memcmp(a.data, b.data, a.size));
+}
+
+/**
+ * @brief Checks whether a view starts with another one.
+ *
+ * @param view The view.
+ * @param prefix The prefix to look for.
+ * @return `true` if view starts with prefix, `false` otherwise.
+ */
+static inline bool strview_starts_with(struct strview view,
+                                       struct strview prefix) {
+    return view.size >= prefix.size
+        && strview_eq(strview_prefix(view, prefix.size), prefix);
+}
+
+/**
+ * @brief Checks whether a view ends with another one.
+ *
+ * @param view The view.
+ * @param suffix The suffix to look for.
+ * @return `true` if view ends with suffix, `false` otherwise.
+ */
+static inline bool strview_ends_with(struct strview view,
+                                     struct strview suffix) {
+    return view.size >= suffix.size
+        && strview_eq(strview_substr(view, view.size - suffix.size, SIZE_MAX),
+                      suffix);
+}
+
+/**
+ * @brief Removes the leading and trailing white spaces of a view.
+ *
+ * @param view The view.
+ * @return The trimmed view.
+ */
+struct strview strview_trim(struct strview view);
+
+/**
+ * @brief Compares two views, ignoring the case of ASCII letters.
+ *
+ * @param a The first view.
+ * @param b The second view.
+ * @return A negative value, 0 or a positive value if a is respectively
+ * before, equal to or after b (in the byte order of the lower-cased strings).
+ */
+int strview_cmp_nocase(struct strview a, struct strview b) PURE;
+
+/**
+ * @brief Checks whether two views are equal, ignoring the case of ASCII
+ * letters.
+ *
+ * @param a The first view.
+ * @param b The second view.
+ * @return `true` if they are equal, `false` otherwise.
+ */
+bool strview_eq_nocase(struct strview a, struct strview b) PURE;
+
+/**
+ * @brief Finds the first occurrence of a character.
+ *
+ * @param view The view to search in.
+ * @param c The character to look for.
+ * @return The position of the character, or STRVIEW_NPOS.
+ */
+static inline size_t strview_find_char(struct strview view, char c) {
+    const char *found = view.size ? memchr(view.data, c, view.size) : NULL;
+    return found ? (size_t)(found - view.data) : STRVIEW_NPOS;
+}
+
+/**
+ * @brief Finds the first occurrence of a sub-string.
+ *
+ * @param view The view to search in.
+ * @param needle The sub-string to look for (an empty needle is found at 0).
+ * @return The position of the sub-string, or STRVIEW_NPOS.
+ */
+size_t strview_find(struct strview view, struct strview needle) PURE;
+
+/**
+ * @brief Finds the first character that belongs to a set.
+ *
+ * Sets of up to 16 characters are matched 16 bytes at once.
+ *
+ * @param view The view to search in.
+ * @param chars The set of characters to look for.
+ * @return The position of the first matching character, or STRVIEW_NPOS.
+ */
+size_t strview_find_any_of(struct strview view, struct strview chars) PURE;
+
+/**
+ * @brief Splits the next token off a view.
+ *
+ * Every delimiter ends a token, so empty tokens are reported (`"a,,b"` gives
+ * `"a"`, `""` and `"b"`). Once the last token is returned, rest gets a NULL
+ * data pointer and the function returns `false`.
+ *
+ * @param rest The view to split, advanced past the token and its delimiter.
+ * @param delim The delimiter.
+ * @param token Output token.
+ * @return `true` if a token was returned, `false` if rest was exhausted.
+ */
+bool strview_split(struct strview *rest, char delim, struct strview *token)
+    NONNULL;
+
+/**
+ * @brief Splits the next token off a view, using any of a set of delimiters.
+ *
+ * Same semantics as strview_split().
+ *
+ * @param rest The view to split, advanced past the token and its delimiter.
+ * @param delims The set of delimiters.
+ * @param token Output token.
+ * @return `true` if a token was returned, `false` if rest was exhausted.
+ */
+bool strview_split_any(struct strview *rest, struct strview delims,
+                       struct strview *token) NONNULL_POSITIONS(1, 3);
+
+// ---------- String Builder ---------- //
+
+/**
+ * @struct strbuf
+ * @brief Growable null terminated string.
+ *
+ * @warning data is NULL until the first append, use strbuf_cstr() to get a
+ * valid string in every case.
+ */
+struct strbuf {
+    char *data; /**< Characters, null terminated once allocated */
+    size_t size; /**< Number of characters (without the terminator) */
+    size_t capacity; /**< Allocated bytes */
+    const struct allocator *allocator; /**< NULL for malloc() */
+};
+
+/**
+ * @brief Initializes an empty string builder (does not allocate).
+ *
+ * @param buf The builder to initialize.
+ * @param allocator The allocator to use (NULL for malloc(), or an arena
+ * allocator, which must outlive the builder).
+ */
+void strbuf_init(struct strbuf *buf, const struct allocator *allocator)
+    NONNULL_POSITIONS(1);
+
+/**
+ * @brief Releases the memory of a string builder.
+ *
+ * @param buf The builder to release (empty and reusable afterwards).
+ */
+void strbuf_deinit(struct strbuf *buf) NONNULL;
+
+/**
+ * @brief Empties a string builder, keeping its memory.
+ *
+ * @param buf The builder to empty.
+ */
+void strbuf_clear(struct strbuf *buf) NONNULL;
+
+/**
+ * @brief Makes room for at least extra more characters.
+ *
+ * @param buf The builder.
+ * @param extra The number of characters about to be appended.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool strbuf_reserve(struct strbuf *buf, size_t extra)
+    NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Appends a memory range.
+ *
+ * @param buf The builder.
+ * @param data The characters to append.
+ * @param size The number of characters.
+ * @return `true` on success, `false` on allocation failure (the builder is
+ * left unchanged).
+ */
+bool strbuf_append_n(struct strbuf *buf, const char *data, size_t size)
+    NONNULL_POSITIONS(1);
+
+/**
+ * @brief Appends a view.
+ *
+ * @param buf The builder.
+ * @param view The view to append.
+ * @return `true` on success, `false` on allocation failure.
+ */
+static inline bool strbuf_append(struct strbuf *buf, struct strview view) {
+    return strbuf_append_n(buf, view.data, view.size);
+}
+
+/**
+ * @brief Appends a null terminated string.
+ *
+ * @param buf The builder.
+ * @param cstr The string to append.
+ * @return `true` on success, `false` on allocation failure.
+ */
+static inline bool strbuf_append_cstr(struct strbuf *buf, const char *cstr) {
+    return strbuf_append_n(buf, cstr, strlen(cstr));
+}
+
+/**
+ * @brief Appends a character.
+ *
+ * @param buf The builder.
+ * @param c The character to append.
+ * @return `true` on success, `false` on allocation failure.
+ */
+static inline bool strbuf_append_char(struct strbuf *buf, char c) {
+    if (buf->size + 1 >= buf->capacity && !strbuf_reserve(buf, 1))
+        return false;
+    buf->data[buf->size++] = c;
+    buf->data[buf->size] = '\0';
+    return true;
+}
+
+/**
+ * @brief Appends a signed integer in decimal.
+ *
+ * @param buf The builder.
+ * @param value The value to append.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool strbuf_append_int(struct strbuf *buf, long long value) NONNULL;
+
+/**
+ * @brief Appends an unsigned integer in decimal.
+ *
+ * @param buf The builder.
+ * @param value The value to append.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool strbuf_append_uint(struct strbuf *buf, unsigned long long value) NONNULL;
+
+/**
+ * @brief Appends a floating point number with a fixed number of decimals.
+ *
+ * Values below 1e15 with at most 9 decimals are formatted without printf()
+ * (rounding half away from zero), others fall back to `"%.*f"`.
+ *
+ * @param buf The builder.
+ * @param value The value to append (nan and inf are written as such).
+ * @param precision The number of decimals.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool strbuf_append_double(struct strbuf *buf, double value,
+                          unsigned precision) NONNULL;
+
+/**
+ * @brief Appends a printf() formatted string.
+ *
+ * @param buf The builder.
+ * @param fmt The format string.
+ * @return `true` on success, `false` on allocation or format failure.
+ */
+bool strbuf_appendf(struct strbuf *buf, const char *fmt, ...)
+    NONNULL_POSITIONS(1, 2) FORMAT(printf, 2, 3);
+
+/**
+ * @brief Appends a printf() formatted string from a va_list.
+ *
+ * @param buf The builder.
+ * @param fmt The format string.
+ * @param args The format arguments.
+ * @return `true` on success, `false` on allocation or format failure.
+ */
+bool strbuf_vappendf(struct strbuf *buf, const char *fmt, va_list args)
+    NONNULL_POSITIONS(1, 2) FORMAT(printf, 2, 0);
+
+/**
+ * @brief Gets the content of a builder as a null terminated string.
+ *
+ * @param buf The builder.
+ * @return The string (`""` if nothing was appended), valid until the next
+ * modification of the builder.
+ */
+static inline const char *strbuf_cstr(const struct strbuf *buf) {
+    return buf->data ? buf->data : "";
+}
+
+/**
+ * @brief Gets a view of the content of a builder.
+ *
+ * @param buf The builder.
+ * @return The view, valid until the next modification of the builder.
+ */
+static inline struct strview strbuf_view(const struct strbuf *buf) {
+    return strview_make(strbuf_cstr(buf), buf->size);
+}
+
+#endif // __AYAZTUB__CORE_UTILS__STR_H__
@@ -0,0 +1,18 @@
+#ifndef __AYAZTUB__DATA_STRUCTURES_H__
+#define __AYAZTUB__DATA_STRUCTURES_H__
+
+#include <ayaztub/data_structures/allocator.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/bitset.h>
+#include <ayaztub/data_structures/btree.h>
+#include <ayaztub/data_structures/cache.h>
+#include <ayaztub/data_structures/concurrent_map.h>
+#include <ayaztub/data_structures/filter.h>
+#include <ayaztub/data_structures/hashmap.h>
+#include <ayaztub/data_structures/heap.h>
+#include <ayaztub/data_structures/interner.h>
+#include <ayaztub/data_structures/pool.h>
+#include <ayaztub/data_structures/ring_buffer.h>
+#include <ayaztub/data_structures/vector.h>
+
+#endif // __AYAZTUB__DATA_STRUCTURES_H__
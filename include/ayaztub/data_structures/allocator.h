@@ -0,0 +1,100 @@
+/**
+ * @file allocator.h
+ * @brief Allocator interface used to parameterize the data structures.
+ *
+ * Containers taking a `const struct allocator *` use it for every memory
+ * operation, so the same container code can run on top of malloc() or of an
+ * arena (see arena.h). A NULL allocator stands for the standard malloc()
+ * family.
+ *
+ * @code
+ * // usage example: a custom allocator counting the allocated bytes
+ * #include <ayaztub/data_structures/allocator.h>
+ *
+ * static size_t allocated = 0;
+ *
+ * static void *counting_realloc(void *ctx, void *ptr, size_t old_size,
+ *                               size_t new_size) {
+ *     (void)ctx;
+ *     allocated += new_size - old_size;
+ *     return realloc(ptr, new_size);
+ * }
+ *
+ * static void counting_free(void *ctx, void *ptr, size_t size) {
+ *     (void)ctx;
+ *     allocated -= size;
+ *     free(ptr);
+ * }
+ *
+ * const struct allocator counting_allocator = {
+ *     counting_realloc, counting_free, NULL
+ * };
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__ALLOCATOR_H__
+#define __AYAZTUB__DATA_STRUCTURES__ALLOCATOR_H__
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * @struct allocator
+ * @brief Memory allocator interface.
+ *
+ * Sizes are given back on reallocation and free so that allocators without
+ * per-allocation headers (arenas, pools) can be plugged in.
+ */
+struct allocator {
+    /**
+     * @brief Allocates (ptr NULL), grows or shrinks a memory block.
+     *
+     * Same semantics as realloc(): on failure NULL is returned and the
+     * original block is left untouched.
+     */
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    /**
+     * @brief Releases a memory block of the given size.
+     */
+    void (*free)(void *ctx, void *ptr, size_t size);
+    /**
+     * @brief Opaque context given back to both callbacks.
+     */
+    void *ctx;
+};
+
+/**
+ * @brief Allocates, resizes or frees memory with an allocator.
+ *
+ * @param allocator The allocator to use (NULL for the malloc() family).
+ * @param ptr The block to resize, or NULL to allocate a new one.
+ * @param old_size The current size of the block (0 if ptr is NULL).
+ * @param new_size The wanted size of the block.
+ * @return The new block, or NULL on failure.
+ */
+static inline void *allocator_realloc(const struct allocator *allocator,
+                                      void *ptr, size_t old_size,
+                                      size_t new_size) {
+    if (!allocator)
+        return realloc(ptr, new_size);
+    return allocator->realloc(allocator->ctx, ptr, old_size, new_size);
+}
+
+/**
+ * @brief Releases memory obtained with allocator_realloc().
+ *
+ * @param allocator The allocator the block comes from (NULL for malloc()).
+ * @param ptr The block to release (can be NULL).
+ * @param size The size of the block.
+ */
+static inline void allocator_free(const struct allocator *allocator,
+                                  void *ptr, size_t size) {
+    if (!ptr)
+        return;
+    if (!allocator)
+        free(ptr);
+    else
+        allocator->free(allocator->ctx, ptr, size);
+}
+
+#endif // __AYAZTUB__DATA_STRUCTURES__ALLOCATOR_H__
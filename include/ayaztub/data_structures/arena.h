@@ -0,0 +1,128 @@
+/**
+ * @file arena.h
+ * @brief Region-based (bump pointer) allocator in C99.
+ *
+ * An arena hands out memory by bumping a pointer in large blocks and frees
+ * everything at once with arena_reset() or arena_destroy(). The last
+ * allocation can be grown or shrunk in place, which makes amortized buffers
+ * (vectors, string builders) cheap on top of an arena.
+ *
+ * @warning An arena is NOT thread-safe. Use one arena per thread or protect it
+ * with your own lock.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/arena.h>
+ *
+ * int main(void) {
+ *     struct arena *arena = arena_create(0);
+ *     if (!arena)
+ *         return 1;
+ *
+ *     int *values = arena_alloc(arena, 100 * sizeof(int));
+ *     // ... use values, no need to free them one by one
+ *
+ *     arena_reset(arena); // every allocation is released at once
+ *     arena_destroy(arena);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__ARENA_H__
+#define __AYAZTUB__DATA_STRUCTURES__ARENA_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <ayaztub/data_structures/allocator.h>
+#include <stddef.h>
+
+/**
+ * @def ARENA_DEFAULT_BLOCK_SIZE
+ * @brief Size of the blocks of an arena created with a block size of 0.
+ */
+#ifndef ARENA_DEFAULT_BLOCK_SIZE
+#    define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#endif // ARENA_DEFAULT_BLOCK_SIZE
+
+/**
+ * @def ARENA_ALIGNMENT
+ * @brief Alignment of every arena allocation.
+ */
+#define ARENA_ALIGNMENT 16
+
+/**
+ * @struct arena
+ * @brief Opaque region allocator.
+ */
+struct arena;
+
+/**
+ * @brief Creates a new arena.
+ *
+ * @param block_size Size of the memory blocks requested to malloc() (0 for
+ * ARENA_DEFAULT_BLOCK_SIZE). Bigger allocations get a dedicated block.
+ * @return The new arena, or NULL on allocation failure.
+ */
+struct arena *arena_create(size_t block_size) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Destroys an arena and every allocation made from it.
+ *
+ * @param arena The arena to destroy (can be NULL).
+ */
+void arena_destroy(struct arena *arena);
+
+/**
+ * @brief Allocates memory from an arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return A pointer aligned on ARENA_ALIGNMENT, or NULL on failure.
+ */
+void *arena_alloc(struct arena *arena, size_t size) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Resizes an allocation made from an arena.
+ *
+ * The block is resized in place when it is the last allocation of the arena
+ * and the current memory block has enough room, otherwise a new block is
+ * allocated and the content copied.
+ *
+ * @param arena The arena the block comes from.
+ * @param ptr The block to resize (NULL to allocate a new one).
+ * @param old_size The current size of the block.
+ * @param new_size The wanted size.
+ * @return The resized block, or NULL on failure (ptr is left untouched).
+ */
+void *arena_realloc(struct arena *arena, void *ptr, size_t old_size,
+                    size_t new_size) NONNULL_POSITIONS(1) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Releases every allocation of an arena at once.
+ *
+ * The first memory block is kept to serve the next allocations.
+ *
+ * @param arena The arena to reset.
+ */
+void arena_reset(struct arena *arena) NONNULL;
+
+/**
+ * @brief Gets the total number of bytes reserved from malloc() by an arena.
+ *
+ * @param arena The arena to inspect.
+ * @return The sum of the sizes of the arena memory blocks.
+ */
+size_t arena_reserved(const struct arena *arena) NONNULL;
+
+/**
+ * @brief Gets an allocator interface backed by an arena.
+ *
+ * Frees through this allocator only give memory back when they target the
+ * last allocation of the arena.
+ *
+ * @param arena The arena to wrap.
+ * @return The allocator, valid as long as the arena is.
+ */
+struct allocator arena_allocator(struct arena *arena) NONNULL;
+
+#endif // __AYAZTUB__DATA_STRUCTURES__ARENA_H__
@@ -0,0 +1,431 @@
+/**
+ * @file bitset.h
+ * @brief Bitsets with SIMD set operations, rank/select, and compressed
+ * roaring bitmaps in C99.
+ *
+ * - `struct bitset`: dense, fixed size array of bits. The set operations
+ *   (and, or, xor, andnot) and population counts process 256 bits at once
+ *   with AVX2, or 128 bits with SSE2 (define BITSET_NO_SIMD to force the
+ *   portable scalar code). Set bits are iterated one word at a time with
+ *   count-trailing-zeros. An optional rank index answers rank and select
+ *   queries in O(1) and O(log n).
+ * - `struct roaring`: compressed bitmap of 32 bits integers (D. Lemire et
+ *   al., "Roaring Bitmaps"). The values are split on their 16 high bits into
+ *   containers, each one a sorted array of 16 bits values while sparse or a
+ *   65536 bits bitmap while dense, so sparse sets of millions of IDs stay
+ *   small and intersections and unions skip what cannot match.
+ *
+ * Both structures take an allocator at initialization (malloc() by default).
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/bitset.h>
+ *
+ * int main(void) {
+ *     struct bitset even, small;
+ *     if (!bitset_init(&even, 1000000, NULL))
+ *         return 1;
+ *     if (!bitset_init(&small, 1000000, NULL)) {
+ *         bitset_deinit(&even);
+ *         return 1;
+ *     }
+ *     for (size_t i = 0; i < 1000000; i += 2)
+ *         bitset_set(&even, i);
+ *     for (size_t i = 0; i < 100; i++)
+ *         bitset_set(&small, i);
+ *
+ *     bitset_and(&small, &even); // small even numbers
+ *     struct bitset_iter iter = bitset_iter(&small);
+ *     size_t index;
+ *     while (bitset_iter_next(&iter, &index))
+ *         printf("%zu\n", index);
+ *
+ *     bitset_deinit(&small);
+ *     bitset_deinit(&even);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__BITSET_H__
+#define __AYAZTUB__DATA_STRUCTURES__BITSET_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <ayaztub/data_structures/allocator.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def BITSET_NPOS
+ * @brief Index returned by the search functions when no bit is found.
+ */
+#define BITSET_NPOS SIZE_MAX
+
+/**
+ * @def BITSET_WORDS(bits)
+ * @brief Number of 64 bits words holding the given number of bits.
+ */
+#define BITSET_WORDS(bits) ((bits) / 64 + ((bits) % 64 != 0))
+
+// ---------- Bitset ---------- //
+
+/**
+ * @struct bitset
+ * @brief Dense array of bits, initialized with bitset_init().
+ *
+ * The bits past the size in the last word are always zero.
+ */
+struct bitset {
+    uint64_t *words; /**< Bits, bit i is bit (i % 64) of words[i / 64] */
+    size_t bits; /**< Number of bits */
+    uint64_t *ranks; /**< Internal use: rank index or NULL */
+    const struct allocator *allocator; /**< Internal use */
+};
+
+/**
+ * @brief Initializes a bitset with all its bits cleared.
+ *
+ * @param set The bitset to initialize.
+ * @param bits The number of bits.
+ * @param allocator The allocator (NULL for malloc()), which must outlive the
+ * bitset.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool bitset_init(struct bitset *set, size_t bits,
+                 const struct allocator *allocator)
+    NONNULL_POSITIONS(1) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Releases the memory of a bitset.
+ *
+ * @param set The bitset to release (empty afterwards).
+ */
+void bitset_deinit(struct bitset *set) NONNULL;
+
+/**
+ * @brief Changes the number of bits of a bitset. New bits are cleared.
+ *
+ * @param set The bitset.
+ * @param bits The new number of bits.
+ * @return `true` on success, `false` on allocation failure (the bitset is
+ * left unchanged).
+ */
+bool bitset_resize(struct bitset *set, size_t bits)
+    NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Sets a bit.
+ *
+ * @param set The bitset.
+ * @param index The index of the bit, lower than the size.
+ */
+static inline void bitset_set(struct bitset *set, size_t index) {
+    set->words[index / 64] |= UINT64_C(1) << (index % 64);
+}
+
+/**
+ * @brief Clears a bit.
+ *
+ * @param set The bitset.
+ * @param index The index of the bit, lower than the size.
+ */
+static inline void bitset_clear(struct bitset *set, size_t index) {
+    set->words[index / 64] &= ~(UINT64_C(1) << (index % 64));
+}
+
+/**
+ * @brief Flips a bit.
+ *
+ * @param set The bitset.
+ * @param index The index of the bit, lower than the size.
+ */
+static inline void bitset_flip(struct bitset *set, size_t index) {
+    set->words[index / 64] ^= UINT64_C(1) << (index % 64);
+}
+
+/**
+ * @brief Tests a bit.
+ *
+ * @param set The bitset.
+ * @param index The index of the bit, lower than the size.
+ * @return `true` if the bit is set, `false` otherwise.
+ */
+static inline bool bitset_test(const struct bitset *set, size_t index) {
+    return (set->words[index / 64] >> (index % 64)) & 1;
+}
+
+/**
+ * @brief Sets or clears every bit.
+ *
+ * @param set The bitset.
+ * @param value `true` to set the bits, `false` to clear them.
+ */
+void bitset_fill(struct bitset *set, bool value) NONNULL;
+
+/**
+ * @brief Counts the set bits.
+ *
+ * @param set The bitset.
+ * @return The number of set bits.
+ */
+size_t bitset_count(const struct bitset *set) NONNULL PURE;
+
+/**
+ * @brief Intersects a bitset with another one: dst &= src.
+ *
+ * Bits of dst past the size of src are cleared.
+ *
+ * @param dst The bitset to modify.
+ * @param src The other bitset.
+ */
+void bitset_and(struct bitset *dst, const struct bitset *src) NONNULL;
+
+/**
+ * @brief Merges another bitset into a bitset: dst |= src.
+ *
+ * Bits of src past the size of dst are ignored.
+ *
+ * @param dst The bitset to modify.
+ * @param src The other bitset.
+ */
+void bitset_or(struct bitset *dst, const struct bitset *src) NONNULL;
+
+/**
+ * @brief Computes the symmetric difference of two bitsets: dst ^= src.
+ *
+ * Bits of src past the size of dst are ignored.
+ *
+ * @param dst The bitset to modify.
+ * @param src The other bitset.
+ */
+void bitset_xor(struct bitset *dst, const struct bitset *src) NONNULL;
+
+/**
+ * @brief Removes the bits of another bitset from a bitset: dst &= ~src.
+ *
+ * @param dst The bitset to modify.
+ * @param src The other bitset.
+ */
+void bitset_andnot(struct bitset *dst, const struct bitset *src) NONNULL;
+
+/**
+ * @brief Counts the bits set in both bitsets, without modifying them.
+ *
+ * @param a The first bitset.
+ * @param b The second bitset.
+ * @return The number of bits of the intersection.
+ */
+size_t bitset_and_count(const struct bitset *a, const struct bitset *b)
+    NONNULL PURE;
+
+/**
+ * @brief Finds the first set bit at or after an index.
+ *
+ * @param set The bitset.
+ * @param from The index to start from.
+ * @return The index of the bit, or BITSET_NPOS if there is none.
+ */
+size_t bitset_next(const struct bitset *set, size_t from) NONNULL PURE;
+
+/**
+ * @brief Builds (or rebuilds) the rank index of a bitset.
+ *
+ * The index makes bitset_rank() O(1) and bitset_select() O(log n). It holds
+ * one counter per 512 bits.
+ *
+ * @param set The bitset.
+ * @return `true` on success, `false` on allocation failure.
+ *
+ * @warning Modifying the bitset makes the index stale: rebuild it before the
+ * next rank or select query. bitset_resize() drops it.
+ */
+bool bitset_build_rank(struct bitset *set) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Counts the set bits before an index.
+ *
+ * @param set The bitset.
+ * @param index The index, at most the size.
+ * @return The number of set bits in [0, index).
+ */
+size_t bitset_rank(const struct bitset *set, size_t index) NONNULL PURE;
+
+/**
+ * @brief Finds the set bit of a given rank.
+ *
+ * @param set The bitset.
+ * @param rank The rank of the bit (0 for the first set bit).
+ * @return The index of the bit, or BITSET_NPOS if there are not enough set
+ * bits.
+ */
+size_t bitset_select(const struct bitset *set, size_t rank) NONNULL PURE;
+
+/**
+ * @struct bitset_iter
+ * @brief Iterator over the set bits of a bitset, in increasing order.
+ */
+struct bitset_iter {
+    const uint64_t *words; /**< Internal use */
+    size_t word_count; /**< Internal use */
+    size_t position; /**< Internal use: index of the current word */
+    uint64_t word; /**< Internal use: bits left in the current word */
+};
+
+/**
+ * @brief Starts an iteration over the set bits of a bitset.
+ *
+ * @param set The bitset, which must not be modified during the iteration.
+ * @return The iterator.
+ */
+static inline struct bitset_iter bitset_iter(const struct bitset *set) {
+    struct bitset_iter iter = { set->words, BITSET_WORDS(set->bits), 0,
+                                set->bits ? set->words[0] : 0 };
+    return iter;
+}
+
+/**
+ * @brief Gets the next set bit of an iteration.
+ *
+ * @param iter The iterator.
+ * @param index Output index of the bit.
+ * @return `true` if a bit was found, `false` at the end of the iteration.
+ */
+static inline bool bitset_iter_next(struct bitset_iter *iter, size_t *index) {
+    while (!iter->word) {
+        if (iter->position + 1 >= iter->word_count)
+            return false;
+        iter->word = iter->words[++iter->position];
+    }
+    *index = iter->position * 64 + (size_t)__builtin_ctzll(iter->word);
+    iter->word &= iter->word - 1;
+    return true;
+}
+
+// ---------- Roaring Bitmap ---------- //
+
+struct roaring_container;
+
+/**
+ * @struct roaring
+ * @brief Compressed bitmap of 32 bits integers, initialized with
+ * roaring_init().
+ */
+struct roaring {
+    struct roaring_container *containers; /**< Internal use: sorted by key */
+    size_t count; /**< Internal use: number of containers */
+    size_t capacity; /**< Internal use */
+    const struct allocator *allocator; /**< Internal use */
+};
+
+/**
+ * @brief Initializes an empty roaring bitmap.
+ *
+ * @param set The bitmap to initialize.
+ * @param allocator The allocator (NULL for malloc()), which must outlive the
+ * bitmap.
+ */
+void roaring_init(struct roaring *set, const struct allocator *allocator)
+    NONNULL_POSITIONS(1);
+
+/**
+ * @brief Releases the memory of a roaring bitmap.
+ *
+ * @param set The bitmap to release (empty and reusable afterwards).
+ */
+void roaring_deinit(struct roaring *set) NONNULL;
+
+/**
+ * @brief Adds a value.
+ *
+ * @param set The bitmap.
+ * @param value The value to add.
+ * @return `true` on success (including if the value was already present),
+ * `false` on allocation failure.
+ */
+bool roaring_add(struct roaring *set, uint32_t value)
+    NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Removes a value.
+ *
+ * @param set The bitmap.
+ * @param value The value to remove.
+ * @return `true` if the value was present, `false` otherwise.
+ */
+bool roaring_remove(struct roaring *set, uint32_t value) NONNULL;
+
+/**
+ * @brief Checks whether a value is present.
+ *
+ * @param set The bitmap.
+ * @param value The value.
+ * @return `true` if the value is present, `false` otherwise.
+ */
+bool roaring_contains(const struct roaring *set, uint32_t value) NONNULL PURE;
+
+/**
+ * @brief Counts the values.
+ *
+ * @param set The bitmap.
+ * @return The number of values.
+ */
+uint64_t roaring_count(const struct roaring *set) NONNULL PURE;
+
+/**
+ * @brief Computes the intersection of two roaring bitmaps.
+ *
+ * @param dst The initialized bitmap receiving the result (its previous values
+ * are dropped). It must be neither a nor b.
+ * @param a The first bitmap.
+ * @param b The second bitmap.
+ * @return `true` on success, `false` on allocation failure (dst is then
+ * empty).
+ */
+bool roaring_and(struct roaring *dst, const struct roaring *a,
+                 const struct roaring *b) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Computes the union of two roaring bitmaps.
+ *
+ * @param dst The initialized bitmap receiving the result (its previous values
+ * are dropped). It must be neither a nor b.
+ * @param a The first bitmap.
+ * @param b The second bitmap.
+ * @return `true` on success, `false` on allocation failure (dst is then
+ * empty).
+ */
+bool roaring_or(struct roaring *dst, const struct roaring *a,
+                const struct roaring *b) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @struct roaring_iter
+ * @brief Iterator over the values of a roaring bitmap, in increasing order.
+ */
+struct roaring_iter {
+    const struct roaring *set; /**< Internal use */
+    size_t container; /**< Internal use */
+    uint32_t position; /**< Internal use */
+};
+
+/**
+ * @brief Starts an iteration over the values of a roaring bitmap.
+ *
+ * @param set The bitmap, which must not be modified during the iteration.
+ * @return The iterator.
+ */
+static inline struct roaring_iter roaring_iter(const struct roaring *set) {
+    struct roaring_iter iter = { set, 0, 0 };
+    return iter;
+}
+
+/**
+ * @brief Gets the next value of an iteration.
+ *
+ * @param iter The iterator.
+ * @param value Output value.
+ * @return `true` if a value was found, `false` at the end of the iteration.
+ */
+bool roaring_iter_next(struct roaring_iter *iter, uint32_t *value) NONNULL;
+
+#endif // __AYAZTUB__DATA_STRUCTURES__BITSET_H__
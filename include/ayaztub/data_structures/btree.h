@@ -0,0 +1,637 @@
+/**
+ * @file btree.h
+ * @brief Type-safe in-memory B+-trees (ordered maps) in C99.
+ *
+ * The BTREE_DECL() macro generates a B+-tree structure and its functions for
+ * a given key and value type, in the same way hashmap.h generates its hash
+ * maps.
+ *
+ * Nodes hold up to BTREE_ORDER() sorted keys in a contiguous array sized to
+ * about BTREE_NODE_BYTES (a few cache lines), so a lookup touches one node per
+ * level instead of one per key as in a binary search tree. Inside a node, the
+ * search is a branchless binary search: the comparison result selects the
+ * next position with a conditional move instead of a hard to predict branch.
+ * Values are only stored in the leaves, which are linked in key order: range
+ * scans walk contiguous arrays from leaf to leaf.
+ *
+ * - Insertions split full nodes on the way down, removals borrow from or
+ *   merge with a sibling on the way back up, so the tree stays balanced.
+ * - Sorted input is bulk loaded bottom-up in O(n) into as few leaves as
+ *   possible, filled evenly: at least half full, nearly full for large inputs.
+ * - Iterators start at the first key or at the first key not less than a
+ *   given key (range queries).
+ *
+ * @warning Pointers to keys or values and iterators are invalidated by any
+ * insertion or removal.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/btree.h>
+ *
+ * BTREE_DECL(uint64_t, double, u64tree, btree_default_cmp)
+ *
+ * int main(void) {
+ *     struct u64tree tree;
+ *     u64tree_init(&tree, NULL);
+ *
+ *     for (uint64_t i = 0; i < 1000; i++) {
+ *         if (!u64tree_put(&tree, i * 3, i / 2.0)) {
+ *             u64tree_deinit(&tree);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     // values of the keys in [100, 130)
+ *     struct u64tree_iter iter = u64tree_lower_bound(&tree, 100);
+ *     const uint64_t *key;
+ *     double *value;
+ *     while (u64tree_iter_next(&iter, &key, &value) && *key < 130)
+ *         printf("%lu: %f\n", (unsigned long)*key, *value);
+ *
+ *     u64tree_deinit(&tree);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__BTREE_H__
+#define __AYAZTUB__DATA_STRUCTURES__BTREE_H__
+
+#include <ayaztub/data_structures/allocator.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @def BTREE_NODE_BYTES
+ * @brief Approximate size in bytes of the key and value (or child) arrays of
+ * a node.
+ */
+#ifndef BTREE_NODE_BYTES
+#    define BTREE_NODE_BYTES 512
+#endif // BTREE_NODE_BYTES
+
+/**
+ * @def BTREE_ORDER(key_size, value_size)
+ * @brief Maximum number of keys of a node (at least 4).
+ */
+#define BTREE_ORDER(key_size, value_size)                                      \
+    (BTREE_NODE_BYTES / ((key_size) + BTREE_MAX(value_size, sizeof(void *)))   \
+             < 4                                                               \
+         ? 4                                                                   \
+         : BTREE_NODE_BYTES                                                    \
+             / ((key_size) + BTREE_MAX(value_size, sizeof(void *))))
+
+#define BTREE_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/**
+ * @def btree_default_cmp(a, b)
+ * @brief Three-way comparison of scalar keys.
+ */
+#define btree_default_cmp(a, b) (((a) > (b)) - ((a) < (b)))
+
+/**
+ * @def btree_string_cmp(a, b)
+ * @brief Three-way comparison of null terminated string keys.
+ */
+#define btree_string_cmp(a, b) strcmp((a), (b))
+
+/**
+ * @def BTREE_DECL(key_type, value_type, name, cmp_func)
+ * @brief Macro to declare a B+-tree type and its functions.
+ *
+ * @param key_type The type of the keys.
+ * @param value_type The type of the values.
+ * @param name The name of the tree structure and the prefix of its
+ * functions.
+ * @param cmp_func A function or macro `int cmp_func(key_type a, key_type b)`
+ * returning a negative value, 0 or a positive value if a is respectively
+ * before, equal to or after b.
+ *
+ * Example usage:
+ * @code
+ * BTREE_DECL(uint64_t, double, u64tree, btree_default_cmp)
+ * // create the following structures:
+ * // struct u64tree_entry { uint64_t key; double value; };
+ * // struct u64tree { size_t size; unsigned height; ... };
+ * // struct u64tree_iter { ... };
+ * // and the following functions:
+ * // void u64tree_init(struct u64tree *tree,
+ * //                   const struct allocator *allocator);
+ * // void u64tree_deinit(struct u64tree *tree);
+ * // double *u64tree_find(const struct u64tree *tree, uint64_t key);
+ * // bool u64tree_contains(const struct u64tree *tree, uint64_t key);
+ * // double *u64tree_emplace(struct u64tree *tree, uint64_t key,
+ * //                         bool *inserted);
+ * // bool u64tree_put(struct u64tree *tree, uint64_t key, double value);
+ * // bool u64tree_remove(struct u64tree *tree, uint64_t key, double *value);
+ * // bool u64tree_bulk_load(struct u64tree *tree,
+ * //                        const struct u64tree_entry *entries,
+ * //                        size_t count);
+ * // struct u64tree_iter u64tree_first(const struct u64tree *tree);
+ * // struct u64tree_iter u64tree_lower_bound(const struct u64tree *tree,
+ * //                                         uint64_t key);
+ * // bool u64tree_iter_next(struct u64tree_iter *iter, const uint64_t **key,
+ * //                        double **value);
+ * @endcode
+ *
+ * @note The allocator given to init is kept by pointer and must outlive the
+ * tree. Functions return false (or NULL) on allocation failure and leave the
+ * tree valid. The value of a key inserted by emplace is uninitialized.
+ */
+#define BTREE_DECL(key_type, value_type, name, cmp_func)                       \
+    typedef key_type name##_key_t;                                             \
+    typedef value_type name##_value_t;                                         \
+                                                                               \
+    enum {                                                                     \
+        name##_order = BTREE_ORDER(sizeof(key_type), sizeof(value_type)),      \
+        name##_min_keys = name##_order / 2                                     \
+    };                                                                         \
+                                                                               \
+    struct name##_entry {                                                      \
+        name##_key_t key;                                                      \
+        name##_value_t value;                                                  \
+    };                                                                         \
+                                                                               \
+    struct name##_node {                                                       \
+        unsigned count;                                                        \
+        bool leaf;                                                             \
+        struct name##_node *next; /* next leaf in key order */                 \
+        name##_key_t keys[name##_order];                                       \
+        union {                                                                \
+            name##_value_t values[name##_order];                               \
+            struct name##_node *children[name##_order + 1];                    \
+        } u;                                                                   \
+    };                                                                         \
+                                                                               \
+    struct name {                                                              \
+        struct name##_node *root;                                              \
+        size_t size;                                                           \
+        unsigned height;                                                       \
+        const struct allocator *allocator;                                     \
+    };                                                                         \
+                                                                               \
+    struct name##_iter {                                                       \
+        struct name##_node *leaf;                                              \
+        unsigned index;                                                        \
+    };                                                                         \
+                                                                               \
+    static inline void name##_init(struct name *tree,                          \
+                                   const struct allocator *allocator) {        \
+        tree->root = NULL;                                                     \
+        tree->size = 0;                                                        \
+        tree->height = 0;                                                      \
+        tree->allocator = allocator;                                           \
+    }                                                                          \
+                                                                               \
+    static inline struct name##_node *name##_node_new(struct name *tree,       \
+                                                      bool leaf) {             \
+        struct name##_node *node = allocator_realloc(                          \
+            tree->allocator, NULL, 0, sizeof(struct name##_node));             \
+        if (node) {                                                            \
+            node->count = 0;                                                   \
+            node->leaf = leaf;                                                 \
+            node->next = NULL;                                                 \
+        }                                                                      \
+        return node;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_node_free(struct name *tree,                     \
+                                        struct name##_node *node) {            \
+        allocator_free(tree->allocator, node, sizeof(struct name##_node));     \
+    }                                                                          \
+                                                                               \
+    static inline void name##_free_subtree(struct name *tree,                  \
+                                           struct name##_node *node) {         \
+        if (!node->leaf) {                                                     \
+            for (unsigned i = 0; i <= node->count; i++)                        \
+                name##_free_subtree(tree, node->u.children[i]);                \
+        }                                                                      \
+        name##_node_free(tree, node);                                          \
+    }                                                                          \
+                                                                               \
+    static inline void name##_deinit(struct name *tree) {                      \
+        if (tree->root)                                                        \
+            name##_free_subtree(tree, tree->root);                             \
+        name##_init(tree, tree->allocator);                                    \
+    }                                                                          \
+                                                                               \
+    /* Index of the first key not less than key (branchless search). */        \
+    static inline unsigned name##_lower_index(const struct name##_node *node,  \
+                                              name##_key_t key) {              \
+        unsigned low = 0;                                                      \
+        unsigned count = node->count;                                          \
+        if (!count)                                                            \
+            return 0;                                                          \
+        while (count > 1) {                                                    \
+            unsigned half = count / 2;                                         \
+            low = cmp_func(node->keys[low + half], key) < 0 ? low + half       \
+                                                             : low;            \
+            count -= half;                                                     \
+        }                                                                      \
+        return low + (cmp_func(node->keys[low], key) < 0);                     \
+    }                                                                          \
+                                                                               \
+    /* Index of the first key greater than key: the child holding key. */      \
+    static inline unsigned name##_upper_index(const struct name##_node *node,  \
+                                              name##_key_t key) {              \
+        unsigned low = 0;                                                      \
+        unsigned count = node->count;                                          \
+        if (!count)                                                            \
+            return 0;                                                          \
+        while (count > 1) {                                                    \
+            unsigned half = count / 2;                                         \
+            low = cmp_func(node->keys[low + half], key) <= 0 ? low + half      \
+                                                              : low;           \
+            count -= half;                                                     \
+        }                                                                      \
+        return low + (cmp_func(node->keys[low], key) <= 0);                    \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t *name##_find(const struct name *tree,         \
+                                              name##_key_t key) {              \
+        struct name##_node *node = tree->root;                                 \
+        if (!node)                                                             \
+            return NULL;                                                       \
+        while (!node->leaf)                                                    \
+            node = node->u.children[name##_upper_index(node, key)];            \
+        unsigned index = name##_lower_index(node, key);                        \
+        if (index < node->count && cmp_func(node->keys[index], key) == 0)      \
+            return &node->u.values[index];                                     \
+        return NULL;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_contains(const struct name *tree,                \
+                                       name##_key_t key) {                     \
+        return name##_find(tree, key) != NULL;                                 \
+    }                                                                          \
+                                                                               \
+    /* Splits the full child at index in two, adding a key to parent. */       \
+    static inline bool name##_split_child(struct name *tree,                   \
+                                          struct name##_node *parent,          \
+                                          unsigned index) {                    \
+        struct name##_node *child = parent->u.children[index];                 \
+        struct name##_node *right = name##_node_new(tree, child->leaf);        \
+        if (!right)                                                            \
+            return false;                                                      \
+                                                                               \
+        unsigned mid = name##_order / 2;                                       \
+        name##_key_t separator;                                                \
+        if (child->leaf) {                                                     \
+            right->count = name##_order - mid;                                 \
+            memcpy(right->keys, child->keys + mid,                             \
+                   right->count * sizeof(name##_key_t));                       \
+            memcpy(right->u.values, child->u.values + mid,                     \
+                   right->count * sizeof(name##_value_t));                     \
+            right->next = child->next;                                         \
+            child->next = right;                                               \
+            separator = right->keys[0];                                        \
+        } else {                                                               \
+            right->count = name##_order - mid - 1;                             \
+            memcpy(right->keys, child->keys + mid + 1,                         \
+                   right->count * sizeof(name##_key_t));                       \
+            memcpy(right->u.children, child->u.children + mid + 1,             \
+                   (right->count + 1) * sizeof(struct name##_node *));         \
+            separator = child->keys[mid];                                      \
+        }                                                                      \
+        child->count = mid;                                                    \
+                                                                               \
+        memmove(parent->keys + index + 1, parent->keys + index,                \
+                (parent->count - index) * sizeof(name##_key_t));               \
+        memmove(parent->u.children + index + 2,                                \
+                parent->u.children + index + 1,                                \
+                (parent->count - index) * sizeof(struct name##_node *));       \
+        parent->keys[index] = separator;                                       \
+        parent->u.children[index + 1] = right;                                 \
+        parent->count++;                                                       \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t *name##_emplace(                              \
+        struct name *tree, name##_key_t key, bool *inserted) {                 \
+        name##_value_t *found = name##_find(tree, key);                        \
+        if (found) {                                                           \
+            if (inserted)                                                      \
+                *inserted = false;                                             \
+            return found;                                                      \
+        }                                                                      \
+                                                                               \
+        if (!tree->root) {                                                     \
+            tree->root = name##_node_new(tree, true);                          \
+            if (!tree->root)                                                   \
+                return NULL;                                                   \
+            tree->height = 1;                                                  \
+        }                                                                      \
+        if (tree->root->count == name##_order) {                               \
+            struct name##_node *root = name##_node_new(tree, false);           \
+            if (!root)                                                         \
+                return NULL;                                                   \
+            root->u.children[0] = tree->root;                                  \
+            if (!name##_split_child(tree, root, 0)) {                          \
+                name##_node_free(tree, root);                                  \
+                return NULL;                                                   \
+            }                                                                  \
+            tree->root = root;                                                 \
+            tree->height++;                                                    \
+        }                                                                      \
+                                                                               \
+        /* split full nodes on the way down: a parent always has room */       \
+        struct name##_node *node = tree->root;                                 \
+        while (!node->leaf) {                                                  \
+            unsigned index = name##_upper_index(node, key);                    \
+            if (node->u.children[index]->count == name##_order) {              \
+                if (!name##_split_child(tree, node, index))                    \
+                    return NULL;                                               \
+                if (cmp_func(node->keys[index], key) <= 0)                     \
+                    index++;                                                   \
+            }                                                                  \
+            node = node->u.children[index];                                    \
+        }                                                                      \
+                                                                               \
+        unsigned index = name##_lower_index(node, key);                        \
+        memmove(node->keys + index + 1, node->keys + index,                    \
+                (node->count - index) * sizeof(name##_key_t));                 \
+        memmove(node->u.values + index + 1, node->u.values + index,            \
+                (node->count - index) * sizeof(name##_value_t));               \
+        node->keys[index] = key;                                               \
+        node->count++;                                                         \
+        tree->size++;                                                          \
+        if (inserted)                                                          \
+            *inserted = true;                                                  \
+        return &node->u.values[index];                                         \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_put(struct name *tree, name##_key_t key,         \
+                                  name##_value_t value) {                      \
+        name##_value_t *slot = name##_emplace(tree, key, NULL);                \
+        if (!slot)                                                             \
+            return false;                                                      \
+        *slot = value;                                                         \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_borrow_left(struct name##_node *parent,          \
+                                          unsigned index) {                    \
+        struct name##_node *child = parent->u.children[index];                 \
+        struct name##_node *left = parent->u.children[index - 1];              \
+        memmove(child->keys + 1, child->keys,                                  \
+                child->count * sizeof(name##_key_t));                          \
+        if (child->leaf) {                                                     \
+            memmove(child->u.values + 1, child->u.values,                      \
+                    child->count * sizeof(name##_value_t));                    \
+            child->keys[0] = left->keys[left->count - 1];                      \
+            child->u.values[0] = left->u.values[left->count - 1];              \
+            parent->keys[index - 1] = child->keys[0];                          \
+        } else {                                                               \
+            memmove(child->u.children + 1, child->u.children,                  \
+                    (child->count + 1) * sizeof(struct name##_node *));        \
+            child->keys[0] = parent->keys[index - 1];                          \
+            child->u.children[0] = left->u.children[left->count];              \
+            parent->keys[index - 1] = left->keys[left->count - 1];             \
+        }                                                                      \
+        child->count++;                                                        \
+        left->count--;                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void name##_borrow_right(struct name##_node *parent,         \
+                                           unsigned index) {                   \
+        struct name##_node *child = parent->u.children[index];                 \
+        struct name##_node *right = parent->u.children[index + 1];             \
+        if (child->leaf) {                                                     \
+            child->keys[child->count] = right->keys[0];                        \
+            child->u.values[child->count] = right->u.values[0];                \
+            memmove(right->u.values, right->u.values + 1,                      \
+                    (right->count - 1) * sizeof(name##_value_t));              \
+            memmove(right->keys, right->keys + 1,                              \
+                    (right->count - 1) * sizeof(name##_key_t));                \
+            parent->keys[index] = right->keys[0];                              \
+        } else {                                                               \
+            child->keys[child->count] = parent->keys[index];                   \
+            child->u.children[child->count + 1] = right->u.children[0];        \
+            parent->keys[index] = right->keys[0];                              \
+            memmove(right->keys, right->keys + 1,                              \
+                    (right->count - 1) * sizeof(name##_key_t));                \
+            memmove(right->u.children, right->u.children + 1,                  \
+                    right->count * sizeof(struct name##_node *));              \
+        }                                                                      \
+        child->count++;                                                        \
+        right->count--;                                                        \
+    }                                                                          \
+                                                                               \
+    /* Merges the children index and index + 1 of parent. */                   \
+    static inline void name##_merge(struct name *tree,                         \
+                                    struct name##_node *parent,                \
+                                    unsigned index) {                          \
+        struct name##_node *left = parent->u.children[index];                  \
+        struct name##_node *right = parent->u.children[index + 1];             \
+        if (left->leaf) {                                                      \
+            memcpy(left->keys + left->count, right->keys,                      \
+                   right->count * sizeof(name##_key_t));                       \
+            memcpy(left->u.values + left->count, right->u.values,              \
+                   right->count * sizeof(name##_value_t));                     \
+            left->count += right->count;                                       \
+            left->next = right->next;                                          \
+        } else {                                                               \
+            left->keys[left->count] = parent->keys[index];                     \
+            memcpy(left->keys + left->count + 1, right->keys,                  \
+                   right->count * sizeof(name##_key_t));                       \
+            memcpy(left->u.children + left->count + 1, right->u.children,      \
+                   (right->count + 1) * sizeof(struct name##_node *));         \
+            left->count += right->count + 1;                                   \
+        }                                                                      \
+        name##_node_free(tree, right);                                         \
+                                                                               \
+        memmove(parent->keys + index, parent->keys + index + 1,                \
+                (parent->count - index - 1) * sizeof(name##_key_t));           \
+        memmove(parent->u.children + index + 1,                                \
+                parent->u.children + index + 2,                                \
+                (parent->count - index - 1) * sizeof(struct name##_node *));   \
+        parent->count--;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void name##_rebalance(struct name *tree,                     \
+                                        struct name##_node *parent,            \
+                                        unsigned index) {                      \
+        if (index > 0                                                          \
+            && parent->u.children[index - 1]->count > name##_min_keys)         \
+            name##_borrow_left(parent, index);                                 \
+        else if (index < parent->count                                         \
+                 && parent->u.children[index + 1]->count > name##_min_keys)    \
+            name##_borrow_right(parent, index);                                \
+        else                                                                   \
+            name##_merge(tree, parent, index > 0 ? index - 1 : index);         \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_remove_from(struct name *tree,                   \
+                                          struct name##_node *node,            \
+                                          name##_key_t key,                    \
+                                          name##_value_t *value) {             \
+        if (node->leaf) {                                                      \
+            unsigned index = name##_lower_index(node, key);                    \
+            if (index >= node->count                                           \
+                || cmp_func(node->keys[index], key) != 0)                      \
+                return false;                                                  \
+            if (value)                                                         \
+                *value = node->u.values[index];                                \
+            memmove(node->keys + index, node->keys + index + 1,                \
+                    (node->count - index - 1) * sizeof(name##_key_t));         \
+            memmove(node->u.values + index, node->u.values + index + 1,        \
+                    (node->count - index - 1) * sizeof(name##_value_t));       \
+            node->count--;                                                     \
+            return true;                                                       \
+        }                                                                      \
+                                                                               \
+        unsigned index = name##_upper_index(node, key);                        \
+        if (!name##_remove_from(tree, node->u.children[index], key, value))    \
+            return false;                                                      \
+        if (node->u.children[index]->count < name##_min_keys)                  \
+            name##_rebalance(tree, node, index);                               \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_remove(struct name *tree, name##_key_t key,      \
+                                     name##_value_t *value) {                  \
+        if (!tree->root || !name##_remove_from(tree, tree->root, key, value))  \
+            return false;                                                      \
+        tree->size--;                                                          \
+                                                                               \
+        struct name##_node *root = tree->root;                                 \
+        if (!root->leaf && !root->count) {                                     \
+            tree->root = root->u.children[0];                                  \
+            tree->height--;                                                    \
+            name##_node_free(tree, root);                                      \
+        } else if (root->leaf && !root->count) {                               \
+            tree->root = NULL;                                                 \
+            tree->height = 0;                                                  \
+            name##_node_free(tree, root);                                      \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline name##_key_t name##_first_key(                               \
+        const struct name##_node *node) {                                      \
+        while (!node->leaf)                                                    \
+            node = node->u.children[0];                                        \
+        return node->keys[0];                                                  \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_bulk_load(struct name *tree,                     \
+                                        const struct name##_entry *entries,    \
+                                        size_t count) {                        \
+        if (tree->root)                                                        \
+            return false;                                                      \
+        for (size_t i = 1; i < count; i++) {                                   \
+            if (cmp_func(entries[i - 1].key, entries[i].key) >= 0)             \
+                return false;                                                  \
+        }                                                                      \
+        if (!count)                                                            \
+            return true;                                                       \
+                                                                               \
+        /* nodes of the level being built, parents overwrite children */       \
+        size_t nodes = (count + name##_order - 1) / name##_order;              \
+        struct name##_node **level = allocator_realloc(                        \
+            tree->allocator, NULL, 0, nodes * sizeof(struct name##_node *));   \
+        if (!level)                                                            \
+            return false;                                                      \
+                                                                               \
+        /* leaves, filled evenly so that every leaf is at least half full */   \
+        struct name##_node *previous = NULL;                                   \
+        for (size_t i = 0, start = 0; i < nodes; i++) {                        \
+            struct name##_node *leaf = name##_node_new(tree, true);            \
+            if (!leaf) {                                                       \
+                for (size_t j = 0; j < i; j++)                                 \
+                    name##_node_free(tree, level[j]);                          \
+                allocator_free(tree->allocator, level,                         \
+                               nodes * sizeof(struct name##_node *));          \
+                return false;                                                  \
+            }                                                                  \
+            leaf->count = (unsigned)(count / nodes + (i < count % nodes));     \
+            for (unsigned j = 0; j < leaf->count; j++) {                       \
+                leaf->keys[j] = entries[start + j].key;                        \
+                leaf->u.values[j] = entries[start + j].value;                  \
+            }                                                                  \
+            start += leaf->count;                                              \
+            if (previous)                                                      \
+                previous->next = leaf;                                         \
+            previous = leaf;                                                   \
+            level[i] = leaf;                                                   \
+        }                                                                      \
+        unsigned height = 1;                                                   \
+                                                                               \
+        size_t children = nodes;                                               \
+        while (children > 1) {                                                 \
+            size_t parents = (children + name##_order) / (name##_order + 1);   \
+            size_t start = 0;                                                  \
+            for (size_t i = 0; i < parents; i++) {                             \
+                struct name##_node *parent = name##_node_new(tree, false);     \
+                if (!parent) {                                                 \
+                    for (size_t j = 0; j < i; j++)                             \
+                        name##_free_subtree(tree, level[j]);                   \
+                    for (size_t j = start; j < children; j++)                  \
+                        name##_free_subtree(tree, level[j]);                   \
+                    allocator_free(tree->allocator, level,                     \
+                                   nodes * sizeof(struct name##_node *));      \
+                    return false;                                              \
+                }                                                              \
+                size_t fanout =                                                \
+                    children / parents + (i < children % parents);             \
+                for (size_t j = 0; j < fanout; j++) {                          \
+                    parent->u.children[j] = level[start + j];                  \
+                    if (j)                                                     \
+                        parent->keys[j - 1] =                                  \
+                            name##_first_key(level[start + j]);                \
+                }                                                              \
+                parent->count = (unsigned)fanout - 1;                          \
+                start += fanout;                                               \
+                level[i] = parent;                                             \
+            }                                                                  \
+            children = parents;                                                \
+            height++;                                                          \
+        }                                                                      \
+                                                                               \
+        tree->root = level[0];                                                 \
+        tree->height = height;                                                 \
+        tree->size = count;                                                    \
+        allocator_free(tree->allocator, level,                                 \
+                       nodes * sizeof(struct name##_node *));                  \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline struct name##_iter name##_first(const struct name *tree) {   \
+        struct name##_iter iter = { tree->root, 0 };                           \
+        while (iter.leaf && !iter.leaf->leaf)                                  \
+            iter.leaf = iter.leaf->u.children[0];                              \
+        return iter;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline struct name##_iter name##_lower_bound(                       \
+        const struct name *tree, name##_key_t key) {                           \
+        struct name##_iter iter = { tree->root, 0 };                           \
+        if (!iter.leaf)                                                        \
+            return iter;                                                       \
+        while (!iter.leaf->leaf)                                               \
+            iter.leaf = iter.leaf->u.children[name##_upper_index(iter.leaf,    \
+                                                                 key)];        \
+        iter.index = name##_lower_index(iter.leaf, key);                       \
+        return iter;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_iter_next(struct name##_iter *iter,              \
+                                        const name##_key_t **key,              \
+                                        name##_value_t **value) {              \
+        while (iter->leaf && iter->index >= iter->leaf->count) {               \
+            iter->leaf = iter->leaf->next;                                     \
+            iter->index = 0;                                                   \
+        }                                                                      \
+        if (!iter->leaf)                                                       \
+            return false;                                                      \
+        if (key)                                                               \
+            *key = &iter->leaf->keys[iter->index];                             \
+        if (value)                                                             \
+            *value = &iter->leaf->u.values[iter->index];                       \
+        iter->index++;                                                         \
+        return true;                                                           \
+    }
+
+#endif // __AYAZTUB__DATA_STRUCTURES__BTREE_H__
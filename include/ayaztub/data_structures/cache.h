@@ -0,0 +1,191 @@
+/**
+ * @file cache.h
+ * @brief Bounded thread-safe cache with CLOCK or S3-FIFO eviction in C99.
+ *
+ * This library provides a cache from byte string keys to byte string values
+ * (both copied), bounded by the total weight of its entries.
+ *
+ * - The cache is split in shards, chosen by the key hash, each with its own
+ *   reader-biased lock (see sync.h): lookups of different keys rarely touch
+ *   the same lock, and lookups never block each other.
+ * - A hit only sets a small per-entry frequency counter with a relaxed atomic
+ *   store, under the read lock. Unlike LRU, nothing is moved on hits: entries
+ *   are only reordered by the eviction, under the write lock.
+ * - `CACHE_CLOCK`: second chance (CLOCK) eviction. The oldest entry is
+ *   evicted unless it was hit since it was last examined, in which case it is
+ *   given another round.
+ * - `CACHE_S3FIFO`: S3-FIFO eviction (J. Yang et al., "FIFO queues are all
+ *   you need for cache eviction"). New entries go to a small FIFO queue (10%
+ *   of the weight), and are only promoted to the main queue if hit before
+ *   leaving it. Keys recently evicted from the small queue are remembered
+ *   (ghost entries) and go straight to the main queue when inserted again.
+ *   This keeps one-hit wonders (scans) from flushing the cache.
+ * - Every entry has a weight (by default its key and value sizes). Inserting
+ *   evicts entries until the weight of the shard fits its share of the
+ *   capacity.
+ * - Hits, misses, insertions and evictions are counted, and can be read with
+ *   cache_stats_read() or emitted through the logger with cache_log_stats().
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/cache.h>
+ *
+ * int main(void) {
+ *     struct cache *cache = cache_create(1 << 20, 0, CACHE_S3FIFO);
+ *     if (!cache)
+ *         return 1;
+ *
+ *     if (!cache_put(cache, "answer", 6, "42", 3, 0))
+ *         return 1;
+ *
+ *     char value[16];
+ *     size_t size = sizeof(value);
+ *     if (cache_get(cache, "answer", 6, value, &size))
+ *         printf("answer = %s\n", value);
+ *
+ *     cache_log_stats(cache, LOG_INFO, "answers");
+ *     cache_destroy(cache);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__CACHE_H__
+#define __AYAZTUB__DATA_STRUCTURES__CACHE_H__
+
+#include <ayaztub/core_utils/logger.h>
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def CACHE_DEFAULT_SHARDS
+ * @brief Number of shards used when cache_create() is given 0.
+ */
+#ifndef CACHE_DEFAULT_SHARDS
+#    define CACHE_DEFAULT_SHARDS 16
+#endif // CACHE_DEFAULT_SHARDS
+
+/**
+ * @def CACHE_GHOST_SLOTS
+ * @brief Number of remembered evicted keys per shard (S3-FIFO, power of two).
+ */
+#ifndef CACHE_GHOST_SLOTS
+#    define CACHE_GHOST_SLOTS 4096
+#endif // CACHE_GHOST_SLOTS
+
+/**
+ * @enum cache_policy
+ * @brief Eviction policy of a cache.
+ */
+enum cache_policy {
+    CACHE_CLOCK, /**< Second chance FIFO (CLOCK) */
+    CACHE_S3FIFO, /**< Small, main and ghost FIFO queues */
+};
+
+/**
+ * @struct cache_stats
+ * @brief Counters of a cache, see cache_stats_read().
+ */
+struct cache_stats {
+    uint64_t hits; /**< Successful cache_get() */
+    uint64_t misses; /**< Failed cache_get() */
+    uint64_t insertions; /**< Successful cache_put() */
+    uint64_t evictions; /**< Entries evicted to make room */
+    size_t count; /**< Number of entries */
+    size_t weight; /**< Total weight of the entries */
+    size_t capacity; /**< Maximum total weight */
+};
+
+/**
+ * @struct cache
+ * @brief Opaque sharded cache.
+ */
+struct cache;
+
+/**
+ * @brief Creates a new cache.
+ *
+ * The capacity is split evenly between the shards: an entry heavier than
+ * capacity / shards can not be cached.
+ *
+ * @param capacity The maximum total weight of the entries.
+ * @param shards The number of shards, rounded up to a power of two (0 for
+ * CACHE_DEFAULT_SHARDS).
+ * @param policy The eviction policy.
+ * @return The new cache, or NULL on allocation failure.
+ */
+struct cache *cache_create(size_t capacity, unsigned shards,
+                           enum cache_policy policy) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Destroys a cache and all its entries.
+ *
+ * @param cache The cache to destroy (can be NULL).
+ *
+ * @warning No other thread may use the cache anymore.
+ */
+void cache_destroy(struct cache *cache);
+
+/**
+ * @brief Inserts a key or replaces its value, evicting entries if needed.
+ *
+ * @param cache The cache to update.
+ * @param key The key bytes (copied).
+ * @param key_length The number of key bytes.
+ * @param value The value bytes (copied, can be NULL if value_length is 0).
+ * @param value_length The number of value bytes.
+ * @param weight The weight of the entry (0 for key_length + value_length).
+ * @return `true` on success, `false` on allocation failure or if the entry is
+ * heavier than the capacity of a shard.
+ */
+bool cache_put(struct cache *cache, const void *key, size_t key_length,
+               const void *value, size_t value_length, size_t weight)
+    NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Looks a key up and copies its value.
+ *
+ * @param cache The cache to search.
+ * @param key The key bytes.
+ * @param key_length The number of key bytes.
+ * @param value Output buffer receiving the first *size bytes of the value
+ * (can be NULL).
+ * @param size Input size of the buffer, output size of the value (can be NULL
+ * to only check the presence of the key).
+ * @return `true` if the key was found, `false` otherwise.
+ */
+bool cache_get(struct cache *cache, const void *key, size_t key_length,
+               void *value, size_t *size) NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Removes a key.
+ *
+ * @param cache The cache to update.
+ * @param key The key bytes.
+ * @param key_length The number of key bytes.
+ * @return `true` if the key was removed, `false` if it was absent.
+ */
+bool cache_remove(struct cache *cache, const void *key, size_t key_length)
+    NONNULL;
+
+/**
+ * @brief Reads the counters of a cache, summed over its shards.
+ *
+ * @param cache The cache to inspect.
+ * @return The counters (a snapshot under concurrent updates).
+ */
+struct cache_stats cache_stats_read(struct cache *cache) NONNULL;
+
+/**
+ * @brief Logs the counters of a cache, with LOG().
+ *
+ * @param cache The cache to inspect.
+ * @param level The log level of the message.
+ * @param name The name of the cache in the message.
+ */
+void cache_log_stats(struct cache *cache, enum log_level level,
+                     const char *name) NONNULL;
+
+#endif // __AYAZTUB__DATA_STRUCTURES__CACHE_H__
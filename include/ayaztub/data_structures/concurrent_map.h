@@ -0,0 +1,156 @@
+/**
+ * @file concurrent_map.h
+ * @brief Thread-safe hash map with lock-free reads in C99.
+ *
+ * This library provides a concurrent hash map from byte string keys to `void *`
+ * values, designed for read-mostly shared state (caches, per call-site logger
+ * state, configuration).
+ *
+ * - cmap_get() takes no lock: it only reads the bucket chains with atomic
+ *   loads, so readers scale with the number of cores and never wait on
+ *   writers.
+ * - Writers take one of CMAP_STRIPES mutexes, chosen by the key hash, so
+ *   writers on different keys rarely contend.
+ * - Resizing is incremental: buckets are migrated one at a time under their
+ *   stripe lock, readers follow forwarding markers to the new table, and only
+ *   writers of the bucket being moved wait.
+ * - Removed entries and old tables are freed once no reader can still see
+ *   them, with epoch-based reclamation (see ebr.h).
+ *
+ * @warning The map does not own the values: a value returned by cmap_get() may
+ * be removed (and freed by its owner) concurrently. Use values with their own
+ * lifetime management (immutable, reference counted, ...), or retire them with
+ * ebr_retire() and access them inside an ebr_enter()/ebr_exit() section.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/concurrent_map.h>
+ *
+ * int main(void) {
+ *     struct cmap *map = cmap_create(0);
+ *     if (!map)
+ *         return 1;
+ *
+ *     static int answer = 42;
+ *     if (!cmap_put(map, "answer", 6, &answer, NULL))
+ *         return 1;
+ *
+ *     void *value;
+ *     if (cmap_get(map, "answer", 6, &value))
+ *         printf("answer = %d\n", *(int *)value);
+ *
+ *     cmap_destroy(map);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__CONCURRENT_MAP_H__
+#define __AYAZTUB__DATA_STRUCTURES__CONCURRENT_MAP_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @def CMAP_STRIPES
+ * @brief Number of writer locks of a concurrent map (power of two).
+ */
+#ifndef CMAP_STRIPES
+#    define CMAP_STRIPES 64
+#endif // CMAP_STRIPES
+
+/**
+ * @struct cmap
+ * @brief Opaque concurrent hash map.
+ */
+struct cmap;
+
+/**
+ * @typedef cmap_visit_t
+ * @brief Callback type for cmap_for_each().
+ *
+ * @param key The entry key.
+ * @param key_length The entry key length.
+ * @param value The entry value.
+ * @param ctx The user context given to cmap_for_each().
+ */
+typedef void (*cmap_visit_t)(const void *key, size_t key_length, void *value,
+                             void *ctx);
+
+/**
+ * @brief Creates a new concurrent map.
+ *
+ * @param capacity Expected number of entries (0 for a default capacity).
+ * @return The new map, or NULL on allocation failure.
+ */
+struct cmap *cmap_create(size_t capacity) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Destroys a concurrent map.
+ *
+ * @param map The map to destroy (can be NULL).
+ *
+ * @warning No other thread may use the map anymore. Values are not freed.
+ */
+void cmap_destroy(struct cmap *map);
+
+/**
+ * @brief Looks a key up without taking any lock.
+ *
+ * @param map The map to search.
+ * @param key The key bytes.
+ * @param key_length The number of key bytes.
+ * @param value Output value if the key was found (can be NULL).
+ * @return `true` if the key was found, `false` otherwise.
+ */
+bool cmap_get(struct cmap *map, const void *key, size_t key_length,
+              void **value) NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Inserts a key or replaces its value.
+ *
+ * @param map The map to update.
+ * @param key The key bytes (copied by the map).
+ * @param key_length The number of key bytes.
+ * @param value The value to associate with the key.
+ * @param previous Output previous value, or NULL if the key was absent (can
+ * be NULL).
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool cmap_put(struct cmap *map, const void *key, size_t key_length,
+              void *value, void **previous) NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Removes a key.
+ *
+ * @param map The map to update.
+ * @param key The key bytes.
+ * @param key_length The number of key bytes.
+ * @param value Output removed value (can be NULL).
+ * @return `true` if the key was removed, `false` if it was absent.
+ */
+bool cmap_remove(struct cmap *map, const void *key, size_t key_length,
+                 void **value) NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Gets the number of entries of the map.
+ *
+ * @param map The map to inspect.
+ * @return The number of entries (a snapshot under concurrent updates).
+ */
+size_t cmap_size(struct cmap *map) NONNULL;
+
+/**
+ * @brief Calls a function on every entry of the map, without taking any lock.
+ *
+ * Entries inserted or removed during the iteration may or may not be visited.
+ *
+ * @param map The map to iterate over.
+ * @param visit The function to call on each entry.
+ * @param ctx User context given to the callback.
+ */
+void cmap_for_each(struct cmap *map, cmap_visit_t visit, void *ctx)
+    NONNULL_POSITIONS(1, 2);
+
+#endif // __AYAZTUB__DATA_STRUCTURES__CONCURRENT_MAP_H__
@@ -0,0 +1,313 @@
+/**
+ * @file filter.h
+ * @brief Bloom and cuckoo membership filters in C99.
+ *
+ * Both filters answer "is this item in the set?" with no false negatives and
+ * a small rate of false positives, in much less memory than the set itself.
+ * Put them in front of expensive lookups (disk, network, big tables) to skip
+ * most of the lookups of absent items.
+ *
+ * - `struct bloom`: split block Bloom filter (F. Putze et al., "Cache-,
+ *   Hash- and Space-Efficient Bloom Filters"). An item sets 8 bits in a
+ *   single 64 bytes block, one bit per 64 bits word, so a lookup reads one
+ *   cache line. About 1% false positives at 10 bits per item.
+ * - `struct cuckoo`: cuckoo filter (B. Fan et al., "Cuckoo Filter:
+ *   Practically Better Than Bloom") storing 16 bits fingerprints in buckets of
+ *   4, in one of two candidate buckets. It supports removal, and has about
+ *   0.012% false positives at 16 bits per slot, up to 95% occupancy.
+ *
+ * Items are given by their 64 bits hash (from hashmap_hash_bytes(),
+ * hashmap_hash_u64(), ...), which must be well mixed. The batch queries
+ * prefetch the memory of the next items while testing the current one.
+ *
+ * Filters serialize to a flat byte layout (64 bytes header, then the raw
+ * table) that can be written to a file and memory mapped back: the view
+ * functions use the bytes in place, without copying. The layout uses the
+ * native byte order; a filter written on a machine of the other byte order is
+ * rejected.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/filter.h>
+ * #include <ayaztub/data_structures/hashmap.h>
+ *
+ * int main(void) {
+ *     struct bloom seen;
+ *     if (!bloom_init(&seen, 1000000, 10, NULL))
+ *         return 1;
+ *
+ *     bloom_add(&seen, hashmap_hash_string("user:42"));
+ *     if (!bloom_contains(&seen, hashmap_hash_string("user:43")))
+ *         puts("definitely not seen"); // no lookup needed
+ *
+ *     bloom_deinit(&seen);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__FILTER_H__
+#define __AYAZTUB__DATA_STRUCTURES__FILTER_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <ayaztub/data_structures/allocator.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def FILTER_HEADER_SIZE
+ * @brief Size in bytes of the header of a serialized filter.
+ */
+#define FILTER_HEADER_SIZE 64
+
+// ---------- Bloom Filter ---------- //
+
+/**
+ * @struct bloom
+ * @brief Split block Bloom filter, initialized with bloom_init(),
+ * bloom_load() or bloom_view().
+ */
+struct bloom {
+    uint64_t *blocks; /**< Internal use: 8 words per block */
+    size_t block_count; /**< Internal use */
+    void *memory; /**< Internal use: NULL for views */
+    size_t memory_size; /**< Internal use */
+    const struct allocator *allocator; /**< Internal use */
+};
+
+/**
+ * @brief Initializes an empty Bloom filter.
+ *
+ * @param filter The filter to initialize.
+ * @param capacity The expected number of items.
+ * @param bits_per_item The number of bits per expected item (10 gives about
+ * 1% false positives, 16 about 0.1%).
+ * @param allocator The allocator (NULL for malloc()), which must outlive the
+ * filter.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool bloom_init(struct bloom *filter, size_t capacity, unsigned bits_per_item,
+                const struct allocator *allocator)
+    NONNULL_POSITIONS(1) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Releases the memory of a Bloom filter (or forgets a view).
+ *
+ * @param filter The filter to release.
+ */
+void bloom_deinit(struct bloom *filter) NONNULL;
+
+/**
+ * @brief Adds an item.
+ *
+ * @param filter The filter (not a view of read-only memory).
+ * @param hash The hash of the item.
+ */
+void bloom_add(struct bloom *filter, uint64_t hash) NONNULL;
+
+/**
+ * @brief Checks whether an item may have been added.
+ *
+ * @param filter The filter.
+ * @param hash The hash of the item.
+ * @return `false` if the item was never added, `true` if it probably was.
+ */
+bool bloom_contains(const struct bloom *filter, uint64_t hash) NONNULL PURE;
+
+/**
+ * @brief Checks many items at once.
+ *
+ * @param filter The filter.
+ * @param hashes The hashes of the items.
+ * @param count The number of items.
+ * @param results Output result of bloom_contains() for every item (can be
+ * NULL to only count).
+ * @return The number of items that may have been added.
+ */
+size_t bloom_contains_batch(const struct bloom *filter, const uint64_t *hashes,
+                            size_t count, bool *results)
+    NONNULL_POSITIONS(1);
+
+/**
+ * @brief Gets the size of the serialized form of a Bloom filter.
+ *
+ * @param filter The filter.
+ * @return The size in bytes.
+ */
+size_t bloom_serialized_size(const struct bloom *filter) NONNULL PURE;
+
+/**
+ * @brief Serializes a Bloom filter.
+ *
+ * @param filter The filter.
+ * @param buffer The output buffer.
+ * @param size The size of the buffer.
+ * @return `true` on success, `false` if the buffer is too small.
+ */
+bool bloom_serialize(const struct bloom *filter, void *buffer, size_t size)
+    NONNULL;
+
+/**
+ * @brief Initializes a Bloom filter with a copy of a serialized one.
+ *
+ * @param filter The filter to initialize.
+ * @param data The serialized filter.
+ * @param size The size of the serialized filter.
+ * @param allocator The allocator (NULL for malloc()).
+ * @return `true` on success, `false` on allocation failure or invalid data.
+ */
+bool bloom_load(struct bloom *filter, const void *data, size_t size,
+                const struct allocator *allocator)
+    NONNULL_POSITIONS(1, 2) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Initializes a Bloom filter using a serialized one in place (for
+ * instance a memory mapped file), without copying it.
+ *
+ * @param filter The filter to initialize.
+ * @param data The serialized filter, aligned on 8 bytes, which must outlive
+ * the filter.
+ * @param size The size of the serialized filter.
+ * @return `true` on success, `false` on invalid or misaligned data.
+ *
+ * @warning Items must not be added if the memory is read-only.
+ */
+bool bloom_view(struct bloom *filter, const void *data, size_t size)
+    NONNULL WARN_UNUSED_RESULT;
+
+// ---------- Cuckoo Filter ---------- //
+
+/**
+ * @struct cuckoo
+ * @brief Cuckoo filter, initialized with cuckoo_init(), cuckoo_load() or
+ * cuckoo_view().
+ */
+struct cuckoo {
+    uint64_t *buckets; /**< Internal use: 4 fingerprints per bucket */
+    size_t bucket_count; /**< Internal use: power of 2 */
+    size_t count; /**< Number of items */
+    size_t victim_index; /**< Internal use */
+    uint16_t victim; /**< Internal use: fingerprint that found no room */
+    void *memory; /**< Internal use: NULL for views */
+    size_t memory_size; /**< Internal use */
+    const struct allocator *allocator; /**< Internal use */
+};
+
+/**
+ * @brief Initializes an empty cuckoo filter.
+ *
+ * @param filter The filter to initialize.
+ * @param capacity The maximum number of items (insertions may fail a bit
+ * earlier, when the filter is about 95% full).
+ * @param allocator The allocator (NULL for malloc()), which must outlive the
+ * filter.
+ * @return `true` on success, `false` on allocation failure.
+ */
+bool cuckoo_init(struct cuckoo *filter, size_t capacity,
+                 const struct allocator *allocator)
+    NONNULL_POSITIONS(1) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Releases the memory of a cuckoo filter (or forgets a view).
+ *
+ * @param filter The filter to release.
+ */
+void cuckoo_deinit(struct cuckoo *filter) NONNULL;
+
+/**
+ * @brief Adds an item.
+ *
+ * The same item can be added several times (up to 8 copies), and must then
+ * be removed as many times.
+ *
+ * @param filter The filter (not a view of read-only memory).
+ * @param hash The hash of the item.
+ * @return `true` on success, `false` if the filter is full.
+ */
+bool cuckoo_add(struct cuckoo *filter, uint64_t hash) NONNULL;
+
+/**
+ * @brief Removes an item.
+ *
+ * @param filter The filter (not a view of read-only memory).
+ * @param hash The hash of the item.
+ * @return `true` if the item was found and removed, `false` otherwise.
+ *
+ * @warning Only remove items that were added: removing an absent item
+ * matching a false positive removes another item.
+ */
+bool cuckoo_remove(struct cuckoo *filter, uint64_t hash) NONNULL;
+
+/**
+ * @brief Checks whether an item may have been added.
+ *
+ * @param filter The filter.
+ * @param hash The hash of the item.
+ * @return `false` if the item is not in the filter, `true` if it probably is.
+ */
+bool cuckoo_contains(const struct cuckoo *filter, uint64_t hash)
+    NONNULL PURE;
+
+/**
+ * @brief Checks many items at once.
+ *
+ * @param filter The filter.
+ * @param hashes The hashes of the items.
+ * @param count The number of items.
+ * @param results Output result of cuckoo_contains() for every item (can be
+ * NULL to only count).
+ * @return The number of items that may be in the filter.
+ */
+size_t cuckoo_contains_batch(const struct cuckoo *filter,
+                             const uint64_t *hashes, size_t count,
+                             bool *results) NONNULL_POSITIONS(1);
+
+/**
+ * @brief Gets the size of the serialized form of a cuckoo filter.
+ *
+ * @param filter The filter.
+ * @return The size in bytes.
+ */
+size_t cuckoo_serialized_size(const struct cuckoo *filter) NONNULL PURE;
+
+/**
+ * @brief Serializes a cuckoo filter.
+ *
+ * @param filter The filter.
+ * @param buffer The output buffer.
+ * @param size The size of the buffer.
+ * @return `true` on success, `false` if the buffer is too small.
+ */
+bool cuckoo_serialize(const struct cuckoo *filter, void *buffer, size_t size)
+    NONNULL;
+
+/**
+ * @brief Initializes a cuckoo filter with a copy of a serialized one.
+ *
+ * @param filter The filter to initialize.
+ * @param data The serialized filter.
+ * @param size The size of the serialized filter.
+ * @param allocator The allocator (NULL for malloc()).
+ * @return `true` on success, `false` on allocation failure or invalid data.
+ */
+bool cuckoo_load(struct cuckoo *filter, const void *data, size_t size,
+                 const struct allocator *allocator)
+    NONNULL_POSITIONS(1, 2) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Initializes a cuckoo filter using a serialized one in place (for
+ * instance a memory mapped file), without copying it.
+ *
+ * @param filter The filter to initialize.
+ * @param data The serialized filter, aligned on 8 bytes, which must outlive
+ * the filter.
+ * @param size The size of the serialized filter.
+ * @return `true` on success, `false` on invalid or misaligned data.
+ *
+ * @warning Items must not be added or removed if the memory is read-only.
+ */
+bool cuckoo_view(struct cuckoo *filter, const void *data, size_t size)
+    NONNULL WARN_UNUSED_RESULT;
+
+#endif // __AYAZTUB__DATA_STRUCTURES__FILTER_H__
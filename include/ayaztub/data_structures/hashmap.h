@@ -0,0 +1,503 @@
+/**
+ * @file hashmap.h
+ * @brief Type-safe open-addressing hash maps (Swiss table design) in C99.
+ *
+ * The HASHMAP_DECL() macro generates a hash map structure and its functions
+ * for a given key and value type, in the same way debug.h generates its dbg
+ * functions.
+ *
+ * Each slot has a one byte control word holding 7 bits of the hash (or an
+ * empty/deleted marker). Lookups compare 16 control bytes at once (with SSE2
+ * when available, a portable scalar loop otherwise) and only touch the slots
+ * whose 7 hash bits match, so a lookup usually costs one control group load
+ * and one key comparison, without any pointer chasing.
+ *
+ * Deleted slots are turned back into empty slots when no probe sequence can
+ * have gone through them, so tombstones only appear in crowded areas of the
+ * table and are purged by the next rehash.
+ *
+ * @warning Pointers to keys or values are invalidated by any insertion (the
+ * table may be rehashed).
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/hashmap.h>
+ *
+ * HASHMAP_DECL(const char *, int, counter_map, hashmap_hash_string,
+ *              hashmap_string_eq)
+ *
+ * int main(void) {
+ *     struct counter_map map;
+ *     counter_map_init(&map, NULL);
+ *
+ *     const char *words[] = { "a", "b", "a" };
+ *     for (size_t i = 0; i < 3; i++) {
+ *         int *count = counter_map_find(&map, words[i]);
+ *         if (count)
+ *             (*count)++;
+ *         else if (!counter_map_put(&map, words[i], 1))
+ *             return 1;
+ *     }
+ *
+ *     size_t iter = 0;
+ *     struct counter_map_entry *entry;
+ *     while ((entry = counter_map_next(&map, &iter)))
+ *         printf("%s: %d\n", entry->key, entry->value);
+ *
+ *     counter_map_deinit(&map);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__HASHMAP_H__
+#define __AYAZTUB__DATA_STRUCTURES__HASHMAP_H__
+
+#include <ayaztub/data_structures/allocator.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) && !defined(HASHMAP_NO_SIMD)
+#    include <emmintrin.h>
+#    define HASHMAP_SSE2 1
+#endif // __SSE2__ && !HASHMAP_NO_SIMD
+
+/**
+ * @def HASHMAP_GROUP_WIDTH
+ * @brief Number of control bytes probed at once.
+ */
+#define HASHMAP_GROUP_WIDTH 16
+
+/**
+ * @def HASHMAP_MIN_CAPACITY
+ * @brief Capacity of a hash map after its first insertion.
+ */
+#define HASHMAP_MIN_CAPACITY HASHMAP_GROUP_WIDTH
+
+#define HASHMAP_CTRL_EMPTY ((uint8_t)0x80)
+#define HASHMAP_CTRL_DELETED ((uint8_t)0xfe)
+
+// ---------- Hash Functions ---------- //
+
+/**
+ * @brief Hashes a 64 bits integer.
+ *
+ * @param key The integer to hash.
+ * @return The hash of the key (every bit depends on every key bit).
+ */
+static inline uint64_t hashmap_hash_u64(uint64_t key) {
+    // murmur3 finalizer
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * @brief Hashes a byte buffer.
+ *
+ * @param data The bytes to hash.
+ * @param length The number of bytes.
+ * @return The hash of the buffer.
+ */
+static inline uint64_t hashmap_hash_bytes(const void *data, size_t length) {
+    const unsigned char *bytes = data;
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (length * 0xff51afd7ed558ccdULL);
+
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ hashmap_hash_u64(word)) * 0x9e3779b97f4a7c15ULL;
+        bytes += 8;
+        length -= 8;
+    }
+
+    uint64_t tail = 0;
+    for (size_t i = 0; i < length; i++)
+        tail |= (uint64_t)bytes[i] << (8 * i);
+    return hashmap_hash_u64(hash ^ tail);
+}
+
+/**
+ * @brief Hashes a null terminated string.
+ *
+ * @param str The string to hash.
+ * @return The hash of the string.
+ */
+static inline uint64_t hashmap_hash_string(const char *str) {
+    return hashmap_hash_bytes(str, strlen(str));
+}
+
+/**
+ * @def hashmap_default_eq(a, b)
+ * @brief Key equality for keys comparable with `==`.
+ */
+#define hashmap_default_eq(a, b) ((a) == (b))
+
+/**
+ * @def hashmap_string_eq(a, b)
+ * @brief Key equality for null terminated string keys.
+ */
+#define hashmap_string_eq(a, b) (strcmp((a), (b)) == 0)
+
+// ---------- Control Groups ---------- //
+
+static inline unsigned hashmap_ctz(uint32_t mask) {
+#ifdef __GNUC__
+    return (unsigned)__builtin_ctz(mask);
+#else // __GNUC__
+    unsigned n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif // __GNUC__
+}
+
+static inline unsigned hashmap_clz16(uint32_t mask) {
+#ifdef __GNUC__
+    return mask ? (unsigned)__builtin_clz(mask) - 16 : 16;
+#else // __GNUC__
+    unsigned n = 0;
+    while (n < HASHMAP_GROUP_WIDTH
+           && !(mask & (1u << (HASHMAP_GROUP_WIDTH - 1 - n))))
+        n++;
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * @brief Bitmask of the control bytes of a group equal to a 7 bits hash.
+ */
+static inline uint32_t hashmap_group_match(const uint8_t *ctrl, uint8_t h2) {
+#ifdef HASHMAP_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    __m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2));
+    return (uint32_t)_mm_movemask_epi8(match);
+#else // HASHMAP_SSE2
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < HASHMAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(ctrl[i] == h2) << i;
+    return mask;
+#endif // HASHMAP_SSE2
+}
+
+/**
+ * @brief Bitmask of the empty control bytes of a group.
+ */
+static inline uint32_t hashmap_group_match_empty(const uint8_t *ctrl) {
+    return hashmap_group_match(ctrl, HASHMAP_CTRL_EMPTY);
+}
+
+/**
+ * @brief Bitmask of the empty or deleted control bytes of a group.
+ *
+ * Both markers have their high bit set, unlike full slots.
+ */
+static inline uint32_t hashmap_group_match_free(const uint8_t *ctrl) {
+#ifdef HASHMAP_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (uint32_t)_mm_movemask_epi8(group);
+#else // HASHMAP_SSE2
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < HASHMAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(ctrl[i] >> 7) << i;
+    return mask;
+#endif // HASHMAP_SSE2
+}
+
+/**
+ * @brief Sets a control byte, keeping the cloned bytes after the end of the
+ * control array in sync (groups may be loaded from any slot).
+ */
+static inline void hashmap_set_ctrl(uint8_t *ctrl, size_t capacity,
+                                    size_t index, uint8_t value) {
+    ctrl[index] = value;
+    if (index < HASHMAP_GROUP_WIDTH)
+        ctrl[capacity + index] = value;
+}
+
+/**
+ * @brief Tells whether a slot being erased can become empty instead of a
+ * tombstone.
+ *
+ * A lookup only goes past a group window with no empty slot. If the run of
+ * non-empty slots around the erased one is shorter than a group, no window
+ * containing the slot was ever full, so no probe sequence went through it.
+ */
+static inline bool hashmap_can_erase_to_empty(const uint8_t *ctrl,
+                                              size_t capacity, size_t index) {
+    size_t before = (index - HASHMAP_GROUP_WIDTH) & (capacity - 1);
+    uint32_t empty_after = hashmap_group_match_empty(ctrl + index);
+    uint32_t empty_before = hashmap_group_match_empty(ctrl + before);
+    return empty_after && empty_before
+        && hashmap_ctz(empty_after) + hashmap_clz16(empty_before)
+        < HASHMAP_GROUP_WIDTH;
+}
+
+static inline size_t hashmap_capacity_for(size_t count) {
+    // keep the load factor under 7/8
+    size_t capacity = HASHMAP_MIN_CAPACITY;
+    while (capacity - capacity / 8 < count) {
+        if (capacity > SIZE_MAX / 2)
+            return 0;
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * @def HASHMAP_DECL(key_type, value_type, name, hash_func, eq_func)
+ * @brief Macro to declare a hash map type and its functions.
+ *
+ * @param key_type The type of the keys.
+ * @param value_type The type of the values.
+ * @param name The name of the hash map structure and the prefix of its
+ * functions.
+ * @param hash_func A function or macro `uint64_t hash_func(key_type key)`.
+ * @param eq_func A function or macro `bool eq_func(key_type a, key_type b)`.
+ *
+ * Example usage:
+ * @code
+ * HASHMAP_DECL(uint64_t, double, u64map, hashmap_hash_u64,
+ *              hashmap_default_eq)
+ * // create the following structures:
+ * // struct u64map_entry { uint64_t key; double value; };
+ * // struct u64map { size_t size; size_t capacity; ... };
+ * // and the following functions:
+ * // void u64map_init(struct u64map *map, const struct allocator *allocator);
+ * // void u64map_deinit(struct u64map *map);
+ * // bool u64map_reserve(struct u64map *map, size_t count);
+ * // double *u64map_find(const struct u64map *map, uint64_t key);
+ * // bool u64map_contains(const struct u64map *map, uint64_t key);
+ * // double *u64map_emplace(struct u64map *map, uint64_t key,
+ * //                        bool *inserted);
+ * // bool u64map_put(struct u64map *map, uint64_t key, double value);
+ * // bool u64map_remove(struct u64map *map, uint64_t key, double *value);
+ * // void u64map_clear(struct u64map *map);
+ * // struct u64map_entry *u64map_next(const struct u64map *map,
+ * //                                  size_t *iter);
+ * @endcode
+ *
+ * @note The allocator given to init is kept by pointer and must outlive the
+ * map. Functions return false (or NULL) on allocation failure and leave the
+ * map untouched.
+ */
+#define HASHMAP_DECL(key_type, value_type, name, hash_func, eq_func)           \
+    typedef key_type name##_key_t;                                             \
+    typedef value_type name##_value_t;                                         \
+                                                                               \
+    struct name##_entry {                                                      \
+        name##_key_t key;                                                      \
+        name##_value_t value;                                                  \
+    };                                                                         \
+                                                                               \
+    struct name {                                                              \
+        uint8_t *ctrl;                                                         \
+        struct name##_entry *slots;                                            \
+        size_t size;                                                           \
+        size_t capacity;                                                       \
+        size_t growth_left;                                                    \
+        const struct allocator *allocator;                                     \
+    };                                                                         \
+                                                                               \
+    static inline void name##_init(struct name *map,                           \
+                                   const struct allocator *allocator) {        \
+        map->ctrl = NULL;                                                      \
+        map->slots = NULL;                                                     \
+        map->size = 0;                                                         \
+        map->capacity = 0;                                                     \
+        map->growth_left = 0;                                                  \
+        map->allocator = allocator;                                            \
+    }                                                                          \
+                                                                               \
+    static inline size_t name##_alloc_size(size_t capacity) {                  \
+        return capacity * sizeof(struct name##_entry) + capacity               \
+            + HASHMAP_GROUP_WIDTH;                                             \
+    }                                                                          \
+                                                                               \
+    static inline void name##_deinit(struct name *map) {                       \
+        allocator_free(map->allocator, map->slots,                             \
+                       name##_alloc_size(map->capacity));                      \
+        name##_init(map, map->allocator);                                      \
+    }                                                                          \
+                                                                               \
+    static inline size_t name##_find_free(const struct name *map,              \
+                                          uint64_t hash) {                     \
+        size_t mask = map->capacity - 1;                                       \
+        size_t pos = (size_t)(hash >> 7) & mask;                               \
+        size_t stride = 0;                                                     \
+        for (;;) {                                                             \
+            uint32_t free_slots = hashmap_group_match_free(map->ctrl + pos);   \
+            if (free_slots)                                                    \
+                return (pos + hashmap_ctz(free_slots)) & mask;                 \
+            stride += HASHMAP_GROUP_WIDTH;                                     \
+            pos = (pos + stride) & mask;                                       \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_rehash(struct name *map, size_t capacity) {      \
+        if (!capacity                                                          \
+            || capacity > SIZE_MAX / 2 / sizeof(struct name##_entry))          \
+            return false;                                                      \
+        struct name new_map = *map;                                            \
+        new_map.slots = allocator_realloc(map->allocator, NULL, 0,             \
+                                          name##_alloc_size(capacity));        \
+        if (!new_map.slots)                                                    \
+            return false;                                                      \
+        new_map.ctrl = (uint8_t *)(new_map.slots + capacity);                  \
+        new_map.capacity = capacity;                                           \
+        new_map.growth_left = capacity - capacity / 8 - map->size;             \
+        memset(new_map.ctrl, HASHMAP_CTRL_EMPTY,                               \
+               capacity + HASHMAP_GROUP_WIDTH);                                \
+                                                                               \
+        for (size_t i = 0; i < map->capacity; i++) {                           \
+            if (map->ctrl[i] & 0x80)                                           \
+                continue;                                                      \
+            uint64_t hash = hash_func(map->slots[i].key);                      \
+            size_t index = name##_find_free(&new_map, hash);                   \
+            hashmap_set_ctrl(new_map.ctrl, capacity, index,                    \
+                             (uint8_t)(hash & 0x7f));                          \
+            new_map.slots[index] = map->slots[i];                              \
+        }                                                                      \
+                                                                               \
+        allocator_free(map->allocator, map->slots,                             \
+                       name##_alloc_size(map->capacity));                      \
+        *map = new_map;                                                        \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_reserve(struct name *map, size_t count) {        \
+        if (count <= map->size + map->growth_left)                             \
+            return true;                                                       \
+        return name##_rehash(map, hashmap_capacity_for(count));                \
+    }                                                                          \
+                                                                               \
+    static inline struct name##_entry *name##_find_entry(                      \
+        const struct name *map, name##_key_t key, uint64_t hash) {             \
+        if (!map->size)                                                        \
+            return NULL;                                                       \
+        size_t mask = map->capacity - 1;                                       \
+        size_t pos = (size_t)(hash >> 7) & mask;                               \
+        size_t stride = 0;                                                     \
+        for (;;) {                                                             \
+            const uint8_t *group = map->ctrl + pos;                            \
+            uint32_t match =                                                   \
+                hashmap_group_match(group, (uint8_t)(hash & 0x7f));            \
+            while (match) {                                                    \
+                size_t index = (pos + hashmap_ctz(match)) & mask;              \
+                if (eq_func(map->slots[index].key, key))                       \
+                    return map->slots + index;                                 \
+                match &= match - 1;                                            \
+            }                                                                  \
+            if (hashmap_group_match_empty(group))                              \
+                return NULL;                                                   \
+            stride += HASHMAP_GROUP_WIDTH;                                     \
+            pos = (pos + stride) & mask;                                       \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t *name##_find(const struct name *map,          \
+                                              name##_key_t key) {              \
+        struct name##_entry *entry =                                           \
+            name##_find_entry(map, key, hash_func(key));                       \
+        return entry ? &entry->value : NULL;                                   \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_contains(const struct name *map,                 \
+                                       name##_key_t key) {                     \
+        return name##_find(map, key) != NULL;                                  \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t *name##_emplace(                              \
+        struct name *map, name##_key_t key, bool *inserted) {                  \
+        uint64_t hash = hash_func(key);                                        \
+        struct name##_entry *entry = name##_find_entry(map, key, hash);        \
+        if (entry) {                                                           \
+            if (inserted)                                                      \
+                *inserted = false;                                             \
+            return &entry->value;                                              \
+        }                                                                      \
+                                                                               \
+        size_t index = 0;                                                      \
+        if (map->capacity)                                                     \
+            index = name##_find_free(map, hash);                               \
+        if (!map->capacity                                                     \
+            || (!map->growth_left                                              \
+                && map->ctrl[index] == HASHMAP_CTRL_EMPTY)) {                  \
+            /* rehash to at most half the maximum load to amortize it */       \
+            size_t capacity = hashmap_capacity_for(2 * (map->size + 1));       \
+            if (!name##_rehash(map, capacity))                                 \
+                return NULL;                                                   \
+            index = name##_find_free(map, hash);                               \
+        }                                                                      \
+                                                                               \
+        if (map->ctrl[index] == HASHMAP_CTRL_EMPTY)                            \
+            map->growth_left--;                                                \
+        hashmap_set_ctrl(map->ctrl, map->capacity, index,                      \
+                         (uint8_t)(hash & 0x7f));                              \
+        map->slots[index].key = key;                                           \
+        map->size++;                                                           \
+        if (inserted)                                                          \
+            *inserted = true;                                                  \
+        return &map->slots[index].value;                                       \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_put(struct name *map, name##_key_t key,          \
+                                  name##_value_t value) {                      \
+        name##_value_t *slot = name##_emplace(map, key, NULL);                 \
+        if (!slot)                                                             \
+            return false;                                                      \
+        *slot = value;                                                         \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_remove(struct name *map, name##_key_t key,       \
+                                     name##_value_t *value) {                  \
+        struct name##_entry *entry =                                           \
+            name##_find_entry(map, key, hash_func(key));                       \
+        if (!entry)                                                            \
+            return false;                                                      \
+        if (value)                                                             \
+            *value = entry->value;                                             \
+                                                                               \
+        size_t index = (size_t)(entry - map->slots);                           \
+        if (hashmap_can_erase_to_empty(map->ctrl, map->capacity, index)) {     \
+            hashmap_set_ctrl(map->ctrl, map->capacity, index,                  \
+                             HASHMAP_CTRL_EMPTY);                              \
+            map->growth_left++;                                                \
+        } else {                                                               \
+            hashmap_set_ctrl(map->ctrl, map->capacity, index,                  \
+                             HASHMAP_CTRL_DELETED);                            \
+        }                                                                      \
+        map->size--;                                                           \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_clear(struct name *map) {                        \
+        if (!map->capacity)                                                    \
+            return;                                                            \
+        memset(map->ctrl, HASHMAP_CTRL_EMPTY,                                  \
+               map->capacity + HASHMAP_GROUP_WIDTH);                           \
+        map->size = 0;                                                         \
+        map->growth_left = map->capacity - map->capacity / 8;                  \
+    }                                                                          \
+                                                                               \
+    static inline struct name##_entry *name##_next(const struct name *map,     \
+                                                   size_t *iter) {             \
+        for (size_t i = *iter; i < map->capacity; i++) {                       \
+            if (!(map->ctrl[i] & 0x80)) {                                      \
+                *iter = i + 1;                                                 \
+                return map->slots + i;                                         \
+            }                                                                  \
+        }                                                                      \
+        *iter = map->capacity;                                                 \
+        return NULL;                                                           \
+    }
+
+#endif // __AYAZTUB__DATA_STRUCTURES__HASHMAP_H__
@@ -0,0 +1,576 @@
+/**
+ * @file heap.h
+ * @brief Type-safe d-ary heaps (priority queues) in C99.
+ *
+ * The HEAP_DECL() macro generates an implicit d-ary min-heap for a given
+ * element type and ordering, in the same way vector.h generates its vectors.
+ * Elements live in a single array: the children of the element i are the
+ * elements d * i + 1 to d * i + d. With the default arity of 4, the heap is
+ * half as deep as a binary heap and the children compared when sifting down
+ * are contiguous (usually in one cache line), which makes pops cheaper.
+ *
+ * The INDEXED_HEAP_DECL() macro generates an indexed variant: every pushed
+ * element gets a handle, which can later be used to change its priority
+ * (decrease-key, as needed by schedulers and graph searches) or to remove it.
+ *
+ * - Pushing many elements at once heapifies them in O(n) instead of
+ *   O(n log n).
+ * - The ordering is a `less_func(a, b)` macro or function: the smallest
+ *   element is on top (swap the arguments for a max-heap).
+ *
+ * @warning Elements are moved with plain assignments, so the element type must
+ * be trivially relocatable (no pointer into itself).
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/heap.h>
+ *
+ * struct job {
+ *     uint64_t deadline;
+ *     void (*run)(void);
+ * };
+ *
+ * #define job_less(a, b) ((a).deadline < (b).deadline)
+ *
+ * INDEXED_HEAP_DECL(struct job, job_queue, job_less)
+ *
+ * int main(void) {
+ *     struct job_queue queue;
+ *     job_queue_init(&queue, NULL);
+ *
+ *     uint32_t handle = job_queue_push(&queue, (struct job){ 100, flush });
+ *     job_queue_push(&queue, (struct job){ 50, rotate });
+ *     job_queue_decrease_key(&queue, handle, (struct job){ 10, flush });
+ *
+ *     struct job job;
+ *     while (job_queue_pop(&queue, &job, NULL))
+ *         job.run(); // flush, then rotate
+ *
+ *     job_queue_deinit(&queue);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__HEAP_H__
+#define __AYAZTUB__DATA_STRUCTURES__HEAP_H__
+
+#include <ayaztub/data_structures/allocator.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @def HEAP_DEFAULT_ARITY
+ * @brief Number of children of a node of the heaps declared with HEAP_DECL()
+ * and INDEXED_HEAP_DECL().
+ */
+#ifndef HEAP_DEFAULT_ARITY
+#    define HEAP_DEFAULT_ARITY 4
+#endif // HEAP_DEFAULT_ARITY
+
+/**
+ * @def HEAP_MIN_CAPACITY
+ * @brief Minimum capacity of a heap once it allocates.
+ */
+#ifndef HEAP_MIN_CAPACITY
+#    define HEAP_MIN_CAPACITY 16
+#endif // HEAP_MIN_CAPACITY
+
+/**
+ * @def HEAP_INVALID_HANDLE
+ * @brief Handle returned by an indexed heap when a push fails.
+ */
+#define HEAP_INVALID_HANDLE UINT32_MAX
+
+/**
+ * @def heap_default_less(a, b)
+ * @brief Ordering of scalar elements (min-heap).
+ */
+#define heap_default_less(a, b) ((a) < (b))
+
+/**
+ * @def HEAP_DECL(type, name, less_func)
+ * @brief Macro to declare a heap type with the default arity.
+ *
+ * @see HEAP_DECL_ARITY()
+ */
+#define HEAP_DECL(type, name, less_func)                                       \
+    HEAP_DECL_ARITY(type, name, less_func, HEAP_DEFAULT_ARITY)
+
+/**
+ * @def HEAP_DECL_ARITY(type, name, less_func, arity)
+ * @brief Macro to declare a d-ary heap type and its functions.
+ *
+ * @param type The type of the elements.
+ * @param name The name of the heap structure and the prefix of its functions.
+ * @param less_func A function or macro `bool less_func(type a, type b)`
+ * returning whether a goes out of the heap before b.
+ * @param arity The number of children of a node (at least 2).
+ *
+ * Example usage:
+ * @code
+ * HEAP_DECL_ARITY(double, dheap, heap_default_less, 8)
+ * // create the following structure:
+ * // struct dheap { double *data; size_t size; size_t capacity; ... };
+ * // and the following functions:
+ * // void dheap_init(struct dheap *heap, const struct allocator *allocator);
+ * // void dheap_deinit(struct dheap *heap);
+ * // bool dheap_reserve(struct dheap *heap, size_t capacity);
+ * // void dheap_clear(struct dheap *heap);
+ * // bool dheap_push(struct dheap *heap, double value);
+ * // bool dheap_push_batch(struct dheap *heap, const double *values,
+ * //                       size_t count);
+ * // double *dheap_top(const struct dheap *heap);
+ * // bool dheap_pop(struct dheap *heap, double *value);
+ * // void dheap_replace_top(struct dheap *heap, double value);
+ * @endcode
+ *
+ * @note The allocator given to init is kept by pointer and must outlive the
+ * heap. Functions returning a bool return false on allocation failure (or
+ * on an empty heap for pop) and leave the heap untouched.
+ */
+#define HEAP_DECL_ARITY(type, name, less_func, arity)                          \
+    typedef type name##_value_t;                                               \
+                                                                               \
+    struct name {                                                              \
+        name##_value_t *data;                                                  \
+        size_t size;                                                           \
+        size_t capacity;                                                       \
+        const struct allocator *allocator;                                     \
+    };                                                                         \
+                                                                               \
+    static inline void name##_init(struct name *heap,                          \
+                                   const struct allocator *allocator) {        \
+        heap->data = NULL;                                                     \
+        heap->size = 0;                                                        \
+        heap->capacity = 0;                                                    \
+        heap->allocator = allocator;                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_deinit(struct name *heap) {                      \
+        allocator_free(heap->allocator, heap->data,                            \
+                       heap->capacity * sizeof(name##_value_t));               \
+        name##_init(heap, heap->allocator);                                    \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_reserve(struct name *heap, size_t capacity) {    \
+        if (capacity <= heap->capacity)                                        \
+            return true;                                                       \
+        if (capacity > SIZE_MAX / sizeof(name##_value_t))                      \
+            return false;                                                      \
+        name##_value_t *data = allocator_realloc(                              \
+            heap->allocator, heap->data,                                       \
+            heap->capacity * sizeof(name##_value_t),                           \
+            capacity * sizeof(name##_value_t));                                \
+        if (!data)                                                             \
+            return false;                                                      \
+        heap->data = data;                                                     \
+        heap->capacity = capacity;                                             \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_grow(struct name *heap, size_t additional) {     \
+        if (additional > SIZE_MAX - heap->size)                                \
+            return false;                                                      \
+        size_t needed = heap->size + additional;                               \
+        if (needed <= heap->capacity)                                          \
+            return true;                                                       \
+        size_t capacity = heap->capacity + heap->capacity / 2;                 \
+        if (capacity < HEAP_MIN_CAPACITY)                                      \
+            capacity = HEAP_MIN_CAPACITY;                                      \
+        if (capacity < needed)                                                 \
+            capacity = needed;                                                 \
+        return name##_reserve(heap, capacity)                                  \
+               || name##_reserve(heap, needed);                                \
+    }                                                                          \
+                                                                               \
+    static inline void name##_clear(struct name *heap) {                       \
+        heap->size = 0;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline void name##_sift_up(struct name *heap, size_t index) {       \
+        name##_value_t value = heap->data[index];                              \
+        while (index > 0) {                                                    \
+            size_t parent = (index - 1) / (arity);                             \
+            if (!less_func(value, heap->data[parent]))                         \
+                break;                                                         \
+            heap->data[index] = heap->data[parent];                            \
+            index = parent;                                                    \
+        }                                                                      \
+        heap->data[index] = value;                                             \
+    }                                                                          \
+                                                                               \
+    static inline void name##_sift_down(struct name *heap, size_t index) {     \
+        name##_value_t value = heap->data[index];                              \
+        for (;;) {                                                             \
+            size_t first = index * (arity) + 1;                                \
+            if (first >= heap->size)                                           \
+                break;                                                         \
+            size_t last = heap->size - first < (arity) ? heap->size            \
+                                                       : first + (arity);      \
+            size_t best = first;                                               \
+            for (size_t child = first + 1; child < last; child++) {            \
+                if (less_func(heap->data[child], heap->data[best]))            \
+                    best = child;                                              \
+            }                                                                  \
+            if (!less_func(heap->data[best], value))                           \
+                break;                                                         \
+            heap->data[index] = heap->data[best];                              \
+            index = best;                                                      \
+        }                                                                      \
+        heap->data[index] = value;                                             \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_push(struct name *heap, name##_value_t value) {  \
+        if (heap->size == heap->capacity && !name##_grow(heap, 1))             \
+            return false;                                                      \
+        heap->data[heap->size++] = value;                                      \
+        name##_sift_up(heap, heap->size - 1);                                  \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_push_batch(struct name *heap,                    \
+                                         const name##_value_t *values,         \
+                                         size_t count) {                       \
+        if (!count)                                                            \
+            return true;                                                       \
+        if (!name##_grow(heap, count))                                         \
+            return false;                                                      \
+        memcpy(heap->data + heap->size, values,                                \
+               count * sizeof(name##_value_t));                                \
+        size_t old_size = heap->size;                                          \
+        heap->size += count;                                                   \
+        if (count < old_size) {                                                \
+            for (size_t i = old_size; i < heap->size; i++)                     \
+                name##_sift_up(heap, i);                                       \
+        } else if (heap->size > 1) {                                           \
+            /* Floyd's bottom-up heap construction, O(size) */                 \
+            for (size_t i = (heap->size - 2) / (arity) + 1; i-- > 0;)          \
+                name##_sift_down(heap, i);                                     \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t *name##_top(const struct name *heap) {        \
+        return heap->size ? heap->data : NULL;                                 \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_pop(struct name *heap, name##_value_t *value) {  \
+        if (!heap->size)                                                       \
+            return false;                                                      \
+        if (value)                                                             \
+            *value = heap->data[0];                                            \
+        if (--heap->size) {                                                    \
+            heap->data[0] = heap->data[heap->size];                            \
+            name##_sift_down(heap, 0);                                         \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    /* Pops the top and pushes value with a single sift (heap not empty). */   \
+    static inline void name##_replace_top(struct name *heap,                   \
+                                          name##_value_t value) {              \
+        heap->data[0] = value;                                                 \
+        name##_sift_down(heap, 0);                                             \
+    }
+
+/**
+ * @def INDEXED_HEAP_DECL(type, name, less_func)
+ * @brief Macro to declare an indexed heap type with the default arity.
+ *
+ * @see INDEXED_HEAP_DECL_ARITY()
+ */
+#define INDEXED_HEAP_DECL(type, name, less_func)                               \
+    INDEXED_HEAP_DECL_ARITY(type, name, less_func, HEAP_DEFAULT_ARITY)
+
+/**
+ * @def INDEXED_HEAP_DECL_ARITY(type, name, less_func, arity)
+ * @brief Macro to declare an indexed d-ary heap type and its functions.
+ *
+ * Each element pushed gets a handle, valid until the element leaves the heap
+ * (pop or remove); handles are then reused. Elements are stored in heap order
+ * next to their handle, so sifting only touches contiguous memory, and a
+ * table maps each handle to the position of its element.
+ *
+ * @param type The type of the elements.
+ * @param name The name of the heap structure and the prefix of its functions.
+ * @param less_func A function or macro `bool less_func(type a, type b)`
+ * returning whether a goes out of the heap before b.
+ * @param arity The number of children of a node (at least 2).
+ *
+ * Example usage:
+ * @code
+ * INDEXED_HEAP_DECL(uint64_t, u64iheap, heap_default_less)
+ * // create the following structures:
+ * // struct u64iheap_node { uint64_t value; uint32_t handle; };
+ * // struct u64iheap { size_t size; size_t capacity; ... };
+ * // and the following functions:
+ * // void u64iheap_init(struct u64iheap *heap,
+ * //                    const struct allocator *allocator);
+ * // void u64iheap_deinit(struct u64iheap *heap);
+ * // bool u64iheap_reserve(struct u64iheap *heap, size_t capacity);
+ * // void u64iheap_clear(struct u64iheap *heap);
+ * // uint32_t u64iheap_push(struct u64iheap *heap, uint64_t value);
+ * // bool u64iheap_push_batch(struct u64iheap *heap, const uint64_t *values,
+ * //                          size_t count, uint32_t *handles);
+ * // const uint64_t *u64iheap_top(const struct u64iheap *heap,
+ * //                              uint32_t *handle);
+ * // bool u64iheap_pop(struct u64iheap *heap, uint64_t *value,
+ * //                   uint32_t *handle);
+ * // bool u64iheap_contains(const struct u64iheap *heap, uint32_t handle);
+ * // const uint64_t *u64iheap_get(const struct u64iheap *heap,
+ * //                              uint32_t handle);
+ * // bool u64iheap_decrease_key(struct u64iheap *heap, uint32_t handle,
+ * //                            uint64_t value);
+ * // bool u64iheap_update(struct u64iheap *heap, uint32_t handle,
+ * //                      uint64_t value);
+ * // bool u64iheap_remove(struct u64iheap *heap, uint32_t handle,
+ * //                      uint64_t *value);
+ * @endcode
+ *
+ * @note The allocator given to init is kept by pointer and must outlive the
+ * heap. Push returns HEAP_INVALID_HANDLE, and functions returning a bool
+ * return false, on allocation failure or on an unknown handle, and leave the
+ * heap untouched.
+ */
+#define INDEXED_HEAP_DECL_ARITY(type, name, less_func, arity)                  \
+    typedef type name##_value_t;                                               \
+                                                                               \
+    struct name##_node {                                                       \
+        name##_value_t value;                                                  \
+        uint32_t handle;                                                       \
+    };                                                                         \
+                                                                               \
+    struct name {                                                              \
+        /* nodes[0, size) is the heap, nodes[size, capacity) only holds the    \
+         * free handles; positions[handle] is the index of its node */         \
+        struct name##_node *nodes;                                             \
+        uint32_t *positions;                                                   \
+        size_t size;                                                           \
+        size_t capacity;                                                       \
+        const struct allocator *allocator;                                     \
+    };                                                                         \
+                                                                               \
+    static inline void name##_init(struct name *heap,                          \
+                                   const struct allocator *allocator) {        \
+        heap->nodes = NULL;                                                    \
+        heap->positions = NULL;                                                \
+        heap->size = 0;                                                        \
+        heap->capacity = 0;                                                    \
+        heap->allocator = allocator;                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_deinit(struct name *heap) {                      \
+        allocator_free(heap->allocator, heap->nodes,                           \
+                       heap->capacity * (sizeof(struct name##_node)            \
+                                         + sizeof(uint32_t)));                 \
+        name##_init(heap, heap->allocator);                                    \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_reserve(struct name *heap, size_t capacity) {    \
+        if (capacity <= heap->capacity)                                        \
+            return true;                                                       \
+        size_t node_size = sizeof(struct name##_node) + sizeof(uint32_t);      \
+        if (capacity >= HEAP_INVALID_HANDLE                                    \
+            || capacity > SIZE_MAX / node_size)                                \
+            return false;                                                      \
+                                                                               \
+        /* nodes and positions share one block, positions last */              \
+        struct name##_node *nodes = allocator_realloc(                         \
+            heap->allocator, heap->nodes, heap->capacity * node_size,          \
+            capacity * node_size);                                             \
+        if (!nodes)                                                            \
+            return false;                                                      \
+        uint32_t *positions = (uint32_t *)(nodes + capacity);                  \
+        memmove(positions, nodes + heap->capacity,                             \
+                heap->capacity * sizeof(uint32_t));                            \
+        for (size_t i = heap->capacity; i < capacity; i++) {                   \
+            nodes[i].handle = (uint32_t)i;                                     \
+            positions[i] = (uint32_t)i;                                        \
+        }                                                                      \
+                                                                               \
+        heap->nodes = nodes;                                                   \
+        heap->positions = positions;                                           \
+        heap->capacity = capacity;                                             \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_grow(struct name *heap, size_t additional) {     \
+        if (additional > SIZE_MAX - heap->size)                                \
+            return false;                                                      \
+        size_t needed = heap->size + additional;                               \
+        if (needed <= heap->capacity)                                          \
+            return true;                                                       \
+        size_t capacity = heap->capacity + heap->capacity / 2;                 \
+        if (capacity < HEAP_MIN_CAPACITY)                                      \
+            capacity = HEAP_MIN_CAPACITY;                                      \
+        if (capacity < needed)                                                 \
+            capacity = needed;                                                 \
+        return name##_reserve(heap, capacity)                                  \
+               || name##_reserve(heap, needed);                                \
+    }                                                                          \
+                                                                               \
+    static inline void name##_clear(struct name *heap) {                       \
+        heap->size = 0;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline void name##_place(struct name *heap, size_t index,           \
+                                    struct name##_node node) {                 \
+        heap->nodes[index] = node;                                             \
+        heap->positions[node.handle] = (uint32_t)index;                        \
+    }                                                                          \
+                                                                               \
+    /* Returns the new index of the node. */                                   \
+    static inline size_t name##_sift_up(struct name *heap, size_t index) {     \
+        struct name##_node node = heap->nodes[index];                          \
+        while (index > 0) {                                                    \
+            size_t parent = (index - 1) / (arity);                             \
+            if (!less_func(node.value, heap->nodes[parent].value))             \
+                break;                                                         \
+            name##_place(heap, index, heap->nodes[parent]);                    \
+            index = parent;                                                    \
+        }                                                                      \
+        name##_place(heap, index, node);                                       \
+        return index;                                                          \
+    }                                                                          \
+                                                                               \
+    static inline void name##_sift_down(struct name *heap, size_t index) {     \
+        struct name##_node node = heap->nodes[index];                          \
+        for (;;) {                                                             \
+            size_t first = index * (arity) + 1;                                \
+            if (first >= heap->size)                                           \
+                break;                                                         \
+            size_t last = heap->size - first < (arity) ? heap->size            \
+                                                       : first + (arity);      \
+            size_t best = first;                                               \
+            for (size_t child = first + 1; child < last; child++) {            \
+                if (less_func(heap->nodes[child].value,                        \
+                              heap->nodes[best].value))                        \
+                    best = child;                                              \
+            }                                                                  \
+            if (!less_func(heap->nodes[best].value, node.value))               \
+                break;                                                         \
+            name##_place(heap, index, heap->nodes[best]);                      \
+            index = best;                                                      \
+        }                                                                      \
+        name##_place(heap, index, node);                                       \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t name##_push(struct name *heap,                      \
+                                       name##_value_t value) {                 \
+        if (heap->size == heap->capacity && !name##_grow(heap, 1))             \
+            return HEAP_INVALID_HANDLE;                                        \
+        size_t index = heap->size++;                                           \
+        uint32_t handle = heap->nodes[index].handle;                           \
+        heap->nodes[index].value = value;                                      \
+        name##_sift_up(heap, index);                                           \
+        return handle;                                                         \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_push_batch(struct name *heap,                    \
+                                         const name##_value_t *values,         \
+                                         size_t count, uint32_t *handles) {    \
+        if (!count)                                                            \
+            return true;                                                       \
+        if (!name##_grow(heap, count))                                         \
+            return false;                                                      \
+        size_t old_size = heap->size;                                          \
+        for (size_t i = 0; i < count; i++) {                                   \
+            heap->nodes[old_size + i].value = values[i];                       \
+            if (handles)                                                       \
+                handles[i] = heap->nodes[old_size + i].handle;                 \
+        }                                                                      \
+        heap->size += count;                                                   \
+        if (count < old_size) {                                                \
+            for (size_t i = old_size; i < heap->size; i++)                     \
+                name##_sift_up(heap, i);                                       \
+        } else if (heap->size > 1) {                                           \
+            /* Floyd's bottom-up heap construction, O(size) */                 \
+            for (size_t i = (heap->size - 2) / (arity) + 1; i-- > 0;)          \
+                name##_sift_down(heap, i);                                     \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline const name##_value_t *name##_top(const struct name *heap,    \
+                                                   uint32_t *handle) {         \
+        if (!heap->size)                                                       \
+            return NULL;                                                       \
+        if (handle)                                                            \
+            *handle = heap->nodes[0].handle;                                   \
+        return &heap->nodes[0].value;                                          \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_contains(const struct name *heap,                \
+                                       uint32_t handle) {                      \
+        return handle < heap->capacity                                         \
+               && heap->positions[handle] < heap->size;                        \
+    }                                                                          \
+                                                                               \
+    static inline const name##_value_t *name##_get(const struct name *heap,    \
+                                                   uint32_t handle) {          \
+        if (!name##_contains(heap, handle))                                    \
+            return NULL;                                                       \
+        return &heap->nodes[heap->positions[handle]].value;                    \
+    }                                                                          \
+                                                                               \
+    /* Removes the node at index, keeping its handle in the free area. */      \
+    static inline void name##_remove_at(struct name *heap, size_t index) {     \
+        struct name##_node removed = heap->nodes[index];                       \
+        size_t last = --heap->size;                                            \
+        if (index != last) {                                                   \
+            name##_place(heap, index, heap->nodes[last]);                      \
+            name##_place(heap, last, removed);                                 \
+            if (name##_sift_up(heap, index) == index)                          \
+                name##_sift_down(heap, index);                                 \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_pop(struct name *heap, name##_value_t *value,    \
+                                  uint32_t *handle) {                          \
+        if (!heap->size)                                                       \
+            return false;                                                      \
+        if (value)                                                             \
+            *value = heap->nodes[0].value;                                     \
+        if (handle)                                                            \
+            *handle = heap->nodes[0].handle;                                   \
+        name##_remove_at(heap, 0);                                             \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_remove(struct name *heap, uint32_t handle,       \
+                                     name##_value_t *value) {                  \
+        if (!name##_contains(heap, handle))                                    \
+            return false;                                                      \
+        size_t index = heap->positions[handle];                                \
+        if (value)                                                             \
+            *value = heap->nodes[index].value;                                 \
+        name##_remove_at(heap, index);                                         \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    /* Only sifts up: value must not go out after the current one. */          \
+    static inline bool name##_decrease_key(struct name *heap, uint32_t handle, \
+                                           name##_value_t value) {             \
+        if (!name##_contains(heap, handle))                                    \
+            return false;                                                      \
+        size_t index = heap->positions[handle];                                \
+        heap->nodes[index].value = value;                                      \
+        name##_sift_up(heap, index);                                           \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_update(struct name *heap, uint32_t handle,       \
+                                     name##_value_t value) {                   \
+        if (!name##_contains(heap, handle))                                    \
+            return false;                                                      \
+        size_t index = heap->positions[handle];                                \
+        heap->nodes[index].value = value;                                      \
+        if (name##_sift_up(heap, index) == index)                              \
+            name##_sift_down(heap, index);                                     \
+        return true;                                                           \
+    }
+
+#endif // __AYAZTUB__DATA_STRUCTURES__HEAP_H__
@@ -0,0 +1,138 @@
+/**
+ * @file interner.h
+ * @brief Thread-safe string interning table in C99.
+ *
+ * An interner maps every distinct string to a small, dense integer ID (0, 1,
+ * 2, ... in insertion order) and to a stable copy of the string. Interned
+ * strings can then be compared by ID or by pointer instead of strcmp(), and
+ * IDs can index plain arrays (per call-site state, metric tables, binary log
+ * dictionaries).
+ *
+ * - The table is append-only: strings are never removed, so IDs and
+ *   pointers stay valid until interner_destroy().
+ * - interner_find() and interner_str() take no lock: they only read with
+ *   atomic loads and never wait on writers.
+ * - interner_intern() takes a mutex only when the string is not interned yet.
+ * - Strings, hash tables and the ID directory live in an arena, so the
+ *   interner never frees memory before it is destroyed.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/interner.h>
+ *
+ * int main(void) {
+ *     struct interner *interner = interner_create(0);
+ *     if (!interner)
+ *         return 1;
+ *
+ *     const char *first;
+ *     uint32_t id = interner_intern_cstr(interner, "http.requests", &first);
+ *     const char *second;
+ *     interner_intern_cstr(interner, "http.requests", &second);
+ *     // same ID, and first == second
+ *     printf("%u: %s\n", id, interner_str(interner, id, NULL));
+ *
+ *     interner_destroy(interner);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__INTERNER_H__
+#define __AYAZTUB__DATA_STRUCTURES__INTERNER_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @def INTERNER_INVALID_ID
+ * @brief ID returned when a string is not found or cannot be interned.
+ */
+#define INTERNER_INVALID_ID UINT32_MAX
+
+/**
+ * @struct interner
+ * @brief Opaque string interning table.
+ */
+struct interner;
+
+/**
+ * @brief Creates a new interner.
+ *
+ * @param capacity Expected number of strings (0 for a default capacity).
+ * @return The new interner, or NULL on allocation failure.
+ */
+struct interner *interner_create(size_t capacity) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Destroys an interner and every interned string.
+ *
+ * @param interner The interner to destroy (can be NULL).
+ *
+ * @warning No other thread may use the interner anymore.
+ */
+void interner_destroy(struct interner *interner);
+
+/**
+ * @brief Interns a string.
+ *
+ * @param interner The interner.
+ * @param str The string bytes (copied by the interner, may contain '\0').
+ * @param size The number of bytes.
+ * @param interned Output stable, null terminated copy of the string (can be
+ * NULL).
+ * @return The ID of the string, or INTERNER_INVALID_ID on allocation failure.
+ */
+uint32_t interner_intern(struct interner *interner, const char *str,
+                         size_t size, const char **interned)
+    NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Interns a null terminated string.
+ *
+ * @param interner The interner.
+ * @param str The string.
+ * @param interned Output stable copy of the string (can be NULL).
+ * @return The ID of the string, or INTERNER_INVALID_ID on allocation failure.
+ */
+static inline uint32_t interner_intern_cstr(struct interner *interner,
+                                            const char *str,
+                                            const char **interned) {
+    return interner_intern(interner, str, strlen(str), interned);
+}
+
+/**
+ * @brief Gets the ID of a string without interning it (lock-free).
+ *
+ * @param interner The interner.
+ * @param str The string bytes.
+ * @param size The number of bytes.
+ * @return The ID of the string, or INTERNER_INVALID_ID if it is not interned.
+ */
+uint32_t interner_find(const struct interner *interner, const char *str,
+                       size_t size) NONNULL_POSITIONS(1, 2);
+
+/**
+ * @brief Gets the string of an ID (lock-free).
+ *
+ * @param interner The interner.
+ * @param id The ID returned by interner_intern().
+ * @param size Output string size (can be NULL).
+ * @return The null terminated string, or NULL if the ID is unknown.
+ */
+const char *interner_str(const struct interner *interner, uint32_t id,
+                         size_t *size) NONNULL_POSITIONS(1);
+
+/**
+ * @brief Gets the number of interned strings.
+ *
+ * IDs of interned strings are all below this number.
+ *
+ * @param interner The interner.
+ * @return The number of strings (a snapshot under concurrent interning).
+ */
+size_t interner_count(const struct interner *interner) NONNULL;
+
+#endif // __AYAZTUB__DATA_STRUCTURES__INTERNER_H__
@@ -0,0 +1,183 @@
+/**
+ * @file pool.h
+ * @brief Thread-safe fixed-size object pool (slab allocator) in C99.
+ *
+ * This library provides a slab allocator for objects of a single fixed size.
+ * Objects are carved from page-aligned slabs and handed out through small
+ * per-thread caches (magazines), so the common alloc/free path takes no lock
+ * and touches no shared cache line.
+ *
+ * When a thread cache overflows (typically because objects allocated by one
+ * thread are freed by another one), the surplus objects are pushed as a single
+ * batch on a lock-free global free list. Refilling a thread cache drains this
+ * list first and only falls back to the slab layer (under the pool mutex) when
+ * it is empty. Slabs whose objects are all back in the slab layer are released
+ * to the operating system by pool_trim().
+ *
+ * @warning pool_destroy() must only be called once no other thread uses the
+ * pool anymore. Objects still held by the user are invalidated.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/pool.h>
+ *
+ * struct connection {
+ *     int fd;
+ *     char buffer[256];
+ * };
+ *
+ * POOL_DECL(struct connection, connection)
+ *
+ * int main(void) {
+ *     struct pool *pool = connection_pool_create();
+ *     if (!pool)
+ *         return 1;
+ *
+ *     struct connection *conn = connection_pool_alloc(pool);
+ *     conn->fd = 0;
+ *     connection_pool_free(pool, conn);
+ *
+ *     pool_destroy(pool);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__POOL_H__
+#define __AYAZTUB__DATA_STRUCTURES__POOL_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stddef.h>
+
+/**
+ * @def POOL_SLAB_SIZE
+ * @brief Size in bytes of one slab (must be a power of two, at least a page).
+ *
+ * Slabs are aligned on their size so the slab owning an object is found by
+ * masking the object address.
+ */
+#ifndef POOL_SLAB_SIZE
+#    define POOL_SLAB_SIZE (64 * 1024)
+#endif // POOL_SLAB_SIZE
+
+/**
+ * @def POOL_MAGAZINE_SIZE
+ * @brief Number of objects cached by each thread for each pool.
+ */
+#ifndef POOL_MAGAZINE_SIZE
+#    define POOL_MAGAZINE_SIZE 64
+#endif // POOL_MAGAZINE_SIZE
+
+/**
+ * @struct pool
+ * @brief Opaque fixed-size object pool.
+ */
+struct pool;
+
+/**
+ * @struct pool_stats
+ * @brief Snapshot of the pool counters, see pool_get_stats().
+ */
+struct pool_stats {
+    size_t object_size; /**< Size of one object (after alignment) */
+    size_t objects_per_slab; /**< Number of objects in one slab */
+    size_t slabs; /**< Number of slabs currently mapped */
+    size_t empty_slabs; /**< Slabs with no object in use (trimmable) */
+    size_t slab_objects; /**< Objects taken out of the slab layer */
+};
+
+/**
+ * @brief Creates a new pool of fixed-size objects.
+ *
+ * @param object_size Size of one object in bytes. It is rounded up to keep
+ * every object suitably aligned.
+ * @return The new pool, or NULL if object_size is 0, too big for a slab, or on
+ * allocation failure.
+ */
+struct pool *pool_create(size_t object_size) WARN_UNUSED_RESULT;
+
+/**
+ * @brief Destroys a pool and releases all its slabs.
+ *
+ * @param pool The pool to destroy (can be NULL).
+ *
+ * @warning Every object allocated from the pool becomes invalid.
+ */
+void pool_destroy(struct pool *pool);
+
+/**
+ * @brief Allocates one object from the pool.
+ *
+ * @param pool The pool to allocate from.
+ * @return A pointer to an uninitialized object, or NULL on allocation failure.
+ */
+void *pool_alloc(struct pool *pool) NONNULL WARN_UNUSED_RESULT;
+
+/**
+ * @brief Gives an object back to the pool.
+ *
+ * The object may be freed by any thread, not only the allocating one.
+ *
+ * @param pool The pool the object was allocated from.
+ * @param ptr The object to free (can be NULL).
+ */
+void pool_free(struct pool *pool, void *ptr) NONNULL_POSITIONS(1);
+
+/**
+ * @brief Returns the calling thread cache to the pool.
+ *
+ * This is done automatically when the thread exits, but long-lived threads
+ * that stop using a pool may call it to make their cached objects reclaimable.
+ *
+ * @param pool The pool to flush the calling thread cache of.
+ */
+void pool_flush(struct pool *pool) NONNULL;
+
+/**
+ * @brief Releases the empty slabs of the pool to the operating system.
+ *
+ * Objects sitting in the lock-free global free list are first given back to
+ * their slab, so slabs only held by freed objects become empty.
+ *
+ * @param pool The pool to trim.
+ * @return The number of slabs released.
+ */
+size_t pool_trim(struct pool *pool) NONNULL;
+
+/**
+ * @brief Gets a snapshot of the pool counters.
+ *
+ * @param pool The pool to inspect.
+ * @param stats Output structure filled with the counters.
+ */
+void pool_get_stats(struct pool *pool, struct pool_stats *stats) NONNULL;
+
+/**
+ * @def POOL_DECL(type, name)
+ * @brief Macro to declare typed wrappers around a pool.
+ *
+ * @param type The type of the pooled objects.
+ * @param name The prefix of the generated functions.
+ *
+ * Example usage:
+ * @code
+ * POOL_DECL(struct request, request)
+ * // create the following functions:
+ * // static inline struct pool *request_pool_create(void);
+ * // static inline struct request *request_pool_alloc(struct pool *pool);
+ * // static inline void request_pool_free(struct pool *pool,
+ * //                                      struct request *obj);
+ * @endcode
+ */
+#define POOL_DECL(type, name)                                                  \
+    static inline struct pool *name##_pool_create(void) {                      \
+        return pool_create(sizeof(type));                                      \
+    }                                                                          \
+    static inline type *name##_pool_alloc(struct pool *pool) {                 \
+        return (type *)pool_alloc(pool);                                       \
+    }                                                                          \
+    static inline void name##_pool_free(struct pool *pool, type *obj) {        \
+        pool_free(pool, obj);                                                  \
+    }
+
+#endif // __AYAZTUB__DATA_STRUCTURES__POOL_H__
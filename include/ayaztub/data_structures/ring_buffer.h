@@ -0,0 +1,121 @@
+/**
+ * @file ring_buffer.h
+ * @brief Bounded lock-free queues (SPSC, MPSC and MPMC ring buffers) in C99.
+ *
+ * This library provides three fixed-capacity FIFO queues of fixed-size
+ * elements (copied in and out of the ring):
+ * - `struct spsc_ring`: one producer and one consumer thread, wait-free.
+ * - `struct mpsc_ring`: any number of producers, one consumer thread.
+ * - `struct mpmc_ring`: any number of producers and consumers.
+ *
+ * The producer and consumer indices live on their own cache lines, and the
+ * multi-producer/consumer rings use per-slot sequence numbers (D. Vyukov's
+ * bounded queue) so that threads only contend on a single compare exchange.
+ *
+ * Every ring has non-blocking operations (returning `false` when the ring is
+ * full or empty), batch operations moving several elements with a single
+ * index update, and blocking wrappers sleeping on a futex (Linux) until
+ * room or elements are available.
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/ring_buffer.h>
+ *
+ * int main(void) {
+ *     struct mpmc_ring *ring = mpmc_ring_create(1024, sizeof(int));
+ *     if (!ring)
+ *         return 1;
+ *
+ *     for (int i = 0; i < 10; i++)
+ *         mpmc_ring_push(ring, &i);
+ *
+ *     int values[10];
+ *     size_t count = mpmc_ring_pop_n(ring, values, 10);
+ *     printf("popped %zu values\n", count);
+ *
+ *     int value;
+ *     if (!mpmc_ring_pop_wait(ring, &value, 100))
+ *         printf("nothing received within 100ms\n");
+ *
+ *     mpmc_ring_destroy(ring);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__RING_BUFFER_H__
+#define __AYAZTUB__DATA_STRUCTURES__RING_BUFFER_H__
+
+#include <ayaztub/core_utils/util_attributes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @def RING_WAIT_FOREVER
+ * @brief Timeout of the blocking functions to wait without limit.
+ */
+#define RING_WAIT_FOREVER (-1)
+
+/**
+ * @def RING_DECL(name)
+ * @brief Declares the functions of a ring type.
+ *
+ * All ring types share the same interface:
+ * - `name_create(capacity, element_size)`: creates a ring holding at least
+ *   `capacity` elements (rounded up to a power of two), NULL on failure.
+ * - `name_destroy(ring)`: destroys a ring (can be NULL).
+ * - `name_push(ring, element)` / `name_pop(ring, element)`: copies one
+ *   element in or out, `false` if the ring is full / empty.
+ * - `name_push_n(ring, elements, count)` / `name_pop_n(ring, elements,
+ *   count)`: moves up to `count` contiguous elements, returns how many.
+ * - `name_push_wait(ring, element, timeout_ms)` / `name_pop_wait(ring,
+ *   element, timeout_ms)`: blocks until the operation succeeds or the timeout
+ *   (in milliseconds, RING_WAIT_FOREVER for none) expires.
+ * - `name_size(ring)`: number of elements (a snapshot under concurrency).
+ * - `name_capacity(ring)`: number of elements the ring can hold.
+ *
+ * @param name The ring type name (`struct name`).
+ */
+#define RING_DECL(name)                                                        \
+    struct name;                                                               \
+                                                                               \
+    struct name *name##_create(size_t capacity, size_t element_size)           \
+        WARN_UNUSED_RESULT;                                                    \
+    void name##_destroy(struct name *ring);                                    \
+    bool name##_push(struct name *ring, const void *element) NONNULL;          \
+    bool name##_pop(struct name *ring, void *element) NONNULL;                 \
+    size_t name##_push_n(struct name *ring, const void *elements,              \
+                         size_t count) NONNULL;                                \
+    size_t name##_pop_n(struct name *ring, void *elements, size_t count)       \
+        NONNULL;                                                               \
+    bool name##_push_wait(struct name *ring, const void *element,              \
+                          int timeout_ms) NONNULL;                             \
+    bool name##_pop_wait(struct name *ring, void *element, int timeout_ms)     \
+        NONNULL;                                                               \
+    size_t name##_size(const struct name *ring) NONNULL;                       \
+    size_t name##_capacity(const struct name *ring) NONNULL;
+
+/**
+ * @struct spsc_ring
+ * @brief Single producer, single consumer ring (wait-free).
+ *
+ * @warning Pushing from two threads (or popping from two threads) at the same
+ * time is undefined behavior.
+ */
+RING_DECL(spsc_ring)
+
+/**
+ * @struct mpsc_ring
+ * @brief Multiple producers, single consumer ring.
+ *
+ * @warning Popping from two threads at the same time is undefined behavior.
+ */
+RING_DECL(mpsc_ring)
+
+/**
+ * @struct mpmc_ring
+ * @brief Multiple producers, multiple consumers ring.
+ */
+RING_DECL(mpmc_ring)
+
+#endif // __AYAZTUB__DATA_STRUCTURES__RING_BUFFER_H__
@@ -0,0 +1,310 @@
+/**
+ * @file vector.h
+ * @brief Type-safe dynamic arrays with small-buffer optimization in C99.
+ *
+ * The VEC_DECL() macro generates a vector structure and its functions for a
+ * given element type, in the same way debug.h generates its dbg functions.
+ * The first elements are stored inline in the vector structure itself, so
+ * short vectors never allocate. Once the inline storage is full, the vector
+ * grows geometrically using the allocator given at initialization (malloc()
+ * by default, or an arena through arena_allocator()).
+ *
+ * @warning Because the inline storage is part of the structure, a vector must
+ * NOT be copied by value: always pass it by pointer.
+ *
+ * @warning Elements are moved with memcpy()/memmove(), so the element type must
+ * be trivially relocatable (no pointer into itself).
+ *
+ * @code
+ * // usage example
+ * #include <ayaztub/data_structures/vector.h>
+ * #include <ayaztub/core_utils/debug.h>
+ *
+ * VEC_DECL(int, ivec)
+ *
+ * int main(void) {
+ *     struct ivec vec;
+ *     ivec_init(&vec, NULL);
+ *
+ *     for (int i = 0; i < 100; i++) {
+ *         if (!ivec_push(&vec, i)) {
+ *             ivec_deinit(&vec);
+ *             return 1;
+ *         }
+ *     }
+ *     ivec_erase(&vec, 10, 80); // remove [10, 90)
+ *     dbg_vec(&vec);
+ *
+ *     ivec_deinit(&vec);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef __AYAZTUB__DATA_STRUCTURES__VECTOR_H__
+#define __AYAZTUB__DATA_STRUCTURES__VECTOR_H__
+
+#include <ayaztub/data_structures/allocator.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @def VEC_INLINE_BYTES
+ * @brief Size in bytes of the inline storage of the vectors declared with
+ * VEC_DECL().
+ */
+#ifndef VEC_INLINE_BYTES
+#    define VEC_INLINE_BYTES 64
+#endif // VEC_INLINE_BYTES
+
+/**
+ * @def VEC_MIN_CAPACITY
+ * @brief Minimum capacity of a vector once it leaves its inline storage.
+ */
+#ifndef VEC_MIN_CAPACITY
+#    define VEC_MIN_CAPACITY 16
+#endif // VEC_MIN_CAPACITY
+
+/**
+ * @def VEC_INLINE_CAPACITY(type)
+ * @brief Number of elements of the given type fitting in VEC_INLINE_BYTES (at
+ * least one).
+ */
+#define VEC_INLINE_CAPACITY(type)                                              \
+    (sizeof(type) < VEC_INLINE_BYTES ? VEC_INLINE_BYTES / sizeof(type) : 1)
+
+/**
+ * @def dbg_vec(vec)
+ * @brief Macro to print a debug message for a vector with dbg_array().
+ *
+ * @note Requires <ayaztub/core_utils/debug.h> and an element type supported by
+ * dbg_array().
+ *
+ * @param vec A pointer to the vector to debug.
+ * @return the vector data pointer.
+ */
+#define dbg_vec(vec) dbg_array((vec)->data, (vec)->length)
+
+/**
+ * @def VEC_DECL(type, name)
+ * @brief Macro to declare a vector type with the default inline capacity.
+ *
+ * @param type The type of the elements.
+ * @param name The name of the vector structure and the prefix of its
+ * functions.
+ *
+ * @see VEC_DECL_INLINE()
+ */
+#define VEC_DECL(type, name)                                                   \
+    VEC_DECL_INLINE(type, name, VEC_INLINE_CAPACITY(type))
+
+/**
+ * @def VEC_DECL_INLINE(type, name, inline_capacity)
+ * @brief Macro to declare a vector type and its functions.
+ *
+ * @param type The type of the elements.
+ * @param name The name of the vector structure and the prefix of its
+ * functions.
+ * @param inline_capacity The number of elements stored inline (at least 1).
+ *
+ * Example usage:
+ * @code
+ * VEC_DECL_INLINE(double, dvec, 4)
+ * // create the following structures:
+ * // struct dvec { double *data; size_t length; size_t capacity; ... };
+ * // struct dvec_view { double *data; size_t length; };
+ * // and the following functions:
+ * // void dvec_init(struct dvec *vec, const struct allocator *allocator);
+ * // void dvec_deinit(struct dvec *vec);
+ * // bool dvec_is_inline(const struct dvec *vec);
+ * // bool dvec_reserve(struct dvec *vec, size_t capacity);
+ * // bool dvec_push(struct dvec *vec, double value);
+ * // double dvec_pop(struct dvec *vec);
+ * // double *dvec_at(const struct dvec *vec, size_t index);
+ * // bool dvec_append(struct dvec *vec, const double *values, size_t count);
+ * // bool dvec_insert(struct dvec *vec, size_t index, const double *values,
+ * //                  size_t count);
+ * // void dvec_erase(struct dvec *vec, size_t index, size_t count);
+ * // void dvec_clear(struct dvec *vec);
+ * // bool dvec_shrink_to_fit(struct dvec *vec);
+ * // struct dvec_view dvec_view(const struct dvec *vec);
+ * @endcode
+ *
+ * @note The allocator given to init is kept by pointer and must outlive the
+ * vector. Functions returning a bool return false on allocation failure (or
+ * size overflow) and leave the vector untouched.
+ *
+ * @warning The values given to append/insert must not point inside the vector
+ * itself as the storage may move.
+ */
+#define VEC_DECL_INLINE(type, name, inline_capacity)                           \
+    typedef type name##_value_t;                                               \
+                                                                               \
+    struct name {                                                              \
+        name##_value_t *data;                                                  \
+        size_t length;                                                         \
+        size_t capacity;                                                       \
+        const struct allocator *allocator;                                     \
+        name##_value_t inline_data[inline_capacity];                           \
+    };                                                                         \
+                                                                               \
+    struct name##_view {                                                       \
+        name##_value_t *data;                                                  \
+        size_t length;                                                         \
+    };                                                                         \
+                                                                               \
+    static inline void name##_init(struct name *vec,                           \
+                                   const struct allocator *allocator) {        \
+        vec->data = vec->inline_data;                                          \
+        vec->length = 0;                                                       \
+        vec->capacity = (inline_capacity);                                     \
+        vec->allocator = allocator;                                            \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_is_inline(const struct name *vec) {              \
+        return vec->data == vec->inline_data;                                  \
+    }                                                                          \
+                                                                               \
+    static inline void name##_deinit(struct name *vec) {                       \
+        if (!name##_is_inline(vec))                                            \
+            allocator_free(vec->allocator, vec->data,                          \
+                           vec->capacity * sizeof(name##_value_t));            \
+        name##_init(vec, vec->allocator);                                      \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_reserve(struct name *vec, size_t capacity) {     \
+        if (capacity <= vec->capacity)                                         \
+            return true;                                                       \
+        if (capacity > SIZE_MAX / sizeof(name##_value_t))                      \
+            return false;                                                      \
+                                                                               \
+        name##_value_t *data;                                                  \
+        size_t size = capacity * sizeof(name##_value_t);                       \
+        if (name##_is_inline(vec)) {                                           \
+            data = allocator_realloc(vec->allocator, NULL, 0, size);           \
+            if (!data)                                                         \
+                return false;                                                  \
+            memcpy(data, vec->inline_data,                                     \
+                   vec->length * sizeof(name##_value_t));                      \
+        } else {                                                               \
+            data = allocator_realloc(vec->allocator, vec->data,                \
+                                     vec->capacity * sizeof(name##_value_t),   \
+                                     size);                                    \
+            if (!data)                                                         \
+                return false;                                                  \
+        }                                                                      \
+                                                                               \
+        vec->data = data;                                                      \
+        vec->capacity = capacity;                                              \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_grow(struct name *vec, size_t additional) {      \
+        if (additional > SIZE_MAX - vec->length)                               \
+            return false;                                                      \
+        size_t needed = vec->length + additional;                              \
+        if (needed <= vec->capacity)                                           \
+            return true;                                                       \
+                                                                               \
+        /* geometric growth (x1.5) to keep appends amortized O(1) */           \
+        size_t capacity = vec->capacity + vec->capacity / 2;                   \
+        if (capacity < VEC_MIN_CAPACITY)                                       \
+            capacity = VEC_MIN_CAPACITY;                                       \
+        if (capacity < needed)                                                 \
+            capacity = needed;                                                 \
+        return name##_reserve(vec, capacity) || name##_reserve(vec, needed);   \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_push(struct name *vec, name##_value_t value) {   \
+        if (vec->length == vec->capacity && !name##_grow(vec, 1))              \
+            return false;                                                      \
+        vec->data[vec->length++] = value;                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t name##_pop(struct name *vec) {                \
+        return vec->data[--vec->length];                                       \
+    }                                                                          \
+                                                                               \
+    static inline name##_value_t *name##_at(const struct name *vec,            \
+                                            size_t index) {                    \
+        return index < vec->length ? vec->data + index : NULL;                 \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_append(struct name *vec,                         \
+                                     const name##_value_t *values,             \
+                                     size_t count) {                           \
+        if (!count)                                                            \
+            return true;                                                       \
+        if (!name##_grow(vec, count))                                          \
+            return false;                                                      \
+        memcpy(vec->data + vec->length, values,                                \
+               count * sizeof(name##_value_t));                                \
+        vec->length += count;                                                  \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_insert(struct name *vec, size_t index,           \
+                                     const name##_value_t *values,             \
+                                     size_t count) {                           \
+        if (index > vec->length)                                               \
+            return false;                                                      \
+        if (!count)                                                            \
+            return true;                                                       \
+        if (!name##_grow(vec, count))                                          \
+            return false;                                                      \
+        memmove(vec->data + index + count, vec->data + index,                  \
+                (vec->length - index) * sizeof(name##_value_t));               \
+        memcpy(vec->data + index, values, count * sizeof(name##_value_t));     \
+        vec->length += count;                                                  \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_erase(struct name *vec, size_t index,            \
+                                    size_t count) {                            \
+        if (index >= vec->length)                                              \
+            return;                                                            \
+        if (count > vec->length - index)                                       \
+            count = vec->length - index;                                       \
+        memmove(vec->data + index, vec->data + index + count,                  \
+                (vec->length - index - count) * sizeof(name##_value_t));       \
+        vec->length -= count;                                                  \
+    }                                                                          \
+                                                                               \
+    static inline void name##_clear(struct name *vec) {                        \
+        vec->length = 0;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline bool name##_shrink_to_fit(struct name *vec) {                \
+        if (name##_is_inline(vec) || vec->length == vec->capacity)             \
+            return true;                                                       \
+                                                                               \
+        size_t old_size = vec->capacity * sizeof(name##_value_t);              \
+        if (vec->length <= (inline_capacity)) {                                \
+            name##_value_t *data = vec->data;                                  \
+            memcpy(vec->inline_data, data,                                     \
+                   vec->length * sizeof(name##_value_t));                      \
+            allocator_free(vec->allocator, data, old_size);                    \
+            vec->data = vec->inline_data;                                      \
+            vec->capacity = (inline_capacity);                                 \
+            return true;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_value_t *data = allocator_realloc(                              \
+            vec->allocator, vec->data, old_size,                               \
+            vec->length * sizeof(name##_value_t));                             \
+        if (!data)                                                             \
+            return false;                                                      \
+        vec->data = data;                                                      \
+        vec->capacity = vec->length;                                           \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline struct name##_view name##_view(const struct name *vec) {     \
+        struct name##_view view = { vec->data, vec->length };                  \
+        return view;                                                           \
+    }
+
+#endif // __AYAZTUB__DATA_STRUCTURES__VECTOR_H__
@@ -0,0 +1,334 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/ebr.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/pool.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CACHE_LINE_SIZE 64
+#define EBR_LIMBO_COUNT 3
+
+/*
+ * Classic three epochs scheme:
+ * - Each thread announces `(epoch << 1) | 1` while in a critical section and
+ *   0 outside of it.
+ * - The global epoch can move from E to E + 1 once every active thread has
+ *   announced E. An object retired at epoch E can thus only be seen by
+ *   threads announcing E - 1 or E, and is safe to free at epoch E + 2.
+ * - Each thread keeps one limbo list per epoch modulo 3. Two lists of the
+ *   same slot are at least three epochs apart: the older one is safe. Lists
+ *   of exited threads are added late with their own (older) epoch, so the
+ *   epochs are compared rather than the newest list assumed to be the added
+ *   one.
+ */
+
+struct ebr_limbo {
+    uint64_t epoch;
+    struct ebr_node *head;
+    size_t count;
+};
+
+struct ebr_record {
+    uint64_t announce; // written by the owner, read by reclaimers
+    char _pad[CACHE_LINE_SIZE - sizeof(uint64_t)];
+
+    struct ebr_record *next; /**< registry link, never removed */
+    bool in_use;
+    unsigned nesting;
+    size_t retired_since_collect;
+    struct ebr_limbo limbo[EBR_LIMBO_COUNT];
+};
+
+struct ebr_ptr_node {
+    struct ebr_node node;
+    void *ptr;
+    ebr_free_ptr_t free;
+    void *ctx;
+};
+
+static struct {
+    uint64_t epoch;
+    char _pad[CACHE_LINE_SIZE - sizeof(uint64_t)];
+
+    struct ebr_record *records;
+    pthread_key_t key;
+    bool has_key; /**< without key, threads have no record */
+    struct pool *ptr_pool;
+
+    // Threads without record (allocation failure) block the epoch instead.
+    unsigned long unregistered_readers;
+
+    // Objects retired by exited (or unregistered) threads.
+    pthread_mutex_t orphans_lock;
+    struct ebr_limbo orphans[EBR_LIMBO_COUNT];
+} ebr = { .orphans_lock = PTHREAD_MUTEX_INITIALIZER };
+
+static pthread_once_t ebr_once = PTHREAD_ONCE_INIT;
+
+// ---------- Limbo Lists ---------- //
+static size_t limbo_free(struct ebr_limbo *limbo) {
+    size_t count = limbo->count;
+    struct ebr_node *node = limbo->head;
+    limbo->head = NULL;
+    limbo->count = 0;
+
+    while (node) {
+        struct ebr_node *next = node->next;
+        node->free(node);
+        node = next;
+    }
+    return count;
+}
+
+static size_t limbo_free_if_safe(struct ebr_limbo *limbo, uint64_t epoch) {
+    if (limbo->head && limbo->epoch + 2 <= epoch)
+        return limbo_free(limbo);
+    return 0;
+}
+
+// Adds a node or a whole list retired at `epoch` to a set of limbo lists.
+static void limbo_add(struct ebr_limbo *limbos, uint64_t epoch,
+                      struct ebr_node *head, size_t count) {
+    struct ebr_limbo *limbo = &limbos[epoch % EBR_LIMBO_COUNT];
+    if (limbo->head && limbo->epoch > epoch) {
+        // the added list is at least three epochs older than the current one
+        struct ebr_limbo old = { epoch, head, count };
+        limbo_free(&old);
+        return;
+    }
+    if (limbo->head && limbo->epoch < epoch)
+        limbo_free(limbo); // at least three epochs old
+
+    limbo->epoch = epoch;
+    struct ebr_node *tail = head;
+    while (tail->next)
+        tail = tail->next;
+    tail->next = limbo->head;
+    limbo->head = head;
+    limbo->count += count;
+}
+
+static void orphans_add(uint64_t epoch, struct ebr_node *head, size_t count) {
+    pthread_mutex_lock(&ebr.orphans_lock);
+    limbo_add(ebr.orphans, epoch, head, count);
+    pthread_mutex_unlock(&ebr.orphans_lock);
+}
+
+static void orphans_collect(uint64_t epoch, bool wait) {
+    if (wait)
+        pthread_mutex_lock(&ebr.orphans_lock);
+    else if (pthread_mutex_trylock(&ebr.orphans_lock) != 0)
+        return;
+
+    for (size_t i = 0; i < EBR_LIMBO_COUNT; i++)
+        limbo_free_if_safe(&ebr.orphans[i], epoch);
+    pthread_mutex_unlock(&ebr.orphans_lock);
+}
+
+// ---------- Thread Records ---------- //
+static void record_release(void *data) {
+    struct ebr_record *record = data;
+
+    __atomic_store_n(&record->announce, 0, __ATOMIC_RELEASE);
+    record->nesting = 0;
+    record->retired_since_collect = 0;
+    for (size_t i = 0; i < EBR_LIMBO_COUNT; i++) {
+        struct ebr_limbo *limbo = &record->limbo[i];
+        if (limbo->head)
+            orphans_add(limbo->epoch, limbo->head, limbo->count);
+        limbo->head = NULL;
+        limbo->count = 0;
+    }
+    __atomic_store_n(&record->in_use, false, __ATOMIC_RELEASE);
+}
+
+static void ebr_init(void) {
+    ebr.has_key = pthread_key_create(&ebr.key, record_release) == 0;
+    ebr.ptr_pool = pool_create(sizeof(struct ebr_ptr_node));
+}
+
+static struct ebr_record *record_get(void) {
+    pthread_once(&ebr_once, ebr_init);
+    if (!ebr.has_key)
+        return NULL;
+
+    struct ebr_record *record = pthread_getspecific(ebr.key);
+    if (record)
+        return record;
+
+    // reuse the record of an exited thread
+    record = __atomic_load_n(&ebr.records, __ATOMIC_ACQUIRE);
+    for (; record; record = record->next) {
+        bool in_use = false;
+        if (!__atomic_load_n(&record->in_use, __ATOMIC_RELAXED)
+            && __atomic_compare_exchange_n(&record->in_use, &in_use, true,
+                                           false, __ATOMIC_ACQUIRE,
+                                           __ATOMIC_RELAXED))
+            break;
+    }
+
+    if (!record) {
+        record = calloc(1, sizeof(struct ebr_record));
+        if (!record)
+            return NULL;
+        record->in_use = true;
+        record->next = __atomic_load_n(&ebr.records, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&ebr.records, &record->next,
+                                            record, true, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED))
+            ;
+    }
+
+    if (pthread_setspecific(ebr.key, record) != 0) {
+        __atomic_store_n(&record->in_use, false, __ATOMIC_RELEASE);
+        return NULL;
+    }
+    return record;
+}
+
+// ---------- Epochs ---------- //
+static uint64_t try_advance(void) {
+    uint64_t epoch = __atomic_load_n(&ebr.epoch, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ebr.unregistered_readers, __ATOMIC_SEQ_CST))
+        return epoch;
+
+    struct ebr_record *record =
+        __atomic_load_n(&ebr.records, __ATOMIC_ACQUIRE);
+    for (; record; record = record->next) {
+        uint64_t announce =
+            __atomic_load_n(&record->announce, __ATOMIC_SEQ_CST);
+        if ((announce & 1) && (announce >> 1) != epoch)
+            return epoch;
+    }
+
+    if (__atomic_compare_exchange_n(&ebr.epoch, &epoch, epoch + 1, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        return epoch + 1;
+    return epoch; // updated by the failed compare exchange
+}
+
+static void record_collect(struct ebr_record *record, uint64_t epoch) {
+    for (size_t i = 0; i < EBR_LIMBO_COUNT; i++)
+        limbo_free_if_safe(&record->limbo[i], epoch);
+    record->retired_since_collect = 0;
+}
+
+// ---------- EBR Functions ---------- //
+void ebr_enter(void) {
+    struct ebr_record *record = record_get();
+    if (!record) {
+        __atomic_add_fetch(&ebr.unregistered_readers, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    if (record->nesting++ == 0) {
+        uint64_t epoch = __atomic_load_n(&ebr.epoch, __ATOMIC_RELAXED);
+        __atomic_store_n(&record->announce, (epoch << 1) | 1,
+                         __ATOMIC_RELAXED);
+        // the announce must be visible before any read of shared pointers
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+void ebr_exit(void) {
+    struct ebr_record *record = ebr.has_key ? pthread_getspecific(ebr.key)
+                                            : NULL;
+    if (!record) {
+        __atomic_sub_fetch(&ebr.unregistered_readers, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    if (--record->nesting == 0)
+        __atomic_store_n(&record->announce, 0, __ATOMIC_RELEASE);
+}
+
+void ebr_retire(struct ebr_node *node, ebr_free_t free_fn) {
+    node->free = free_fn;
+    node->next = NULL;
+
+    struct ebr_record *record = record_get();
+    uint64_t epoch = __atomic_load_n(&ebr.epoch, __ATOMIC_SEQ_CST);
+    if (!record) {
+        orphans_add(epoch, node, 1);
+        return;
+    }
+
+    limbo_add(record->limbo, epoch, node, 1);
+    if (++record->retired_since_collect >= EBR_BATCH_SIZE)
+        ebr_collect();
+}
+
+static void ptr_node_free(struct ebr_node *node) {
+    struct ebr_ptr_node *ptr_node = (struct ebr_ptr_node *)node;
+    ptr_node->free(ptr_node->ptr, ptr_node->ctx);
+    pool_free(ebr.ptr_pool, ptr_node);
+}
+
+bool ebr_retire_ptr(void *ptr, ebr_free_ptr_t free_fn, void *ctx) {
+    pthread_once(&ebr_once, ebr_init);
+    if (!ebr.ptr_pool)
+        return false;
+
+    struct ebr_ptr_node *ptr_node = pool_alloc(ebr.ptr_pool);
+    if (!ptr_node)
+        return false;
+
+    ptr_node->ptr = ptr;
+    ptr_node->free = free_fn;
+    ptr_node->ctx = ctx;
+    ebr_retire(&ptr_node->node, ptr_node_free);
+    return true;
+}
+
+void ebr_collect(void) {
+    struct ebr_record *record = record_get();
+    uint64_t epoch = try_advance();
+    if (record)
+        record_collect(record, epoch);
+    orphans_collect(epoch, false);
+}
+
+void ebr_synchronize(void) {
+    struct ebr_record *record = record_get();
+    if (record && record->nesting)
+        return;
+
+    uint64_t target = __atomic_load_n(&ebr.epoch, __ATOMIC_SEQ_CST) + 2;
+    uint64_t epoch;
+    while ((epoch = try_advance()) < target)
+        sched_yield();
+
+    if (record)
+        record_collect(record, epoch);
+    orphans_collect(epoch, true);
+}
+
+size_t ebr_pending(void) {
+    struct ebr_record *record = record_get();
+    if (!record)
+        return 0;
+
+    size_t pending = 0;
+    for (size_t i = 0; i < EBR_LIMBO_COUNT; i++)
+        pending += record->limbo[i].count;
+    return pending;
+}
+
+// ---------- ebr_retire_ptr() callbacks ---------- //
+void ebr_free_malloc(void *ptr, UNUSED void *ctx) {
+    free(ptr);
+}
+
+void ebr_free_pool_object(void *ptr, void *ctx) {
+    pool_free(ctx, ptr);
+}
+
+void ebr_free_arena(void *ptr, UNUSED void *ctx) {
+    arena_destroy(ptr);
+}
@@ -0,0 +1,210 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/sync.h>
+
+#include <limits.h>
+#include <sched.h>
+#include <stddef.h>
+
+#ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif // __linux__
+
+// ---------- Futex ---------- //
+static void futex_wait(uint32_t *addr, uint32_t value) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+    (void)addr;
+    (void)value;
+    sched_yield();
+#endif // __linux__
+}
+
+static void futex_wake(uint32_t *addr, int count) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+#else
+    (void)addr;
+    (void)count;
+#endif // __linux__
+}
+
+/*
+ * Spinning waiters yield the CPU after a while: a spinlock owner (or, for the
+ * FIFO locks, the next waiter in line) may be preempted, and pure spinning
+ * would then burn whole time slices when threads outnumber CPUs.
+ */
+static void spin_wait(unsigned *spins) {
+    if (*spins < SYNC_SPIN_COUNT) {
+        (*spins)++;
+        sync_cpu_relax();
+    } else {
+        sched_yield();
+    }
+}
+
+struct sync_stats sync_stats_read(const struct sync_stats *stats) {
+    struct sync_stats snapshot;
+    snapshot.acquisitions =
+        __atomic_load_n(&stats->acquisitions, __ATOMIC_RELAXED);
+    snapshot.contentions =
+        __atomic_load_n(&stats->contentions, __ATOMIC_RELAXED);
+    snapshot.sleeps = __atomic_load_n(&stats->sleeps, __ATOMIC_RELAXED);
+    return snapshot;
+}
+
+// ---------- Futex Mutex ---------- //
+/*
+ * U. Drepper, "Futexes Are Tricky", mutex 3 (with a spinning phase): a thread
+ * about to sleep sets the state to 2 so that the owner knows it must wake
+ * someone on unlock. A woken thread also takes the lock with state 2, as it
+ * cannot know whether others still sleep.
+ */
+void sync_mutex_lock_slow(struct sync_mutex *mutex) {
+    SYNC_STAT_ADD(&mutex->stats, contentions);
+
+    for (int i = 0; i < SYNC_SPIN_COUNT; i++) {
+        sync_cpu_relax();
+        if (__atomic_load_n(&mutex->state, __ATOMIC_RELAXED) == 0
+            && sync_mutex_trylock(mutex))
+            return;
+    }
+
+    while (__atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE) != 0) {
+        SYNC_STAT_ADD(&mutex->stats, sleeps);
+        futex_wait(&mutex->state, 2);
+    }
+    SYNC_STAT_ADD_LOCKED(&mutex->stats, acquisitions);
+}
+
+void sync_mutex_wake(struct sync_mutex *mutex) {
+    futex_wake(&mutex->state, 1);
+}
+
+// ---------- Read-Mostly RW Lock ---------- //
+/*
+ * Readers increment the counter of their slot, then check the writer flag:
+ * if a writer is in (or waiting), they back off and sleep on the flag. The
+ * writer sets the flag, then waits for every slot to drain. Both sides use
+ * sequentially consistent operations so that either the reader sees the flag
+ * or the writer sees the reader.
+ */
+static __thread size_t reader_slot; // slot index + 1, 0 if not assigned yet
+static size_t next_reader_slot;
+
+static size_t thread_slot(void) {
+    if (!reader_slot)
+        reader_slot = __atomic_fetch_add(&next_reader_slot, 1, __ATOMIC_RELAXED)
+                % SYNC_RWLOCK_SLOTS
+            + 1;
+    return reader_slot - 1;
+}
+
+void sync_rwlock_read_lock(struct sync_rwlock *lock) {
+    size_t slot = thread_slot();
+    unsigned long *readers = &lock->slots[slot].readers;
+    bool contended = false;
+
+    for (;;) {
+        __atomic_add_fetch(readers, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&lock->writer, __ATOMIC_SEQ_CST))
+            break;
+
+        __atomic_sub_fetch(readers, 1, __ATOMIC_RELEASE);
+        contended = true;
+        while (__atomic_load_n(&lock->writer, __ATOMIC_ACQUIRE)) {
+            SYNC_STAT_ADD(&lock->stats, sleeps);
+            futex_wait(&lock->writer, 1);
+        }
+    }
+
+    if (contended)
+        SYNC_STAT_ADD(&lock->stats, contentions);
+    SYNC_STAT_ADD(&lock->slots[slot], reads);
+}
+
+void sync_rwlock_read_unlock(struct sync_rwlock *lock) {
+    __atomic_sub_fetch(&lock->slots[thread_slot()].readers, 1,
+                       __ATOMIC_RELEASE);
+}
+
+static bool readers_active(struct sync_rwlock *lock) {
+    for (size_t i = 0; i < SYNC_RWLOCK_SLOTS; i++) {
+        if (__atomic_load_n(&lock->slots[i].readers, __ATOMIC_SEQ_CST))
+            return true;
+    }
+    return false;
+}
+
+void sync_rwlock_write_lock(struct sync_rwlock *lock) {
+    sync_mutex_lock(&lock->writers);
+    __atomic_store_n(&lock->writer, 1, __ATOMIC_SEQ_CST);
+
+    // readers sections are short: spin, then yield the CPU to them
+    if (readers_active(lock)) {
+        SYNC_STAT_ADD(&lock->stats, contentions);
+        unsigned spins = 0;
+        while (readers_active(lock))
+            spin_wait(&spins);
+    }
+    SYNC_STAT_ADD_LOCKED(&lock->stats, acquisitions);
+}
+
+void sync_rwlock_write_unlock(struct sync_rwlock *lock) {
+    __atomic_store_n(&lock->writer, 0, __ATOMIC_RELEASE);
+    futex_wake(&lock->writer, INT_MAX);
+    sync_mutex_unlock(&lock->writers);
+}
+
+struct sync_stats sync_rwlock_stats(const struct sync_rwlock *lock) {
+    struct sync_stats stats = sync_stats_read(&lock->stats);
+    for (size_t i = 0; i < SYNC_RWLOCK_SLOTS; i++)
+        stats.acquisitions +=
+            __atomic_load_n(&lock->slots[i].reads, __ATOMIC_RELAXED);
+    return stats;
+}
+
+// ---------- Ticket Spinlock ---------- //
+void ticket_lock_wait(struct ticket_lock *lock, uint32_t ticket) {
+    SYNC_STAT_ADD(&lock->stats, contentions);
+    unsigned spins = 0;
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+        spin_wait(&spins);
+}
+
+// ---------- MCS Spinlock ---------- //
+void mcs_lock_acquire(struct mcs_lock *lock, struct mcs_node *node) {
+    node->next = NULL;
+    node->locked = true;
+
+    struct mcs_node *previous =
+        __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (previous) {
+        SYNC_STAT_ADD(&lock->stats, contentions);
+        __atomic_store_n(&previous->next, node, __ATOMIC_RELEASE);
+        unsigned spins = 0;
+        while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE))
+            spin_wait(&spins);
+    }
+    SYNC_STAT_ADD_LOCKED(&lock->stats, acquisitions);
+}
+
+void mcs_lock_release(struct mcs_lock *lock, struct mcs_node *node) {
+    struct mcs_node *next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    if (!next) {
+        struct mcs_node *expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            return;
+        // a successor is linking itself
+        unsigned spins = 0;
+        while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)))
+            spin_wait(&spins);
+    }
+    __atomic_store_n(&next->locked, false, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,712 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/thread_pool.h>
+#include <ayaztub/core_utils/logger.h>
+#include <ayaztub/data_structures/pool.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CACHE_LINE_SIZE 64
+#define DEQUE_INITIAL_SIZE 256
+#define DEFAULT_NAME "worker"
+#define GRAIN_SPLITS_PER_WORKER 8
+#define HELP_WAIT_NS 1000000L
+
+/*
+ * Design:
+ * - Every worker owns a Chase-Lev deque (D. Chase and Y. Lev, "Dynamic
+ *   Circular Work-Stealing Deque", with the C11 orderings of N.M. Le et al.):
+ *   the owner pushes and takes at `bottom`, thieves steal at `top`. Grown
+ *   arrays are kept until the pool is destroyed since thieves may still read
+ *   an old one (the element they read there is validated by their CAS).
+ * - Tasks submitted by other threads go to a mutex protected injection list.
+ * - Idle workers sleep on a condition variable. Submitters only take the
+ *   mutex when `sleepers` is not zero: a worker increments it then checks for
+ *   work before sleeping, a submitter publishes its task then reads it, both
+ *   with sequentially consistent operations.
+ * - Task structures come from a slab pool with per-thread caches.
+ */
+
+enum task_kind {
+    TASK_FUNC,
+    TASK_THEN,
+    TASK_RANGE,
+};
+
+struct parallel_for {
+    parallel_for_func_t func;
+    void *ctx;
+    size_t grain;
+    size_t pending; /**< range tasks not completed yet */
+};
+
+struct task {
+    struct task *next; /**< injection list or continuations link */
+    enum task_kind kind;
+    struct task_future *future;
+    union {
+        struct {
+            task_func_t func;
+            void *arg;
+        } func;
+        struct {
+            task_then_t func;
+            void *ctx;
+            void *result; /**< result of the previous task */
+        } then;
+        struct {
+            struct parallel_for *loop;
+            size_t begin;
+            size_t end;
+        } range;
+    } u;
+};
+
+struct task_future {
+    struct thread_pool *pool;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool done;
+    void *result;
+    unsigned refs;
+    struct task *continuations;
+};
+
+struct deque_array {
+    struct deque_array *previous; /**< freed with the pool */
+    int64_t size;
+    struct task *tasks[];
+};
+
+struct worker {
+    int64_t top;
+    char _pad_top[CACHE_LINE_SIZE - sizeof(int64_t)];
+    int64_t bottom;
+    struct deque_array *array;
+    struct thread_pool *pool;
+    pthread_t thread;
+    size_t index;
+    uint64_t seed;
+    char name[LOGGER_THREAD_NAME_SIZE];
+    char _pad_bottom[CACHE_LINE_SIZE];
+};
+
+struct thread_pool {
+    struct worker *workers;
+    size_t count;
+    struct pool *tasks;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake; /**< idle workers */
+    pthread_cond_t idle; /**< thread_pool_destroy() */
+    struct task *inject_head;
+    struct task *inject_tail;
+    unsigned sleepers;
+    size_t pending; /**< tasks created and not completed yet */
+    bool stop;
+};
+
+static __thread struct worker *current_worker;
+
+// ---------- Chase-Lev Deques ---------- //
+static struct deque_array *deque_array_create(int64_t size) {
+    struct deque_array *array =
+        malloc(sizeof(struct deque_array) + size * sizeof(struct task *));
+    if (array) {
+        array->previous = NULL;
+        array->size = size;
+    }
+    return array;
+}
+
+static inline struct task **deque_slot(struct deque_array *array,
+                                       int64_t index) {
+    return &array->tasks[index & (array->size - 1)];
+}
+
+// Owner only. Returns false if the deque is full and cannot grow.
+static bool deque_push(struct worker *worker, struct task *task) {
+    int64_t bottom = __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&worker->top, __ATOMIC_ACQUIRE);
+    struct deque_array *array =
+        __atomic_load_n(&worker->array, __ATOMIC_RELAXED);
+
+    if (bottom - top > array->size - 1) {
+        struct deque_array *grown = deque_array_create(2 * array->size);
+        if (!grown)
+            return false;
+        for (int64_t i = top; i < bottom; i++)
+            *deque_slot(grown, i) = __atomic_load_n(deque_slot(array, i),
+                                                    __ATOMIC_RELAXED);
+        grown->previous = array;
+        __atomic_store_n(&worker->array, grown, __ATOMIC_RELEASE);
+        array = grown;
+    }
+
+    __atomic_store_n(deque_slot(array, bottom), task, __ATOMIC_RELAXED);
+    // publishes the task to thieves (acquire load of bottom in deque_steal)
+    __atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Owner only.
+static struct task *deque_take(struct worker *worker) {
+    int64_t bottom = __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED) - 1;
+    struct deque_array *array =
+        __atomic_load_n(&worker->array, __ATOMIC_RELAXED);
+    __atomic_store_n(&worker->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&worker->top, __ATOMIC_RELAXED);
+
+    struct task *task = NULL;
+    if (top <= bottom) {
+        task = __atomic_load_n(deque_slot(array, bottom), __ATOMIC_RELAXED);
+        if (top == bottom) {
+            // last task: race against thieves
+            if (!__atomic_compare_exchange_n(&worker->top, &top, top + 1,
+                                             false, __ATOMIC_SEQ_CST,
+                                             __ATOMIC_RELAXED))
+                task = NULL;
+            __atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+static struct task *deque_steal(struct worker *victim) {
+    int64_t top = __atomic_load_n(&victim->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = __atomic_load_n(&victim->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom)
+        return NULL;
+
+    struct deque_array *array =
+        __atomic_load_n(&victim->array, __ATOMIC_ACQUIRE);
+    struct task *task =
+        __atomic_load_n(deque_slot(array, top), __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&victim->top, &top, top + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+    return task;
+}
+
+static bool deque_empty(struct worker *worker) {
+    return __atomic_load_n(&worker->top, __ATOMIC_SEQ_CST)
+        >= __atomic_load_n(&worker->bottom, __ATOMIC_SEQ_CST);
+}
+
+// ---------- Scheduling ---------- //
+static inline uint64_t next_random(uint64_t *seed) {
+    // xorshift64
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed;
+}
+
+static void wake_worker(struct thread_pool *pool) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void push_task(struct thread_pool *pool, struct task *task) {
+    struct worker *worker = current_worker;
+    if (!worker || worker->pool != pool || !deque_push(worker, task)) {
+        task->next = NULL;
+        pthread_mutex_lock(&pool->lock);
+        if (pool->inject_tail)
+            pool->inject_tail->next = task;
+        else
+            __atomic_store_n(&pool->inject_head, task, __ATOMIC_SEQ_CST);
+        pool->inject_tail = task;
+        pthread_mutex_unlock(&pool->lock);
+    }
+    wake_worker(pool);
+}
+
+static struct task *pop_injected(struct thread_pool *pool) {
+    if (!__atomic_load_n(&pool->inject_head, __ATOMIC_RELAXED))
+        return NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    struct task *task = pool->inject_head;
+    if (task) {
+        __atomic_store_n(&pool->inject_head, task->next, __ATOMIC_RELAXED);
+        if (!task->next)
+            pool->inject_tail = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return task;
+}
+
+static struct task *find_task(struct thread_pool *pool) {
+    struct worker *self = current_worker;
+    if (self && self->pool != pool)
+        self = NULL;
+
+    struct task *task = self ? deque_take(self) : NULL;
+    if (task)
+        return task;
+
+    // random victims first, then a full sweep before giving up
+    uint64_t seed = self ? self->seed : (uint64_t)(uintptr_t)&task | 1;
+    for (size_t i = 0; i < pool->count; i++) {
+        struct worker *victim =
+            &pool->workers[next_random(&seed) % pool->count];
+        if (victim != self && (task = deque_steal(victim)))
+            break;
+    }
+    for (size_t i = 0; !task && i < pool->count; i++) {
+        if (&pool->workers[i] != self)
+            task = deque_steal(&pool->workers[i]);
+    }
+    if (self)
+        self->seed = seed;
+
+    return task ? task : pop_injected(pool);
+}
+
+static bool has_work(struct thread_pool *pool) {
+    if (__atomic_load_n(&pool->inject_head, __ATOMIC_SEQ_CST))
+        return true;
+    for (size_t i = 0; i < pool->count; i++) {
+        if (!deque_empty(&pool->workers[i]))
+            return true;
+    }
+    return false;
+}
+
+// ---------- Tasks ---------- //
+static struct task *task_create(struct thread_pool *pool, enum task_kind kind,
+                                struct task_future *future) {
+    struct task *task = pool_alloc(pool->tasks);
+    if (!task)
+        return NULL;
+    task->next = NULL;
+    task->kind = kind;
+    task->future = future;
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_RELAXED);
+    return task;
+}
+
+static void task_done(struct thread_pool *pool, struct task *task) {
+    pool_free(pool->tasks, task);
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void future_release(struct task_future *future) {
+    if (__atomic_sub_fetch(&future->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_destroy(&future->lock);
+        pthread_cond_destroy(&future->cond);
+        free(future);
+    }
+}
+
+static void future_complete(struct task_future *future, void *result) {
+    pthread_mutex_lock(&future->lock);
+    future->result = result;
+    __atomic_store_n(&future->done, true, __ATOMIC_RELEASE);
+    struct task *continuations = future->continuations;
+    future->continuations = NULL;
+    pthread_cond_broadcast(&future->cond);
+    pthread_mutex_unlock(&future->lock);
+
+    while (continuations) {
+        struct task *next = continuations->next;
+        continuations->u.then.result = result;
+        push_task(future->pool, continuations);
+        continuations = next;
+    }
+    future_release(future);
+}
+
+static void run_range(struct thread_pool *pool, struct parallel_for *loop,
+                      size_t begin, size_t end) {
+    // keep the first half, expose the second one to thieves
+    while (end - begin > loop->grain) {
+        size_t middle = begin + (end - begin) / 2;
+        struct task *task = task_create(pool, TASK_RANGE, NULL);
+        if (!task)
+            break;
+        task->u.range.loop = loop;
+        task->u.range.begin = middle;
+        task->u.range.end = end;
+        __atomic_add_fetch(&loop->pending, 1, __ATOMIC_RELAXED);
+        push_task(pool, task);
+        end = middle;
+    }
+    loop->func(begin, end, loop->ctx);
+}
+
+static void task_run(struct thread_pool *pool, struct task *task) {
+    void *result = NULL;
+    switch (task->kind) {
+        case TASK_FUNC:
+            result = task->u.func.func(task->u.func.arg);
+            break;
+        case TASK_THEN:
+            result = task->u.then.func(task->u.then.result, task->u.then.ctx);
+            break;
+        case TASK_RANGE: {
+            struct parallel_for *loop = task->u.range.loop;
+            run_range(pool, loop, task->u.range.begin, task->u.range.end);
+            __atomic_sub_fetch(&loop->pending, 1, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+
+    struct task_future *future = task->future;
+    task_done(pool, task);
+    if (future)
+        future_complete(future, result);
+}
+
+// ---------- Workers ---------- //
+static void *worker_main(void *arg) {
+    struct worker *self = arg;
+    struct thread_pool *pool = self->pool;
+    current_worker = self;
+
+    logger_set_thread_name(self->name);
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), self->name);
+#endif // __linux__
+
+    for (;;) {
+        struct task *task = find_task(pool);
+        if (task) {
+            task_run(pool, task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        bool stop = pool->stop;
+        if (!stop && !has_work(pool))
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&pool->lock);
+        if (stop)
+            break;
+    }
+    return NULL;
+}
+
+// `<name>-<index>`, truncating the name rather than the index.
+static void worker_name(struct worker *worker, const char *name) {
+    char suffix[24];
+    int suffix_length = snprintf(suffix, sizeof(suffix), "-%zu", worker->index);
+    size_t length = strlen(name);
+    size_t max_length = sizeof(worker->name) - 1 - (size_t)suffix_length;
+    if (length > max_length)
+        length = max_length;
+    memcpy(worker->name, name, length);
+    memcpy(worker->name + length, suffix, (size_t)suffix_length + 1);
+}
+
+static void pin_worker(pthread_attr_t *attr, size_t index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+
+    int count = CPU_COUNT(&allowed);
+    if (count <= 0)
+        return;
+    int target = (int)(index % (size_t)count);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed) && target-- == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+            return;
+        }
+    }
+#else
+    (void)attr;
+    (void)index;
+#endif // __linux__
+}
+
+// ---------- Thread Pool Functions ---------- //
+static void pool_free_workers(struct thread_pool *pool) {
+    for (size_t i = 0; i < pool->count; i++) {
+        struct deque_array *array = pool->workers[i].array;
+        while (array) {
+            struct deque_array *previous = array->previous;
+            free(array);
+            array = previous;
+        }
+    }
+    free(pool->workers);
+}
+
+static void pool_stop(struct thread_pool *pool, size_t started) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < started; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    pool_free_workers(pool);
+    pool_destroy(pool->tasks);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    free(pool);
+}
+
+struct thread_pool *
+thread_pool_create(const struct thread_pool_options *options) {
+    struct thread_pool_options defaults = { 0 };
+    if (!options)
+        options = &defaults;
+
+    size_t count = options->threads;
+    if (count == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        count = online > 0 ? (size_t)online : 1;
+    }
+    const char *name = options->name ? options->name : DEFAULT_NAME;
+
+    struct thread_pool *pool = calloc(1, sizeof(struct thread_pool));
+    if (!pool)
+        return NULL;
+    void *workers = NULL;
+    if (count > SIZE_MAX / sizeof(struct worker)
+        || posix_memalign(&workers, CACHE_LINE_SIZE,
+                          count * sizeof(struct worker))
+            != 0) {
+        free(pool);
+        return NULL;
+    }
+    memset(workers, 0, count * sizeof(struct worker));
+    pool->workers = workers;
+    pool->count = count;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    pool->tasks = pool_create(sizeof(struct task));
+    if (!pool->tasks) {
+        pool_stop(pool, 0);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct worker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+        worker_name(worker, name);
+        worker->array = deque_array_create(DEQUE_INITIAL_SIZE);
+        if (!worker->array) {
+            pool_stop(pool, 0);
+            return NULL;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (options->pin_threads)
+            pin_worker(&attr, i);
+        int error = pthread_create(&pool->workers[i].thread, &attr,
+                                   worker_main, &pool->workers[i]);
+        pthread_attr_destroy(&attr);
+        if (error != 0) {
+            pool_stop(pool, i);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void thread_pool_destroy(struct thread_pool *pool) {
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE))
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_stop(pool, pool->count);
+}
+
+size_t thread_pool_size(const struct thread_pool *pool) {
+    return pool->count;
+}
+
+long thread_pool_worker_index(const struct thread_pool *pool) {
+    struct worker *worker = current_worker;
+    if (!worker || worker->pool != pool)
+        return -1;
+    return (long)worker->index;
+}
+
+bool thread_pool_submit(struct thread_pool *pool, task_func_t func,
+                        void *arg) {
+    struct task *task = task_create(pool, TASK_FUNC, NULL);
+    if (!task)
+        return false;
+    task->u.func.func = func;
+    task->u.func.arg = arg;
+    push_task(pool, task);
+    return true;
+}
+
+static struct task_future *future_create(struct thread_pool *pool) {
+    struct task_future *future = calloc(1, sizeof(struct task_future));
+    if (!future)
+        return NULL;
+    future->pool = pool;
+    future->refs = 2; // the caller and the task
+    pthread_mutex_init(&future->lock, NULL);
+    pthread_cond_init(&future->cond, NULL);
+    return future;
+}
+
+struct task_future *thread_pool_async(struct thread_pool *pool,
+                                      task_func_t func, void *arg) {
+    struct task_future *future = future_create(pool);
+    if (!future)
+        return NULL;
+    struct task *task = task_create(pool, TASK_FUNC, future);
+    if (!task) {
+        future_release(future);
+        future_release(future);
+        return NULL;
+    }
+    task->u.func.func = func;
+    task->u.func.arg = arg;
+    push_task(pool, task);
+    return future;
+}
+
+void thread_pool_parallel_for(struct thread_pool *pool, size_t begin,
+                              size_t end, size_t grain,
+                              parallel_for_func_t func, void *ctx) {
+    if (begin >= end)
+        return;
+    if (grain == 0) {
+        grain = (end - begin) / (pool->count * GRAIN_SPLITS_PER_WORKER);
+        if (grain == 0)
+            grain = 1;
+    }
+
+    struct parallel_for loop = {
+        .func = func,
+        .ctx = ctx,
+        .grain = grain,
+        .pending = 0,
+    };
+    run_range(pool, &loop, begin, end);
+
+    // help with the remaining sub-ranges (or any other task)
+    while (__atomic_load_n(&loop.pending, __ATOMIC_ACQUIRE)) {
+        struct task *task = find_task(pool);
+        if (task)
+            task_run(pool, task);
+        else
+            sched_yield();
+    }
+}
+
+// ---------- Futures ---------- //
+void *task_future_wait(struct task_future *future) {
+    struct thread_pool *pool = future->pool;
+    bool worker = current_worker && current_worker->pool == pool;
+
+    while (!__atomic_load_n(&future->done, __ATOMIC_ACQUIRE)) {
+        // a worker blocking here could starve the task it waits for
+        if (worker) {
+            struct task *task = find_task(pool);
+            if (task) {
+                task_run(pool, task);
+                continue;
+            }
+        }
+
+        pthread_mutex_lock(&future->lock);
+        if (!future->done && worker) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += HELP_WAIT_NS;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&future->cond, &future->lock, &deadline);
+        } else if (!future->done) {
+            pthread_cond_wait(&future->cond, &future->lock);
+        }
+        pthread_mutex_unlock(&future->lock);
+    }
+    return future->result;
+}
+
+bool task_future_ready(struct task_future *future, void **result) {
+    if (!__atomic_load_n(&future->done, __ATOMIC_ACQUIRE))
+        return false;
+    if (result)
+        *result = future->result;
+    return true;
+}
+
+struct task_future *task_future_then(struct task_future *future,
+                                     task_then_t func, void *ctx) {
+    struct thread_pool *pool = future->pool;
+    struct task_future *next = future_create(pool);
+    if (!next)
+        return NULL;
+    struct task *task = task_create(pool, TASK_THEN, next);
+    if (!task) {
+        future_release(next);
+        future_release(next);
+        return NULL;
+    }
+    task->u.then.func = func;
+    task->u.then.ctx = ctx;
+
+    pthread_mutex_lock(&future->lock);
+    bool done = future->done;
+    if (!done) {
+        task->next = future->continuations;
+        future->continuations = task;
+    }
+    pthread_mutex_unlock(&future->lock);
+
+    if (done) {
+        task->u.then.result = future->result;
+        push_task(pool, task);
+    }
+    return next;
+}
+
+void task_future_destroy(struct task_future *future) {
+    if (future)
+        future_release(future);
+}
@@ -0,0 +1,382 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/timer_wheel.h>
+#include <ayaztub/core_utils/bits.h>
+#include <ayaztub/core_utils/logger.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1u << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define SLOT_BATCH UINT32_MAX // timer in a local list of timer_wheel_advance()
+#define THREAD_NAME "timer"
+
+/*
+ * Design:
+ * - A pending timer lives in the slot of the level given by the highest
+ *   6 bits group where its expiry tick differs from the current tick, at the
+ *   index given by that group of its expiry. As the time moves forward, the
+ *   slots of every level whose index is passed are emptied: their timers
+ *   either expired or are inserted again, in a lower level.
+ * - Each level keeps a bitmap of its non-empty slots, so advancing by any
+ *   number of ticks and computing the next expiry cost O(levels), whatever
+ *   the number of empty slots in between.
+ * - Slots are NULL terminated doubly linked lists where each timer points to
+ *   the pointer referencing it (`pprev`), which makes unlinking O(1) without
+ *   knowing the list head.
+ */
+
+struct timer_wheel {
+    uint64_t now;
+    size_t count;
+    uint64_t occupied[TIMER_WHEEL_LEVELS];
+    struct timer *slots[TIMER_WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+// ---------- Timer Lists ---------- //
+static void list_push(struct timer **head, struct timer *timer) {
+    timer->next = *head;
+    if (timer->next)
+        timer->next->pprev = &timer->next;
+    timer->pprev = head;
+    *head = timer;
+}
+
+static void list_unlink(struct timer *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next)
+        timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+static inline uint64_t rotate_left(uint64_t mask, unsigned shift) {
+    shift &= 63;
+    return shift ? (mask << shift) | (mask >> (64 - shift)) : mask;
+}
+
+// ---------- Timing Wheel ---------- //
+static void wheel_insert(struct timer_wheel *wheel, struct timer *timer) {
+    // expires > now, so both differ in at least one bit, except once now
+    // reached the last tick: the timer then waits in the current slot, which
+    // no tick passes anymore
+    uint64_t diff = timer->expires ^ wheel->now;
+    unsigned level = diff ? bits_log2_64(diff) / WHEEL_BITS : 0;
+    unsigned index =
+        (unsigned)(timer->expires >> (level * WHEEL_BITS)) & WHEEL_MASK;
+
+    list_push(&wheel->slots[level][index], timer);
+    wheel->occupied[level] |= (uint64_t)1 << index;
+    timer->slot = level * WHEEL_SLOTS + index;
+}
+
+static void wheel_remove(struct timer_wheel *wheel, struct timer *timer) {
+    unsigned slot = timer->slot;
+    list_unlink(timer);
+    if (slot == SLOT_BATCH)
+        return;
+
+    unsigned level = slot / WHEEL_SLOTS;
+    unsigned index = slot % WHEEL_SLOTS;
+    if (!wheel->slots[level][index])
+        wheel->occupied[level] &= ~((uint64_t)1 << index);
+}
+
+struct timer_wheel *timer_wheel_create(void) {
+    return calloc(1, sizeof(struct timer_wheel));
+}
+
+void timer_wheel_destroy(struct timer_wheel *wheel) {
+    if (!wheel)
+        return;
+
+    // leave the dropped timers in a consistent, not pending, state
+    for (unsigned level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (unsigned index = 0; index < WHEEL_SLOTS; index++) {
+            while (wheel->slots[level][index])
+                list_unlink(wheel->slots[level][index]);
+        }
+    }
+    free(wheel);
+}
+
+void timer_wheel_add(struct timer_wheel *wheel, struct timer *timer,
+                     uint64_t delay, uint64_t period) {
+    if (timer_pending(timer))
+        wheel_remove(wheel, timer);
+    else
+        wheel->count++;
+
+    if (!delay)
+        delay = 1;
+    timer->expires =
+        delay > UINT64_MAX - wheel->now ? UINT64_MAX : wheel->now + delay;
+    timer->period = period;
+    wheel_insert(wheel, timer);
+}
+
+bool timer_wheel_cancel(struct timer_wheel *wheel, struct timer *timer) {
+    if (!timer_pending(timer))
+        return false;
+    wheel_remove(wheel, timer);
+    wheel->count--;
+    return true;
+}
+
+/* Moves every timer of the slots of a level selected by mask to a list. */
+static void take_slots(struct timer_wheel *wheel, unsigned level,
+                       uint64_t mask, struct timer **list) {
+    mask &= wheel->occupied[level];
+    wheel->occupied[level] &= ~mask;
+    while (mask) {
+        struct timer **slot = &wheel->slots[level][bits_ctz64(mask)];
+        while (*slot) {
+            struct timer *timer = *slot;
+            list_unlink(timer);
+            list_push(list, timer);
+            timer->slot = SLOT_BATCH;
+        }
+        mask &= mask - 1;
+    }
+}
+
+size_t timer_wheel_advance(struct timer_wheel *wheel, uint64_t ticks) {
+    uint64_t from = wheel->now;
+    uint64_t to = ticks > UINT64_MAX - from ? UINT64_MAX : from + ticks;
+    if (from == to)
+        return 0;
+
+    // empty the slots passed at each level
+    struct timer *passed = NULL;
+    for (unsigned level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        unsigned shift = level * WHEEL_BITS;
+        uint64_t first = from >> shift;
+        uint64_t last = to >> shift;
+        if (first == last)
+            break;
+
+        uint64_t mask = UINT64_MAX;
+        if (last - first < WHEEL_SLOTS) {
+            // indices first + 1 to last, modulo the number of slots
+            uint64_t span = ((uint64_t)1 << (last - first)) - 1;
+            mask = rotate_left(span, (unsigned)(first + 1) & WHEEL_MASK);
+        }
+        take_slots(wheel, level, mask, &passed);
+    }
+    wheel->now = to;
+
+    struct timer *expired = NULL;
+    while (passed) {
+        struct timer *timer = passed;
+        list_unlink(timer);
+        if (timer->expires <= to) {
+            list_push(&expired, timer);
+            timer->slot = SLOT_BATCH;
+        } else {
+            wheel_insert(wheel, timer);
+        }
+    }
+
+    // callbacks may cancel timers of the batch: always take the list head
+    size_t fired = 0;
+    while (expired) {
+        struct timer *timer = expired;
+        list_unlink(timer);
+        // a late periodic timer expires once, not once per missed period
+        uint64_t next = timer->period > UINT64_MAX - timer->expires
+                            ? UINT64_MAX
+                            : timer->expires + timer->period;
+        if (next <= to && to < UINT64_MAX)
+            next = to + 1;
+        if (timer->period && next > to) { // none after the last tick
+            timer->expires = next;
+            wheel_insert(wheel, timer);
+        } else {
+            wheel->count--;
+        }
+        timer->func(timer, timer->ctx);
+        fired++;
+    }
+    return fired;
+}
+
+uint64_t timer_wheel_now(const struct timer_wheel *wheel) {
+    return wheel->now;
+}
+
+uint64_t timer_wheel_next_expiry(const struct timer_wheel *wheel) {
+    uint64_t next = UINT64_MAX;
+    for (unsigned level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (!wheel->occupied[level])
+            continue;
+
+        // timers of a level are in the slots after the index of now
+        unsigned shift = level * WHEEL_BITS;
+        uint64_t position = wheel->now >> shift;
+        unsigned index = (unsigned)position & WHEEL_MASK;
+        if (index == WHEEL_MASK)
+            continue;
+        uint64_t after = wheel->occupied[level] >> (index + 1);
+        if (!after)
+            continue;
+        uint64_t slot_start = (position + 1 + bits_ctz64(after)) << shift;
+        if (slot_start - wheel->now < next)
+            next = slot_start - wheel->now;
+    }
+    return next;
+}
+
+size_t timer_wheel_count(const struct timer_wheel *wheel) {
+    return wheel->count;
+}
+
+// ---------- Timer Thread ---------- //
+struct timer_thread {
+    struct timer_wheel *wheel;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+
+    uint64_t tick_ms;
+    struct timespec start;
+    uint64_t wake_tick; /**< tick the thread sleeps until */
+    bool stop;
+};
+
+static __thread struct timer_thread *current_timers;
+
+static uint64_t current_tick(const struct timer_thread *timers) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t elapsed_ms =
+        (uint64_t)(now.tv_sec - timers->start.tv_sec) * 1000
+        + (uint64_t)(now.tv_nsec / 1000000)
+        - (uint64_t)(timers->start.tv_nsec / 1000000);
+    return elapsed_ms / timers->tick_ms;
+}
+
+static struct timespec tick_deadline(const struct timer_thread *timers,
+                                     uint64_t tick) {
+    uint64_t ms = tick * timers->tick_ms
+        + (uint64_t)(timers->start.tv_nsec / 1000000);
+    struct timespec deadline = {
+        .tv_sec = timers->start.tv_sec + (time_t)(ms / 1000),
+        .tv_nsec = (long)(ms % 1000) * 1000000L,
+    };
+    return deadline;
+}
+
+static void *timer_thread_main(void *arg) {
+    struct timer_thread *timers = arg;
+    current_timers = timers;
+
+    logger_set_thread_name(THREAD_NAME);
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), THREAD_NAME);
+#endif // __linux__
+
+    pthread_mutex_lock(&timers->lock);
+    while (!timers->stop) {
+        uint64_t tick = current_tick(timers);
+        uint64_t now = timer_wheel_now(timers->wheel);
+        if (tick > now)
+            timer_wheel_advance(timers->wheel, tick - now);
+
+        uint64_t delay = timer_wheel_next_expiry(timers->wheel);
+        if (delay == UINT64_MAX) {
+            timers->wake_tick = UINT64_MAX;
+            pthread_cond_wait(&timers->wakeup, &timers->lock);
+        } else {
+            timers->wake_tick = timer_wheel_now(timers->wheel) + delay;
+            struct timespec deadline = tick_deadline(timers, timers->wake_tick);
+            pthread_cond_timedwait(&timers->wakeup, &timers->lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&timers->lock);
+    return NULL;
+}
+
+struct timer_thread *timer_thread_create(unsigned tick_ms) {
+    struct timer_thread *timers = calloc(1, sizeof(struct timer_thread));
+    if (!timers)
+        return NULL;
+
+    timers->wheel = timer_wheel_create();
+    if (!timers->wheel) {
+        free(timers);
+        return NULL;
+    }
+    timers->tick_ms = tick_ms ? tick_ms : TIMER_THREAD_DEFAULT_TICK_MS;
+    timers->wake_tick = UINT64_MAX;
+    clock_gettime(CLOCK_MONOTONIC, &timers->start);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timers->wakeup, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&timers->lock, NULL);
+
+    if (pthread_create(&timers->thread, NULL, timer_thread_main, timers)) {
+        pthread_cond_destroy(&timers->wakeup);
+        pthread_mutex_destroy(&timers->lock);
+        timer_wheel_destroy(timers->wheel);
+        free(timers);
+        return NULL;
+    }
+    return timers;
+}
+
+void timer_thread_destroy(struct timer_thread *timers) {
+    if (!timers)
+        return;
+
+    pthread_mutex_lock(&timers->lock);
+    timers->stop = true;
+    pthread_cond_signal(&timers->wakeup);
+    pthread_mutex_unlock(&timers->lock);
+    pthread_join(timers->thread, NULL);
+
+    pthread_cond_destroy(&timers->wakeup);
+    pthread_mutex_destroy(&timers->lock);
+    timer_wheel_destroy(timers->wheel);
+    free(timers);
+}
+
+static uint64_t ms_to_ticks(const struct timer_thread *timers, uint64_t ms) {
+    return ms / timers->tick_ms + (ms % timers->tick_ms != 0);
+}
+
+void timer_thread_add(struct timer_thread *timers, struct timer *timer,
+                      uint64_t delay_ms, uint64_t period_ms) {
+    // callbacks run with the lock held by the timer thread
+    bool locked = current_timers == timers;
+    if (!locked)
+        pthread_mutex_lock(&timers->lock);
+
+    // the wheel time lags behind while the thread sleeps
+    uint64_t lag = current_tick(timers) - timer_wheel_now(timers->wheel);
+    uint64_t delay = ms_to_ticks(timers, delay_ms);
+    timer_wheel_add(timers->wheel, timer, lag + (delay ? delay : 1),
+                    ms_to_ticks(timers, period_ms));
+    if (timer->expires < timers->wake_tick)
+        pthread_cond_signal(&timers->wakeup);
+
+    if (!locked)
+        pthread_mutex_unlock(&timers->lock);
+}
+
+bool timer_thread_cancel(struct timer_thread *timers, struct timer *timer) {
+    bool locked = current_timers == timers;
+    if (!locked)
+        pthread_mutex_lock(&timers->lock);
+    bool cancelled = timer_wheel_cancel(timers->wheel, timer);
+    if (!locked)
+        pthread_mutex_unlock(&timers->lock);
+    return cancelled;
+}
@@ -0,0 +1,339 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/core_utils/bits.h>
+#include <ayaztub/core_utils/io.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) && !defined(IO_NO_SIMD)
+#    include <immintrin.h>
+#    define IO_AVX2 1
+#elif defined(__SSE2__) && !defined(IO_NO_SIMD)
+#    include <emmintrin.h>
+#    define IO_SSE2 1
+#endif // __SSE2__ && !IO_NO_SIMD
+
+#ifndef O_CLOEXEC
+#    define O_CLOEXEC 0
+#endif // O_CLOEXEC
+
+/*
+ * Design:
+ * - Files are mapped whole and read-only, with MAP_PRIVATE. The descriptor
+ *   stays open so that the mapping can be extended when the file grows. An
+ *   empty file is not mapped (mmap() rejects empty mappings): its data is a
+ *   static empty string.
+ * - The line iterator keeps a 64 bits mask of the newlines of the current 64
+ *   bytes block: a line ends at the lowest set bit, which is then cleared.
+ *   Blocks are only loaded when their mask is empty, so a block holding many
+ *   short lines is compared once.
+ * - The writer flushes before a write that does not fit in the buffer, and
+ *   writes directly what is larger than the buffer: everything is written in
+ *   chunks of at least the buffer size, except the final flush.
+ */
+
+#define IO_BLOCK 64
+
+// ---------- Newline Scanning ---------- //
+
+// Mask of the '\n' of the 64 bytes at data.
+static inline uint64_t newline_mask(const char *data) {
+#if defined(IO_AVX2)
+    __m256i newline = _mm256_set1_epi8('\n');
+    __m256i low = _mm256_loadu_si256((const __m256i *)data);
+    __m256i high = _mm256_loadu_si256((const __m256i *)(data + 32));
+    uint32_t low_mask =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline));
+    uint32_t high_mask =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline));
+    return (uint64_t)low_mask | (uint64_t)high_mask << 32;
+#elif defined(IO_SSE2)
+    __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < IO_BLOCK; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+        uint64_t bits =
+            (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        mask |= bits << i;
+    }
+    return mask;
+#else // scalar
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < IO_BLOCK; ++i)
+        mask |= (uint64_t)(data[i] == '\n') << i;
+    return mask;
+#endif // IO_AVX2
+}
+
+// Mask of the '\n' of the (up to) 64 bytes at offset.
+static inline uint64_t block_newlines(const char *data, size_t size,
+                                      size_t offset) {
+    if (size - offset >= IO_BLOCK)
+        return newline_mask(data + offset);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < size - offset; ++i)
+        mask |= (uint64_t)(data[offset + i] == '\n') << i;
+    return mask;
+}
+
+size_t io_find_newline(const char *data, size_t size) {
+    size_t offset = 0;
+    for (; offset + IO_BLOCK <= size; offset += IO_BLOCK) {
+        uint64_t mask = newline_mask(data + offset);
+        if (mask)
+            return offset + bits_ctz64(mask);
+    }
+    const char *found = size > offset
+                            ? memchr(data + offset, '\n', size - offset)
+                            : NULL;
+    return found ? (size_t)(found - data) : size;
+}
+
+size_t io_count_newlines(const char *data, size_t size) {
+    size_t count = 0;
+    size_t offset = 0;
+    for (; offset + IO_BLOCK <= size; offset += IO_BLOCK)
+        count += bits_popcount64(newline_mask(data + offset));
+    if (offset < size)
+        count += bits_popcount64(block_newlines(data, size, offset));
+    return count;
+}
+
+void line_iter_init(struct line_iter *iter, const char *data, size_t size) {
+    iter->data = data;
+    iter->size = size;
+    iter->start = 0;
+    iter->block = 0;
+    iter->newlines = size ? block_newlines(data, size, 0) : 0;
+}
+
+bool line_iter_next(struct line_iter *iter, struct strview *line) {
+    if (iter->start >= iter->size)
+        return false;
+
+    while (!iter->newlines) {
+        iter->block += IO_BLOCK;
+        if (iter->block >= iter->size) { // last line without '\n'
+            *line = strview_make(iter->data + iter->start,
+                                 iter->size - iter->start);
+            iter->start = iter->size;
+            return true;
+        }
+        iter->newlines = block_newlines(iter->data, iter->size, iter->block);
+    }
+
+    size_t end = iter->block + bits_ctz64(iter->newlines);
+    iter->newlines &= iter->newlines - 1;
+    *line = strview_make(iter->data + iter->start, end - iter->start);
+    iter->start = end + 1;
+    return true;
+}
+
+// ---------- Memory Mapped Files ---------- //
+static bool advise(const void *addr, size_t length, unsigned advice) {
+    bool ok = true;
+    void *address = (void *)(uintptr_t)addr;
+    if (advice & MAPPED_FILE_SEQUENTIAL)
+        ok &= madvise(address, length, MADV_SEQUENTIAL) == 0;
+    if (advice & MAPPED_FILE_RANDOM)
+        ok &= madvise(address, length, MADV_RANDOM) == 0;
+    if (advice & MAPPED_FILE_WILLNEED)
+        ok &= madvise(address, length, MADV_WILLNEED) == 0;
+    if (advice & MAPPED_FILE_DONTNEED)
+        ok &= madvise(address, length, MADV_DONTNEED) == 0;
+#ifdef MADV_HUGEPAGE
+    if (advice & MAPPED_FILE_HUGEPAGE)
+        ok &= madvise(address, length, MADV_HUGEPAGE) == 0;
+#endif // MADV_HUGEPAGE
+    return ok;
+}
+
+static bool map(struct mapped_file *file, size_t size) {
+    if (size == 0) {
+        file->data = "";
+        file->size = 0;
+        return true;
+    }
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    file->data = data;
+    file->size = size;
+    advise(data, size, file->advice); // best effort
+    return true;
+}
+
+static void unmap(const char *data, size_t size) {
+    if (size)
+        munmap((void *)(uintptr_t)data, size);
+}
+
+static bool file_size(int fd, size_t *size) {
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return false;
+    if ((uint64_t)st.st_size > SIZE_MAX) {
+        errno = EFBIG;
+        return false;
+    }
+    *size = (size_t)st.st_size;
+    return true;
+}
+
+bool mapped_file_open(struct mapped_file *file, const char *path,
+                      unsigned advice) {
+    file->advice = advice;
+    file->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0)
+        return false;
+    size_t size;
+    if (!file_size(file->fd, &size) || !map(file, size)) {
+        int error = errno;
+        close(file->fd);
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+bool mapped_file_advise(const struct mapped_file *file, size_t offset,
+                        size_t length, unsigned advice) {
+    if (offset >= file->size)
+        return true;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page - 1);
+    if (length > file->size - offset)
+        length = file->size - offset;
+    return advise(file->data + start, length + (offset - start), advice);
+}
+
+bool mapped_file_refresh(struct mapped_file *file) {
+    size_t size;
+    if (!file_size(file->fd, &size))
+        return false;
+    if (size <= file->size)
+        return true;
+
+    const char *old_data = file->data;
+    size_t old_size = file->size;
+    if (!map(file, size))
+        return false;
+    unmap(old_data, old_size);
+    return true;
+}
+
+void mapped_file_close(struct mapped_file *file) {
+    unmap(file->data, file->size);
+    close(file->fd);
+    file->data = NULL;
+    file->size = 0;
+    file->fd = -1;
+}
+
+// ---------- Chunked Writer ---------- //
+static bool write_all(struct chunk_writer *writer, const char *data,
+                      size_t size) {
+    while (size) {
+        ssize_t n = write(writer->fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            writer->failed = true;
+            return false;
+        }
+        data += n;
+        size -= (size_t)n;
+        writer->written += (uint64_t)n;
+    }
+    return true;
+}
+
+bool chunk_writer_init_fd(struct chunk_writer *writer, int fd,
+                          size_t chunk_size) {
+    writer->fd = fd;
+    writer->owned = false;
+    writer->failed = false;
+    writer->size = 0;
+    writer->capacity = chunk_size ? chunk_size : IO_CHUNK_SIZE;
+    writer->written = 0;
+    writer->buffer = malloc(writer->capacity);
+    return writer->buffer != NULL;
+}
+
+bool chunk_writer_open(struct chunk_writer *writer, const char *path,
+                       bool append, size_t chunk_size) {
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    int fd = open(path, flags, 0644);
+    if (fd < 0)
+        return false;
+    if (!chunk_writer_init_fd(writer, fd, chunk_size)) {
+        close(fd);
+        return false;
+    }
+    writer->owned = true;
+    return true;
+}
+
+bool chunk_writer_flush(struct chunk_writer *writer) {
+    if (writer->failed)
+        return false;
+    bool ok = write_all(writer, writer->buffer, writer->size);
+    writer->size = 0;
+    return ok;
+}
+
+bool chunk_writer_write(struct chunk_writer *writer, const void *data,
+                        size_t size) {
+    if (writer->failed)
+        return false;
+    if (size > writer->capacity - writer->size) {
+        if (!chunk_writer_flush(writer))
+            return false;
+        if (size >= writer->capacity)
+            return write_all(writer, data, size);
+    }
+    memcpy(writer->buffer + writer->size, data, size);
+    writer->size += size;
+    return true;
+}
+
+bool chunk_writer_write_line(struct chunk_writer *writer,
+                             struct strview line) {
+    char *room = chunk_writer_reserve(writer, line.size + 1);
+    if (!room) {
+        return line.size >= writer->capacity
+               && chunk_writer_write(writer, line.data, line.size)
+               && chunk_writer_write(writer, "\n", 1);
+    }
+    memcpy(room, line.data, line.size);
+    room[line.size] = '\n';
+    chunk_writer_commit(writer, line.size + 1);
+    return true;
+}
+
+char *chunk_writer_reserve(struct chunk_writer *writer, size_t size) {
+    if (writer->failed || size > writer->capacity)
+        return NULL;
+    if (size > writer->capacity - writer->size
+        && !chunk_writer_flush(writer))
+        return NULL;
+    return writer->buffer + writer->size;
+}
+
+bool chunk_writer_close(struct chunk_writer *writer) {
+    bool ok = chunk_writer_flush(writer);
+    if (writer->owned && close(writer->fd) != 0)
+        ok = false;
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->fd = -1;
+    return ok;
+}
@@ -2,13 +2,17 @@
 #    define _GNU_SOURCE
 #endif // __linux__
 
+#include <ayaztub/concurrency/sync.h>
 #include <ayaztub/core_utils/logger.h>
+#include <ayaztub/core_utils/lz4.h>
 
 #include <errno.h>
 #include <execinfo.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stddef.h>
@@ -16,9 +20,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__SSE4_2__) && !defined(LOGGER_NO_SIMD)
+#    include <nmmintrin.h>
+#    define LOGGER_SSE42 1
+#endif // __SSE4_2__ && !LOGGER_NO_SIMD
+
 /*
  * Color identifiers:
  * - \033 (octal) or \e (bash) or \x1b (hex):
@@ -52,15 +63,152 @@
 #define RESET "\033[0m"
 
 #define BUFFER_SIZE 2048
+#define CACHE_LINE_SIZE 64
 
 // ---------- Static Variables ---------- //
 static FILE *log_file = NULL;
-static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sync_mutex log_mutex = SYNC_MUTEX_INITIALIZER;
 static logger_cb_t log_callback = NULL;
-static enum log_level current_log_level = LOG_INFO;
-static bool show_date = true;
-static bool show_thread = true;
-static bool log_trace_on_fatal = true;
+static __thread char thread_name[LOGGER_THREAD_NAME_SIZE];
+
+/*
+ * Context of a thread, kept rendered ("key=value key=value") so that records
+ * only copy it. marks[i] is the size of the text before the entry i. Entries
+ * pushed beyond LOGGER_CONTEXT_DEPTH are only counted, so that pushes and pops
+ * stay paired.
+ */
+struct log_context {
+    char text[LOGGER_CONTEXT_SIZE];
+    size_t size;
+    size_t depth;
+    size_t marks[LOGGER_CONTEXT_DEPTH];
+};
+
+static __thread struct log_context log_context;
+
+/*
+ * Time index of the log file: a header entry (INDEX_MAGIC, entry size), then
+ * (time, offset) entries with non decreasing times. Everything is written
+ * under log_mutex, with the log file. The log file offset is counted here (it
+ * is only written by the logger) instead of asking the stream for it.
+ */
+#define INDEX_MAGIC INT64_C(0x3149474f4c5a5941) // "AYZLOGI1"
+
+struct index_entry {
+    int64_t time;
+    uint64_t offset;
+};
+
+struct log_index {
+    FILE *file; /**< NULL when the log file has no index */
+    size_t every_records;
+    size_t every_bytes;
+    size_t records; /**< records since the last entry */
+    uint64_t offset; /**< end of the log file */
+    uint64_t entry_offset; /**< offset of the last entry */
+    int64_t entry_time; /**< time of the last entry */
+    bool empty; /**< no entry yet */
+};
+
+static struct log_index log_index = { 0 };
+static size_t index_every_records = 0;
+static size_t index_every_bytes = 0;
+
+/*
+ * Compression of the log file: records are appended to a pending buffer that
+ * is written as an LZ4 frame when full, flushed or closed. This happens under
+ * log_mutex, by the thread writing the file: the writer thread (or the shared
+ * ring collector) when enabled, so log calls only format and queue.
+ */
+#define FRAME_MIN_SIZE (2 * BUFFER_SIZE)
+
+struct log_compression {
+    char *pending; /**< NULL when the log file is not compressed */
+    size_t size; /**< pending bytes */
+    size_t capacity; /**< content of a frame */
+    char *frame; /**< lz4_frame_bound(capacity) bytes */
+};
+
+static struct log_compression log_compression = { 0 };
+static size_t compression_frame_size = 0;
+
+/*
+ * Framed records: a header (RECORD_MAGIC, payload size, writer, sequence), the
+ * payload (the line with its newline), then the CRC32C of both. Integers are
+ * in the native byte order, like the time index. Several processes may append
+ * to the same file (prefork servers, forked children): each one numbers its
+ * own records, under its pid. A record going back in the sequence of its
+ * writer is a stale or duplicated one, not the continuation. Records reach
+ * the file whole: the stream buffer is flushed before a record that would not
+ * fit, so each write() holds whole records and appends are not interleaved.
+ */
+#define RECORD_MAGIC 0x4345524cU // "LREC"
+#define RECORD_MAX_SIZE (64 * 1024)
+#define RECORD_BUFFER_SIZE (64 * 1024)
+
+struct record_header {
+    uint32_t magic;
+    uint32_t size; /**< payload bytes */
+    uint64_t writer; /**< pid of the writing process */
+    uint64_t sequence; /**< among the records of the writer, from 1 */
+};
+
+struct log_framing {
+    bool enabled;
+    uint64_t writer;
+    uint64_t sequence; /**< of the last record written */
+    size_t buffered; /**< bytes written since the last flush, at most */
+};
+
+static struct log_framing log_framing = { 0 };
+static bool framing_enabled = false;
+
+/*
+ * The configuration is read by every log call and almost never written: it is
+ * kept under a seqlock so that readers do not write (nor contend on) shared
+ * memory. Fields are accessed with relaxed atomics, see struct seqlock.
+ */
+struct logger_config {
+    enum log_level level;
+    bool show_date;
+    bool show_thread;
+    bool log_trace_on_fatal;
+};
+
+static struct seqlock config_lock = SEQLOCK_INITIALIZER;
+static struct logger_config config = { LOG_INFO, true, true, true };
+
+/*
+ * Reads the fields without the seqlock: each one is valid, but they may come
+ * from two configurations. Used by the signal handler, which may interrupt a
+ * writer of its own thread (the sequence would then stay odd forever).
+ */
+static struct logger_config read_config_unlocked(void) {
+    struct logger_config snapshot;
+    snapshot.level = __atomic_load_n(&config.level, __ATOMIC_RELAXED);
+    snapshot.show_date = __atomic_load_n(&config.show_date, __ATOMIC_RELAXED);
+    snapshot.show_thread =
+        __atomic_load_n(&config.show_thread, __ATOMIC_RELAXED);
+    snapshot.log_trace_on_fatal =
+        __atomic_load_n(&config.log_trace_on_fatal, __ATOMIC_RELAXED);
+    return snapshot;
+}
+
+static struct logger_config read_config(void) {
+    struct logger_config snapshot;
+    unsigned sequence;
+    do {
+        sequence = seqlock_read_begin(&config_lock);
+        snapshot = read_config_unlocked();
+    } while (seqlock_read_retry(&config_lock, sequence));
+    return snapshot;
+}
+
+static void set_log_level(enum log_level level) {
+    seqlock_write_lock(&config_lock);
+    __atomic_store_n(&config.level, level, __ATOMIC_RELAXED);
+    seqlock_write_unlock(&config_lock);
+}
 
 // ---------- Utility Functions ---------- //
 static const char *log_level_to_string(enum log_level level) {
@@ -106,22 +254,27 @@ static const char *log_level_to_color(enum log_level level) {
 }
 
 static void format_log_message(char *colored_buffer, char *raw_buffer,
-                               size_t buffer_size, enum log_level level,
+                               size_t buffer_size,
+                               const struct logger_config *options,
+                               time_t now, enum log_level level,
                                const char *const file, size_t line,
                                const char *const func, const char *const fmt,
                                va_list args) {
     char date_buffer[64] = "";
-    if (show_date) {
-        time_t t = time(NULL);
-        struct tm *tm_info = localtime(&t);
+    if (options->show_date) {
+        struct tm *tm_info = localtime(&now);
         strftime(date_buffer, sizeof(date_buffer) / sizeof(date_buffer[0]),
                  "%Y-%m-%d %H:%M:%S ", tm_info);
     }
 
     char thread_buffer[32] = "";
-    if (show_thread) {
+    if (options->show_thread) {
         pid_t tid = gettid();
-        if (tid == getpid()) {
+        if (thread_name[0]) {
+            snprintf(thread_buffer,
+                     sizeof(thread_buffer) / sizeof(thread_buffer[0]),
+                     "[%s] ", thread_name);
+        } else if (tid == getpid()) {
             snprintf(thread_buffer,
                      sizeof(thread_buffer) / sizeof(thread_buffer[0]),
                      "[main thread] ");
@@ -142,33 +295,1394 @@ static void format_log_message(char *colored_buffer, char *raw_buffer,
         }
     }
 
+    const struct log_context *context = &log_context;
+    const char *context_open = context->size ? "{" : "";
+    const char *context_close = context->size ? "} " : "";
+
     snprintf(colored_buffer, buffer_size,
-             "%s%s[%s]" RESET " [%s:%zu:%s()] %s%s%s" RESET, date_buffer,
+             "%s%s[%s]" RESET " [%s:%zu:%s()] %s%s%s%s%s%s" RESET, date_buffer,
              log_level_to_color(level), log_level_to_string(level), file, line,
-             func, thread_buffer, log_level_to_color(level), message);
-    snprintf(raw_buffer, buffer_size, "%s[%s] [%s:%zu:%s()] %s%s", date_buffer,
-             log_level_to_string(level), file, line, func, thread_buffer,
+             func, thread_buffer, context_open, context->text, context_close,
+             log_level_to_color(level), message);
+    snprintf(raw_buffer, buffer_size, "%s[%s] [%s:%zu:%s()] %s%s%s%s%s",
+             date_buffer, log_level_to_string(level), file, line, func,
+             thread_buffer, context_open, context->text, context_close,
              message);
 }
 
-static void log_backtrace(const char *const init_msg) {
-    pthread_mutex_lock(&log_mutex);
+// ---------- Time Index ---------- //
+
+// Adds an entry for the record about to be written, if due (under log_mutex).
+static void index_record(time_t now) {
+    struct log_index *index = &log_index;
+    if (!index->file)
+        return;
+    bool due = index->empty
+               || (index->every_records
+                   && index->records >= index->every_records)
+               || (index->every_bytes
+                   && index->offset - index->entry_offset
+                          >= index->every_bytes);
+    // a late record (time taken before the lock) waits for the next one
+    if (due && (index->empty || (int64_t)now >= index->entry_time)) {
+        struct index_entry entry = { (int64_t)now, index->offset };
+        if (fwrite(&entry, sizeof(entry), 1, index->file) == 1
+            && fflush(index->file) == 0) {
+            index->records = 0;
+            index->entry_offset = entry.offset;
+            index->entry_time = entry.time;
+            index->empty = false;
+        }
+    }
+    index->records++;
+}
+
+static bool file_size(FILE *file, uint64_t *size) {
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0)
+        return false;
+    *size = (uint64_t)st.st_size;
+    return true;
+}
+
+// ---------- Compression ---------- //
+
+// Writes the pending records as a frame (under log_mutex).
+static void finish_frame(void) {
+    struct log_compression *compression = &log_compression;
+    if (!compression->size)
+        return;
+    size_t size = lz4_frame_compress(compression->pending, compression->size,
+                                     compression->frame,
+                                     lz4_frame_bound(compression->capacity));
+    if (size)
+        fwrite(compression->frame, 1, size, log_file);
+    compression->size = 0;
+}
+
+// Appends to the pending frame, a record never spans two frames.
+static void compress_log_file(const char *const fmt, va_list args) {
+    struct log_compression *compression = &log_compression;
+    size_t room = compression->capacity - compression->size;
+    va_list copy;
+    va_copy(copy, args);
+    int written = vsnprintf(compression->pending + compression->size, room + 1,
+                            fmt, copy);
+    va_end(copy);
+    if (written > 0 && (size_t)written > room && compression->size) {
+        finish_frame();
+        room = compression->capacity;
+        written = vsnprintf(compression->pending, room + 1, fmt, args);
+    }
+    if (written <= 0)
+        return;
+    // a record larger than a frame is truncated
+    compression->size += (size_t)written < room ? (size_t)written : room;
+    if (compression->size == compression->capacity)
+        finish_frame();
+}
+
+static bool compression_init(struct log_compression *compression,
+                             size_t capacity) {
+    compression->pending = malloc(capacity + 1); // + vsnprintf terminator
+    compression->frame = malloc(lz4_frame_bound(capacity));
+    compression->size = 0;
+    compression->capacity = capacity;
+    if (compression->pending && compression->frame)
+        return true;
+    free(compression->pending);
+    free(compression->frame);
+    compression->pending = NULL;
+    compression->frame = NULL;
+    return false;
+}
+
+// ---------- Framed Records ---------- //
+
+#ifndef LOGGER_SSE42
+static uint32_t crc32c_table[256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init(void) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (unsigned bit = 0; bit < 8; ++bit)
+            crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78U : crc >> 1;
+        crc32c_table[i] = crc;
+    }
+}
+#endif // LOGGER_SSE42
+
+uint32_t logger_crc32c(const void *data, size_t size, uint32_t crc) {
+    const uint8_t *p = data;
+    crc = ~crc;
+#ifdef LOGGER_SSE42
+    uint64_t crc64 = crc;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+    for (; size; --size)
+        crc = _mm_crc32_u8(crc, *p++);
+#else
+    pthread_once(&crc32c_once, crc32c_init);
+    for (; size; --size)
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+#endif // LOGGER_SSE42
+    return ~crc;
+}
+
+size_t logger_record_read(const void *data, size_t size,
+                          struct logger_record *record) {
+    struct record_header header;
+    if (size < sizeof(header))
+        return 0;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != RECORD_MAGIC || header.size > RECORD_MAX_SIZE
+        || size - sizeof(header) < (size_t)header.size + sizeof(uint32_t))
+        return 0;
+    size_t length = sizeof(header) + header.size;
+    uint32_t crc;
+    memcpy(&crc, (const char *)data + length, sizeof(crc));
+    if (crc != logger_crc32c(data, length, 0))
+        return 0;
+    record->writer = header.writer;
+    record->sequence = header.sequence;
+    record->text = (const char *)data + sizeof(header);
+    record->size = header.size;
+    return length + sizeof(crc);
+}
+
+// Frames a record and writes it (under log_mutex).
+static void write_record(const char *const fmt, va_list args) {
+    char record[sizeof(struct record_header) + BUFFER_SIZE + sizeof(uint32_t)];
+    char *payload = record + sizeof(struct record_header);
+    int written = vsnprintf(payload, BUFFER_SIZE, fmt, args);
+    if (written <= 0)
+        return;
+    // a truncated record keeps its newline
+    size_t size = (size_t)written < BUFFER_SIZE ? (size_t)written
+                                                : BUFFER_SIZE - 1;
+    payload[size - 1] = '\n';
+
+    struct record_header header = { RECORD_MAGIC, (uint32_t)size,
+                                    log_framing.writer,
+                                    log_framing.sequence + 1 };
+    memcpy(record, &header, sizeof(header));
+    size_t length = sizeof(header) + size;
+    uint32_t crc = logger_crc32c(record, length, 0);
+    memcpy(record + length, &crc, sizeof(crc));
+    length += sizeof(crc);
+    if (log_framing.buffered + length > RECORD_BUFFER_SIZE) {
+        fflush(log_file);
+        log_framing.buffered = 0;
+    }
+    if (fwrite(record, 1, length, log_file) == length) {
+        log_framing.sequence++;
+        log_framing.buffered += length;
+        log_index.offset += length;
+    }
+}
+
+#define RECORD_MAX_LENGTH                                                      \
+    (sizeof(struct record_header) + RECORD_MAX_SIZE + sizeof(uint32_t))
+#define SCAN_BUFFER_SIZE (4 * RECORD_MAX_LENGTH)
+
+// Last sequence of each writer met by a scan (open addressing, pid 0 free).
+struct scan_writer {
+    uint64_t writer;
+    uint64_t sequence;
+};
+
+struct scan_writers {
+    struct scan_writer *slots;
+    size_t capacity; /**< power of two */
+    size_t count;
+};
+
+static struct scan_writer *scan_writer_slot(struct scan_writer *slots,
+                                            size_t capacity, uint64_t writer) {
+    size_t i = (size_t)(writer * UINT64_C(0x9E3779B97F4A7C15) >> 32);
+    for (;; ++i) {
+        struct scan_writer *slot = &slots[i & (capacity - 1)];
+        if (slot->writer == writer || !slot->writer)
+            return slot;
+    }
+}
+
+// Finds (or adds) a writer, NULL if out of memory.
+static struct scan_writer *scan_writer_find(struct scan_writers *writers,
+                                            uint64_t writer) {
+    if (2 * (writers->count + 1) > writers->capacity) {
+        size_t capacity = writers->capacity ? 2 * writers->capacity : 16;
+        struct scan_writer *slots = calloc(capacity, sizeof(*slots));
+        if (!slots)
+            return NULL;
+        for (size_t i = 0; i < writers->capacity; ++i) {
+            if (writers->slots[i].writer)
+                *scan_writer_slot(slots, capacity, writers->slots[i].writer) =
+                    writers->slots[i];
+        }
+        free(writers->slots);
+        writers->slots = slots;
+        writers->capacity = capacity;
+    }
+    struct scan_writer *slot =
+        scan_writer_slot(writers->slots, writers->capacity, writer);
+    if (!slot->writer) {
+        slot->writer = writer;
+        slot->sequence = 0;
+        writers->count++;
+    }
+    return slot;
+}
+
+/*
+ * Scans the records of a file. Invalid bytes (torn records) and records going
+ * back in the sequence of their writer are skipped, up to the next valid
+ * record. A file that does not start with a record is not scanned further.
+ */
+static bool scan_records(FILE *file, struct logger_recovery *recovery) {
+    *recovery = (struct logger_recovery){ 0 };
+    if (!file_size(file, &recovery->file_size))
+        return false;
+
+    char *buffer = malloc(SCAN_BUFFER_SIZE);
+    if (!buffer)
+        return false;
+    struct scan_writers writers = { 0 };
+    bool ok = true;
+    uint64_t offset = 0; // of buffer[0] in the file
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+    for (;;) {
+        // a whole record is always in the buffer, unless the file ends
+        if (!eof && end - begin < RECORD_MAX_LENGTH) {
+            memmove(buffer, buffer + begin, end - begin);
+            offset += begin;
+            end -= begin;
+            begin = 0;
+            end += fread(buffer + end, 1, SCAN_BUFFER_SIZE - end, file);
+            eof = feof(file) || ferror(file);
+        }
+        if (begin == end)
+            break;
+
+        struct logger_record parsed;
+        size_t length =
+            logger_record_read(buffer + begin, end - begin, &parsed);
+        struct scan_writer *writer = NULL;
+        if (length && !(writer = scan_writer_find(&writers, parsed.writer))) {
+            ok = false;
+            break;
+        }
+        // a writer starts again from 1 when it reopens the file
+        if (length
+            && (parsed.sequence > writer->sequence || parsed.sequence == 1)) {
+            recovery->records++;
+            recovery->sequence = parsed.sequence;
+            recovery->skipped += offset + begin - recovery->valid_size;
+            recovery->valid_size = offset + begin + length;
+            writer->sequence = parsed.sequence;
+            begin += length;
+            continue;
+        }
+        if (offset + begin == 0)
+            break; // not framed
+
+        // resynchronize on the next magic number
+        const uint32_t magic = RECORD_MAGIC;
+        begin++;
+        const char *next =
+            memmem(buffer + begin, end - begin, &magic, sizeof(magic));
+        if (next)
+            begin = (size_t)(next - buffer);
+        else if (eof)
+            begin = end;
+        else if (end - begin > sizeof(magic) - 1)
+            begin = end - (sizeof(magic) - 1); // may straddle the refill
+    }
+    free(writers.slots);
+    free(buffer);
+    return ok && !ferror(file);
+}
+
+bool logger_recover(const char *const filename, bool truncate,
+                    struct logger_recovery *recovery) {
+    FILE *file = fopen(filename, truncate ? "r+b" : "rb");
+    if (!file)
+        return false;
+    bool ok = scan_records(file, recovery);
+    // a file that does not start with a record is not framed: kept as is
+    if (ok && !recovery->records && recovery->file_size)
+        ok = false;
+    if (ok && truncate && recovery->valid_size < recovery->file_size)
+        ok = ftruncate(fileno(file), (off_t)recovery->valid_size) == 0;
+    fclose(file);
+    return ok;
+}
+
+// Whether a file is empty or starts with a framed record.
+static bool starts_with_record(const char *const filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        return false;
+    char *record = malloc(RECORD_MAX_LENGTH);
+    size_t size = record ? fread(record, 1, RECORD_MAX_LENGTH, file) : 0;
+    struct logger_record parsed;
+    bool ok = record && !ferror(file)
+              && (!size || logger_record_read(record, size, &parsed));
+    free(record);
+    fclose(file);
+    return ok;
+}
+
+// Writes to the log file, counting the size written (under log_mutex).
+FORMAT(printf, 1, 2)
+static void write_log_file(const char *const fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    if (log_compression.pending) {
+        compress_log_file(fmt, args);
+    } else if (log_framing.enabled) {
+        write_record(fmt, args);
+    } else {
+        int written = vfprintf(log_file, fmt, args);
+        if (written > 0)
+            log_index.offset += (uint64_t)written;
+    }
+    va_end(args);
+}
+
+// Opens (or continues) the index of a log file.
+static bool open_index(const char *const filename, struct log_index *index) {
+    size_t length = strlen(filename);
+    char *path = malloc(length + sizeof(LOGGER_INDEX_SUFFIX));
+    if (!path)
+        return false;
+    memcpy(path, filename, length);
+    memcpy(path + length, LOGGER_INDEX_SUFFIX, sizeof(LOGGER_INDEX_SUFFIX));
+    index->file = fopen(path, "a+b");
+    free(path);
+    if (!index->file)
+        return false;
+
+    index->empty = true;
+    uint64_t size;
+    if (!file_size(index->file, &size))
+        goto failure;
+    if (size < sizeof(struct index_entry)) {
+        struct index_entry header = { INDEX_MAGIC, sizeof(header) };
+        if (size != 0 || fwrite(&header, sizeof(header), 1, index->file) != 1
+            || fflush(index->file) != 0)
+            goto failure;
+        return true;
+    }
+
+    // drop a partial entry (crash while writing it)
+    uint64_t entries = size / sizeof(struct index_entry);
+    if (size % sizeof(struct index_entry) != 0
+        && ftruncate(fileno(index->file),
+                     (off_t)(entries * sizeof(struct index_entry)))
+               != 0)
+        goto failure;
+
+    struct index_entry header;
+    if (fseek(index->file, 0, SEEK_SET) != 0
+        || fread(&header, sizeof(header), 1, index->file) != 1
+        || header.time != INDEX_MAGIC || header.offset != sizeof(header))
+        goto failure;
+    if (entries > 1) {
+        struct index_entry last;
+        long offset = (long)((entries - 1) * sizeof(struct index_entry));
+        if (fseek(index->file, offset, SEEK_SET) != 0
+            || fread(&last, sizeof(last), 1, index->file) != 1)
+            goto failure;
+        index->entry_offset = last.offset;
+        index->entry_time = last.time;
+        index->empty = false;
+    }
+    return true;
+
+failure:
+    fclose(index->file);
+    index->file = NULL;
+    return false;
+}
+
+static bool read_index_entry(int fd, uint64_t i, struct index_entry *entry) {
+    off_t offset = (off_t)((i + 1) * sizeof(struct index_entry));
+    return pread(fd, entry, sizeof(*entry), offset)
+           == (ssize_t)sizeof(*entry);
+}
+
+// First entry with a time > limit (strict) or >= limit, count if none.
+static bool index_search(int fd, uint64_t count, int64_t limit, bool strict,
+                         uint64_t *found) {
+    uint64_t low = 0;
+    uint64_t high = count;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        struct index_entry entry;
+        if (!read_index_entry(fd, mid, &entry))
+            return false;
+        if (strict ? entry.time > limit : entry.time >= limit)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    *found = low;
+    return true;
+}
+
+// ---------- Asynchronous File Sink ---------- //
+
+static uint64_t monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+/*
+ * Records are formatted by the log calls and copied in one of two bounded
+ * queues (lanes): the priority lane holds ERROR and FATAL records, the normal
+ * lane the others. Only the normal lane overflows (drop or spill); both are
+ * merged back in log call order with a sequence number. The writer thread
+ * moves a batch of records out of the queues, then writes it under log_mutex
+ * with a single flush: the queue lock is never held during I/O, so log calls
+ * only wait for the disk with LOGGER_BLOCK or a full priority lane.
+ */
+#define ASYNC_BATCH 16
+
+struct async_record {
+    uint64_t sequence;
+    time_t time;
+    char line[BUFFER_SIZE]; /**< null terminated raw message */
+};
+
+struct async_lane {
+    struct async_record *records;
+    size_t capacity;
+    size_t head; /**< oldest record */
+    size_t count;
+};
+
+enum { NORMAL_LANE, PRIORITY_LANE };
+
+struct async_sink {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty; /**< writer */
+    pthread_cond_t not_full; /**< blocked log calls */
+    pthread_cond_t drained; /**< logger_flush() */
+    bool running; /**< log calls can queue */
+    bool stopping; /**< writer exits once the lanes are empty */
+    bool busy; /**< writer has a batch out of the lanes */
+    pthread_t writer;
+    struct async_lane lanes[2];
+    uint64_t sequence;
+    enum logger_overflow overflow;
+    FILE *spill;
+    size_t spilling; /**< log calls writing to the overflow file */
+    unsigned report_ms;
+    struct logger_async_stats stats;
+    uint64_t reported_dropped;
+    uint64_t reported_spilled;
+    uint64_t last_report; /**< monotonic time of the last report (ms) */
+    struct async_record *batch;
+};
+
+static bool async_enabled = false; // fast path, read without the lock
+static struct async_sink async_sink = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .not_empty = PTHREAD_COND_INITIALIZER,
+    .not_full = PTHREAD_COND_INITIALIZER,
+    .drained = PTHREAD_COND_INITIALIZER,
+};
+
+static struct async_record *lane_slot(struct async_lane *lane, size_t i) {
+    return &lane->records[(lane->head + i) % lane->capacity];
+}
+
+static void lane_pop(struct async_lane *lane) {
+    lane->head = (lane->head + 1) % lane->capacity;
+    lane->count--;
+}
+
+static bool lanes_empty(const struct async_sink *sink) {
+    return !sink->lanes[NORMAL_LANE].count && !sink->lanes[PRIORITY_LANE].count;
+}
+
+enum async_result {
+    ASYNC_DIRECT, /**< sink stopped: write the record directly */
+    ASYNC_QUEUED, /**< queued or dropped */
+    ASYNC_SPILL, /**< write the record to the overflow file */
+};
+
+// Queues a record, or drops it (under the sink lock).
+static enum async_result async_push(struct async_sink *sink,
+                                    enum log_level level, time_t now,
+                                    const char *const raw) {
+    bool priority = level <= LOG_ERROR;
+    struct async_lane *lane =
+        &sink->lanes[priority ? PRIORITY_LANE : NORMAL_LANE];
+    enum logger_overflow overflow = priority ? LOGGER_BLOCK : sink->overflow;
+    bool waited = false;
+    while (sink->running && lane->count == lane->capacity) {
+        if (overflow == LOGGER_DROP_NEWEST) {
+            sink->stats.dropped++;
+            return ASYNC_QUEUED;
+        }
+        if (overflow == LOGGER_SPILL) {
+            sink->stats.spilled++;
+            sink->spilling++;
+            return ASYNC_SPILL;
+        }
+        if (overflow == LOGGER_DROP_OLDEST) {
+            lane_pop(lane);
+            sink->stats.dropped++;
+            break;
+        }
+        if (!waited)
+            sink->stats.blocked++;
+        waited = true;
+        pthread_cond_wait(&sink->not_full, &sink->lock);
+    }
+    if (!sink->running)
+        return ASYNC_DIRECT;
+
+    struct async_record *record = lane_slot(lane, lane->count++);
+    record->sequence = sink->sequence++;
+    record->time = now;
+    memcpy(record->line, raw, strlen(raw) + 1);
+    pthread_cond_signal(&sink->not_empty);
+    return ASYNC_QUEUED;
+}
+
+// Writes a record to the overflow file (kept open while spilling).
+static void async_spill(struct async_sink *sink, const char *const raw) {
+    fprintf(sink->spill, "%s\n", raw);
+    fflush(sink->spill);
+    pthread_mutex_lock(&sink->lock);
+    if (--sink->spilling == 0)
+        pthread_cond_broadcast(&sink->drained);
+    pthread_mutex_unlock(&sink->lock);
+}
+
+// Lane of the oldest queued record (under the sink lock, lanes not empty).
+static struct async_lane *oldest_lane(struct async_sink *sink) {
+    struct async_lane *normal = &sink->lanes[NORMAL_LANE];
+    struct async_lane *priority = &sink->lanes[PRIORITY_LANE];
+    if (!normal->count
+        || (priority->count
+            && lane_slot(priority, 0)->sequence
+                   < lane_slot(normal, 0)->sequence))
+        return priority;
+    return normal;
+}
+
+// Moves the oldest records of both lanes to the batch (under the sink lock).
+static size_t async_take(struct async_sink *sink) {
+    size_t count = 0;
+    while (count < ASYNC_BATCH && !lanes_empty(sink)) {
+        struct async_lane *lane = oldest_lane(sink);
+        struct async_record *record = lane_slot(lane, 0);
+        struct async_record *copy = &sink->batch[count++];
+        copy->sequence = record->sequence;
+        copy->time = record->time;
+        memcpy(copy->line, record->line, strlen(record->line) + 1);
+        lane_pop(lane);
+    }
+    return count;
+}
+
+FORMAT(printf, 3, 4)
+static void async_report_line(char *colored, char *raw, const char *fmt, ...) {
+    struct logger_config options = read_config();
+    va_list args;
+    va_start(args, fmt);
+    format_log_message(colored, raw, BUFFER_SIZE, &options, time(NULL),
+                       LOG_WARN, __FILENAME__, __LINE__, __func__, fmt, args);
+    va_end(args);
+}
+
+// Logs the records dropped or spilled since the last report (under log_mutex).
+static void async_report(uint64_t dropped, uint64_t spilled) {
+    char colored[BUFFER_SIZE];
+    char raw[BUFFER_SIZE];
+    async_report_line(colored, raw,
+                      "logger: %" PRIu64 " records dropped, %" PRIu64
+                      " records spilled",
+                      dropped, spilled);
+    if (log_callback)
+        log_callback(LOG_WARN, colored, raw);
+    if (log_file) {
+        index_record(time(NULL));
+        write_log_file("%s\n", raw);
+    }
+}
+
+// Reports the drops and spills at most once per report_ms, and when stopping.
+static void *async_writer(void *arg) {
+    struct async_sink *sink = arg;
+    logger_set_thread_name("logger");
+    pthread_mutex_lock(&sink->lock);
+    for (;;) {
+        uint64_t elapsed = monotonic_ms() - sink->last_report;
+        bool unreported = sink->stats.dropped != sink->reported_dropped
+                          || sink->stats.spilled != sink->reported_spilled;
+        if (lanes_empty(sink) && !sink->stopping
+            && (!unreported || elapsed < sink->report_ms)) {
+            uint64_t wait = unreported ? sink->report_ms - elapsed
+                                       : sink->report_ms;
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += (time_t)(wait / 1000);
+            deadline.tv_nsec += (long)(wait % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&sink->not_empty, &sink->lock, &deadline);
+        }
+        size_t count = async_take(sink);
+        bool stop = !count && sink->stopping;
+        uint64_t dropped = 0;
+        uint64_t spilled = 0;
+        uint64_t now = monotonic_ms();
+        if (stop || now - sink->last_report >= sink->report_ms) {
+            dropped = sink->stats.dropped - sink->reported_dropped;
+            spilled = sink->stats.spilled - sink->reported_spilled;
+            sink->reported_dropped = sink->stats.dropped;
+            sink->reported_spilled = sink->stats.spilled;
+            if (dropped || spilled)
+                sink->last_report = now;
+        }
+        if (!count && !dropped && !spilled) {
+            if (stop)
+                break;
+            continue;
+        }
+        sink->busy = true;
+        pthread_cond_broadcast(&sink->not_full);
+        pthread_mutex_unlock(&sink->lock);
+
+        sync_mutex_lock(&log_mutex);
+        bool discarded = !log_file; // closed since the records were queued
+        for (size_t i = 0; log_file && i < count; ++i) {
+            index_record(sink->batch[i].time);
+            write_log_file("%s\n", sink->batch[i].line);
+        }
+        if (dropped || spilled)
+            async_report(dropped, spilled);
+        if (log_file)
+            fflush(log_file);
+        sync_mutex_unlock(&log_mutex);
+
+        pthread_mutex_lock(&sink->lock);
+        if (discarded)
+            sink->stats.dropped += count;
+        else
+            sink->stats.written += count;
+        sink->busy = false;
+        if (lanes_empty(sink))
+            pthread_cond_broadcast(&sink->drained);
+        if (stop)
+            break;
+    }
+    pthread_cond_broadcast(&sink->drained);
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+static bool lane_init(struct async_lane *lane, size_t capacity) {
+    lane->records = malloc(capacity * sizeof(struct async_record));
+    lane->capacity = capacity;
+    lane->head = 0;
+    lane->count = 0;
+    return lane->records != NULL;
+}
+
+bool logger_start_async(const struct logger_async_options *options) {
+    struct logger_async_options defaults = { 0 };
+    if (!options)
+        options = &defaults;
+    if (options->overflow == LOGGER_SPILL && !options->spill_file)
+        return false;
+
+    struct async_sink *sink = &async_sink;
+    pthread_mutex_lock(&sink->lock);
+    if (sink->running || sink->stopping)
+        goto failure;
+
+    size_t capacity = options->capacity ? options->capacity
+                                        : LOGGER_ASYNC_CAPACITY;
+    size_t priority_capacity = options->priority_capacity
+                                   ? options->priority_capacity
+                                   : LOGGER_ASYNC_PRIORITY_CAPACITY;
+    sink->batch = malloc(ASYNC_BATCH * sizeof(struct async_record));
+    if (!sink->batch || !lane_init(&sink->lanes[NORMAL_LANE], capacity)
+        || !lane_init(&sink->lanes[PRIORITY_LANE], priority_capacity))
+        goto failure;
+    sink->spill = NULL;
+    sink->spilling = 0;
+    if (options->overflow == LOGGER_SPILL) {
+        sink->spill = fopen(options->spill_file, "a");
+        if (!sink->spill)
+            goto failure;
+    }
+    sink->overflow = options->overflow;
+    sink->report_ms = options->report_ms ? options->report_ms
+                                         : LOGGER_ASYNC_REPORT_MS;
+    sink->stats = (struct logger_async_stats){ 0 };
+    sink->reported_dropped = 0;
+    sink->reported_spilled = 0;
+    sink->last_report = monotonic_ms();
+    sink->sequence = 0;
+    sink->busy = false;
+    if (pthread_create(&sink->writer, NULL, async_writer, sink) != 0)
+        goto failure;
+
+    sink->running = true;
+    __atomic_store_n(&async_enabled, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&sink->lock);
+    return true;
+
+failure:
+    if (!sink->running && !sink->stopping) {
+        if (sink->spill)
+            fclose(sink->spill);
+        sink->spill = NULL;
+        free(sink->lanes[NORMAL_LANE].records);
+        free(sink->lanes[PRIORITY_LANE].records);
+        free(sink->batch);
+        sink->lanes[NORMAL_LANE].records = NULL;
+        sink->lanes[PRIORITY_LANE].records = NULL;
+        sink->batch = NULL;
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return false;
+}
+
+void logger_flush(void) {
+    if (__atomic_load_n(&async_enabled, __ATOMIC_ACQUIRE)) {
+        struct async_sink *sink = &async_sink;
+        pthread_mutex_lock(&sink->lock);
+        // the writer itself cannot wait for its own batch
+        if (sink->running && !pthread_equal(pthread_self(), sink->writer)) {
+            while ((!lanes_empty(sink) || sink->busy) && sink->running)
+                pthread_cond_wait(&sink->drained, &sink->lock);
+        }
+        pthread_mutex_unlock(&sink->lock);
+    }
+
+    sync_mutex_lock(&log_mutex);
+    if (log_file && log_compression.size) {
+        finish_frame();
+        fflush(log_file);
+    }
+    sync_mutex_unlock(&log_mutex);
+}
+
+void logger_stop_async(void) {
+    struct async_sink *sink = &async_sink;
+    pthread_mutex_lock(&sink->lock);
+    if (!sink->running || pthread_equal(pthread_self(), sink->writer)) {
+        pthread_mutex_unlock(&sink->lock);
+        return;
+    }
+    sink->running = false;
+    sink->stopping = true;
+    __atomic_store_n(&async_enabled, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&sink->not_full);
+    pthread_cond_broadcast(&sink->not_empty);
+    pthread_mutex_unlock(&sink->lock);
+
+    pthread_join(sink->writer, NULL);
+
+    pthread_mutex_lock(&sink->lock);
+    while (sink->spilling)
+        pthread_cond_wait(&sink->drained, &sink->lock);
+    sink->stopping = false;
+    if (sink->spill)
+        fclose(sink->spill);
+    sink->spill = NULL;
+    free(sink->lanes[NORMAL_LANE].records);
+    free(sink->lanes[PRIORITY_LANE].records);
+    free(sink->batch);
+    sink->lanes[NORMAL_LANE].records = NULL;
+    sink->lanes[PRIORITY_LANE].records = NULL;
+    sink->batch = NULL;
+    pthread_mutex_unlock(&sink->lock);
+}
+
+struct logger_async_stats logger_async_stats_read(void) {
+    pthread_mutex_lock(&async_sink.lock);
+    struct logger_async_stats stats = async_sink.stats;
+    pthread_mutex_unlock(&async_sink.lock);
+    return stats;
+}
+
+// ---------- Multi-Process Shared Ring ---------- //
+
+/*
+ * Bounded multi-producer ring (after D. Vyukov's queue) in shared memory: the
+ * slot of a ticket is free when its sequence equals the ticket. A record
+ * claims the free slot at the tail by swapping the sequence for a claimed
+ * state (its pid and the low bits of the ticket), moves the tail on, and
+ * publishes the slot by swapping the claimed state for ticket + 1. A writer
+ * finding the tail slot claimed helps the tail on, so a writer killed after
+ * its claim blocks nobody. The collector reads the tickets in order, so the
+ * stream is ordered by ticket across all processes, and frees the slot with
+ * ticket + slots. It skips a claimed slot only once the writer process is
+ * gone: a live writer always publishes, and never into a reused slot.
+ * Counters and positions live in the shared header, on their own cache lines.
+ */
+#define SHM_MAGIC UINT64_C(0x474e49524c5a5941) // "AYZLRING"
+#define SHM_DRAIN_BATCH 64
+#define SHM_CLAIMED (UINT64_C(1) << 63)
+#define SHM_CLAIM_TICKET UINT64_C(0x7fffffff)
+
+struct shm_slot {
+    uint64_t sequence; /**< free, claimed or published */
+    int64_t time;
+    uint32_t size;
+    char line[BUFFER_SIZE];
+};
+
+struct shm_header {
+    uint64_t magic; /**< written last by the creator */
+    uint64_t slots; /**< power of two */
+    uint64_t dropped;
+    uint64_t collector; /**< pid of the collector process, 0 if none */
+    char pad0[CACHE_LINE_SIZE - 4 * sizeof(uint64_t)];
+    uint64_t tail; /**< next ticket of the writers */
+    char pad1[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    uint64_t head; /**< next ticket of the collector */
+    char pad2[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    struct shm_slot records[];
+};
+
+struct shm_state {
+    pthread_mutex_t lock; /**< attach, detach and collector changes */
+    struct shm_header *ring; /**< read by the log calls, see pushing */
+    size_t size;
+    size_t pushing; /**< log calls using the ring (detach waits for them) */
+    uint64_t pid; /**< of this process, in the claimed slots */
+    bool owner; /**< created the ring: unlinks its name */
+    char name[256]; /**< empty for an anonymous ring */
+    bool collecting; /**< this process runs the collector */
+    struct shm_header *collected; /**< ring of the collector thread */
+    bool stop;
+    pthread_t collector;
+    uint64_t reported_dropped;
+    uint64_t dropped; /**< after logger_shm_detach() */
+    uint64_t written;
+    uint64_t lost;
+};
+
+static struct shm_state shm_state = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static size_t shm_ring_size(uint64_t slots) {
+    return sizeof(struct shm_header) + slots * sizeof(struct shm_slot);
+}
+
+// Claimed state of the slot of a ticket.
+static uint64_t shm_claim(uint64_t ticket, uint64_t pid) {
+    return SHM_CLAIMED | (ticket & SHM_CLAIM_TICKET) << 32 | (pid & 0xffffffff);
+}
+
+static bool shm_claimed_by(uint64_t sequence, uint64_t ticket) {
+    uint64_t claimed = sequence >> 32 & SHM_CLAIM_TICKET;
+    return (sequence & SHM_CLAIMED) && claimed == (ticket & SHM_CLAIM_TICKET);
+}
+
+/*
+ * Appends a record to the ring (lock free). Returns false without ring, or on
+ * a full ring for a priority record (never dropped): the record must be
+ * written directly.
+ */
+static bool shm_push(const char *const raw, time_t now, bool priority) {
+    struct shm_state *state = &shm_state;
+    if (!__atomic_load_n(&state->ring, __ATOMIC_RELAXED))
+        return false;
+    __atomic_add_fetch(&state->pushing, 1, __ATOMIC_SEQ_CST);
+    struct shm_header *ring = __atomic_load_n(&state->ring, __ATOMIC_SEQ_CST);
+    if (!ring) {
+        __atomic_sub_fetch(&state->pushing, 1, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    uint64_t mask = ring->slots - 1;
+    uint64_t claim = 0;
+    uint64_t ticket = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    struct shm_slot *slot;
+    for (;;) {
+        slot = &ring->records[ticket & mask];
+        uint64_t sequence =
+            __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (sequence == ticket) {
+            claim = shm_claim(ticket, state->pid);
+            if (__atomic_compare_exchange_n(&slot->sequence, &sequence, claim,
+                                            false, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE)) {
+                uint64_t expected = ticket;
+                __atomic_compare_exchange_n(&ring->tail, &expected, ticket + 1,
+                                            false, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED);
+                break;
+            }
+        } else if (shm_claimed_by(sequence, ticket)
+                   || (!(sequence & SHM_CLAIMED)
+                       && (int64_t)(sequence - ticket) > 0)) {
+            // claimed, maybe by a dead writer: move the tail on
+            uint64_t expected = ticket;
+            if (__atomic_compare_exchange_n(&ring->tail, &expected, ticket + 1,
+                                            false, __ATOMIC_RELEASE,
+                                            __ATOMIC_ACQUIRE))
+                ticket++;
+            else
+                ticket = expected;
+        } else {
+            uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+            if (tail != ticket) { // stale ticket
+                ticket = tail;
+                continue;
+            }
+            // full: the collector is behind
+            if (priority) {
+                __atomic_sub_fetch(&state->pushing, 1, __ATOMIC_RELEASE);
+                return false;
+            }
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            slot = NULL;
+            break;
+        }
+    }
+    if (slot) {
+        size_t size = strlen(raw);
+        memcpy(slot->line, raw, size);
+        slot->size = (uint32_t)size;
+        slot->time = (int64_t)now;
+        __atomic_compare_exchange_n(&slot->sequence, &claim, ticket + 1, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+    __atomic_sub_fetch(&state->pushing, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Whether the writer of a claimed slot still runs.
+static bool shm_writer_alive(uint64_t sequence) {
+    pid_t pid = (pid_t)(sequence & 0xffffffff);
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/*
+ * Writes up to SHM_DRAIN_BATCH records of the ring (collector thread).
+ * Returns the number of tickets consumed.
+ */
+static size_t shm_drain(struct shm_state *state, struct shm_header *ring) {
+    uint64_t mask = ring->slots - 1;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t count = 0;
+    sync_mutex_lock(&log_mutex);
+    for (; count < SHM_DRAIN_BATCH; ++count, ++head) {
+        struct shm_slot *slot = &ring->records[head & mask];
+        uint64_t sequence =
+            __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (sequence != head + 1) {
+            // empty, or a record being written
+            if (!shm_claimed_by(sequence, head) || shm_writer_alive(sequence))
+                break;
+            // its writer died: skip it, unless it was published meanwhile
+            if (!__atomic_compare_exchange_n(&slot->sequence, &sequence,
+                                             head + ring->slots, false,
+                                             __ATOMIC_ACQ_REL,
+                                             __ATOMIC_ACQUIRE))
+                break;
+            state->lost++;
+            uint64_t tail = head; // it may have died before moving the tail
+            __atomic_compare_exchange_n(&ring->tail, &tail, head + 1, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (log_file) {
+            index_record((time_t)slot->time);
+            write_log_file("%.*s\n", (int)slot->size, slot->line);
+        }
+        state->written++;
+        __atomic_store_n(&slot->sequence, head + ring->slots,
+                         __ATOMIC_RELEASE);
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELAXED);
+    }
+
+    uint64_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    if (dropped != state->reported_dropped) {
+        async_report(dropped - state->reported_dropped, 0);
+        state->reported_dropped = dropped;
+    }
+    if (count && log_file)
+        fflush(log_file);
+    sync_mutex_unlock(&log_mutex);
+    return count;
+}
+
+static void *shm_collect(void *arg) {
+    struct shm_state *state = arg;
+    struct shm_header *ring = state->collected;
+    logger_set_thread_name("collector");
+    unsigned idle_ms = 0;
+    for (;;) {
+        bool stop = __atomic_load_n(&state->stop, __ATOMIC_ACQUIRE);
+        if (shm_drain(state, ring)) {
+            idle_ms = 0;
+            continue;
+        }
+        if (stop
+            && __atomic_load_n(&ring->head, __ATOMIC_RELAXED)
+                   == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+            break;
+        // back off up to LOGGER_SHM_POLL_MS while idle
+        idle_ms = idle_ms ? idle_ms * 2 : 1;
+        if (idle_ms > LOGGER_SHM_POLL_MS)
+            idle_ms = LOGGER_SHM_POLL_MS;
+        struct timespec delay = { 0, (long)idle_ms * 1000000 };
+        nanosleep(&delay, NULL);
+    }
+    return NULL;
+}
+
+static bool shm_map(struct shm_state *state, int fd, size_t size) {
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | (fd < 0 ? MAP_ANONYMOUS : 0), fd, 0);
+    if (map == MAP_FAILED)
+        return false;
+    state->size = size;
+    __atomic_store_n(&state->ring, (struct shm_header *)map,
+                     __ATOMIC_SEQ_CST);
+    return true;
+}
+
+bool logger_shm_create(const char *const name, size_t slots) {
+    uint64_t count = 2;
+    while (count < (slots ? slots : LOGGER_SHM_SLOTS))
+        count <<= 1;
+    size_t size = shm_ring_size(count);
+
+    struct shm_state *state = &shm_state;
+    pthread_mutex_lock(&state->lock);
+    bool ok = false;
+    int fd = -1;
+    if (state->ring) {
+        errno = EBUSY;
+        goto end;
+    }
+    if (name) {
+        if (strlen(name) >= sizeof(state->name)) {
+            errno = ENAMETOOLONG;
+            goto end;
+        }
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            goto end;
+        if (ftruncate(fd, (off_t)size) != 0) {
+            int error = errno;
+            shm_unlink(name);
+            errno = error;
+            goto end;
+        }
+    }
+
+    if (!shm_map(state, fd, size)) {
+        if (name)
+            shm_unlink(name);
+        goto end;
+    }
+    // a new mapping is zeroed: only the sequences need a value
+    struct shm_header *ring = state->ring;
+    ring->slots = count;
+    for (uint64_t i = 0; i < count; ++i)
+        ring->records[i].sequence = i;
+    __atomic_store_n(&ring->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+    state->owner = true;
+    state->pid = (uint64_t)getpid();
+    strcpy(state->name, name ? name : "");
+    state->reported_dropped = 0;
+    state->dropped = 0;
+    state->written = 0;
+    state->lost = 0;
+    ok = true;
+
+end:
+    if (fd >= 0)
+        close(fd);
+    pthread_mutex_unlock(&state->lock);
+    return ok;
+}
+
+bool logger_shm_attach(const char *const name) {
+    struct shm_state *state = &shm_state;
+    pthread_mutex_lock(&state->lock);
+    bool ok = false;
+    int fd = -1;
+    if (state->ring) {
+        errno = EBUSY;
+        goto end;
+    }
+    if (strlen(name) >= sizeof(state->name)) {
+        errno = ENAMETOOLONG;
+        goto end;
+    }
+    fd = shm_open(name, O_RDWR, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        goto end;
+    struct shm_header header;
+    if ((size_t)st.st_size < sizeof(header)
+        || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || header.magic != SHM_MAGIC
+        || (size_t)st.st_size != shm_ring_size(header.slots)) {
+        errno = EINVAL;
+        goto end;
+    }
+    if (!shm_map(state, fd, (size_t)st.st_size))
+        goto end;
+
+    state->owner = false;
+    state->pid = (uint64_t)getpid();
+    strcpy(state->name, name);
+    state->reported_dropped =
+        __atomic_load_n(&state->ring->dropped, __ATOMIC_RELAXED);
+    state->dropped = 0;
+    state->written = 0;
+    state->lost = 0;
+    ok = true;
+
+end:
+    if (fd >= 0)
+        close(fd);
+    pthread_mutex_unlock(&state->lock);
+    return ok;
+}
+
+bool logger_shm_start_collector(void) {
+    struct shm_state *state = &shm_state;
+    pthread_mutex_lock(&state->lock);
+    bool ok = false;
+    struct shm_header *ring = state->ring;
+    if (!ring || state->collecting)
+        goto end;
+
+    // take over a collector that died
+    uint64_t pid = (uint64_t)getpid();
+    uint64_t current = __atomic_load_n(&ring->collector, __ATOMIC_ACQUIRE);
+    if (current && (kill((pid_t)current, 0) == 0 || errno != ESRCH))
+        goto end;
+    if (!__atomic_compare_exchange_n(&ring->collector, &current, pid, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        goto end;
+
+    state->stop = false;
+    state->collected = ring;
+    if (pthread_create(&state->collector, NULL, shm_collect, state) != 0) {
+        __atomic_store_n(&ring->collector, 0, __ATOMIC_RELEASE);
+        goto end;
+    }
+    state->collecting = true;
+    ok = true;
+
+end:
+    pthread_mutex_unlock(&state->lock);
+    return ok;
+}
+
+void logger_shm_detach(void) {
+    struct shm_state *state = &shm_state;
+    pthread_mutex_lock(&state->lock);
+    struct shm_header *ring = state->ring;
+    if (!ring || (state->collecting
+                  && pthread_equal(pthread_self(), state->collector))) {
+        pthread_mutex_unlock(&state->lock);
+        return;
+    }
+
+    // new records are written directly, wait for the ones being appended
+    __atomic_store_n(&state->ring, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&state->pushing, __ATOMIC_SEQ_CST))
+        sched_yield();
+
+    if (state->collecting) {
+        __atomic_store_n(&state->stop, true, __ATOMIC_RELEASE);
+        pthread_join(state->collector, NULL);
+        state->collecting = false;
+        __atomic_store_n(&ring->collector, 0, __ATOMIC_RELEASE);
+    }
+    state->dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    munmap(ring, state->size);
+    if (state->owner && state->name[0])
+        shm_unlink(state->name);
+    state->owner = false;
+    state->name[0] = '\0';
+    pthread_mutex_unlock(&state->lock);
+}
+
+struct logger_shm_stats logger_shm_stats_read(void) {
+    struct shm_state *state = &shm_state;
+    struct logger_shm_stats stats = { 0 };
+    pthread_mutex_lock(&state->lock);
+    stats.dropped = state->ring ? __atomic_load_n(&state->ring->dropped,
+                                                  __ATOMIC_RELAXED)
+                                : state->dropped;
+    sync_mutex_lock(&log_mutex); // counted by shm_drain()
+    stats.written = state->written;
+    stats.lost = state->lost;
+    sync_mutex_unlock(&log_mutex);
+    pthread_mutex_unlock(&state->lock);
+    return stats;
+}
+
+// ---------- Fork ---------- //
+
+/*
+ * A forked child only has the thread that called fork(): the writer and
+ * collector threads are gone and the locks they held stay locked. The child
+ * logs synchronously (or to the shared ring), with fresh locks.
+ */
+static void logger_atfork_child(void) {
+    memset(&log_mutex, 0, sizeof(log_mutex));
+
+    struct async_sink *sink = &async_sink;
+    pthread_mutex_init(&sink->lock, NULL);
+    pthread_cond_init(&sink->not_empty, NULL);
+    pthread_cond_init(&sink->not_full, NULL);
+    pthread_cond_init(&sink->drained, NULL);
+    if (sink->running) { // the parent writes the queued records
+        __atomic_store_n(&async_enabled, false, __ATOMIC_RELAXED);
+        sink->running = false;
+        if (sink->spill)
+            fclose(sink->spill);
+        sink->spill = NULL;
+        free(sink->lanes[NORMAL_LANE].records);
+        free(sink->lanes[PRIORITY_LANE].records);
+        free(sink->batch);
+        sink->lanes[NORMAL_LANE].records = NULL;
+        sink->lanes[PRIORITY_LANE].records = NULL;
+        sink->batch = NULL;
+    }
+    sink->stopping = false;
+    sink->busy = false;
+    sink->spilling = 0;
+
+    struct shm_state *state = &shm_state;
+    pthread_mutex_init(&state->lock, NULL);
+    state->pushing = 0;
+    state->pid = (uint64_t)getpid();
+    state->collecting = false; // the ring stays attached, not collected
+    state->owner = false;
+
+    log_compression.size = 0; // the parent writes the pending frame
+    if (log_framing.enabled) { // a writer of its own in the shared file
+        log_framing.writer = (uint64_t)getpid();
+        log_framing.sequence = 0;
+    }
+}
+
+/*
+ * A signal handler cannot wait for a lock the crashed thread may hold, nor for
+ * the writer thread: the locks are tried for SIGNAL_LOCK_MS, then the records
+ * still queued are written directly.
+ */
+#define SIGNAL_LOCK_MS 100
+
+static bool try_sink_lock(void) {
+    return pthread_mutex_trylock(&async_sink.lock) == 0;
+}
+
+static bool try_log_mutex(void) {
+    return sync_mutex_trylock(&log_mutex);
+}
+
+static bool lock_within(bool (*trylock)(void)) {
+    uint64_t start = monotonic_ms();
+    while (!trylock()) {
+        if (monotonic_ms() - start >= SIGNAL_LOCK_MS)
+            return false;
+        sched_yield();
+    }
+    return true;
+}
+
+// logger_flush() of the signal handler. Returns with log_mutex locked, or
+// false if it could not be taken.
+static bool signal_flush(void) {
+    bool queued = __atomic_load_n(&async_enabled, __ATOMIC_ACQUIRE)
+                  && lock_within(try_sink_lock);
+    if (!lock_within(try_log_mutex)) {
+        if (queued)
+            pthread_mutex_unlock(&async_sink.lock);
+        return false;
+    }
+    if (queued) {
+        struct async_sink *sink = &async_sink;
+        size_t count = 0;
+        for (; !lanes_empty(sink); ++count) {
+            struct async_lane *lane = oldest_lane(sink);
+            if (log_file) {
+                index_record(lane_slot(lane, 0)->time);
+                write_log_file("%s\n", lane_slot(lane, 0)->line);
+            }
+            lane_pop(lane);
+        }
+        if (log_file)
+            sink->stats.written += count;
+        else
+            sink->stats.dropped += count;
+        pthread_mutex_unlock(&sink->lock);
+    }
+    return true;
+}
+
+// Writes a backtrace line to the shared ring or, when log_mutex is held, to
+// the log file.
+FORMAT(printf, 2, 3)
+static void write_fatal_line(bool locked, const char *const fmt, ...) {
+    static char line[BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (!shm_push(line, time(NULL), true) && locked && log_file) {
+        write_log_file("%s\n", line);
+        fflush(log_file);
+    }
+}
+
+static void log_backtrace(const char *const init_msg, bool with_date,
+                          bool in_signal) {
+    bool locked = true;
+    if (in_signal) {
+        locked = signal_flush();
+    } else {
+        logger_flush(); // the queued records come first
+        sync_mutex_lock(&log_mutex);
+    }
 
     if (init_msg) {
         static char _init_msg[1024];
         size_t idx = 0;
 
-        if (show_date) {
+        if (with_date) {
             time_t t = time(NULL);
             struct tm *tm_info = localtime(&t);
             strftime(_init_msg, 1024, "%Y-%m-%d %H:%M:%S ", tm_info);
             idx = strlen(_init_msg);
         }
 
-        if (log_file) {
-            fprintf(log_file, "%s[FATAL] %s\n", _init_msg, init_msg);
-            fflush(log_file);
-        }
+        write_fatal_line(locked, "%s[FATAL] %s", _init_msg, init_msg);
 
         if (log_callback) {
             static char _init_raw[1024];
@@ -187,10 +1701,7 @@ static void log_backtrace(const char *const init_msg) {
 
     for (int i = 1; i < nptrs; i++) {
         if (symbols) {
-            if (log_file) {
-                fprintf(log_file, "  %s\n", symbols[i]);
-                fflush(log_file);
-            }
+            write_fatal_line(locked, "  %s", symbols[i]);
 
             if (log_callback) {
                 snprintf(one, 512, "  %s", symbols[i]);
@@ -201,15 +1712,22 @@ static void log_backtrace(const char *const init_msg) {
 
     free(symbols);
 
-    pthread_mutex_unlock(&log_mutex);
+    if (!locked)
+        return;
+    if (log_file && log_compression.size) { // the process is about to die
+        finish_frame();
+        fflush(log_file);
+    }
+    sync_mutex_unlock(&log_mutex);
 }
 
 static void logger_signal_handler(int signo) {
-    if (log_trace_on_fatal) {
+    struct logger_config options = read_config_unlocked();
+    if (options.log_trace_on_fatal) {
         static char init_msg[256];
         snprintf(init_msg, 256, "Caught signal %d (%s). Backtrace:", signo,
                 strsignal(signo));
-        log_backtrace(init_msg);
+        log_backtrace(init_msg, options.show_date, true);
     }
 
     // Re-raise the signal to terminate the program with the defaut behavior
@@ -230,25 +1748,94 @@ CONSTRUCTOR void logger_init(void) {
     sigaction(SIGABRT, &sa, NULL); // Aborted
     sigaction(SIGFPE, &sa, NULL); // Floating-point exception
     sigaction(SIGBUS, &sa, NULL); // Bus error
+
+    pthread_atfork(NULL, NULL, logger_atfork_child);
 }
 
 DESTRUCTOR void logger_deinit(void) {
+    logger_shm_detach();
+    logger_stop_async();
     logger_close_file();
 }
 
 void logger_set_format_options(bool show_date_opt, bool show_thread_opt,
                                bool log_trace_on_fatal_opt) {
-    pthread_mutex_lock(&log_mutex);
-    show_date = show_date_opt;
-    show_thread = show_thread_opt;
-    log_trace_on_fatal = log_trace_on_fatal_opt;
-    pthread_mutex_unlock(&log_mutex);
+    seqlock_write_lock(&config_lock);
+    __atomic_store_n(&config.show_date, show_date_opt, __ATOMIC_RELAXED);
+    __atomic_store_n(&config.show_thread, show_thread_opt, __ATOMIC_RELAXED);
+    __atomic_store_n(&config.log_trace_on_fatal, log_trace_on_fatal_opt,
+                     __ATOMIC_RELAXED);
+    seqlock_write_unlock(&config_lock);
+}
+
+void logger_set_thread_name(const char *const name) {
+    thread_name[0] = '\0';
+    if (name) {
+        strncpy(thread_name, name, LOGGER_THREAD_NAME_SIZE - 1);
+        thread_name[LOGGER_THREAD_NAME_SIZE - 1] = '\0';
+    }
+}
+
+// ---------- Context ---------- //
+
+FORMAT(printf, 2, 0)
+static bool context_push(const char *const key, const char *const fmt,
+                         va_list args) {
+    struct log_context *context = &log_context;
+    size_t depth = context->depth++;
+    if (depth >= LOGGER_CONTEXT_DEPTH)
+        return false;
+
+    size_t size = context->size;
+    context->marks[depth] = size;
+    char *text = context->text + size;
+    size_t room = sizeof(context->text) - size;
+    int key_size = snprintf(text, room, "%s%s=", size ? " " : "", key);
+    if (key_size < 0 || (size_t)key_size >= room)
+        goto full;
+    int value_size = vsnprintf(text + key_size, room - (size_t)key_size, fmt,
+                               args);
+    if (value_size < 0 || (size_t)value_size >= room - (size_t)key_size)
+        goto full;
+    context->size = size + (size_t)key_size + (size_t)value_size;
+    return true;
+
+full: // an empty entry, still popped
+    *text = '\0';
+    return false;
+}
+
+bool logger_context_push(const char *const key, const char *const value) {
+    return logger_context_pushf(key, "%s", value);
+}
+
+bool logger_context_pushf(const char *const key, const char *const fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool pushed = context_push(key, fmt, args);
+    va_end(args);
+    return pushed;
+}
+
+void logger_context_pop(void) {
+    struct log_context *context = &log_context;
+    if (!context->depth)
+        return;
+    size_t depth = --context->depth;
+    if (depth < LOGGER_CONTEXT_DEPTH) {
+        context->size = context->marks[depth];
+        context->text[context->size] = '\0';
+    }
+}
+
+void logger_context_clear(void) {
+    log_context.depth = 0;
+    log_context.size = 0;
+    log_context.text[0] = '\0';
 }
 
 void logger_set_log_level(enum log_level level) {
-    pthread_mutex_lock(&log_mutex);
-    current_log_level = level;
-    pthread_mutex_unlock(&log_mutex);
+    set_log_level(level);
 }
 
 void logger_set_log_level_from_string(const char *const log_level) {
@@ -256,24 +1843,22 @@ void logger_set_log_level_from_string(const char *const log_level) {
     if (strncmp(log_level, "LOG_", 4) == 0)
         lvl_str = log_level + 4;
 
-    pthread_mutex_lock(&log_mutex);
     if (strcmp(lvl_str, "FULL") == 0)
-        current_log_level = LOG_FULL;
+        set_log_level(LOG_FULL);
     else if (strcmp(lvl_str, "DEBUG") == 0)
-        current_log_level = LOG_DEBUG;
+        set_log_level(LOG_DEBUG);
     else if (strcmp(lvl_str, "TRACE") == 0)
-        current_log_level = LOG_TRACE;
+        set_log_level(LOG_TRACE);
     else if (strcmp(lvl_str, "INFO") == 0)
-        current_log_level = LOG_INFO;
+        set_log_level(LOG_INFO);
     else if (strcmp(lvl_str, "WARN") == 0)
-        current_log_level = LOG_WARN;
+        set_log_level(LOG_WARN);
     else if (strcmp(lvl_str, "ERROR") == 0)
-        current_log_level = LOG_ERROR;
+        set_log_level(LOG_ERROR);
     else if (strcmp(lvl_str, "FATAL") == 0)
-        current_log_level = LOG_FATAL;
+        set_log_level(LOG_FATAL);
     else if (strcmp(lvl_str, "QUIET") == 0)
-        current_log_level = LOG_QUITE;
-    pthread_mutex_unlock(&log_mutex);
+        set_log_level(LOG_QUITE);
 }
 
 void logger_set_log_level_from_env(void) {
@@ -288,10 +1873,46 @@ bool logger_set_log_file(const char *const filename) {
     if (!file)
         return false;
 
+    struct log_index index = { 0 };
+    struct log_compression compression = { 0 };
+    struct log_framing framing = { 0 };
+    sync_mutex_lock(&log_mutex);
+    index.every_records = index_every_records;
+    index.every_bytes = index_every_bytes;
+    size_t frame_size = compression_frame_size;
+    framing.enabled = framing_enabled && !frame_size;
+    sync_mutex_unlock(&log_mutex);
+    if (frame_size) { // offsets in a compressed file are not seekable
+        index.every_records = 0;
+        index.every_bytes = 0;
+    }
+    // other processes may be appending: a torn record of a crash is left to
+    // the readers, which skip it, and this process numbers its own records
+    if (framing.enabled) {
+        if (!starts_with_record(filename)
+            || setvbuf(file, NULL, _IOFBF, RECORD_BUFFER_SIZE) != 0) {
+            fclose(file);
+            return false;
+        }
+        framing.writer = (uint64_t)getpid();
+    }
+    if (!file_size(file, &index.offset)
+        || (frame_size && !compression_init(&compression, frame_size))
+        || ((index.every_records || index.every_bytes)
+            && !open_index(filename, &index))) {
+        free(compression.pending);
+        free(compression.frame);
+        fclose(file);
+        return false;
+    }
+
     logger_close_file();
-    pthread_mutex_lock(&log_mutex);
+    sync_mutex_lock(&log_mutex);
     log_file = file;
-    pthread_mutex_unlock(&log_mutex);
+    log_index = index;
+    log_compression = compression;
+    log_framing = framing;
+    sync_mutex_unlock(&log_mutex);
     return true;
 }
 
@@ -310,25 +1931,102 @@ bool logger_set_log_file_from_env(const char *const default_filename) {
 
 bool logger_set_log_fileno(FILE *file) {
     logger_close_file();
-    pthread_mutex_lock(&log_mutex);
+    sync_mutex_lock(&log_mutex);
     log_file = file;
-    pthread_mutex_unlock(&log_mutex);
+    log_index = (struct log_index){ 0 }; // no path: no index
+    log_framing = (struct log_framing){ 0 };
+    sync_mutex_unlock(&log_mutex);
     return true;
 }
 
 void logger_close_file(void) {
+    logger_flush(); // queued records belong to this file
+    sync_mutex_lock(&log_mutex);
     if (log_file) {
-        pthread_mutex_lock(&log_mutex);
+        finish_frame();
         fclose(log_file);
         log_file = NULL;
-        pthread_mutex_unlock(&log_mutex);
     }
+    free(log_compression.pending);
+    free(log_compression.frame);
+    log_compression = (struct log_compression){ 0 };
+    log_framing = (struct log_framing){ 0 };
+    if (log_index.file) {
+        fclose(log_index.file);
+        log_index.file = NULL;
+    }
+    sync_mutex_unlock(&log_mutex);
+}
+
+void logger_set_index(size_t every_records, size_t every_bytes) {
+    sync_mutex_lock(&log_mutex);
+    index_every_records = every_records;
+    index_every_bytes = every_bytes;
+    sync_mutex_unlock(&log_mutex);
+}
+
+void logger_set_framing(bool framed) {
+    sync_mutex_lock(&log_mutex);
+    framing_enabled = framed;
+    sync_mutex_unlock(&log_mutex);
+}
+
+void logger_set_compression(size_t frame_size) {
+    if (frame_size && frame_size < FRAME_MIN_SIZE)
+        frame_size = FRAME_MIN_SIZE;
+    if (frame_size > LZ4_FRAME_MAX_SIZE)
+        frame_size = LZ4_FRAME_MAX_SIZE;
+    sync_mutex_lock(&log_mutex);
+    compression_frame_size = frame_size;
+    sync_mutex_unlock(&log_mutex);
+}
+
+bool logger_index_lookup(const char *const index_path, time_t since,
+                         time_t until, uint64_t *begin, uint64_t *end) {
+    int fd = open(index_path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    bool ok = false;
+    struct stat st;
+    struct index_entry header;
+    if (fstat(fd, &st) != 0
+        || (uint64_t)st.st_size < sizeof(struct index_entry)
+        || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || header.time != INDEX_MAGIC || header.offset != sizeof(header))
+        goto end;
+
+    uint64_t count = (uint64_t)st.st_size / sizeof(struct index_entry) - 1;
+    uint64_t first;
+    uint64_t last;
+    if (!index_search(fd, count, (int64_t)since, false, &first)
+        || !index_search(fd, count, (int64_t)until, true, &last))
+        goto end;
+
+    struct index_entry entry;
+    *begin = 0;
+    if (first > 0) {
+        if (!read_index_entry(fd, first - 1, &entry))
+            goto end;
+        *begin = entry.offset;
+    }
+    *end = UINT64_MAX;
+    if (last < count) {
+        if (!read_index_entry(fd, last, &entry))
+            goto end;
+        *end = entry.offset;
+    }
+    ok = true;
+
+end:
+    close(fd);
+    return ok;
 }
 
 void logger_set_callback(logger_cb_t callback) {
-    pthread_mutex_lock(&log_mutex);
-    log_callback = callback;
-    pthread_mutex_unlock(&log_mutex);
+    sync_mutex_lock(&log_mutex);
+    __atomic_store_n(&log_callback, callback, __ATOMIC_RELEASE);
+    sync_mutex_unlock(&log_mutex);
 }
 
 void log_message(enum log_level level, const char *const file, size_t line,
@@ -337,34 +2035,54 @@ void log_message(enum log_level level, const char *const file, size_t line,
     // for convenience to accept either all logs or no ones.
     if (level == LOG_FULL || level == LOG_QUITE)
         return;
-    if (level > current_log_level)
+    struct logger_config options = read_config();
+    if (level > options.level)
         return;
 
     char colored_msg[BUFFER_SIZE];
     char raw_msg[BUFFER_SIZE];
+    time_t now = time(NULL);
     va_list args;
     va_start(args, fmt);
-    format_log_message(colored_msg, raw_msg, BUFFER_SIZE, level, file, line,
-                       func, fmt, args);
+    format_log_message(colored_msg, raw_msg, BUFFER_SIZE, &options, now, level,
+                       file, line, func, fmt, args);
     va_end(args);
 
-    pthread_mutex_lock(&log_mutex);
-
-    if (log_callback) {
-        log_callback(level, colored_msg, raw_msg);
+    enum async_result queued = ASYNC_DIRECT;
+    if (shm_push(raw_msg, now, level <= LOG_ERROR)) {
+        queued = ASYNC_QUEUED;
+    } else if (__atomic_load_n(&async_enabled, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&async_sink.lock);
+        queued = async_push(&async_sink, level, now, raw_msg);
+        pthread_mutex_unlock(&async_sink.lock);
+        if (queued == ASYNC_SPILL) // outside the lock, see spilling
+            async_spill(&async_sink, raw_msg);
     }
 
-    if (log_file) {
-        fprintf(log_file, "%s\n", raw_msg);
-        fflush(log_file);
-    }
+    // the writer threads hold log_mutex while writing: a queued record only
+    // takes it for the callback
+    if (queued == ASYNC_DIRECT
+        || __atomic_load_n(&log_callback, __ATOMIC_ACQUIRE)) {
+        sync_mutex_lock(&log_mutex);
+
+        if (log_callback) {
+            log_callback(level, colored_msg, raw_msg);
+        }
+
+        if (log_file && queued == ASYNC_DIRECT) {
+            index_record(now);
+            write_log_file("%s\n", raw_msg);
+            fflush(log_file);
+        }
 
-    pthread_mutex_unlock(&log_mutex);
+        sync_mutex_unlock(&log_mutex);
+    }
 
     if (level == LOG_FATAL) {
-        if (log_trace_on_fatal) {
-            log_backtrace(NULL);
+        if (options.log_trace_on_fatal) {
+            log_backtrace(NULL, options.show_date, false);
         }
+        logger_flush();
         exit(EXIT_FAILURE);
     }
 }
@@ -385,5 +2103,5 @@ void log_on_stderr(UNUSED enum log_level lvl, const char *const colored_message,
 // ---------- Logger Tests ---------- //
 
 enum log_level logger_get_log_level(void) {
-    return current_log_level;
+    return read_config().level;
 }
@@ -0,0 +1,405 @@
+#include <ayaztub/core_utils/lz4.h>
+
+#include <string.h>
+
+/*
+ * Design:
+ * - A block is a list of sequences: a token (4 bits of literal length, 4 bits
+ *   of match length - 4, 15 meaning "more length bytes follow"), the
+ *   literals, then a 16 bits offset and the extra match length. The last
+ *   sequence only has literals: the last 5 bytes are always literals and a
+ *   match cannot start in the last 12 bytes (so that decoders can copy by
+ *   words).
+ * - The compressor hashes the 4 bytes at each position into a table of the
+ *   last positions (16K entries, on the stack). On a miss, the step grows
+ *   with the distance to the last match, so incompressible data is crossed
+ *   quickly. Matches are extended backwards over the pending literals.
+ * - Frame fields are little endian and read byte by byte. The hashed 4 bytes
+ *   only need to be consistent, so they are read in the native order.
+ */
+
+#define LZ4_MAGIC 0x184D2204U
+#define LZ4_SKIPPABLE_MASK 0xFFFFFFF0U
+#define LZ4_SKIPPABLE_MAGIC 0x184D2A50U
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MF_LIMIT 12
+#define MAX_DISTANCE 65535
+#define HASH_LOG 14
+#define SKIP_TRIGGER 6
+
+// FLG bits of the frame descriptor
+#define FLG_VERSION 0x40
+#define FLG_BLOCK_INDEPENDENCE 0x20
+#define FLG_BLOCK_CHECKSUM 0x10
+#define FLG_CONTENT_SIZE 0x08
+#define FLG_CONTENT_CHECKSUM 0x04
+#define FLG_DICT_ID 0x01
+
+#define BLOCK_UNCOMPRESSED 0x80000000U
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16
+           | (uint32_t)p[3] << 24;
+}
+
+static inline void write_le32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+// ---------- XXH32 ---------- //
+
+#define PRIME32_1 2654435761U
+#define PRIME32_2 2246822519U
+#define PRIME32_3 3266489917U
+#define PRIME32_4 668265263U
+#define PRIME32_5 374761393U
+
+static inline uint32_t rotl32(uint32_t x, unsigned r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t xxh32_round(uint32_t acc, uint32_t input) {
+    acc += input * PRIME32_2;
+    return rotl32(acc, 13) * PRIME32_1;
+}
+
+uint32_t lz4_xxh32(const void *data, size_t size, uint32_t seed) {
+    const uint8_t *p = data;
+    const uint8_t *end = p + size;
+    uint32_t h;
+    if (size >= 16) {
+        uint32_t v1 = seed + PRIME32_1 + PRIME32_2;
+        uint32_t v2 = seed + PRIME32_2;
+        uint32_t v3 = seed;
+        uint32_t v4 = seed - PRIME32_1;
+        do {
+            v1 = xxh32_round(v1, read_le32(p));
+            v2 = xxh32_round(v2, read_le32(p + 4));
+            v3 = xxh32_round(v3, read_le32(p + 8));
+            v4 = xxh32_round(v4, read_le32(p + 12));
+            p += 16;
+        } while (end - p >= 16);
+        h = rotl32(v1, 1) + rotl32(v2, 7) + rotl32(v3, 12) + rotl32(v4, 18);
+    } else {
+        h = seed + PRIME32_5;
+    }
+    h += (uint32_t)size;
+    for (; end - p >= 4; p += 4)
+        h = rotl32(h + read_le32(p) * PRIME32_3, 17) * PRIME32_4;
+    for (; p < end; ++p)
+        h = rotl32(h + *p * PRIME32_5, 11) * PRIME32_1;
+    h ^= h >> 15;
+    h *= PRIME32_2;
+    h ^= h >> 13;
+    h *= PRIME32_3;
+    h ^= h >> 16;
+    return h;
+}
+
+// ---------- Blocks ---------- //
+
+static uint8_t *write_length(uint8_t *op, size_t length) {
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static uint8_t *write_sequence(uint8_t *op, const uint8_t *literals,
+                               size_t literal_length, size_t offset,
+                               size_t match_length) {
+    uint8_t *token = op++;
+    *token = (uint8_t)((literal_length < 15 ? literal_length : 15) << 4);
+    if (literal_length >= 15)
+        op = write_length(op, literal_length - 15);
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (!match_length) // last literals
+        return op;
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    match_length -= MIN_MATCH;
+    *token |= (uint8_t)(match_length < 15 ? match_length : 15);
+    if (match_length >= 15)
+        op = write_length(op, match_length - 15);
+    return op;
+}
+
+size_t lz4_compress_block(const void *src, size_t size, void *dst,
+                          size_t capacity) {
+    if (capacity < lz4_compress_bound(size) || size > 0x7E000000)
+        return 0;
+    const uint8_t *base = src;
+    uint8_t *op = dst;
+    size_t anchor = 0;
+
+    if (size > MF_LIMIT) {
+        uint32_t table[1 << HASH_LOG];
+        memset(table, 0, sizeof(table));
+        size_t limit = size - MF_LIMIT;
+        size_t match_limit = size - LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < limit) {
+            uint32_t sequence = read32(base + ip);
+            uint32_t h = hash4(sequence);
+            size_t ref = table[h];
+            table[h] = (uint32_t)ip;
+            if (ref >= ip || ip - ref > MAX_DISTANCE
+                || read32(base + ref) != sequence) {
+                ip += 1 + ((ip - anchor) >> SKIP_TRIGGER);
+                continue;
+            }
+
+            while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t length = MIN_MATCH;
+            while (ip + length < match_limit
+                   && base[ip + length] == base[ref + length])
+                length++;
+            op = write_sequence(op, base + anchor, ip - anchor, ip - ref,
+                                length);
+            ip += length;
+            anchor = ip;
+            if (ip - 2 < limit)
+                table[hash4(read32(base + ip - 2))] = (uint32_t)(ip - 2);
+        }
+    }
+    op = write_sequence(op, base + anchor, size - anchor, 0, 0);
+    return (size_t)(op - (uint8_t *)dst);
+}
+
+static bool read_length(const uint8_t **ip, const uint8_t *end,
+                        size_t *length) {
+    uint8_t byte;
+    do {
+        if (*ip >= end)
+            return false;
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/*
+ * Decodes a block at op, matches can reach back to base (the start of the
+ * frame output for linked blocks).
+ */
+static bool decode_block(const uint8_t *ip, size_t size, uint8_t *base,
+                         uint8_t *op, const uint8_t *oend, uint8_t **out) {
+    const uint8_t *end = ip + size;
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(&ip, end, &literal_length))
+            return false;
+        if ((size_t)(end - ip) < literal_length
+            || (size_t)(oend - op) < literal_length)
+            return false;
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        if (ip == end) // last literals
+            break;
+
+        if (end - ip < 2)
+            return false;
+        size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15 && !read_length(&ip, end, &match_length))
+            return false;
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - base)
+            || (size_t)(oend - op) < match_length)
+            return false;
+        const uint8_t *match = op - offset;
+        if (offset >= match_length) {
+            memcpy(op, match, match_length);
+            op += match_length;
+        } else { // overlapping: repeats the last offset bytes
+            for (size_t i = 0; i < match_length; ++i)
+                *op++ = *match++;
+        }
+    }
+    *out = op;
+    return true;
+}
+
+bool lz4_decompress_block(const void *src, size_t size, void *dst,
+                          size_t capacity, size_t *produced) {
+    uint8_t *base = dst;
+    uint8_t *op;
+    if (!decode_block(src, size, base, base, base + capacity, &op))
+        return false;
+    *produced = (size_t)(op - base);
+    return true;
+}
+
+// ---------- Frames ---------- //
+
+// Block maximum size code of the BD byte (4: 64KB to 7: 4MB).
+static uint8_t block_size_code(size_t size) {
+    uint8_t code = 4;
+    while (code < 7 && size > ((size_t)1 << (8 + 2 * code)))
+        code++;
+    return code;
+}
+
+size_t lz4_frame_compress(const void *src, size_t size, void *dst,
+                          size_t capacity) {
+    if (size > LZ4_FRAME_MAX_SIZE || capacity < lz4_frame_bound(size))
+        return 0;
+    uint8_t *op = dst;
+    write_le32(op, LZ4_MAGIC);
+    uint8_t *descriptor = op + 4;
+    descriptor[0] = FLG_VERSION | FLG_BLOCK_INDEPENDENCE | FLG_CONTENT_SIZE;
+    descriptor[1] = (uint8_t)(block_size_code(size) << 4);
+    uint64_t content_size = size;
+    for (unsigned i = 0; i < 8; ++i)
+        descriptor[2 + i] = (uint8_t)(content_size >> (8 * i));
+    descriptor[10] = (uint8_t)(lz4_xxh32(descriptor, 10, 0) >> 8);
+    op = descriptor + 11;
+
+    if (size) {
+        size_t compressed =
+            lz4_compress_block(src, size, op + 4, lz4_compress_bound(size));
+        if (compressed && compressed < size) {
+            write_le32(op, (uint32_t)compressed);
+            op += 4 + compressed;
+        } else { // stored
+            write_le32(op, (uint32_t)size | BLOCK_UNCOMPRESSED);
+            memcpy(op + 4, src, size);
+            op += 4 + size;
+        }
+    }
+    write_le32(op, 0); // end mark
+    op += 4;
+    return (size_t)(op - (uint8_t *)dst);
+}
+
+struct frame_header {
+    uint8_t flags;
+    size_t block_max;
+    bool has_content_size;
+    uint64_t content_size;
+    size_t size; /**< size of the header */
+};
+
+static bool read_frame_header(const uint8_t *p, size_t size,
+                              struct frame_header *header) {
+    if (size < 7 || read_le32(p) != LZ4_MAGIC)
+        return false;
+    uint8_t flags = p[4];
+    uint8_t bd = p[5];
+    if ((flags & 0xC0) != FLG_VERSION || (flags & 0x02) || (bd & 0x8F))
+        return false;
+    unsigned code = (bd >> 4) & 7;
+    if (code < 4)
+        return false;
+
+    size_t descriptor = 2 + (flags & FLG_CONTENT_SIZE ? 8 : 0)
+                        + (flags & FLG_DICT_ID ? 4 : 0);
+    if (size < 4 + descriptor + 1
+        || p[4 + descriptor] != (uint8_t)(lz4_xxh32(p + 4, descriptor, 0) >> 8))
+        return false;
+    header->flags = flags;
+    header->block_max = (size_t)1 << (8 + 2 * code);
+    header->has_content_size = flags & FLG_CONTENT_SIZE;
+    header->content_size = 0;
+    for (unsigned i = 0; header->has_content_size && i < 8; ++i)
+        header->content_size |= (uint64_t)p[6 + i] << (8 * i);
+    header->size = 4 + descriptor + 1;
+    return true;
+}
+
+bool lz4_frame_content_size(const void *src, size_t size,
+                            uint64_t *content_size) {
+    struct frame_header header;
+    if (!read_frame_header(src, size, &header) || !header.has_content_size)
+        return false;
+    *content_size = header.content_size;
+    return true;
+}
+
+bool lz4_frame_decompress(const void *src, size_t size, void *dst,
+                          size_t capacity, size_t *consumed,
+                          size_t *produced) {
+    const uint8_t *ip = src;
+    const uint8_t *end = ip + size;
+    if (size >= 8
+        && (read_le32(ip) & LZ4_SKIPPABLE_MASK) == LZ4_SKIPPABLE_MAGIC) {
+        uint32_t length = read_le32(ip + 4);
+        if (size - 8 < length)
+            return false;
+        *consumed = 8 + (size_t)length;
+        *produced = 0;
+        return true;
+    }
+
+    struct frame_header header;
+    if (!read_frame_header(ip, size, &header) || header.flags & FLG_DICT_ID)
+        return false;
+    ip += header.size;
+
+    uint8_t *base = dst;
+    uint8_t *op = base;
+    uint8_t *oend = base + capacity;
+    bool independent = header.flags & FLG_BLOCK_INDEPENDENCE;
+    size_t checksum_size = header.flags & FLG_BLOCK_CHECKSUM ? 4 : 0;
+    for (;;) {
+        if (end - ip < 4)
+            return false;
+        uint32_t block = read_le32(ip);
+        ip += 4;
+        if (block == 0) // end mark
+            break;
+        size_t block_size = block & ~BLOCK_UNCOMPRESSED;
+        if (block_size > header.block_max
+            || (size_t)(end - ip) < block_size + checksum_size)
+            return false;
+        if (checksum_size
+            && read_le32(ip + block_size) != lz4_xxh32(ip, block_size, 0))
+            return false;
+
+        if (block & BLOCK_UNCOMPRESSED) {
+            if ((size_t)(oend - op) < block_size)
+                return false;
+            memcpy(op, ip, block_size);
+            op += block_size;
+        } else if (!decode_block(ip, block_size, independent ? op : base, op,
+                                 oend, &op)) {
+            return false;
+        }
+        ip += block_size + checksum_size;
+    }
+
+    size_t output = (size_t)(op - base);
+    if (header.has_content_size && header.content_size != output)
+        return false;
+    if (header.flags & FLG_CONTENT_CHECKSUM) {
+        if (end - ip < 4 || read_le32(ip) != lz4_xxh32(base, output, 0))
+            return false;
+        ip += 4;
+    }
+    *consumed = (size_t)(ip - (const uint8_t *)src);
+    *produced = output;
+    return true;
+}
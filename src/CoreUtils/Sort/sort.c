@@ -0,0 +1,326 @@
+#include <ayaztub/concurrency/thread_pool.h>
+#include <ayaztub/core_utils/sort.h>
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Design:
+ * - Every key type is mapped to an unsigned integer of the same size whose
+ *   order is the key order (the radix key): signed integers get their sign
+ *   bit flipped, floats their sign bit flipped if positive or all their bits
+ *   flipped if negative.
+ * - The radix sort counts the bytes of every position in one read of the
+ *   keys, then scatters the keys between the array and a scratch buffer once
+ *   per position where the keys differ. Below SORT_RADIX_THRESHOLD keys, the
+ *   counters cost more than they save and the pdqsort is used instead.
+ * - The parallel sort is a sample sort with one bucket per part: the array is
+ *   cut in parts, sorted samples give the bucket splitters, every part counts
+ *   then scatters its keys to the buckets (in the scratch buffer), and every
+ *   bucket is radix sorted back into the array. The bucket of a key is found
+ *   with a branchless binary search and remembered in a byte between the two
+ *   passes.
+ */
+
+#define SORT_RADIX_THRESHOLD 256
+#define SORT_KV_INSERTION_THRESHOLD 32
+#define SORT_MAX_PARTS 256
+#define SORT_MIN_PART_SIZE 4096
+#define SORT_SAMPLES_PER_PART 32
+
+// ---------- Radix Keys ---------- //
+#define SORT_UNSIGNED_KEY(type, name, utype)                                   \
+    static inline utype name##_radix_key(type value) {                         \
+        return (utype)value;                                                   \
+    }
+
+#define SORT_SIGNED_KEY(type, name, utype)                                     \
+    static inline utype name##_radix_key(type value) {                         \
+        return (utype)((utype)value                                            \
+                       ^ ((utype)1 << (sizeof(utype) * CHAR_BIT - 1)));        \
+    }
+
+#define SORT_FLOAT_KEY(type, name, utype)                                      \
+    static inline utype name##_radix_key(type value) {                         \
+        utype bits;                                                            \
+        memcpy(&bits, &value, sizeof(bits));                                   \
+        utype high = (utype)1 << (sizeof(utype) * CHAR_BIT - 1);               \
+        return bits ^ ((bits & high) ? (utype)~(utype)0 : high);               \
+    }
+
+#if CHAR_MIN < 0
+SORT_SIGNED_KEY(char, char, unsigned char)
+#else // CHAR_MIN < 0
+SORT_UNSIGNED_KEY(char, char, unsigned char)
+#endif // CHAR_MIN < 0
+SORT_SIGNED_KEY(signed char, schar, unsigned char)
+SORT_UNSIGNED_KEY(unsigned char, uchar, unsigned char)
+SORT_SIGNED_KEY(short, short, unsigned short)
+SORT_UNSIGNED_KEY(unsigned short, ushort, unsigned short)
+SORT_SIGNED_KEY(int, int, unsigned int)
+SORT_UNSIGNED_KEY(unsigned int, uint, unsigned int)
+SORT_SIGNED_KEY(long, long, unsigned long)
+SORT_UNSIGNED_KEY(unsigned long, ulong, unsigned long)
+SORT_SIGNED_KEY(long long, llong, unsigned long long)
+SORT_UNSIGNED_KEY(unsigned long long, ullong, unsigned long long)
+SORT_FLOAT_KEY(float, float, uint32_t)
+SORT_FLOAT_KEY(double, double, uint64_t)
+
+// ---------- Sorts ---------- //
+#define SORT_PRIMITIVE_DEFINE(type, name, utype)                               \
+    static inline bool name##_key_less(type a, type b) {                       \
+        return name##_radix_key(a) < name##_radix_key(b);                      \
+    }                                                                          \
+                                                                               \
+    SORT_DECL(type, name##_keys, name##_key_less)                              \
+                                                                               \
+    /* Sorts src using tmp, returns the buffer holding the sorted keys. */     \
+    static type *name##_radix(type *src, type *tmp, size_t count) {            \
+        enum { DIGITS = sizeof(type) };                                        \
+        size_t counts[DIGITS][256];                                            \
+        memset(counts, 0, sizeof(counts));                                     \
+        for (size_t i = 0; i < count; ++i) {                                   \
+            utype key = name##_radix_key(src[i]);                              \
+            for (unsigned d = 0; d < DIGITS; ++d)                              \
+                counts[d][(key >> (d * CHAR_BIT)) & 0xFF]++;                   \
+        }                                                                      \
+                                                                               \
+        utype first = name##_radix_key(src[0]);                                \
+        for (unsigned d = 0; d < DIGITS; ++d) {                                \
+            unsigned shift = d * CHAR_BIT;                                     \
+            if (counts[d][(first >> shift) & 0xFF] == count)                   \
+                continue; /* same byte everywhere */                           \
+            size_t offset = 0;                                                 \
+            for (unsigned b = 0; b < 256; ++b) {                               \
+                size_t n = counts[d][b];                                       \
+                counts[d][b] = offset;                                         \
+                offset += n;                                                   \
+            }                                                                  \
+            for (size_t i = 0; i < count; ++i) {                               \
+                size_t b = (name##_radix_key(src[i]) >> shift) & 0xFF;         \
+                tmp[counts[d][b]++] = src[i];                                  \
+            }                                                                  \
+            type *swap = src;                                                  \
+            src = tmp;                                                         \
+            tmp = swap;                                                        \
+        }                                                                      \
+        return src;                                                            \
+    }                                                                          \
+                                                                               \
+    void radix_sort_##name(type *array, size_t count) {                        \
+        type *scratch;                                                         \
+        if (count < SORT_RADIX_THRESHOLD                                       \
+            || !(scratch = malloc(count * sizeof(type)))) {                    \
+            name##_keys_sort(array, count);                                    \
+            return;                                                            \
+        }                                                                      \
+        if (name##_radix(array, scratch, count) != array)                      \
+            memcpy(array, scratch, count * sizeof(type));                      \
+        free(scratch);                                                         \
+    }                                                                          \
+                                                                               \
+    bool radix_sort_##name##_kv(type *keys, size_t *values, size_t count) {    \
+        if (count < SORT_KV_INSERTION_THRESHOLD) {                             \
+            for (size_t i = 1; i < count; ++i) {                               \
+                type key = keys[i];                                            \
+                size_t value = values[i];                                      \
+                size_t j = i;                                                  \
+                for (; j > 0 && name##_key_less(key, keys[j - 1]); --j) {      \
+                    keys[j] = keys[j - 1];                                     \
+                    values[j] = values[j - 1];                                 \
+                }                                                              \
+                keys[j] = key;                                                 \
+                values[j] = value;                                             \
+            }                                                                  \
+            return true;                                                       \
+        }                                                                      \
+                                                                               \
+        enum { DIGITS = sizeof(type) };                                        \
+        type *key_tmp = malloc(count * sizeof(type));                          \
+        size_t *value_tmp = malloc(count * sizeof(size_t));                    \
+        if (!key_tmp || !value_tmp) {                                          \
+            free(key_tmp);                                                     \
+            free(value_tmp);                                                   \
+            return false;                                                      \
+        }                                                                      \
+        size_t counts[DIGITS][256];                                            \
+        memset(counts, 0, sizeof(counts));                                     \
+        for (size_t i = 0; i < count; ++i) {                                   \
+            utype key = name##_radix_key(keys[i]);                             \
+            for (unsigned d = 0; d < DIGITS; ++d)                              \
+                counts[d][(key >> (d * CHAR_BIT)) & 0xFF]++;                   \
+        }                                                                      \
+                                                                               \
+        type *key_src = keys;                                                  \
+        type *key_dst = key_tmp;                                               \
+        size_t *value_src = values;                                            \
+        size_t *value_dst = value_tmp;                                         \
+        utype first = name##_radix_key(keys[0]);                               \
+        for (unsigned d = 0; d < DIGITS; ++d) {                                \
+            unsigned shift = d * CHAR_BIT;                                     \
+            if (counts[d][(first >> shift) & 0xFF] == count)                   \
+                continue;                                                      \
+            size_t offset = 0;                                                 \
+            for (unsigned b = 0; b < 256; ++b) {                               \
+                size_t n = counts[d][b];                                       \
+                counts[d][b] = offset;                                         \
+                offset += n;                                                   \
+            }                                                                  \
+            for (size_t i = 0; i < count; ++i) {                               \
+                size_t b = (name##_radix_key(key_src[i]) >> shift) & 0xFF;     \
+                size_t to = counts[d][b]++;                                    \
+                key_dst[to] = key_src[i];                                      \
+                value_dst[to] = value_src[i];                                  \
+            }                                                                  \
+            type *key_swap = key_src;                                          \
+            key_src = key_dst;                                                 \
+            key_dst = key_swap;                                                \
+            size_t *value_swap = value_src;                                    \
+            value_src = value_dst;                                             \
+            value_dst = value_swap;                                            \
+        }                                                                      \
+        if (key_src != keys) {                                                 \
+            memcpy(keys, key_src, count * sizeof(type));                       \
+            memcpy(values, value_src, count * sizeof(size_t));                 \
+        }                                                                      \
+        free(key_tmp);                                                         \
+        free(value_tmp);                                                       \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    struct name##_sample_sort {                                                \
+        type *array;                                                           \
+        type *scratch;                                                         \
+        unsigned char *buckets; /* bucket of every key */                      \
+        size_t *offsets; /* [part][bucket] counts, then offsets */             \
+        size_t *starts; /* [bucket], start of the bucket in scratch */         \
+        size_t count;                                                          \
+        size_t part_size;                                                      \
+        size_t parts; /* power of two */                                       \
+        utype splitters[SORT_MAX_PARTS]; /* [b]: first key of bucket b */      \
+    };                                                                         \
+                                                                               \
+    static void name##_count_part(size_t begin, size_t end, void *ctx) {       \
+        struct name##_sample_sort *sort = ctx;                                 \
+        for (size_t part = begin; part < end; ++part) {                        \
+            size_t *counts = &sort->offsets[part * sort->parts];               \
+            size_t last = (part + 1) * sort->part_size;                        \
+            if (last > sort->count)                                            \
+                last = sort->count;                                            \
+            for (size_t i = part * sort->part_size; i < last; ++i) {           \
+                utype key = name##_radix_key(sort->array[i]);                  \
+                size_t bucket = 0;                                             \
+                for (size_t step = sort->parts / 2; step; step /= 2) {         \
+                    utype splitter = sort->splitters[bucket + step];           \
+                    bucket += key >= splitter ? step : 0;                      \
+                }                                                              \
+                sort->buckets[i] = (unsigned char)bucket;                      \
+                counts[bucket]++;                                              \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static void name##_scatter_part(size_t begin, size_t end, void *ctx) {     \
+        struct name##_sample_sort *sort = ctx;                                 \
+        for (size_t part = begin; part < end; ++part) {                        \
+            size_t *offsets = &sort->offsets[part * sort->parts];              \
+            size_t last = (part + 1) * sort->part_size;                        \
+            if (last > sort->count)                                            \
+                last = sort->count;                                            \
+            for (size_t i = part * sort->part_size; i < last; ++i)             \
+                sort->scratch[offsets[sort->buckets[i]]++] = sort->array[i];   \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static void name##_sort_bucket(size_t begin, size_t end, void *ctx) {      \
+        struct name##_sample_sort *sort = ctx;                                 \
+        for (size_t bucket = begin; bucket < end; ++bucket) {                  \
+            size_t start = sort->starts[bucket];                               \
+            size_t count = sort->starts[bucket + 1] - start;                   \
+            type *src = sort->scratch + start;                                 \
+            type *dst = sort->array + start;                                   \
+            if (count < SORT_RADIX_THRESHOLD) {                                \
+                memcpy(dst, src, count * sizeof(type));                        \
+                name##_keys_sort(dst, count);                                  \
+            } else if (name##_radix(src, dst, count) != dst) {                 \
+                memcpy(dst, src, count * sizeof(type));                        \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    void parallel_sort_##name(struct thread_pool *pool, type *array,           \
+                              size_t count) {                                  \
+        size_t parts = 1;                                                      \
+        size_t threads = thread_pool_size(pool) + 1; /* with the caller */     \
+        while (parts * 2 <= 4 * threads && parts * 2 <= SORT_MAX_PARTS         \
+               && count / (parts * 2) >= SORT_MIN_PART_SIZE)                   \
+            parts *= 2;                                                        \
+        if (count < SORT_PARALLEL_THRESHOLD || parts < 2) {                    \
+            radix_sort_##name(array, count);                                   \
+            return;                                                            \
+        }                                                                      \
+                                                                               \
+        struct name##_sample_sort sort = {                                     \
+            .array = array,                                                    \
+            .scratch = malloc(count * sizeof(type)),                           \
+            .buckets = malloc(count),                                          \
+            .offsets = calloc(parts * parts, sizeof(size_t)),                  \
+            .starts = malloc((parts + 1) * sizeof(size_t)),                    \
+            .count = count,                                                    \
+            .part_size = (count + parts - 1) / parts,                          \
+            .parts = parts,                                                    \
+        };                                                                     \
+        if (!sort.scratch || !sort.buckets || !sort.offsets || !sort.starts) { \
+            radix_sort_##name(array, count);                                   \
+            goto cleanup;                                                      \
+        }                                                                      \
+                                                                               \
+        /* splitters from evenly spread samples, sorted in scratch */          \
+        type *samples = sort.scratch;                                          \
+        size_t sample_count = parts * SORT_SAMPLES_PER_PART;                   \
+        for (size_t i = 0; i < sample_count; ++i)                              \
+            samples[i] = array[(i * 2 + 1) * (count / (2 * sample_count))];    \
+        name##_keys_sort(samples, sample_count);                               \
+        sort.splitters[0] = 0;                                                 \
+        for (size_t b = 1; b < parts; ++b)                                     \
+            sort.splitters[b] =                                                \
+                name##_radix_key(samples[b * SORT_SAMPLES_PER_PART]);          \
+                                                                               \
+        thread_pool_parallel_for(pool, 0, parts, 1, name##_count_part, &sort); \
+        size_t offset = 0;                                                     \
+        for (size_t b = 0; b < parts; ++b) {                                   \
+            sort.starts[b] = offset;                                           \
+            for (size_t part = 0; part < parts; ++part) {                      \
+                size_t n = sort.offsets[part * parts + b];                     \
+                sort.offsets[part * parts + b] = offset;                       \
+                offset += n;                                                   \
+            }                                                                  \
+        }                                                                      \
+        sort.starts[parts] = offset;                                           \
+        thread_pool_parallel_for(pool, 0, parts, 1, name##_scatter_part,       \
+                                 &sort);                                       \
+        thread_pool_parallel_for(pool, 0, parts, 1, name##_sort_bucket,        \
+                                 &sort);                                       \
+                                                                               \
+    cleanup:                                                                   \
+        free(sort.scratch);                                                    \
+        free(sort.buckets);                                                    \
+        free(sort.offsets);                                                    \
+        free(sort.starts);                                                     \
+    }
+
+SORT_PRIMITIVE_DEFINE(char, char, unsigned char)
+SORT_PRIMITIVE_DEFINE(signed char, schar, unsigned char)
+SORT_PRIMITIVE_DEFINE(unsigned char, uchar, unsigned char)
+SORT_PRIMITIVE_DEFINE(short, short, unsigned short)
+SORT_PRIMITIVE_DEFINE(unsigned short, ushort, unsigned short)
+SORT_PRIMITIVE_DEFINE(int, int, unsigned int)
+SORT_PRIMITIVE_DEFINE(unsigned int, uint, unsigned int)
+SORT_PRIMITIVE_DEFINE(long, long, unsigned long)
+SORT_PRIMITIVE_DEFINE(unsigned long, ulong, unsigned long)
+SORT_PRIMITIVE_DEFINE(long long, llong, unsigned long long)
+SORT_PRIMITIVE_DEFINE(unsigned long long, ullong, unsigned long long)
+SORT_PRIMITIVE_DEFINE(float, float, uint32_t)
+SORT_PRIMITIVE_DEFINE(double, double, uint64_t)
@@ -0,0 +1,376 @@
+#include <ayaztub/core_utils/bits.h>
+#include <ayaztub/core_utils/str.h>
+
+#include <float.h>
+#include <stdio.h>
+
+#if defined(__SSE2__) && !defined(STR_NO_SIMD)
+#    include <emmintrin.h>
+#    define STR_SSE2 1
+#endif // __SSE2__ && !STR_NO_SIMD
+
+#define STR_BLOCK 16
+
+static inline unsigned char ascii_lower(char c) {
+    return (unsigned char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+}
+
+#ifdef STR_SSE2
+/*
+ * Lower-cases the ASCII letters of a block: adding 0x80 - 'A' maps ['A', 'Z']
+ * to the 26 smallest signed bytes, which a single signed comparison detects.
+ */
+static inline __m128i block_lower(__m128i block) {
+    __m128i shifted = _mm_add_epi8(block, _mm_set1_epi8((char)(0x80 - 'A')));
+    __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(-128 + 26)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#endif // STR_SSE2
+
+// ---------- String Views ---------- //
+static bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+struct strview strview_trim(struct strview view) {
+    while (view.size && is_space(view.data[0])) {
+        view.data++;
+        view.size--;
+    }
+    while (view.size && is_space(view.data[view.size - 1]))
+        view.size--;
+    return view;
+}
+
+int strview_cmp_nocase(struct strview a, struct strview b) {
+    size_t size = a.size < b.size ? a.size : b.size;
+    size_t i = 0;
+
+#ifdef STR_SSE2
+    for (; i + STR_BLOCK <= size; i += STR_BLOCK) {
+        __m128i la =
+            block_lower(_mm_loadu_si128((const __m128i *)(a.data + i)));
+        __m128i lb =
+            block_lower(_mm_loadu_si128((const __m128i *)(b.data + i)));
+        uint32_t equal = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(la, lb));
+        if (equal != 0xffff) {
+            i += bits_ctz32(~equal);
+            return ascii_lower(a.data[i]) - ascii_lower(b.data[i]);
+        }
+    }
+#endif // STR_SSE2
+
+    for (; i < size; i++) {
+        int diff = ascii_lower(a.data[i]) - ascii_lower(b.data[i]);
+        if (diff)
+            return diff;
+    }
+    return (a.size > b.size) - (a.size < b.size);
+}
+
+bool strview_eq_nocase(struct strview a, struct strview b) {
+    return a.size == b.size && strview_cmp_nocase(a, b) == 0;
+}
+
+/*
+ * W. Muła, "SIMD-friendly algorithms for substring searching": candidates are
+ * the positions where both the first and the last character of the needle
+ * match, which filters 16 positions per iteration before any memcmp().
+ */
+size_t strview_find(struct strview view, struct strview needle) {
+    if (!needle.size)
+        return 0;
+    if (needle.size > view.size)
+        return STRVIEW_NPOS;
+    if (needle.size == 1)
+        return strview_find_char(view, needle.data[0]);
+
+    const char *data = view.data;
+    size_t size = needle.size;
+    size_t last = view.size - size; // last candidate position
+    size_t i = 0;
+
+#ifdef STR_SSE2
+    __m128i first_char = _mm_set1_epi8(needle.data[0]);
+    __m128i last_char = _mm_set1_epi8(needle.data[size - 1]);
+    for (; i + STR_BLOCK - 1 <= last; i += STR_BLOCK) {
+        __m128i firsts = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i lasts =
+            _mm_loadu_si128((const __m128i *)(data + i + size - 1));
+        __m128i match = _mm_and_si128(_mm_cmpeq_epi8(firsts, first_char),
+                                      _mm_cmpeq_epi8(lasts, last_char));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+        while (mask) {
+            size_t pos = i + bits_ctz32(mask);
+            if (!memcmp(data + pos + 1, needle.data + 1, size - 2))
+                return pos;
+            mask &= mask - 1;
+        }
+    }
+#endif // STR_SSE2
+
+    while (i <= last) {
+        const char *found = memchr(data + i, needle.data[0], last - i + 1);
+        if (!found)
+            break;
+        i = (size_t)(found - data);
+        if (!memcmp(found + 1, needle.data + 1, size - 1))
+            return i;
+        i++;
+    }
+    return STRVIEW_NPOS;
+}
+
+size_t strview_find_any_of(struct strview view, struct strview chars) {
+    if (!chars.size || !view.size)
+        return STRVIEW_NPOS;
+    if (chars.size == 1)
+        return strview_find_char(view, chars.data[0]);
+
+    size_t i = 0;
+
+#ifdef STR_SSE2
+    if (chars.size <= STR_BLOCK) {
+        __m128i set[STR_BLOCK];
+        for (size_t k = 0; k < chars.size; k++)
+            set[k] = _mm_set1_epi8(chars.data[k]);
+
+        for (; i + STR_BLOCK <= view.size; i += STR_BLOCK) {
+            __m128i block = _mm_loadu_si128((const __m128i *)(view.data + i));
+            __m128i match = _mm_cmpeq_epi8(block, set[0]);
+            for (size_t k = 1; k < chars.size; k++)
+                match = _mm_or_si128(match, _mm_cmpeq_epi8(block, set[k]));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+            if (mask)
+                return i + bits_ctz32(mask);
+        }
+    }
+#endif // STR_SSE2
+
+    uint32_t table[256 / 32] = { 0 };
+    for (size_t k = 0; k < chars.size; k++) {
+        unsigned char c = (unsigned char)chars.data[k];
+        table[c / 32] |= 1u << (c % 32);
+    }
+    for (; i < view.size; i++) {
+        unsigned char c = (unsigned char)view.data[i];
+        if (table[c / 32] & (1u << (c % 32)))
+            return i;
+    }
+    return STRVIEW_NPOS;
+}
+
+static bool split_at(struct strview *rest, size_t pos, struct strview *token) {
+    if (pos == STRVIEW_NPOS) {
+        *token = *rest;
+        rest->data = NULL;
+        rest->size = 0;
+        return true;
+    }
+
+    *token = strview_make(rest->data, pos);
+    rest->data += pos + 1;
+    rest->size -= pos + 1;
+    return true;
+}
+
+bool strview_split(struct strview *rest, char delim, struct strview *token) {
+    if (!rest->data)
+        return false;
+    return split_at(rest, strview_find_char(*rest, delim), token);
+}
+
+bool strview_split_any(struct strview *rest, struct strview delims,
+                       struct strview *token) {
+    if (!rest->data)
+        return false;
+    return split_at(rest, strview_find_any_of(*rest, delims), token);
+}
+
+// ---------- String Builder ---------- //
+void strbuf_init(struct strbuf *buf, const struct allocator *allocator) {
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+    buf->allocator = allocator;
+}
+
+void strbuf_deinit(struct strbuf *buf) {
+    allocator_free(buf->allocator, buf->data, buf->capacity);
+    strbuf_init(buf, buf->allocator);
+}
+
+void strbuf_clear(struct strbuf *buf) {
+    buf->size = 0;
+    if (buf->data)
+        buf->data[0] = '\0';
+}
+
+bool strbuf_reserve(struct strbuf *buf, size_t extra) {
+    if (extra > SIZE_MAX - buf->size - 1)
+        return false;
+    size_t needed = buf->size + extra + 1;
+    if (needed <= buf->capacity)
+        return true;
+
+    size_t capacity = buf->capacity ? buf->capacity : STRBUF_MIN_CAPACITY;
+    while (capacity < needed)
+        capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+
+    char *data =
+        allocator_realloc(buf->allocator, buf->data, buf->capacity, capacity);
+    if (!data)
+        return false;
+    if (!buf->data)
+        data[0] = '\0';
+    buf->data = data;
+    buf->capacity = capacity;
+    return true;
+}
+
+bool strbuf_append_n(struct strbuf *buf, const char *data, size_t size) {
+    if (!strbuf_reserve(buf, size))
+        return false;
+    if (size)
+        memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+    buf->data[buf->size] = '\0';
+    return true;
+}
+
+static const char digit_pairs[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+#define UINT_DIGITS_MAX 20
+
+/*
+ * Writes the digits of value before end, two at a time, and returns the
+ * pointer to the first digit.
+ */
+static char *format_uint(char *end, unsigned long long value) {
+    while (value >= 100) {
+        end -= 2;
+        memcpy(end, digit_pairs + 2 * (value % 100), 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        end -= 2;
+        memcpy(end, digit_pairs + 2 * value, 2);
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+static bool append_number(struct strbuf *buf, bool negative,
+                          unsigned long long magnitude) {
+    char digits[UINT_DIGITS_MAX + 1];
+    char *end = digits + sizeof(digits);
+    char *begin = format_uint(end, magnitude);
+    if (negative)
+        *--begin = '-';
+    return strbuf_append_n(buf, begin, (size_t)(end - begin));
+}
+
+bool strbuf_append_int(struct strbuf *buf, long long value) {
+    return append_number(buf, value < 0,
+                         value < 0 ? 0ULL - (unsigned long long)value
+                                   : (unsigned long long)value);
+}
+
+bool strbuf_append_uint(struct strbuf *buf, unsigned long long value) {
+    return append_number(buf, false, value);
+}
+
+#define DOUBLE_FAST_PRECISION 9
+#define DOUBLE_FAST_LIMIT 1e15
+
+bool strbuf_append_double(struct strbuf *buf, double value,
+                          unsigned precision) {
+    static const unsigned long long powers_of_10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000,
+    };
+
+    if (value != value)
+        return strbuf_append_n(buf, "nan", 3);
+    if (value > DBL_MAX)
+        return strbuf_append_n(buf, "inf", 3);
+    if (value < -DBL_MAX)
+        return strbuf_append_n(buf, "-inf", 4);
+    if (precision > DOUBLE_FAST_PRECISION || value >= DOUBLE_FAST_LIMIT
+        || value <= -DOUBLE_FAST_LIMIT)
+        return strbuf_appendf(buf, "%.*f", (int)precision, value);
+
+    bool negative = value < 0;
+    if (negative)
+        value = -value;
+    unsigned long long scale = powers_of_10[precision];
+    unsigned long long integer = (unsigned long long)value;
+    unsigned long long fraction = (unsigned long long)(
+        (value - (double)integer) * (double)scale + 0.5);
+    if (fraction >= scale) {
+        integer++;
+        fraction -= scale;
+    }
+
+    // sign, integer digits, dot and fraction digits
+    char digits[1 + UINT_DIGITS_MAX + 1 + DOUBLE_FAST_PRECISION];
+    char *end = digits + sizeof(digits);
+    char *begin = end;
+    if (precision) {
+        begin = format_uint(end, fraction);
+        while (end - begin < (ptrdiff_t)precision)
+            *--begin = '0';
+        *--begin = '.';
+    }
+    begin = format_uint(begin, integer);
+    if (negative)
+        *--begin = '-';
+    return strbuf_append_n(buf, begin, (size_t)(end - begin));
+}
+
+bool strbuf_vappendf(struct strbuf *buf, const char *fmt, va_list args) {
+    size_t available = buf->capacity - buf->size;
+    va_list copy;
+    va_copy(copy, args);
+    int written = vsnprintf(buf->data ? buf->data + buf->size : NULL,
+                            buf->data ? available : 0, fmt, copy);
+    va_end(copy);
+    if (written < 0)
+        goto failure;
+
+    if (!buf->data || (size_t)written >= available) {
+        if (!strbuf_reserve(buf, (size_t)written))
+            goto failure;
+        written = vsnprintf(buf->data + buf->size, buf->capacity - buf->size,
+                            fmt, args);
+        if (written < 0)
+            goto failure;
+    }
+
+    buf->size += (size_t)written;
+    return true;
+
+failure:
+    // a partial write may have overwritten the terminator
+    if (buf->data)
+        buf->data[buf->size] = '\0';
+    return false;
+}
+
+bool strbuf_appendf(struct strbuf *buf, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool appended = strbuf_vappendf(buf, fmt, args);
+    va_end(args);
+    return appended;
+}
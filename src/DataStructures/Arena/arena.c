@@ -0,0 +1,154 @@
+#include <ayaztub/data_structures/arena.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    // keep data aligned on ARENA_ALIGNMENT
+    char _pad[ARENA_ALIGNMENT - 3 * sizeof(size_t) % ARENA_ALIGNMENT];
+    char data[];
+};
+
+struct arena {
+    struct arena_block *head; /**< current block, older ones follow */
+    size_t block_size;
+    size_t reserved;
+    void *last; /**< last allocation, the only one resizable in place */
+};
+
+static inline size_t align_up(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static struct arena_block *arena_new_block(struct arena *arena, size_t min) {
+    size_t size = min > arena->block_size ? min : arena->block_size;
+    if (size > SIZE_MAX - sizeof(struct arena_block))
+        return NULL;
+
+    struct arena_block *block = malloc(sizeof(struct arena_block) + size);
+    if (!block)
+        return NULL;
+
+    block->size = size;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+    arena->reserved += size;
+    return block;
+}
+
+struct arena *arena_create(size_t block_size) {
+    struct arena *arena = calloc(1, sizeof(struct arena));
+    if (!arena)
+        return NULL;
+    arena->block_size = align_up(block_size ? block_size
+                                            : ARENA_DEFAULT_BLOCK_SIZE);
+    return arena;
+}
+
+void arena_destroy(struct arena *arena) {
+    if (!arena)
+        return;
+
+    struct arena_block *block = arena->head;
+    while (block) {
+        struct arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void *arena_alloc(struct arena *arena, size_t size) {
+    if (size > SIZE_MAX - ARENA_ALIGNMENT)
+        return NULL;
+    size = align_up(size ? size : 1);
+
+    struct arena_block *block = arena->head;
+    if (!block || block->size - block->used < size) {
+        block = arena_new_block(arena, size);
+        if (!block)
+            return NULL;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+void *arena_realloc(struct arena *arena, void *ptr, size_t old_size,
+                    size_t new_size) {
+    if (!ptr)
+        return arena_alloc(arena, new_size);
+    if (new_size > SIZE_MAX - ARENA_ALIGNMENT)
+        return NULL;
+
+    struct arena_block *block = arena->head;
+    if (ptr == arena->last && block) {
+        size_t offset = (char *)ptr - block->data;
+        size_t needed = align_up(new_size ? new_size : 1);
+        if (block->size - offset >= needed) {
+            block->used = offset + needed;
+            return ptr;
+        }
+    }
+
+    if (new_size <= old_size)
+        return ptr;
+
+    void *new_ptr = arena_alloc(arena, new_size);
+    if (new_ptr)
+        memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
+
+void arena_reset(struct arena *arena) {
+    struct arena_block *block = arena->head;
+    if (!block)
+        return;
+
+    // Keep the oldest block: it has the configured block size while the
+    // newer ones may be dedicated to big allocations.
+    while (block->next) {
+        struct arena_block *next = block->next;
+        arena->reserved -= block->size;
+        free(block);
+        block = next;
+    }
+
+    block->used = 0;
+    arena->head = block;
+    arena->last = NULL;
+}
+
+size_t arena_reserved(const struct arena *arena) {
+    return arena->reserved;
+}
+
+// ---------- Allocator Interface ---------- //
+static void *arena_allocator_realloc(void *ctx, void *ptr, size_t old_size,
+                                     size_t new_size) {
+    return arena_realloc(ctx, ptr, old_size, new_size);
+}
+
+static void arena_allocator_free(void *ctx, void *ptr, size_t size) {
+    struct arena *arena = ctx;
+    (void)size;
+
+    // Only the last allocation can be given back.
+    if (ptr == arena->last && arena->head) {
+        arena->head->used = (char *)ptr - arena->head->data;
+        arena->last = NULL;
+    }
+}
+
+struct allocator arena_allocator(struct arena *arena) {
+    struct allocator allocator = { arena_allocator_realloc,
+                                   arena_allocator_free, arena };
+    return allocator;
+}
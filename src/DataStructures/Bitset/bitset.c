@@ -0,0 +1,843 @@
+#include <ayaztub/data_structures/bitset.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) && !defined(BITSET_NO_SIMD)
+#    include <immintrin.h>
+#    define BITSET_AVX2 1
+#elif defined(__SSE2__) && !defined(BITSET_NO_SIMD)
+#    include <emmintrin.h>
+#    define BITSET_SSE2 1
+#endif // __AVX2__ || __SSE2__ && !BITSET_NO_SIMD
+
+#if defined(__BMI2__) && !defined(BITSET_NO_SIMD)
+#    include <immintrin.h>
+#    define BITSET_BMI2 1
+#endif // __BMI2__ && !BITSET_NO_SIMD
+
+/*
+ * Design:
+ * - Every word loop goes through a small vector abstraction (vec_t, loads,
+ *   stores, bitwise operations and a per 64 bits lane population count):
+ *   256 bits AVX2 registers, 128 bits SSE2 registers, or plain uint64_t
+ *   words for the scalar build. Population counts use the nibble lookup
+ *   table of W. Muła, "Faster Population Counts Using AVX2 Instructions"
+ *   with AVX2, and the classic SWAR reduction with SSE2, summed per lane
+ *   with a sum of absolute differences.
+ * - The rank index stores the number of set bits before every block of 8
+ *   words (512 bits): a rank reads one counter and at most 8 words, a select
+ *   binary searches the counters.
+ * - Roaring containers switch from a sorted array to a bitmap above 4096
+ *   values (where both take 8KB), and back to an array below 2048 values only,
+ *   so that a container oscillating around the limit does not convert on
+ *   every update.
+ */
+
+// ---------- Vector Abstraction ---------- //
+#ifdef BITSET_AVX2
+typedef __m256i vec_t;
+#    define VEC_WORDS 4
+#    define vec_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#    define vec_store(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#    define vec_and(a, b) _mm256_and_si256((a), (b))
+#    define vec_or(a, b) _mm256_or_si256((a), (b))
+#    define vec_xor(a, b) _mm256_xor_si256((a), (b))
+#    define vec_andnot(a, b) _mm256_andnot_si256((b), (a))
+#    define vec_zero() _mm256_setzero_si256()
+#    define vec_add64(a, b) _mm256_add_epi64((a), (b))
+
+static inline vec_t vec_popcount(vec_t v) {
+    const __m256i lookup =
+        _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                         1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_and_si256(v, low_mask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                     _mm256_shuffle_epi8(lookup, high));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+#elif defined(BITSET_SSE2)
+typedef __m128i vec_t;
+#    define VEC_WORDS 2
+#    define vec_load(p) _mm_loadu_si128((const __m128i *)(p))
+#    define vec_store(p, v) _mm_storeu_si128((__m128i *)(p), (v))
+#    define vec_and(a, b) _mm_and_si128((a), (b))
+#    define vec_or(a, b) _mm_or_si128((a), (b))
+#    define vec_xor(a, b) _mm_xor_si128((a), (b))
+#    define vec_andnot(a, b) _mm_andnot_si128((b), (a))
+#    define vec_zero() _mm_setzero_si128()
+#    define vec_add64(a, b) _mm_add_epi64((a), (b))
+
+static inline vec_t vec_popcount(vec_t v) {
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+    v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), m1));
+    v = _mm_add_epi8(_mm_and_si128(v, m2),
+                     _mm_and_si128(_mm_srli_epi64(v, 2), m2));
+    v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), m4);
+    return _mm_sad_epu8(v, _mm_setzero_si128());
+}
+#else // BITSET_AVX2 || BITSET_SSE2
+typedef uint64_t vec_t;
+#    define VEC_WORDS 1
+#    define vec_load(p) (*(p))
+#    define vec_store(p, v) (*(p) = (v))
+#    define vec_and(a, b) ((a) & (b))
+#    define vec_or(a, b) ((a) | (b))
+#    define vec_xor(a, b) ((a) ^ (b))
+#    define vec_andnot(a, b) ((a) & ~(b))
+#    define vec_zero() ((uint64_t)0)
+#    define vec_add64(a, b) ((a) + (b))
+#    define vec_popcount(v) ((uint64_t)__builtin_popcountll(v))
+#endif // BITSET_AVX2 || BITSET_SSE2
+
+static inline uint64_t vec_sum(vec_t v) {
+    uint64_t lanes[VEC_WORDS];
+    vec_store(lanes, v);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < VEC_WORDS; i++)
+        sum += lanes[i];
+    return sum;
+}
+
+// ---------- Word Kernels ---------- //
+#define WORDS_OP(name, op)                                                     \
+    static void name(uint64_t *out, const uint64_t *a, const uint64_t *b,      \
+                     size_t count) {                                           \
+        size_t i = 0;                                                          \
+        for (; i + VEC_WORDS <= count; i += VEC_WORDS)                         \
+            vec_store(out + i, op(vec_load(a + i), vec_load(b + i)));          \
+        for (; i < count; i++)                                                 \
+            out[i] = op##_word(a[i], b[i]);                                    \
+    }
+
+#define vec_and_word(a, b) ((a) & (b))
+#define vec_or_word(a, b) ((a) | (b))
+#define vec_xor_word(a, b) ((a) ^ (b))
+#define vec_andnot_word(a, b) ((a) & ~(b))
+
+WORDS_OP(words_and, vec_and)
+WORDS_OP(words_or, vec_or)
+WORDS_OP(words_xor, vec_xor)
+WORDS_OP(words_andnot, vec_andnot)
+
+static uint64_t words_count(const uint64_t *words, size_t count) {
+    vec_t sum = vec_zero();
+    size_t i = 0;
+    for (; i + VEC_WORDS <= count; i += VEC_WORDS)
+        sum = vec_add64(sum, vec_popcount(vec_load(words + i)));
+    uint64_t total = vec_sum(sum);
+    for (; i < count; i++)
+        total += (uint64_t)__builtin_popcountll(words[i]);
+    return total;
+}
+
+static uint64_t words_and_count(const uint64_t *a, const uint64_t *b,
+                                size_t count) {
+    vec_t sum = vec_zero();
+    size_t i = 0;
+    for (; i + VEC_WORDS <= count; i += VEC_WORDS) {
+        sum = vec_add64(
+            sum, vec_popcount(vec_and(vec_load(a + i), vec_load(b + i))));
+    }
+    uint64_t total = vec_sum(sum);
+    for (; i < count; i++)
+        total += (uint64_t)__builtin_popcountll(a[i] & b[i]);
+    return total;
+}
+
+/* Index of the set bit of the given rank in a word (rank < popcount). */
+static unsigned word_select(uint64_t word, unsigned rank) {
+#ifdef BITSET_BMI2
+    return (unsigned)__builtin_ctzll(_pdep_u64(UINT64_C(1) << rank, word));
+#else // BITSET_BMI2
+    for (; rank; rank--)
+        word &= word - 1;
+    return (unsigned)__builtin_ctzll(word);
+#endif // BITSET_BMI2
+}
+
+// ---------- Bitset ---------- //
+#define RANK_BLOCK_WORDS 8
+
+static size_t rank_entries(const struct bitset *set) {
+    // one counter per block, plus the total
+    size_t words = BITSET_WORDS(set->bits);
+    return words / RANK_BLOCK_WORDS + (words % RANK_BLOCK_WORDS != 0) + 1;
+}
+
+static void drop_rank(struct bitset *set) {
+    allocator_free(set->allocator, set->ranks,
+                   rank_entries(set) * sizeof(uint64_t));
+    set->ranks = NULL;
+}
+
+static void clear_padding(struct bitset *set) {
+    if (set->bits % 64)
+        set->words[set->bits / 64] &= (UINT64_C(1) << (set->bits % 64)) - 1;
+}
+
+bool bitset_init(struct bitset *set, size_t bits,
+                 const struct allocator *allocator) {
+    set->words = NULL;
+    set->bits = 0;
+    set->ranks = NULL;
+    set->allocator = allocator;
+    return bitset_resize(set, bits);
+}
+
+void bitset_deinit(struct bitset *set) {
+    drop_rank(set);
+    allocator_free(set->allocator, set->words,
+                   BITSET_WORDS(set->bits) * sizeof(uint64_t));
+    set->words = NULL;
+    set->bits = 0;
+}
+
+bool bitset_resize(struct bitset *set, size_t bits) {
+    size_t old_count = BITSET_WORDS(set->bits);
+    size_t count = BITSET_WORDS(bits);
+    if (count > SIZE_MAX / sizeof(uint64_t))
+        return false;
+
+    drop_rank(set);
+    if (count != old_count) {
+        uint64_t *words;
+        if (count) {
+            words = allocator_realloc(set->allocator, set->words,
+                                      old_count * sizeof(uint64_t),
+                                      count * sizeof(uint64_t));
+            if (!words)
+                return false;
+        } else {
+            allocator_free(set->allocator, set->words,
+                           old_count * sizeof(uint64_t));
+            words = NULL;
+        }
+        if (count > old_count)
+            memset(words + old_count, 0,
+                   (count - old_count) * sizeof(uint64_t));
+        set->words = words;
+    }
+    set->bits = bits;
+    clear_padding(set);
+    return true;
+}
+
+void bitset_fill(struct bitset *set, bool value) {
+    memset(set->words, value ? 0xff : 0,
+           BITSET_WORDS(set->bits) * sizeof(uint64_t));
+    clear_padding(set);
+}
+
+size_t bitset_count(const struct bitset *set) {
+    return (size_t)words_count(set->words, BITSET_WORDS(set->bits));
+}
+
+static size_t common_words(const struct bitset *a, const struct bitset *b) {
+    size_t a_count = BITSET_WORDS(a->bits);
+    size_t b_count = BITSET_WORDS(b->bits);
+    return a_count < b_count ? a_count : b_count;
+}
+
+void bitset_and(struct bitset *dst, const struct bitset *src) {
+    size_t count = common_words(dst, src);
+    words_and(dst->words, dst->words, src->words, count);
+    memset(dst->words + count, 0,
+           (BITSET_WORDS(dst->bits) - count) * sizeof(uint64_t));
+}
+
+void bitset_or(struct bitset *dst, const struct bitset *src) {
+    words_or(dst->words, dst->words, src->words, common_words(dst, src));
+    clear_padding(dst);
+}
+
+void bitset_xor(struct bitset *dst, const struct bitset *src) {
+    words_xor(dst->words, dst->words, src->words, common_words(dst, src));
+    clear_padding(dst);
+}
+
+void bitset_andnot(struct bitset *dst, const struct bitset *src) {
+    words_andnot(dst->words, dst->words, src->words, common_words(dst, src));
+}
+
+size_t bitset_and_count(const struct bitset *a, const struct bitset *b) {
+    return (size_t)words_and_count(a->words, b->words, common_words(a, b));
+}
+
+size_t bitset_next(const struct bitset *set, size_t from) {
+    if (from >= set->bits)
+        return BITSET_NPOS;
+    size_t count = BITSET_WORDS(set->bits);
+    size_t position = from / 64;
+    uint64_t word = set->words[position] & (~UINT64_C(0) << (from % 64));
+    while (!word) {
+        if (++position == count)
+            return BITSET_NPOS;
+        word = set->words[position];
+    }
+    return position * 64 + (size_t)__builtin_ctzll(word);
+}
+
+bool bitset_build_rank(struct bitset *set) {
+    size_t entries = rank_entries(set);
+    if (!set->ranks) {
+        set->ranks = allocator_realloc(set->allocator, NULL, 0,
+                                       entries * sizeof(uint64_t));
+        if (!set->ranks)
+            return false;
+    }
+
+    size_t count = BITSET_WORDS(set->bits);
+    uint64_t total = 0;
+    for (size_t block = 0; block < entries; block++) {
+        set->ranks[block] = total;
+        size_t start = block * RANK_BLOCK_WORDS;
+        if (start < count) {
+            size_t words = count - start < RANK_BLOCK_WORDS ? count - start
+                                                            : RANK_BLOCK_WORDS;
+            total += words_count(set->words + start, words);
+        }
+    }
+    return true;
+}
+
+size_t bitset_rank(const struct bitset *set, size_t index) {
+    size_t position = index / 64;
+    uint64_t rank;
+    if (set->ranks) {
+        size_t start = position / RANK_BLOCK_WORDS * RANK_BLOCK_WORDS;
+        rank = set->ranks[position / RANK_BLOCK_WORDS]
+               + words_count(set->words + start, position - start);
+    } else {
+        rank = words_count(set->words, position);
+    }
+    if (index % 64) {
+        uint64_t mask = (UINT64_C(1) << (index % 64)) - 1;
+        rank += (uint64_t)__builtin_popcountll(set->words[position] & mask);
+    }
+    return (size_t)rank;
+}
+
+size_t bitset_select(const struct bitset *set, size_t rank) {
+    size_t count = BITSET_WORDS(set->bits);
+    size_t position = 0;
+    if (set->ranks) {
+        // last block starting at or before the rank
+        size_t low = 0;
+        size_t high = rank_entries(set) - 1;
+        if (rank >= set->ranks[high])
+            return BITSET_NPOS;
+        while (low < high) {
+            size_t mid = low + (high - low + 1) / 2;
+            if (set->ranks[mid] <= rank)
+                low = mid;
+            else
+                high = mid - 1;
+        }
+        rank -= set->ranks[low];
+        position = low * RANK_BLOCK_WORDS;
+    }
+
+    for (; position < count; position++) {
+        size_t bits = (size_t)__builtin_popcountll(set->words[position]);
+        if (rank < bits)
+            return position * 64
+                   + word_select(set->words[position], (unsigned)rank);
+        rank -= bits;
+    }
+    return BITSET_NPOS;
+}
+
+// ---------- Roaring Containers ---------- //
+#define ARRAY_MAX 4096 // bigger array containers become bitmaps
+#define ARRAY_MIN 2048 // smaller bitmap containers become arrays
+#define BITMAP_WORDS 1024
+
+struct roaring_container {
+    uint16_t key; // high 16 bits of the values
+    bool bitmap;
+    uint32_t cardinality;
+    uint32_t capacity; // values allocated for array containers
+    union {
+        uint16_t *values;
+        uint64_t *words;
+    } u;
+};
+
+static void container_free(const struct allocator *allocator,
+                           struct roaring_container *container) {
+    if (container->bitmap)
+        allocator_free(allocator, container->u.words,
+                       BITMAP_WORDS * sizeof(uint64_t));
+    else
+        allocator_free(allocator, container->u.values,
+                       container->capacity * sizeof(uint16_t));
+}
+
+static bool container_alloc_array(const struct allocator *allocator,
+                                  struct roaring_container *container,
+                                  uint16_t key, uint32_t capacity) {
+    container->key = key;
+    container->bitmap = false;
+    container->cardinality = 0;
+    container->capacity = capacity;
+    container->u.values =
+        allocator_realloc(allocator, NULL, 0, capacity * sizeof(uint16_t));
+    return container->u.values != NULL;
+}
+
+static bool container_alloc_bitmap(const struct allocator *allocator,
+                                   struct roaring_container *container,
+                                   uint16_t key) {
+    container->key = key;
+    container->bitmap = true;
+    container->cardinality = 0;
+    container->capacity = 0;
+    container->u.words = allocator_realloc(allocator, NULL, 0,
+                                           BITMAP_WORDS * sizeof(uint64_t));
+    if (!container->u.words)
+        return false;
+    memset(container->u.words, 0, BITMAP_WORDS * sizeof(uint64_t));
+    return true;
+}
+
+/* Index of the first value not less than value (branchless search). */
+static uint32_t array_lower(const uint16_t *values, uint32_t count,
+                            uint16_t value) {
+    if (!count)
+        return 0;
+    uint32_t low = 0;
+    while (count > 1) {
+        uint32_t half = count / 2;
+        low = values[low + half] < value ? low + half : low;
+        count -= half;
+    }
+    return low + (values[low] < value);
+}
+
+static bool container_contains(const struct roaring_container *container,
+                               uint16_t low) {
+    if (container->bitmap)
+        return (container->u.words[low / 64] >> (low % 64)) & 1;
+    uint32_t index =
+        array_lower(container->u.values, container->cardinality, low);
+    return index < container->cardinality
+           && container->u.values[index] == low;
+}
+
+static bool container_to_bitmap(const struct allocator *allocator,
+                                struct roaring_container *container) {
+    struct roaring_container bitmap;
+    if (!container_alloc_bitmap(allocator, &bitmap, container->key))
+        return false;
+    for (uint32_t i = 0; i < container->cardinality; i++) {
+        uint16_t value = container->u.values[i];
+        bitmap.u.words[value / 64] |= UINT64_C(1) << (value % 64);
+    }
+    bitmap.cardinality = container->cardinality;
+    container_free(allocator, container);
+    *container = bitmap;
+    return true;
+}
+
+static bool container_to_array(const struct allocator *allocator,
+                               struct roaring_container *container) {
+    struct roaring_container array;
+    if (!container_alloc_array(allocator, &array, container->key,
+                               container->cardinality))
+        return false;
+    for (uint32_t i = 0; i < BITMAP_WORDS; i++) {
+        for (uint64_t word = container->u.words[i]; word; word &= word - 1) {
+            array.u.values[array.cardinality++] =
+                (uint16_t)(i * 64 + (uint32_t)__builtin_ctzll(word));
+        }
+    }
+    container_free(allocator, container);
+    *container = array;
+    return true;
+}
+
+static bool container_add(const struct allocator *allocator,
+                          struct roaring_container *container, uint16_t low) {
+    if (!container->bitmap) {
+        uint32_t index =
+            array_lower(container->u.values, container->cardinality, low);
+        if (index < container->cardinality
+            && container->u.values[index] == low)
+            return true;
+
+        if (container->cardinality == ARRAY_MAX) {
+            if (!container_to_bitmap(allocator, container))
+                return false;
+        } else {
+            if (container->cardinality == container->capacity) {
+                uint32_t capacity = container->capacity * 2;
+                if (capacity > ARRAY_MAX)
+                    capacity = ARRAY_MAX;
+                uint16_t *values = allocator_realloc(
+                    allocator, container->u.values,
+                    container->capacity * sizeof(uint16_t),
+                    capacity * sizeof(uint16_t));
+                if (!values)
+                    return false;
+                container->u.values = values;
+                container->capacity = capacity;
+            }
+            memmove(container->u.values + index + 1,
+                    container->u.values + index,
+                    (container->cardinality - index) * sizeof(uint16_t));
+            container->u.values[index] = low;
+            container->cardinality++;
+            return true;
+        }
+    }
+
+    uint64_t bit = UINT64_C(1) << (low % 64);
+    if (!(container->u.words[low / 64] & bit)) {
+        container->u.words[low / 64] |= bit;
+        container->cardinality++;
+    }
+    return true;
+}
+
+static bool container_remove(const struct allocator *allocator,
+                             struct roaring_container *container,
+                             uint16_t low) {
+    if (container->bitmap) {
+        uint64_t bit = UINT64_C(1) << (low % 64);
+        if (!(container->u.words[low / 64] & bit))
+            return false;
+        container->u.words[low / 64] &= ~bit;
+        container->cardinality--;
+        // best effort: a bitmap is a valid container whatever its size
+        if (container->cardinality && container->cardinality < ARRAY_MIN)
+            container_to_array(allocator, container);
+        return true;
+    }
+
+    uint32_t index =
+        array_lower(container->u.values, container->cardinality, low);
+    if (index == container->cardinality || container->u.values[index] != low)
+        return false;
+    memmove(container->u.values + index, container->u.values + index + 1,
+            (container->cardinality - index - 1) * sizeof(uint16_t));
+    container->cardinality--;
+    return true;
+}
+
+static bool container_copy(const struct allocator *allocator,
+                           struct roaring_container *copy,
+                           const struct roaring_container *container) {
+    if (container->bitmap) {
+        if (!container_alloc_bitmap(allocator, copy, container->key))
+            return false;
+        memcpy(copy->u.words, container->u.words,
+               BITMAP_WORDS * sizeof(uint64_t));
+    } else {
+        if (!container_alloc_array(allocator, copy, container->key,
+                                   container->cardinality))
+            return false;
+        memcpy(copy->u.values, container->u.values,
+               container->cardinality * sizeof(uint16_t));
+    }
+    copy->cardinality = container->cardinality;
+    return true;
+}
+
+/* Intersection of two containers of the same key, possibly empty. */
+static bool container_and(const struct allocator *allocator,
+                          struct roaring_container *out,
+                          const struct roaring_container *a,
+                          const struct roaring_container *b) {
+    if (a->bitmap && b->bitmap) {
+        if (!container_alloc_bitmap(allocator, out, a->key))
+            return false;
+        words_and(out->u.words, a->u.words, b->u.words, BITMAP_WORDS);
+        out->cardinality =
+            (uint32_t)words_count(out->u.words, BITMAP_WORDS);
+        if (out->cardinality && out->cardinality <= ARRAY_MAX)
+            container_to_array(allocator, out); // best effort
+        return true;
+    }
+
+    if (a->bitmap) {
+        const struct roaring_container *swap = a;
+        a = b;
+        b = swap;
+    }
+    // a is an array: the result is at most as big
+    if (!container_alloc_array(allocator, out, a->key, a->cardinality))
+        return false;
+    if (b->bitmap) {
+        for (uint32_t i = 0; i < a->cardinality; i++) {
+            uint16_t value = a->u.values[i];
+            out->u.values[out->cardinality] = value;
+            out->cardinality += (b->u.words[value / 64] >> (value % 64)) & 1;
+        }
+        return true;
+    }
+    for (uint32_t i = 0, j = 0; i < a->cardinality && j < b->cardinality;) {
+        uint16_t x = a->u.values[i];
+        uint16_t y = b->u.values[j];
+        if (x == y)
+            out->u.values[out->cardinality++] = x;
+        i += x <= y;
+        j += y <= x;
+    }
+    return true;
+}
+
+/* Union of two containers of the same key. */
+static bool container_or(const struct allocator *allocator,
+                         struct roaring_container *out,
+                         const struct roaring_container *a,
+                         const struct roaring_container *b) {
+    if (!a->bitmap && !b->bitmap
+        && a->cardinality + b->cardinality <= ARRAY_MAX) {
+        if (!container_alloc_array(allocator, out, a->key,
+                                   a->cardinality + b->cardinality))
+            return false;
+        uint32_t i = 0;
+        uint32_t j = 0;
+        while (i < a->cardinality && j < b->cardinality) {
+            uint16_t x = a->u.values[i];
+            uint16_t y = b->u.values[j];
+            out->u.values[out->cardinality++] = x <= y ? x : y;
+            i += x <= y;
+            j += y <= x;
+        }
+        while (i < a->cardinality)
+            out->u.values[out->cardinality++] = a->u.values[i++];
+        while (j < b->cardinality)
+            out->u.values[out->cardinality++] = b->u.values[j++];
+        return true;
+    }
+
+    if (!container_alloc_bitmap(allocator, out, a->key))
+        return false;
+    const struct roaring_container *sides[] = { a, b };
+    for (size_t side = 0; side < 2; side++) {
+        const struct roaring_container *container = sides[side];
+        if (container->bitmap) {
+            words_or(out->u.words, out->u.words, container->u.words,
+                     BITMAP_WORDS);
+            continue;
+        }
+        for (uint32_t i = 0; i < container->cardinality; i++) {
+            uint16_t value = container->u.values[i];
+            out->u.words[value / 64] |= UINT64_C(1) << (value % 64);
+        }
+    }
+    out->cardinality = (uint32_t)words_count(out->u.words, BITMAP_WORDS);
+    return true;
+}
+
+// ---------- Roaring Bitmap ---------- //
+/* Index of the first container whose key is not less than key. */
+static size_t find_container(const struct roaring *set, uint16_t key) {
+    size_t low = 0;
+    size_t high = set->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (set->containers[mid].key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+static bool reserve_containers(struct roaring *set, size_t count) {
+    if (count <= set->capacity)
+        return true;
+    size_t capacity = set->capacity ? set->capacity * 2 : 4;
+    if (capacity < count)
+        capacity = count;
+    struct roaring_container *containers = allocator_realloc(
+        set->allocator, set->containers,
+        set->capacity * sizeof(struct roaring_container),
+        capacity * sizeof(struct roaring_container));
+    if (!containers)
+        return false;
+    set->containers = containers;
+    set->capacity = capacity;
+    return true;
+}
+
+static void remove_container(struct roaring *set, size_t index) {
+    container_free(set->allocator, &set->containers[index]);
+    memmove(set->containers + index, set->containers + index + 1,
+            (set->count - index - 1) * sizeof(struct roaring_container));
+    set->count--;
+}
+
+static void clear_containers(struct roaring *set) {
+    for (size_t i = 0; i < set->count; i++)
+        container_free(set->allocator, &set->containers[i]);
+    set->count = 0;
+}
+
+void roaring_init(struct roaring *set, const struct allocator *allocator) {
+    set->containers = NULL;
+    set->count = 0;
+    set->capacity = 0;
+    set->allocator = allocator;
+}
+
+void roaring_deinit(struct roaring *set) {
+    clear_containers(set);
+    allocator_free(set->allocator, set->containers,
+                   set->capacity * sizeof(struct roaring_container));
+    roaring_init(set, set->allocator);
+}
+
+bool roaring_add(struct roaring *set, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    size_t index = find_container(set, key);
+    if (index == set->count || set->containers[index].key != key) {
+        struct roaring_container container;
+        if (!reserve_containers(set, set->count + 1)
+            || !container_alloc_array(set->allocator, &container, key, 4))
+            return false;
+        memmove(set->containers + index + 1, set->containers + index,
+                (set->count - index) * sizeof(struct roaring_container));
+        set->containers[index] = container;
+        set->count++;
+    }
+
+    if (!container_add(set->allocator, &set->containers[index],
+                       (uint16_t)value)) {
+        if (!set->containers[index].cardinality)
+            remove_container(set, index);
+        return false;
+    }
+    return true;
+}
+
+bool roaring_remove(struct roaring *set, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    size_t index = find_container(set, key);
+    if (index == set->count || set->containers[index].key != key)
+        return false;
+
+    struct roaring_container *container = &set->containers[index];
+    if (!container_remove(set->allocator, container, (uint16_t)value))
+        return false;
+    if (!container->cardinality)
+        remove_container(set, index);
+    return true;
+}
+
+bool roaring_contains(const struct roaring *set, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    size_t index = find_container(set, key);
+    return index < set->count && set->containers[index].key == key
+           && container_contains(&set->containers[index], (uint16_t)value);
+}
+
+uint64_t roaring_count(const struct roaring *set) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < set->count; i++)
+        count += set->containers[i].cardinality;
+    return count;
+}
+
+bool roaring_and(struct roaring *dst, const struct roaring *a,
+                 const struct roaring *b) {
+    clear_containers(dst);
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a->count && j < b->count) {
+        const struct roaring_container *x = &a->containers[i];
+        const struct roaring_container *y = &b->containers[j];
+        if (x->key != y->key) {
+            i += x->key < y->key;
+            j += y->key < x->key;
+            continue;
+        }
+
+        if (!reserve_containers(dst, dst->count + 1))
+            goto failure;
+        struct roaring_container *out = &dst->containers[dst->count];
+        if (!container_and(dst->allocator, out, x, y))
+            goto failure;
+        if (out->cardinality)
+            dst->count++;
+        else
+            container_free(dst->allocator, out);
+        i++;
+        j++;
+    }
+    return true;
+
+failure:
+    clear_containers(dst);
+    return false;
+}
+
+bool roaring_or(struct roaring *dst, const struct roaring *a,
+                const struct roaring *b) {
+    clear_containers(dst);
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a->count || j < b->count) {
+        if (!reserve_containers(dst, dst->count + 1))
+            goto failure;
+        struct roaring_container *out = &dst->containers[dst->count];
+        bool ok;
+        if (j == b->count
+            || (i < a->count && a->containers[i].key < b->containers[j].key))
+            ok = container_copy(dst->allocator, out, &a->containers[i++]);
+        else if (i == a->count || b->containers[j].key < a->containers[i].key)
+            ok = container_copy(dst->allocator, out, &b->containers[j++]);
+        else
+            ok = container_or(dst->allocator, out, &a->containers[i++],
+                              &b->containers[j++]);
+        if (!ok)
+            goto failure;
+        dst->count++;
+    }
+    return true;
+
+failure:
+    clear_containers(dst);
+    return false;
+}
+
+bool roaring_iter_next(struct roaring_iter *iter, uint32_t *value) {
+    const struct roaring *set = iter->set;
+    for (; iter->container < set->count; iter->container++) {
+        const struct roaring_container *container =
+            &set->containers[iter->container];
+        uint32_t high = (uint32_t)container->key << 16;
+
+        if (!container->bitmap) {
+            if (iter->position < container->cardinality) {
+                *value = high | container->u.values[iter->position++];
+                return true;
+            }
+        } else {
+            uint32_t word_index = iter->position / 64;
+            if (word_index < BITMAP_WORDS) {
+                uint64_t word = container->u.words[word_index]
+                                & (~UINT64_C(0) << (iter->position % 64));
+                while (!word && ++word_index < BITMAP_WORDS)
+                    word = container->u.words[word_index];
+                if (word) {
+                    uint32_t low =
+                        word_index * 64 + (uint32_t)__builtin_ctzll(word);
+                    iter->position = low + 1;
+                    *value = high | low;
+                    return true;
+                }
+            }
+        }
+        iter->position = 0;
+    }
+    return false;
+}
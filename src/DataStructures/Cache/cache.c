@@ -0,0 +1,411 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/sync.h>
+#include <ayaztub/core_utils/logger.h>
+#include <ayaztub/data_structures/cache.h>
+#include <ayaztub/data_structures/hashmap.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Design:
+ * - The high 32 bits of the key hash select the shard, the low bits the
+ *   bucket of the shard hash table (singly linked chains, one bucket per
+ *   entry on average).
+ * - Entries are allocated with their key and value bytes, and linked in the
+ *   FIFO queues of their shard (doubly linked, head is the oldest). CLOCK
+ *   only uses the main queue: going around a circular buffer or moving a
+ *   given-another-round entry from the head to the tail is the same thing.
+ * - Lookups run under the read lock and only write the frequency of the
+ *   entry (relaxed atomic, capped at 1 for CLOCK and 3 for S3-FIFO) and the
+ *   hit/miss counters of the shard. Insertions, removals and evictions run
+ *   under the write lock, which makes the frequency updates visible.
+ * - S3-FIFO ghost entries are 32 bits fingerprints of the hash in a direct
+ *   mapped table: a collision forgets a ghost, or rarely promotes a new key
+ *   to the main queue, which only costs some hit ratio.
+ */
+
+#define QUEUE_SMALL 0
+#define QUEUE_MAIN 1
+
+struct cache_entry {
+    struct cache_entry *chain; /**< next entry of the bucket */
+    struct cache_entry *prev; /**< towards the head of the queue */
+    struct cache_entry *next; /**< towards the tail of the queue */
+    uint64_t hash;
+    size_t weight;
+    size_t key_length;
+    size_t value_length;
+    uint8_t frequency;
+    uint8_t queue;
+    unsigned char data[]; /**< key bytes, then value bytes */
+};
+
+struct cache_queue {
+    struct cache_entry *head;
+    struct cache_entry *tail;
+    size_t weight;
+};
+
+struct cache_shard {
+    struct sync_rwlock lock;
+    struct cache_entry **buckets;
+    size_t mask;
+    size_t count;
+    size_t weight;
+    size_t capacity;
+    struct cache_queue small;
+    struct cache_queue main;
+    uint32_t *ghosts;
+    uint64_t insertions;
+    uint64_t evictions;
+    uint64_t hits; /**< atomic: updated under the read lock */
+    uint64_t misses; /**< atomic: updated under the read lock */
+    char _pad[CACHE_LINE_SIZE];
+};
+
+struct cache {
+    struct cache_shard *shards;
+    unsigned shard_mask;
+    uint8_t max_frequency;
+    enum cache_policy policy;
+    size_t capacity;
+};
+
+#define CACHE_INITIAL_BUCKETS 16
+
+// ---------- Queues ---------- //
+static void queue_push(struct cache_queue *queue, struct cache_entry *entry) {
+    entry->next = NULL;
+    entry->prev = queue->tail;
+    if (queue->tail)
+        queue->tail->next = entry;
+    else
+        queue->head = entry;
+    queue->tail = entry;
+    queue->weight += entry->weight;
+}
+
+static void queue_unlink(struct cache_queue *queue, struct cache_entry *entry) {
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        queue->head = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        queue->tail = entry->prev;
+    queue->weight -= entry->weight;
+}
+
+static inline struct cache_queue *entry_queue(struct cache_shard *shard,
+                                              const struct cache_entry *entry) {
+    return entry->queue == QUEUE_MAIN ? &shard->main : &shard->small;
+}
+
+// ---------- Hash Table ---------- //
+static struct cache_entry **bucket_of(const struct cache_shard *shard,
+                                      uint64_t hash) {
+    return &shard->buckets[hash & shard->mask];
+}
+
+static struct cache_entry *find(const struct cache_shard *shard,
+                                uint64_t hash, const void *key,
+                                size_t key_length) {
+    for (struct cache_entry *entry = *bucket_of(shard, hash); entry;
+         entry = entry->chain) {
+        if (entry->hash == hash && entry->key_length == key_length
+            && memcmp(entry->data, key, key_length) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+static void chain_unlink(struct cache_shard *shard, struct cache_entry *entry) {
+    struct cache_entry **link = bucket_of(shard, entry->hash);
+    while (*link != entry)
+        link = &(*link)->chain;
+    *link = entry->chain;
+}
+
+static void grow(struct cache_shard *shard) {
+    size_t buckets = (shard->mask + 1) * 2;
+    struct cache_entry **table = calloc(buckets, sizeof(*table));
+    if (!table)
+        return; // longer chains, still correct
+
+    for (size_t i = 0; i <= shard->mask; ++i) {
+        struct cache_entry *entry = shard->buckets[i];
+        while (entry) {
+            struct cache_entry *chain = entry->chain;
+            struct cache_entry **bucket = &table[entry->hash & (buckets - 1)];
+            entry->chain = *bucket;
+            *bucket = entry;
+            entry = chain;
+        }
+    }
+    free(shard->buckets);
+    shard->buckets = table;
+    shard->mask = buckets - 1;
+}
+
+// ---------- Eviction ---------- //
+static void entry_drop(struct cache_shard *shard, struct cache_entry *entry) {
+    queue_unlink(entry_queue(shard, entry), entry);
+    chain_unlink(shard, entry);
+    shard->count--;
+    shard->weight -= entry->weight;
+    free(entry);
+}
+
+static inline uint32_t ghost_fingerprint(uint64_t hash) {
+    return (uint32_t)(hash >> 32) | 1; // 0 marks empty slots
+}
+
+static inline uint32_t *ghost_slot(const struct cache_shard *shard,
+                                   uint64_t hash) {
+    return &shard->ghosts[(hash >> 16) & (CACHE_GHOST_SLOTS - 1)];
+}
+
+static void evict_one(const struct cache *cache, struct cache_shard *shard) {
+    for (;;) {
+        struct cache_entry *entry;
+        if (cache->policy == CACHE_S3FIFO && shard->small.head
+            && (shard->small.weight * 10 >= shard->capacity
+                || !shard->main.head)) {
+            entry = shard->small.head;
+            if (entry->frequency) {
+                queue_unlink(&shard->small, entry);
+                entry->frequency = 0;
+                entry->queue = QUEUE_MAIN;
+                queue_push(&shard->main, entry);
+                continue;
+            }
+            *ghost_slot(shard, entry->hash) = ghost_fingerprint(entry->hash);
+        } else {
+            entry = shard->main.head;
+            if (entry->frequency) {
+                entry->frequency--;
+                queue_unlink(&shard->main, entry);
+                queue_push(&shard->main, entry);
+                continue;
+            }
+        }
+        entry_drop(shard, entry);
+        shard->evictions++;
+        return;
+    }
+}
+
+// ---------- Public API ---------- //
+struct cache *cache_create(size_t capacity, unsigned shards,
+                           enum cache_policy policy) {
+    if (shards == 0)
+        shards = CACHE_DEFAULT_SHARDS;
+    unsigned shard_count = 1;
+    while (shard_count < shards && shard_count < (1u << 16))
+        shard_count *= 2;
+    while (shard_count > 1 && capacity / shard_count == 0)
+        shard_count /= 2;
+
+    struct cache *cache = calloc(1, sizeof(struct cache));
+    if (!cache)
+        return NULL;
+    cache->shard_mask = shard_count - 1;
+    cache->policy = policy;
+    cache->max_frequency = policy == CACHE_S3FIFO ? 3 : 1;
+    cache->capacity = capacity;
+
+    void *memory;
+    if (posix_memalign(&memory, CACHE_LINE_SIZE,
+                       shard_count * sizeof(struct cache_shard)))
+        goto failure;
+    cache->shards = memset(memory, 0, shard_count * sizeof(struct cache_shard));
+
+    for (unsigned i = 0; i < shard_count; ++i) {
+        struct cache_shard *shard = &cache->shards[i];
+        shard->capacity = capacity / shard_count;
+        shard->mask = CACHE_INITIAL_BUCKETS - 1;
+        shard->buckets = calloc(CACHE_INITIAL_BUCKETS, sizeof(*shard->buckets));
+        if (!shard->buckets)
+            goto failure;
+        if (policy == CACHE_S3FIFO) {
+            shard->ghosts = calloc(CACHE_GHOST_SLOTS, sizeof(*shard->ghosts));
+            if (!shard->ghosts)
+                goto failure;
+        }
+    }
+    return cache;
+
+failure:
+    cache_destroy(cache);
+    return NULL;
+}
+
+void cache_destroy(struct cache *cache) {
+    if (!cache)
+        return;
+    if (cache->shards) {
+        for (unsigned i = 0; i <= cache->shard_mask; ++i) {
+            struct cache_shard *shard = &cache->shards[i];
+            struct cache_queue *queues[] = { &shard->small, &shard->main };
+            for (size_t q = 0; q < 2; ++q) {
+                struct cache_entry *entry = queues[q]->head;
+                while (entry) {
+                    struct cache_entry *next = entry->next;
+                    free(entry);
+                    entry = next;
+                }
+            }
+            free(shard->buckets);
+            free(shard->ghosts);
+        }
+        free(cache->shards);
+    }
+    free(cache);
+}
+
+static inline struct cache_shard *shard_of(const struct cache *cache,
+                                           uint64_t hash) {
+    return &cache->shards[(hash >> 32) & cache->shard_mask];
+}
+
+bool cache_put(struct cache *cache, const void *key, size_t key_length,
+               const void *value, size_t value_length, size_t weight) {
+    uint64_t hash = hashmap_hash_bytes(key, key_length);
+    struct cache_shard *shard = shard_of(cache, hash);
+    if (weight == 0)
+        weight = key_length + value_length;
+    if (weight > shard->capacity)
+        return false;
+
+    struct cache_entry *entry =
+        malloc(sizeof(struct cache_entry) + key_length + value_length);
+    if (!entry)
+        return false;
+    entry->hash = hash;
+    entry->weight = weight;
+    entry->key_length = key_length;
+    entry->value_length = value_length;
+    entry->frequency = 0;
+    memcpy(entry->data, key, key_length);
+    if (value_length)
+        memcpy(entry->data + key_length, value, value_length);
+
+    sync_rwlock_write_lock(&shard->lock);
+
+    // a replaced entry keeps its queue and frequency, but moves to the tail
+    struct cache_queue *queue = &shard->main;
+    entry->queue = QUEUE_MAIN;
+    struct cache_entry *old = find(shard, hash, key, key_length);
+    if (old) {
+        entry->queue = old->queue;
+        entry->frequency = old->frequency;
+        queue = entry_queue(shard, old);
+        entry_drop(shard, old);
+    } else if (cache->policy == CACHE_S3FIFO) {
+        uint32_t *ghost = ghost_slot(shard, hash);
+        if (*ghost == ghost_fingerprint(hash)) {
+            *ghost = 0;
+        } else {
+            entry->queue = QUEUE_SMALL;
+            queue = &shard->small;
+        }
+    }
+
+    while (shard->weight + weight > shard->capacity)
+        evict_one(cache, shard);
+    if (shard->count >= shard->mask + 1)
+        grow(shard);
+
+    struct cache_entry **bucket = bucket_of(shard, hash);
+    entry->chain = *bucket;
+    *bucket = entry;
+    queue_push(queue, entry);
+    shard->count++;
+    shard->weight += weight;
+    shard->insertions++;
+
+    sync_rwlock_write_unlock(&shard->lock);
+    return true;
+}
+
+bool cache_get(struct cache *cache, const void *key, size_t key_length,
+               void *value, size_t *size) {
+    uint64_t hash = hashmap_hash_bytes(key, key_length);
+    struct cache_shard *shard = shard_of(cache, hash);
+
+    sync_rwlock_read_lock(&shard->lock);
+    struct cache_entry *entry = find(shard, hash, key, key_length);
+    if (entry) {
+        uint8_t frequency =
+            __atomic_load_n(&entry->frequency, __ATOMIC_RELAXED);
+        if (frequency < cache->max_frequency) // no write on hot entries
+            __atomic_store_n(&entry->frequency, frequency + 1,
+                             __ATOMIC_RELAXED);
+        if (size) {
+            if (value)
+                memcpy(value, entry->data + key_length,
+                       *size < entry->value_length ? *size
+                                                   : entry->value_length);
+            *size = entry->value_length;
+        }
+    }
+    sync_rwlock_read_unlock(&shard->lock);
+
+    __atomic_fetch_add(entry ? &shard->hits : &shard->misses, 1,
+                       __ATOMIC_RELAXED);
+    return entry != NULL;
+}
+
+bool cache_remove(struct cache *cache, const void *key, size_t key_length) {
+    uint64_t hash = hashmap_hash_bytes(key, key_length);
+    struct cache_shard *shard = shard_of(cache, hash);
+
+    sync_rwlock_write_lock(&shard->lock);
+    struct cache_entry *entry = find(shard, hash, key, key_length);
+    if (entry)
+        entry_drop(shard, entry);
+    sync_rwlock_write_unlock(&shard->lock);
+    return entry != NULL;
+}
+
+struct cache_stats cache_stats_read(struct cache *cache) {
+    struct cache_stats stats = { 0 };
+    stats.capacity = cache->capacity;
+    for (unsigned i = 0; i <= cache->shard_mask; ++i) {
+        struct cache_shard *shard = &cache->shards[i];
+        sync_rwlock_read_lock(&shard->lock);
+        stats.insertions += shard->insertions;
+        stats.evictions += shard->evictions;
+        stats.count += shard->count;
+        stats.weight += shard->weight;
+        sync_rwlock_read_unlock(&shard->lock);
+        stats.hits += __atomic_load_n(&shard->hits, __ATOMIC_RELAXED);
+        stats.misses += __atomic_load_n(&shard->misses, __ATOMIC_RELAXED);
+    }
+    return stats;
+}
+
+void cache_log_stats(struct cache *cache, enum log_level level,
+                     const char *name) {
+    struct cache_stats stats = cache_stats_read(cache);
+    uint64_t lookups = stats.hits + stats.misses;
+    LOG(level,
+        "cache %s: %" PRIu64 " hits, %" PRIu64 " misses (%.1f%% hit ratio), "
+        "%" PRIu64 " insertions, %" PRIu64 " evictions, %zu entries, "
+        "weight %zu/%zu",
+        name, stats.hits, stats.misses,
+        lookups ? 100.0 * (double)stats.hits / (double)lookups : 0.0,
+        stats.insertions, stats.evictions, stats.count, stats.weight,
+        stats.capacity);
+    (void)level; // unused with NOLOG
+    (void)name;
+}
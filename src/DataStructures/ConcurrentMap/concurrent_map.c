@@ -0,0 +1,380 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/ebr.h>
+#include <ayaztub/data_structures/concurrent_map.h>
+#include <ayaztub/data_structures/hashmap.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Design:
+ * - Buckets are singly linked chains. Chains are only modified under the
+ *   stripe lock of their bucket (bucket index & (CMAP_STRIPES - 1)), and
+ *   every link is published with a release store so that lock-free readers
+ *   always see fully initialized nodes.
+ * - The number of buckets is a power of two and at least CMAP_STRIPES, so
+ *   the stripe of a bucket is the same in a table and in its successor.
+ * - Resizing migrates the buckets one by one: the entries of a bucket are
+ *   copied to the new table, then the old bucket is replaced by the
+ *   CMAP_MOVED marker. Readers and writers reaching a marker follow the
+ *   `next` pointer of the table.
+ * - Every access runs in an EBR critical section: unlinked nodes and old
+ *   tables are handed to ebr_retire() and freed once no reader can still
+ *   hold a pointer to them.
+ */
+
+struct cmap_node {
+    struct ebr_node ebr; // must stay first (freed through it)
+    struct cmap_node *next;
+    uint64_t hash;
+    void *value;
+    size_t key_length;
+    unsigned char key[];
+};
+
+struct cmap_table {
+    struct ebr_node ebr; // must stay first (freed through it)
+    struct cmap_table *next; /**< table the buckets are migrated to */
+    size_t mask;
+    struct cmap_node *buckets[];
+};
+
+struct cmap_stripe {
+    pthread_mutex_t lock;
+    size_t count;
+    char _pad[CACHE_LINE_SIZE
+              - (sizeof(pthread_mutex_t) + sizeof(size_t)) % CACHE_LINE_SIZE];
+};
+
+struct cmap {
+    struct cmap_table *table;
+    struct cmap_stripe stripes[CMAP_STRIPES];
+
+    bool resizing;
+    size_t migrate_index; /**< next bucket to migrate (resizing owner) */
+};
+
+static struct cmap_node moved_marker;
+#define CMAP_MOVED (&moved_marker)
+
+// ---------- Reclamation ---------- //
+static void retired_free(struct ebr_node *node) {
+    free(node);
+}
+
+static inline void retire(struct ebr_node *node) {
+    ebr_retire(node, retired_free);
+}
+
+// ---------- Tables and Chains ---------- //
+static struct cmap_table *table_create(size_t buckets) {
+    struct cmap_table *table =
+        calloc(1, sizeof(struct cmap_table)
+                      + buckets * sizeof(struct cmap_node *));
+    if (table)
+        table->mask = buckets - 1;
+    return table;
+}
+
+static struct cmap_node *node_create(uint64_t hash, const void *key,
+                                     size_t key_length, void *value) {
+    struct cmap_node *node = malloc(sizeof(struct cmap_node) + key_length);
+    if (!node)
+        return NULL;
+    node->next = NULL;
+    node->hash = hash;
+    node->value = value;
+    node->key_length = key_length;
+    memcpy(node->key, key, key_length);
+    return node;
+}
+
+static void chain_free(struct cmap_node *node) {
+    while (node) {
+        struct cmap_node *next = node->next;
+        free(node);
+        node = next;
+    }
+}
+
+static inline struct cmap_node *load_link(struct cmap_node **link) {
+    return __atomic_load_n(link, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_link(struct cmap_node **link,
+                              struct cmap_node *node) {
+    __atomic_store_n(link, node, __ATOMIC_RELEASE);
+}
+
+/*
+ * Returns the bucket of a hash, following the migration markers. Under the
+ * stripe lock of the hash, the returned bucket cannot be migrated.
+ */
+static struct cmap_node **bucket_of(struct cmap_table *table, uint64_t hash) {
+    for (;;) {
+        struct cmap_node **bucket = &table->buckets[hash & table->mask];
+        if (load_link(bucket) != CMAP_MOVED)
+            return bucket;
+        table = __atomic_load_n(&table->next, __ATOMIC_ACQUIRE);
+    }
+}
+
+/*
+ * Returns the node of a key and sets `link` to the link pointing to it. The
+ * link is only stable under the stripe lock of the key.
+ */
+static struct cmap_node *chain_find(struct cmap_node ***link, uint64_t hash,
+                                    const void *key, size_t key_length) {
+    struct cmap_node *node;
+    while ((node = load_link(*link))) {
+        if (node->hash == hash && node->key_length == key_length
+            && memcmp(node->key, key, key_length) == 0)
+            return node;
+        *link = &node->next;
+    }
+    return NULL;
+}
+
+static inline struct cmap_stripe *stripe_of(struct cmap *map, uint64_t hash) {
+    return &map->stripes[hash & (CMAP_STRIPES - 1)];
+}
+
+// ---------- Resizing ---------- //
+static bool migrate_bucket(struct cmap *map, struct cmap_table *old,
+                           struct cmap_table *new, size_t index) {
+    struct cmap_stripe *stripe = &map->stripes[index & (CMAP_STRIPES - 1)];
+    pthread_mutex_lock(&stripe->lock);
+
+    struct cmap_node *lo = NULL;
+    struct cmap_node *hi = NULL;
+    struct cmap_node *head = load_link(&old->buckets[index]);
+    for (struct cmap_node *node = head; node; node = node->next) {
+        struct cmap_node *copy = node_create(node->hash, node->key,
+                                             node->key_length, node->value);
+        if (!copy) {
+            pthread_mutex_unlock(&stripe->lock);
+            chain_free(lo);
+            chain_free(hi);
+            return false;
+        }
+        if (node->hash & (old->mask + 1)) {
+            copy->next = hi;
+            hi = copy;
+        } else {
+            copy->next = lo;
+            lo = copy;
+        }
+    }
+
+    store_link(&new->buckets[index], lo);
+    store_link(&new->buckets[index + old->mask + 1], hi);
+    store_link(&old->buckets[index], CMAP_MOVED);
+    pthread_mutex_unlock(&stripe->lock);
+
+    // the old chain is unreachable for new readers
+    while (head) {
+        struct cmap_node *next = head->next;
+        retire(&head->ebr);
+        head = next;
+    }
+    return true;
+}
+
+static void resize(struct cmap *map) {
+    if (__atomic_exchange_n(&map->resizing, true, __ATOMIC_ACQUIRE))
+        return;
+
+    ebr_enter();
+    struct cmap_table *old = __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+    struct cmap_table *new = __atomic_load_n(&old->next, __ATOMIC_ACQUIRE);
+
+    if (!new) {
+        // another thread may have completed a resize in the meantime
+        if (cmap_size(map) <= old->mask + 1 || old->mask > SIZE_MAX / 4)
+            goto out;
+        new = table_create(2 * (old->mask + 1));
+        if (!new)
+            goto out;
+        map->migrate_index = 0;
+        __atomic_store_n(&old->next, new, __ATOMIC_RELEASE);
+    }
+
+    // On allocation failure the migration is resumed by the next resize:
+    // a partially migrated table is fully usable.
+    for (; map->migrate_index <= old->mask; map->migrate_index++) {
+        if (!migrate_bucket(map, old, new, map->migrate_index))
+            goto out;
+    }
+
+    __atomic_store_n(&map->table, new, __ATOMIC_RELEASE);
+    retire(&old->ebr);
+
+out:
+    ebr_exit();
+    __atomic_store_n(&map->resizing, false, __ATOMIC_RELEASE);
+}
+
+// ---------- Concurrent Map Functions ---------- //
+struct cmap *cmap_create(size_t capacity) {
+    size_t buckets = CMAP_STRIPES;
+    while (buckets < capacity && buckets <= SIZE_MAX / 4)
+        buckets *= 2;
+
+    struct cmap *map = calloc(1, sizeof(struct cmap));
+    if (!map)
+        return NULL;
+    map->table = table_create(buckets);
+    if (!map->table) {
+        free(map);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < CMAP_STRIPES; i++)
+        pthread_mutex_init(&map->stripes[i].lock, NULL);
+    return map;
+}
+
+static void table_destroy(struct cmap_table *table) {
+    if (!table)
+        return;
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        if (table->buckets[i] != CMAP_MOVED)
+            chain_free(table->buckets[i]);
+    }
+    table_destroy(table->next);
+    free(table);
+}
+
+void cmap_destroy(struct cmap *map) {
+    if (!map)
+        return;
+
+    table_destroy(map->table);
+    for (size_t i = 0; i < CMAP_STRIPES; i++)
+        pthread_mutex_destroy(&map->stripes[i].lock);
+    free(map);
+}
+
+bool cmap_get(struct cmap *map, const void *key, size_t key_length,
+              void **value) {
+    uint64_t hash = hashmap_hash_bytes(key, key_length);
+
+    ebr_enter();
+    struct cmap_table *table = __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+    struct cmap_node **link = bucket_of(table, hash);
+    struct cmap_node *node = chain_find(&link, hash, key, key_length);
+    if (node && value)
+        *value = __atomic_load_n(&node->value, __ATOMIC_ACQUIRE);
+    ebr_exit();
+
+    return node != NULL;
+}
+
+bool cmap_put(struct cmap *map, const void *key, size_t key_length,
+              void *value, void **previous) {
+    uint64_t hash = hashmap_hash_bytes(key, key_length);
+    struct cmap_stripe *stripe = stripe_of(map, hash);
+    bool grow = false;
+    bool migrating;
+
+    ebr_enter();
+    pthread_mutex_lock(&stripe->lock);
+
+    struct cmap_table *table = __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+    struct cmap_node **bucket = bucket_of(table, hash);
+    struct cmap_node **link = bucket;
+    struct cmap_node *node = chain_find(&link, hash, key, key_length);
+    if (node) {
+        void *old =
+            __atomic_exchange_n(&node->value, value, __ATOMIC_ACQ_REL);
+        if (previous)
+            *previous = old;
+    } else {
+        node = node_create(hash, key, key_length, value);
+        if (!node) {
+            pthread_mutex_unlock(&stripe->lock);
+            ebr_exit();
+            return false;
+        }
+        node->next = load_link(bucket);
+        store_link(bucket, node);
+        __atomic_store_n(&stripe->count, stripe->count + 1, __ATOMIC_RELAXED);
+        grow = stripe->count > (table->mask + 1) / CMAP_STRIPES;
+        if (previous)
+            *previous = NULL;
+    }
+    // resume a migration interrupted by an allocation failure
+    migrating = __atomic_load_n(&table->next, __ATOMIC_RELAXED) != NULL;
+
+    pthread_mutex_unlock(&stripe->lock);
+    ebr_exit();
+
+    if (grow || migrating)
+        resize(map);
+    return true;
+}
+
+bool cmap_remove(struct cmap *map, const void *key, size_t key_length,
+                 void **value) {
+    uint64_t hash = hashmap_hash_bytes(key, key_length);
+    struct cmap_stripe *stripe = stripe_of(map, hash);
+
+    ebr_enter();
+    pthread_mutex_lock(&stripe->lock);
+
+    struct cmap_table *table = __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+    struct cmap_node **link = bucket_of(table, hash);
+    struct cmap_node *node = chain_find(&link, hash, key, key_length);
+    if (node) {
+        store_link(link, node->next);
+        __atomic_store_n(&stripe->count, stripe->count - 1, __ATOMIC_RELAXED);
+        if (value)
+            *value = node->value;
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+    ebr_exit();
+
+    if (node)
+        retire(&node->ebr);
+    return node != NULL;
+}
+
+size_t cmap_size(struct cmap *map) {
+    size_t size = 0;
+    for (size_t i = 0; i < CMAP_STRIPES; i++)
+        size += __atomic_load_n(&map->stripes[i].count, __ATOMIC_RELAXED);
+    return size;
+}
+
+static void visit_bucket(struct cmap_table *table, size_t index,
+                         cmap_visit_t visit, void *ctx) {
+    struct cmap_node *node = load_link(&table->buckets[index]);
+    if (node == CMAP_MOVED) {
+        struct cmap_table *next =
+            __atomic_load_n(&table->next, __ATOMIC_ACQUIRE);
+        visit_bucket(next, index, visit, ctx);
+        visit_bucket(next, index + table->mask + 1, visit, ctx);
+        return;
+    }
+
+    for (; node; node = load_link(&node->next))
+        visit(node->key, node->key_length,
+              __atomic_load_n(&node->value, __ATOMIC_ACQUIRE), ctx);
+}
+
+void cmap_for_each(struct cmap *map, cmap_visit_t visit, void *ctx) {
+    ebr_enter();
+    struct cmap_table *table = __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i <= table->mask; i++)
+        visit_bucket(table, i, visit, ctx);
+    ebr_exit();
+}
@@ -0,0 +1,463 @@
+#include <ayaztub/data_structures/filter.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Design:
+ * - Tables are aligned on cache lines: a Bloom block, or the pair of lines
+ *   holding the two candidate buckets of a cuckoo item, is all a lookup
+ *   reads. The table memory is over-allocated by a line to align it.
+ * - Bloom: the 32 high bits of the hash pick the block (multiply-shift range
+ *   reduction, no modulo), the 32 low bits times 8 odd salts pick one bit in
+ *   each of the 8 words of the block (the salts of the Parquet split block
+ *   Bloom filter). Lookups are branchless.
+ * - Cuckoo: a bucket is one 64 bits word of 4 fingerprints (0 marks an empty
+ *   slot), searched with a SWAR "has zero lane" test. The alternate bucket
+ *   is index ^ hash(fingerprint), so it can be computed from either bucket
+ *   when kicking a fingerprint out. An insertion that still finds no room
+ *   after MAX_KICKS relocations parks the last fingerprint in a victim slot
+ *   (so no item is ever lost) and the filter reports itself full.
+ * - Serialized filters are a 64 bytes header followed by the table, in the
+ *   same layout as in memory, so views just point into the data.
+ */
+
+#define CACHE_LINE 64
+#define BLOCK_WORDS 8
+#define BUCKET_SLOTS 4
+#define MAX_KICKS 500
+#define PREFETCH_DISTANCE 8
+#define FORMAT_VERSION 1
+
+static const char BLOOM_MAGIC[8] = "AYZBLOOM";
+static const char CUCKOO_MAGIC[8] = "AYZCUCKO";
+
+struct filter_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t table_size; // blocks or buckets
+    uint64_t count;
+    uint64_t victim_index;
+    uint64_t victim;
+    uint64_t reserved[2];
+};
+
+typedef char filter_header_size_check
+    [sizeof(struct filter_header) == FILTER_HEADER_SIZE ? 1 : -1];
+
+// ---------- Common ---------- //
+static void *alloc_table(const struct allocator *allocator, size_t size,
+                         void **memory, size_t *memory_size) {
+    if (size > SIZE_MAX - CACHE_LINE)
+        return NULL;
+    *memory_size = size + CACHE_LINE - 1;
+    *memory = allocator_realloc(allocator, NULL, 0, *memory_size);
+    if (!*memory)
+        return NULL;
+    uintptr_t address = ((uintptr_t)*memory + CACHE_LINE - 1)
+                        & ~(uintptr_t)(CACHE_LINE - 1);
+    memset((void *)address, 0, size);
+    return (void *)address;
+}
+
+static bool write_header(void *buffer, size_t size, const char *magic,
+                         size_t table_bytes,
+                         const struct filter_header *fields) {
+    if (size < FILTER_HEADER_SIZE || size - FILTER_HEADER_SIZE < table_bytes)
+        return false;
+    struct filter_header header = *fields;
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.header_size = FILTER_HEADER_SIZE;
+    memset(header.reserved, 0, sizeof(header.reserved));
+    memcpy(buffer, &header, sizeof(header));
+    return true;
+}
+
+/* Checks the header, and that the table fills the rest of the data. */
+static bool read_header(const void *data, size_t size, const char *magic,
+                        size_t entry_size, struct filter_header *header) {
+    if (size < FILTER_HEADER_SIZE)
+        return false;
+    memcpy(header, data, sizeof(*header));
+    size_t table_bytes = size - FILTER_HEADER_SIZE;
+    return !memcmp(header->magic, magic, sizeof(header->magic))
+           && header->version == FORMAT_VERSION
+           && header->header_size == FILTER_HEADER_SIZE
+           && header->table_size && table_bytes % entry_size == 0
+           && header->table_size == table_bytes / entry_size;
+}
+
+static const void *table_of(const void *data) {
+    return (const char *)data + FILTER_HEADER_SIZE;
+}
+
+// ---------- Bloom Filter ---------- //
+static const uint32_t SALTS[BLOCK_WORDS] = { 0x47b6137bU, 0x44974d91U,
+                                             0x8824ad5bU, 0xa2b7289dU,
+                                             0x705495c7U, 0x2df1424bU,
+                                             0x9efc4947U, 0x5c6bfb31U };
+
+static inline uint64_t *block_of(const struct bloom *filter, uint64_t hash) {
+    // block_count fits in 32 bits: (hash >> 32) * block_count >> 32 is in
+    // [0, block_count)
+    size_t block = (size_t)(((hash >> 32) * filter->block_count) >> 32);
+    return filter->blocks + block * BLOCK_WORDS;
+}
+
+static inline uint64_t bit_of(uint64_t hash, unsigned word) {
+    return UINT64_C(1) << (((uint32_t)hash * SALTS[word]) >> 26);
+}
+
+bool bloom_init(struct bloom *filter, size_t capacity, unsigned bits_per_item,
+                const struct allocator *allocator) {
+    memset(filter, 0, sizeof(*filter));
+    filter->allocator = allocator;
+    if (bits_per_item && capacity > SIZE_MAX / bits_per_item)
+        return false;
+
+    size_t block_bits = BLOCK_WORDS * 64;
+    size_t blocks = (capacity * bits_per_item + block_bits - 1) / block_bits;
+    if (!blocks)
+        blocks = 1;
+    if (blocks > UINT32_MAX)
+        return false;
+
+    filter->blocks =
+        alloc_table(allocator, blocks * BLOCK_WORDS * sizeof(uint64_t),
+                    &filter->memory, &filter->memory_size);
+    if (!filter->blocks)
+        return false;
+    filter->block_count = blocks;
+    return true;
+}
+
+void bloom_deinit(struct bloom *filter) {
+    if (filter->memory)
+        allocator_free(filter->allocator, filter->memory,
+                       filter->memory_size);
+    filter->blocks = NULL;
+    filter->block_count = 0;
+    filter->memory = NULL;
+    filter->memory_size = 0;
+}
+
+void bloom_add(struct bloom *filter, uint64_t hash) {
+    uint64_t *block = block_of(filter, hash);
+    for (unsigned i = 0; i < BLOCK_WORDS; i++)
+        block[i] |= bit_of(hash, i);
+}
+
+bool bloom_contains(const struct bloom *filter, uint64_t hash) {
+    const uint64_t *block = block_of(filter, hash);
+    uint64_t missing = 0;
+    for (unsigned i = 0; i < BLOCK_WORDS; i++)
+        missing |= ~block[i] & bit_of(hash, i);
+    return !missing;
+}
+
+size_t bloom_contains_batch(const struct bloom *filter, const uint64_t *hashes,
+                            size_t count, bool *results) {
+    size_t hits = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i + PREFETCH_DISTANCE < count)
+            __builtin_prefetch(
+                block_of(filter, hashes[i + PREFETCH_DISTANCE]));
+        bool hit = bloom_contains(filter, hashes[i]);
+        if (results)
+            results[i] = hit;
+        hits += hit;
+    }
+    return hits;
+}
+
+size_t bloom_serialized_size(const struct bloom *filter) {
+    return FILTER_HEADER_SIZE
+           + filter->block_count * BLOCK_WORDS * sizeof(uint64_t);
+}
+
+bool bloom_serialize(const struct bloom *filter, void *buffer, size_t size) {
+    size_t table_bytes = filter->block_count * BLOCK_WORDS * sizeof(uint64_t);
+    struct filter_header fields = { .table_size = filter->block_count };
+    if (!write_header(buffer, size, BLOOM_MAGIC, table_bytes, &fields))
+        return false;
+    memcpy((char *)buffer + FILTER_HEADER_SIZE, filter->blocks, table_bytes);
+    return true;
+}
+
+static bool bloom_check(const void *data, size_t size,
+                        struct filter_header *header) {
+    return read_header(data, size, BLOOM_MAGIC,
+                       BLOCK_WORDS * sizeof(uint64_t), header)
+           && header->table_size <= UINT32_MAX;
+}
+
+bool bloom_load(struct bloom *filter, const void *data, size_t size,
+                const struct allocator *allocator) {
+    struct filter_header header;
+    memset(filter, 0, sizeof(*filter));
+    filter->allocator = allocator;
+    if (!bloom_check(data, size, &header))
+        return false;
+
+    size_t table_bytes = size - FILTER_HEADER_SIZE;
+    filter->blocks = alloc_table(allocator, table_bytes, &filter->memory,
+                                 &filter->memory_size);
+    if (!filter->blocks)
+        return false;
+    memcpy(filter->blocks, table_of(data), table_bytes);
+    filter->block_count = (size_t)header.table_size;
+    return true;
+}
+
+bool bloom_view(struct bloom *filter, const void *data, size_t size) {
+    struct filter_header header;
+    memset(filter, 0, sizeof(*filter));
+    if ((uintptr_t)data % sizeof(uint64_t) || !bloom_check(data, size, &header))
+        return false;
+    filter->blocks = (uint64_t *)table_of(data);
+    filter->block_count = (size_t)header.table_size;
+    return true;
+}
+
+// ---------- Cuckoo Filter ---------- //
+#define LANE_ONES UINT64_C(0x0001000100010001)
+#define LANE_HIGHS UINT64_C(0x8000800080008000)
+#define LANE_MASK UINT64_C(0xffff)
+
+/*
+ * Flags the 16 bits lanes of a bucket equal to a fingerprint. The lowest
+ * flagged lane is always a match (a borrow can only flag a lane above a
+ * match), and no flag means no match.
+ */
+static inline uint64_t lanes_equal(uint64_t bucket, uint16_t fingerprint) {
+    uint64_t x = bucket ^ (fingerprint * LANE_ONES);
+    return (x - LANE_ONES) & ~x & LANE_HIGHS;
+}
+
+static inline unsigned lowest_lane(uint64_t flags) {
+    return (unsigned)__builtin_ctzll(flags) / 16;
+}
+
+static inline uint16_t fingerprint_of(uint64_t hash) {
+    uint16_t fingerprint = (uint16_t)(hash >> 48);
+    return fingerprint ? fingerprint : 1;
+}
+
+static inline size_t index_of(const struct cuckoo *filter, uint64_t hash) {
+    return (size_t)hash & (filter->bucket_count - 1);
+}
+
+static inline size_t alternate_of(const struct cuckoo *filter, size_t index,
+                                  uint16_t fingerprint) {
+    return (index ^ (size_t)(fingerprint * UINT32_C(0x5bd1e995)))
+           & (filter->bucket_count - 1);
+}
+
+static bool bucket_insert(uint64_t *bucket, uint16_t fingerprint) {
+    uint64_t empty = lanes_equal(*bucket, 0);
+    if (!empty)
+        return false;
+    *bucket |= (uint64_t)fingerprint << (16 * lowest_lane(empty));
+    return true;
+}
+
+static bool bucket_remove(uint64_t *bucket, uint16_t fingerprint) {
+    uint64_t found = lanes_equal(*bucket, fingerprint);
+    if (!found)
+        return false;
+    *bucket &= ~(LANE_MASK << (16 * lowest_lane(found)));
+    return true;
+}
+
+/* Stores a fingerprint in one of its buckets, or in the victim slot. */
+static void insert_fingerprint(struct cuckoo *filter, size_t index,
+                               uint16_t fingerprint) {
+    if (bucket_insert(&filter->buckets[index], fingerprint))
+        return;
+    index = alternate_of(filter, index, fingerprint);
+    if (bucket_insert(&filter->buckets[index], fingerprint))
+        return;
+
+    for (unsigned kick = 0; kick < MAX_KICKS; kick++) {
+        unsigned lane = (kick + fingerprint) % BUCKET_SLOTS;
+        uint64_t *bucket = &filter->buckets[index];
+        uint16_t evicted = (uint16_t)((*bucket >> (16 * lane)) & LANE_MASK);
+        *bucket = (*bucket & ~(LANE_MASK << (16 * lane)))
+                  | (uint64_t)fingerprint << (16 * lane);
+        fingerprint = evicted;
+        index = alternate_of(filter, index, fingerprint);
+        if (bucket_insert(&filter->buckets[index], fingerprint))
+            return;
+    }
+    filter->victim = fingerprint;
+    filter->victim_index = index;
+}
+
+static inline bool victim_matches(const struct cuckoo *filter, size_t index,
+                                  size_t alternate, uint16_t fingerprint) {
+    return filter->victim == fingerprint
+           && (filter->victim_index == index
+               || filter->victim_index == alternate);
+}
+
+bool cuckoo_init(struct cuckoo *filter, size_t capacity,
+                 const struct allocator *allocator) {
+    memset(filter, 0, sizeof(*filter));
+    filter->allocator = allocator;
+    if (capacity > SIZE_MAX / 100)
+        return false;
+
+    // at most 95% full at capacity
+    size_t buckets = 2;
+    while (buckets * BUCKET_SLOTS * 95 < capacity * 100) {
+        if (buckets > SIZE_MAX / 2 / sizeof(uint64_t))
+            return false;
+        buckets *= 2;
+    }
+
+    filter->buckets = alloc_table(allocator, buckets * sizeof(uint64_t),
+                                  &filter->memory, &filter->memory_size);
+    if (!filter->buckets)
+        return false;
+    filter->bucket_count = buckets;
+    return true;
+}
+
+void cuckoo_deinit(struct cuckoo *filter) {
+    if (filter->memory)
+        allocator_free(filter->allocator, filter->memory,
+                       filter->memory_size);
+    filter->buckets = NULL;
+    filter->bucket_count = 0;
+    filter->count = 0;
+    filter->victim = 0;
+    filter->memory = NULL;
+    filter->memory_size = 0;
+}
+
+bool cuckoo_add(struct cuckoo *filter, uint64_t hash) {
+    if (filter->victim)
+        return false;
+    insert_fingerprint(filter, index_of(filter, hash), fingerprint_of(hash));
+    filter->count++;
+    return true;
+}
+
+bool cuckoo_remove(struct cuckoo *filter, uint64_t hash) {
+    uint16_t fingerprint = fingerprint_of(hash);
+    size_t index = index_of(filter, hash);
+    size_t alternate = alternate_of(filter, index, fingerprint);
+
+    if (bucket_remove(&filter->buckets[index], fingerprint)
+        || bucket_remove(&filter->buckets[alternate], fingerprint)) {
+        filter->count--;
+        if (filter->victim) {
+            // there is room again: try to store the victim in a bucket
+            uint16_t victim = filter->victim;
+            filter->victim = 0;
+            insert_fingerprint(filter, filter->victim_index, victim);
+        }
+        return true;
+    }
+
+    if (victim_matches(filter, index, alternate, fingerprint)) {
+        filter->victim = 0;
+        filter->count--;
+        return true;
+    }
+    return false;
+}
+
+bool cuckoo_contains(const struct cuckoo *filter, uint64_t hash) {
+    uint16_t fingerprint = fingerprint_of(hash);
+    size_t index = index_of(filter, hash);
+    size_t alternate = alternate_of(filter, index, fingerprint);
+    return (lanes_equal(filter->buckets[index], fingerprint)
+            | lanes_equal(filter->buckets[alternate], fingerprint))
+           || victim_matches(filter, index, alternate, fingerprint);
+}
+
+size_t cuckoo_contains_batch(const struct cuckoo *filter,
+                             const uint64_t *hashes, size_t count,
+                             bool *results) {
+    size_t hits = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i + PREFETCH_DISTANCE < count) {
+            uint64_t next = hashes[i + PREFETCH_DISTANCE];
+            size_t index = index_of(filter, next);
+            __builtin_prefetch(&filter->buckets[index]);
+            __builtin_prefetch(&filter->buckets[alternate_of(
+                filter, index, fingerprint_of(next))]);
+        }
+        bool hit = cuckoo_contains(filter, hashes[i]);
+        if (results)
+            results[i] = hit;
+        hits += hit;
+    }
+    return hits;
+}
+
+size_t cuckoo_serialized_size(const struct cuckoo *filter) {
+    return FILTER_HEADER_SIZE + filter->bucket_count * sizeof(uint64_t);
+}
+
+bool cuckoo_serialize(const struct cuckoo *filter, void *buffer,
+                      size_t size) {
+    size_t table_bytes = filter->bucket_count * sizeof(uint64_t);
+    struct filter_header fields = { .table_size = filter->bucket_count,
+                                    .count = filter->count,
+                                    .victim_index = filter->victim_index,
+                                    .victim = filter->victim };
+    if (!write_header(buffer, size, CUCKOO_MAGIC, table_bytes, &fields))
+        return false;
+    memcpy((char *)buffer + FILTER_HEADER_SIZE, filter->buckets, table_bytes);
+    return true;
+}
+
+static bool cuckoo_check(const void *data, size_t size,
+                         struct filter_header *header) {
+    return read_header(data, size, CUCKOO_MAGIC, sizeof(uint64_t), header)
+           && !(header->table_size & (header->table_size - 1))
+           && header->victim <= UINT16_MAX
+           && header->victim_index < header->table_size;
+}
+
+static void cuckoo_set_fields(struct cuckoo *filter,
+                              const struct filter_header *header) {
+    filter->bucket_count = (size_t)header->table_size;
+    filter->count = (size_t)header->count;
+    filter->victim_index = (size_t)header->victim_index;
+    filter->victim = (uint16_t)header->victim;
+}
+
+bool cuckoo_load(struct cuckoo *filter, const void *data, size_t size,
+                 const struct allocator *allocator) {
+    struct filter_header header;
+    memset(filter, 0, sizeof(*filter));
+    filter->allocator = allocator;
+    if (!cuckoo_check(data, size, &header))
+        return false;
+
+    size_t table_bytes = size - FILTER_HEADER_SIZE;
+    filter->buckets = alloc_table(allocator, table_bytes, &filter->memory,
+                                  &filter->memory_size);
+    if (!filter->buckets)
+        return false;
+    memcpy(filter->buckets, table_of(data), table_bytes);
+    cuckoo_set_fields(filter, &header);
+    return true;
+}
+
+bool cuckoo_view(struct cuckoo *filter, const void *data, size_t size) {
+    struct filter_header header;
+    memset(filter, 0, sizeof(*filter));
+    if ((uintptr_t)data % sizeof(uint64_t)
+        || !cuckoo_check(data, size, &header))
+        return false;
+    filter->buckets = (uint64_t *)table_of(data);
+    cuckoo_set_fields(filter, &header);
+    return true;
+}
@@ -0,0 +1,234 @@
+#include <ayaztub/concurrency/sync.h>
+#include <ayaztub/core_utils/bits.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/hashmap.h>
+#include <ayaztub/data_structures/interner.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Design:
+ * - Entries (hash, ID and string) are allocated once in the arena and never
+ *   move. The hash table is an open-addressing table (linear probing) of
+ *   entry pointers; the ID directory is a list of chunks of doubling sizes,
+ *   so that the entry of an ID is found in O(1) and chunks never move.
+ * - Writers are serialized by a mutex. They fill an entry, store it in the
+ *   directory, publish the new count, and only then publish the entry in the
+ *   hash table with a release store: a reader finding an entry always sees
+ *   it complete, and sees a count covering its ID.
+ * - The table is grown by building a bigger copy and publishing it with a
+ *   single release store. Old tables stay valid (and in the arena) until
+ *   destroy, so lock-free readers never need any reclamation scheme.
+ */
+
+#define MIN_TABLE_SIZE 64
+#define DIRECTORY_BASE_SHIFT 6 // first directory chunk: 64 IDs
+#define DIRECTORY_CHUNKS (33 - DIRECTORY_BASE_SHIFT)
+
+struct interned {
+    uint64_t hash;
+    uint32_t id;
+    uint32_t size;
+    char data[];
+};
+
+struct interner_table {
+    size_t mask;
+    struct interned *slots[];
+};
+
+struct interner {
+    struct interner_table *table;
+    struct interned **chunks[DIRECTORY_CHUNKS];
+    uint32_t count;
+
+    struct sync_mutex lock;
+    struct arena *arena; /**< only used under lock */
+};
+
+// ---------- ID Directory ---------- //
+/*
+ * Chunk k holds the IDs [base * (2^k - 1), base * (2^(k+1) - 1)), with base
+ * the size of the first chunk.
+ */
+static unsigned chunk_of(uint32_t id, size_t *offset) {
+    uint64_t position = ((uint64_t)id >> DIRECTORY_BASE_SHIFT) + 1;
+    unsigned chunk = bits_log2_64(position);
+    *offset = id - ((((uint64_t)1 << chunk) - 1) << DIRECTORY_BASE_SHIFT);
+    return chunk;
+}
+
+static size_t chunk_size(unsigned chunk) {
+    return (size_t)1 << (chunk + DIRECTORY_BASE_SHIFT);
+}
+
+// ---------- Hash Table ---------- //
+static struct interner_table *table_create(struct arena *arena, size_t size) {
+    struct interner_table *table =
+        arena_alloc(arena, sizeof(struct interner_table)
+                               + size * sizeof(struct interned *));
+    if (table) {
+        table->mask = size - 1;
+        memset(table->slots, 0, size * sizeof(struct interned *));
+    }
+    return table;
+}
+
+static struct interned *table_find(const struct interner_table *table,
+                                   uint64_t hash, const char *str,
+                                   size_t size) {
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        struct interned *entry =
+            __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+        if (!entry)
+            return NULL;
+        if (entry->hash == hash && entry->size == size
+            && !memcmp(entry->data, str, size))
+            return entry;
+    }
+}
+
+static void table_insert(struct interner_table *table,
+                         struct interned *entry) {
+    size_t i = entry->hash & table->mask;
+    while (table->slots[i])
+        i = (i + 1) & table->mask;
+    __atomic_store_n(&table->slots[i], entry, __ATOMIC_RELEASE);
+}
+
+/* Grows the table (under lock) so that one more entry keeps it 3/4 full. */
+static bool reserve_one(struct interner *interner) {
+    struct interner_table *table = interner->table;
+    size_t size = table->mask + 1;
+    if (((size_t)interner->count + 1) * 4 <= size * 3)
+        return true;
+
+    struct interner_table *bigger = table_create(interner->arena, size * 2);
+    if (!bigger)
+        return false;
+    for (size_t i = 0; i < size; i++) {
+        if (table->slots[i])
+            table_insert(bigger, table->slots[i]);
+    }
+    __atomic_store_n(&interner->table, bigger, __ATOMIC_RELEASE);
+    return true;
+}
+
+// ---------- Interner ---------- //
+struct interner *interner_create(size_t capacity) {
+    struct interner *interner = calloc(1, sizeof(struct interner));
+    if (!interner)
+        return NULL;
+
+    size_t size = MIN_TABLE_SIZE;
+    while (size * 3 < capacity * 4)
+        size *= 2;
+
+    interner->arena = arena_create(0);
+    if (!interner->arena)
+        goto failure;
+    interner->table = table_create(interner->arena, size);
+    if (!interner->table)
+        goto failure;
+    return interner;
+
+failure:
+    arena_destroy(interner->arena);
+    free(interner);
+    return NULL;
+}
+
+void interner_destroy(struct interner *interner) {
+    if (!interner)
+        return;
+    arena_destroy(interner->arena);
+    free(interner);
+}
+
+uint32_t interner_find(const struct interner *interner, const char *str,
+                       size_t size) {
+    uint64_t hash = hashmap_hash_bytes(str, size);
+    struct interned *entry = table_find(
+        __atomic_load_n(&interner->table, __ATOMIC_ACQUIRE), hash, str, size);
+    return entry ? entry->id : INTERNER_INVALID_ID;
+}
+
+static struct interned *intern_locked(struct interner *interner,
+                                      uint64_t hash, const char *str,
+                                      size_t size) {
+    struct interned *entry = table_find(interner->table, hash, str, size);
+    if (entry)
+        return entry;
+
+    uint32_t id = interner->count;
+    if (id == INTERNER_INVALID_ID || size >= UINT32_MAX
+        || !reserve_one(interner))
+        return NULL;
+
+    size_t offset;
+    unsigned chunk = chunk_of(id, &offset);
+    if (!interner->chunks[chunk]) {
+        struct interned **entries = arena_alloc(
+            interner->arena, chunk_size(chunk) * sizeof(struct interned *));
+        if (!entries)
+            return NULL;
+        __atomic_store_n(&interner->chunks[chunk], entries, __ATOMIC_RELAXED);
+    }
+
+    entry = arena_alloc(interner->arena, sizeof(struct interned) + size + 1);
+    if (!entry)
+        return NULL;
+    entry->hash = hash;
+    entry->id = id;
+    entry->size = (uint32_t)size;
+    memcpy(entry->data, str, size);
+    entry->data[size] = '\0';
+
+    // directory, then count, then table: see the design comment
+    __atomic_store_n(&interner->chunks[chunk][offset], entry,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&interner->count, id + 1, __ATOMIC_RELEASE);
+    table_insert(interner->table, entry);
+    return entry;
+}
+
+uint32_t interner_intern(struct interner *interner, const char *str,
+                         size_t size, const char **interned) {
+    uint64_t hash = hashmap_hash_bytes(str, size);
+    struct interned *entry = table_find(
+        __atomic_load_n(&interner->table, __ATOMIC_ACQUIRE), hash, str, size);
+
+    if (!entry) {
+        sync_mutex_lock(&interner->lock);
+        entry = intern_locked(interner, hash, str, size);
+        sync_mutex_unlock(&interner->lock);
+        if (!entry)
+            return INTERNER_INVALID_ID;
+    }
+
+    if (interned)
+        *interned = entry->data;
+    return entry->id;
+}
+
+const char *interner_str(const struct interner *interner, uint32_t id,
+                         size_t *size) {
+    if (id >= __atomic_load_n(&interner->count, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    size_t offset;
+    unsigned chunk = chunk_of(id, &offset);
+    struct interned **entries =
+        __atomic_load_n(&interner->chunks[chunk], __ATOMIC_RELAXED);
+    struct interned *entry =
+        __atomic_load_n(&entries[offset], __ATOMIC_RELAXED);
+    if (size)
+        *size = entry->size;
+    return entry->data;
+}
+
+size_t interner_count(const struct interner *interner) {
+    return __atomic_load_n(&interner->count, __ATOMIC_ACQUIRE);
+}
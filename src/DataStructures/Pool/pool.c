@@ -0,0 +1,411 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/data_structures/pool.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Memory layout:
+ * - A slab is a POOL_SLAB_SIZE block aligned on POOL_SLAB_SIZE. It starts
+ *   with a `struct slab` header (padded to a cache line) followed by the
+ *   objects. The slab owning an object is found by masking its address.
+ * - A free object stores the next free object in its first word, both in the
+ *   slab free lists and in the lock-free global free list.
+ * - Each (thread, pool) couple owns a magazine, an array of cached objects
+ *   reached through a pthread key. Magazines only exchange objects with the
+ *   shared layers in batches of half a magazine.
+ */
+
+enum slab_state {
+    SLAB_PARTIAL,
+    SLAB_FULL,
+    SLAB_EMPTY,
+};
+
+struct slab {
+    struct pool *pool;
+    struct slab *prev;
+    struct slab *next;
+    void *free_list;
+    size_t bump; /**< index of the first never used object */
+    size_t used; /**< objects currently out of the slab layer */
+    enum slab_state state;
+};
+
+struct magazine {
+    struct pool *pool;
+    struct magazine *prev;
+    struct magazine *next;
+    size_t count;
+    void *objects[POOL_MAGAZINE_SIZE];
+};
+
+struct pool {
+    // Lock-free global free list, alone on its cache line as every thread
+    // flushing or refilling its magazine hits it.
+    void *remote;
+    char _pad[CACHE_LINE_SIZE - sizeof(void *)];
+
+    size_t object_size;
+    size_t objects_per_slab;
+    size_t header_size;
+    pthread_key_t key;
+
+    // Everything below is protected by the mutex.
+    pthread_mutex_t mutex;
+    struct slab *slabs[3]; /**< indexed by enum slab_state */
+    size_t slab_count;
+    size_t empty_slabs;
+    size_t slab_objects;
+    struct magazine *magazines;
+};
+
+// ---------- Utility Functions ---------- //
+static inline void *obj_next(void *obj) {
+    return *(void **)obj;
+}
+
+static inline void obj_set_next(void *obj, void *next) {
+    *(void **)obj = next;
+}
+
+static inline struct slab *obj_slab(void *obj) {
+    return (struct slab *)((uintptr_t)obj & ~(uintptr_t)(POOL_SLAB_SIZE - 1));
+}
+
+// ---------- Lock-free Global Free List ---------- //
+/*
+ * Objects are pushed as whole chains and only ever popped all at once with an
+ * atomic exchange, so the list is immune to the ABA problem of Treiber stacks.
+ */
+static void remote_push_chain(struct pool *pool, void *head, void *tail) {
+    void *old = __atomic_load_n(&pool->remote, __ATOMIC_RELAXED);
+    do {
+        obj_set_next(tail, old);
+    } while (!__atomic_compare_exchange_n(&pool->remote, &old, head, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static void *remote_pop_all(struct pool *pool) {
+    if (!__atomic_load_n(&pool->remote, __ATOMIC_RELAXED))
+        return NULL;
+    return __atomic_exchange_n(&pool->remote, NULL, __ATOMIC_ACQUIRE);
+}
+
+// ---------- Slab Layer (pool mutex held) ---------- //
+static void slab_unlink(struct pool *pool, struct slab *slab) {
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        pool->slabs[slab->state] = slab->next;
+    if (slab->next)
+        slab->next->prev = slab->prev;
+}
+
+static void slab_link(struct pool *pool, struct slab *slab,
+                      enum slab_state state) {
+    slab->state = state;
+    slab->prev = NULL;
+    slab->next = pool->slabs[state];
+    if (slab->next)
+        slab->next->prev = slab;
+    pool->slabs[state] = slab;
+}
+
+static void slab_move(struct pool *pool, struct slab *slab,
+                      enum slab_state state) {
+    if (slab->state == state)
+        return;
+    if (slab->state == SLAB_EMPTY)
+        pool->empty_slabs--;
+    if (state == SLAB_EMPTY)
+        pool->empty_slabs++;
+    slab_unlink(pool, slab);
+    slab_link(pool, slab, state);
+}
+
+static struct slab *slab_create(struct pool *pool) {
+    // Over-map to align the slab on its size, then give back the excess.
+    size_t map_size = 2 * POOL_SLAB_SIZE;
+    char *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    uintptr_t aligned = ((uintptr_t)map + POOL_SLAB_SIZE - 1)
+        & ~(uintptr_t)(POOL_SLAB_SIZE - 1);
+    size_t head = aligned - (uintptr_t)map;
+    if (head)
+        munmap(map, head);
+    if (map_size - head > POOL_SLAB_SIZE)
+        munmap((char *)aligned + POOL_SLAB_SIZE,
+               map_size - head - POOL_SLAB_SIZE);
+
+    struct slab *slab = (struct slab *)aligned;
+    slab->pool = pool;
+    slab->free_list = NULL;
+    slab->bump = 0;
+    slab->used = 0;
+    slab_link(pool, slab, SLAB_EMPTY);
+    pool->slab_count++;
+    pool->empty_slabs++;
+    return slab;
+}
+
+static void slab_release(struct pool *pool, struct slab *slab) {
+    slab_unlink(pool, slab);
+    if (slab->state == SLAB_EMPTY)
+        pool->empty_slabs--;
+    pool->slab_count--;
+    munmap(slab, POOL_SLAB_SIZE);
+}
+
+static void *slab_get(struct pool *pool) {
+    struct slab *slab = pool->slabs[SLAB_PARTIAL];
+    if (!slab)
+        slab = pool->slabs[SLAB_EMPTY];
+    if (!slab)
+        slab = slab_create(pool);
+    if (!slab)
+        return NULL;
+
+    void *obj = slab->free_list;
+    if (obj) {
+        slab->free_list = obj_next(obj);
+    } else {
+        obj = (char *)slab + pool->header_size
+            + slab->bump * pool->object_size;
+        slab->bump++;
+    }
+
+    slab->used++;
+    pool->slab_objects++;
+    if (!slab->free_list && slab->bump == pool->objects_per_slab)
+        slab_move(pool, slab, SLAB_FULL);
+    else
+        slab_move(pool, slab, SLAB_PARTIAL);
+    return obj;
+}
+
+static void slab_put(struct pool *pool, void *obj) {
+    struct slab *slab = obj_slab(obj);
+    obj_set_next(obj, slab->free_list);
+    slab->free_list = obj;
+    slab->used--;
+    pool->slab_objects--;
+    slab_move(pool, slab, slab->used ? SLAB_PARTIAL : SLAB_EMPTY);
+}
+
+static void slab_put_chain(struct pool *pool, void *chain) {
+    while (chain) {
+        void *next = obj_next(chain);
+        slab_put(pool, chain);
+        chain = next;
+    }
+}
+
+// ---------- Magazine Layer ---------- //
+static void magazine_destructor(void *data) {
+    struct magazine *mag = data;
+    struct pool *pool = mag->pool;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (size_t i = 0; i < mag->count; i++)
+        slab_put(pool, mag->objects[i]);
+    if (mag->prev)
+        mag->prev->next = mag->next;
+    else
+        pool->magazines = mag->next;
+    if (mag->next)
+        mag->next->prev = mag->prev;
+    pthread_mutex_unlock(&pool->mutex);
+
+    free(mag);
+}
+
+static struct magazine *magazine_get(struct pool *pool) {
+    struct magazine *mag = pthread_getspecific(pool->key);
+    if (mag)
+        return mag;
+
+    mag = malloc(sizeof(struct magazine));
+    if (!mag)
+        return NULL;
+    mag->pool = pool;
+    mag->count = 0;
+    mag->prev = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    mag->next = pool->magazines;
+    if (mag->next)
+        mag->next->prev = mag;
+    pool->magazines = mag;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (pthread_setspecific(pool->key, mag) != 0) {
+        magazine_destructor(mag);
+        return NULL;
+    }
+    return mag;
+}
+
+static bool magazine_refill(struct pool *pool, struct magazine *mag) {
+    const size_t target = POOL_MAGAZINE_SIZE / 2;
+
+    void *chain = remote_pop_all(pool);
+    while (chain && mag->count < target) {
+        mag->objects[mag->count++] = chain;
+        chain = obj_next(chain);
+    }
+
+    if (chain || mag->count < target) {
+        pthread_mutex_lock(&pool->mutex);
+        slab_put_chain(pool, chain);
+        while (mag->count < target) {
+            void *obj = slab_get(pool);
+            if (!obj)
+                break;
+            mag->objects[mag->count++] = obj;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    return mag->count > 0;
+}
+
+static void magazine_spill(struct pool *pool, struct magazine *mag) {
+    // Give back the oldest half: the most recently freed objects are the most
+    // likely to still be in the CPU cache.
+    const size_t half = POOL_MAGAZINE_SIZE / 2;
+    for (size_t i = 0; i + 1 < half; i++)
+        obj_set_next(mag->objects[i], mag->objects[i + 1]);
+    remote_push_chain(pool, mag->objects[0], mag->objects[half - 1]);
+
+    for (size_t i = half; i < mag->count; i++)
+        mag->objects[i - half] = mag->objects[i];
+    mag->count -= half;
+}
+
+// ---------- Pool Functions ---------- //
+struct pool *pool_create(size_t object_size) {
+    if (object_size == 0)
+        return NULL;
+
+    size_t align = object_size >= 16 ? 16 : sizeof(void *);
+    object_size = (object_size + align - 1) & ~(align - 1);
+
+    size_t header_size = (sizeof(struct slab) + CACHE_LINE_SIZE - 1)
+        & ~(size_t)(CACHE_LINE_SIZE - 1);
+    if (object_size > POOL_SLAB_SIZE - header_size)
+        return NULL;
+
+    struct pool *pool = calloc(1, sizeof(struct pool));
+    if (!pool)
+        return NULL;
+
+    pool->object_size = object_size;
+    pool->header_size = header_size;
+    pool->objects_per_slab = (POOL_SLAB_SIZE - header_size) / object_size;
+
+    if (pthread_key_create(&pool->key, magazine_destructor) != 0) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    return pool;
+}
+
+void pool_destroy(struct pool *pool) {
+    if (!pool)
+        return;
+
+    pthread_key_delete(pool->key);
+
+    struct magazine *mag = pool->magazines;
+    while (mag) {
+        struct magazine *next = mag->next;
+        free(mag);
+        mag = next;
+    }
+
+    for (size_t i = 0; i < sizeof(pool->slabs) / sizeof(pool->slabs[0]); i++) {
+        while (pool->slabs[i])
+            slab_release(pool, pool->slabs[i]);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+void *pool_alloc(struct pool *pool) {
+    struct magazine *mag = magazine_get(pool);
+    if (!mag) {
+        pthread_mutex_lock(&pool->mutex);
+        void *obj = slab_get(pool);
+        pthread_mutex_unlock(&pool->mutex);
+        return obj;
+    }
+
+    if (mag->count == 0 && !magazine_refill(pool, mag))
+        return NULL;
+    return mag->objects[--mag->count];
+}
+
+void pool_free(struct pool *pool, void *ptr) {
+    if (!ptr)
+        return;
+
+    struct magazine *mag = magazine_get(pool);
+    if (!mag) {
+        remote_push_chain(pool, ptr, ptr);
+        return;
+    }
+
+    if (mag->count == POOL_MAGAZINE_SIZE)
+        magazine_spill(pool, mag);
+    mag->objects[mag->count++] = ptr;
+}
+
+void pool_flush(struct pool *pool) {
+    struct magazine *mag = pthread_getspecific(pool->key);
+    if (!mag || !mag->count)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (size_t i = 0; i < mag->count; i++)
+        slab_put(pool, mag->objects[i]);
+    pthread_mutex_unlock(&pool->mutex);
+    mag->count = 0;
+}
+
+size_t pool_trim(struct pool *pool) {
+    size_t released = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    slab_put_chain(pool, remote_pop_all(pool));
+    while (pool->slabs[SLAB_EMPTY]) {
+        slab_release(pool, pool->slabs[SLAB_EMPTY]);
+        released++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return released;
+}
+
+void pool_get_stats(struct pool *pool, struct pool_stats *stats) {
+    pthread_mutex_lock(&pool->mutex);
+    stats->object_size = pool->object_size;
+    stats->objects_per_slab = pool->objects_per_slab;
+    stats->slabs = pool->slab_count;
+    stats->empty_slabs = pool->empty_slabs;
+    stats->slab_objects = pool->slab_objects;
+    pthread_mutex_unlock(&pool->mutex);
+}
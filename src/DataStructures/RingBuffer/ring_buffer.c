@@ -0,0 +1,427 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/data_structures/ring_buffer.h>
+
+#include <limits.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif // __linux__
+
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Design:
+ * - `tail` (producers) and `head` (consumers) are free running positions,
+ *   the slot of a position is `position & mask`.
+ * - The SPSC ring only publishes the indices: the producer owns `tail` and
+ *   keeps a cached copy of `head` (refreshed when the ring looks full), and
+ *   symmetrically for the consumer, so each side touches the other's cache
+ *   line once per wrap at best.
+ * - The other rings store a sequence number in each slot: a slot is free for
+ *   the producer of position p when its sequence is p, and holds an element
+ *   for the consumer of p when it is p + 1. Producers (resp. consumers) claim
+ *   positions with a compare exchange on `tail` (resp. `head`), batches claim
+ *   several consecutive ready slots at once.
+ * - Blocking waits use an event (sequence + waiter count): waiters register
+ *   then retry before sleeping on the sequence, and successful operations
+ *   bump the sequence only when someone waits.
+ */
+
+struct ring_event {
+    uint32_t seq;
+    uint32_t waiters;
+};
+
+struct ring {
+    size_t tail;
+    size_t cached_head; /**< SPSC producer copy of head */
+    char _pad_producer[CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+
+    size_t head;
+    size_t cached_tail; /**< SPSC consumer copy of tail */
+    char _pad_consumer[CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+
+    struct ring_event not_empty;
+    struct ring_event not_full;
+    size_t mask;
+    size_t element_size;
+    size_t slot_size;
+    unsigned char *slots;
+};
+
+struct spsc_ring {
+    struct ring ring;
+};
+
+struct mpsc_ring {
+    struct ring ring;
+};
+
+struct mpmc_ring {
+    struct ring ring;
+};
+
+typedef size_t (*ring_move_t)(struct ring *ring, void *elements, size_t count);
+
+// ---------- Futex Events ---------- //
+static void futex_wait(uint32_t *addr, uint32_t value,
+                       const struct timespec *timeout) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, timeout, NULL, 0);
+#else
+    (void)addr;
+    (void)value;
+    (void)timeout;
+    sched_yield();
+#endif // __linux__
+}
+
+static void futex_wake_all(uint32_t *addr) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif // __linux__
+}
+
+static void event_notify(struct ring_event *event) {
+    // orders the operation before the waiters check (pairs with event_wait)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&event->waiters, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&event->seq, 1, __ATOMIC_RELEASE);
+        futex_wake_all(&event->seq);
+    }
+}
+
+static struct timespec deadline_after(int timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+// Sets `remaining` to the time left before `deadline`, false if expired.
+static bool time_left(const struct timespec *deadline,
+                      struct timespec *remaining) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    remaining->tv_sec = deadline->tv_sec - now.tv_sec;
+    remaining->tv_nsec = deadline->tv_nsec - now.tv_nsec;
+    if (remaining->tv_nsec < 0) {
+        remaining->tv_sec--;
+        remaining->tv_nsec += 1000000000L;
+    }
+    return remaining->tv_sec >= 0
+        && (remaining->tv_sec > 0 || remaining->tv_nsec > 0);
+}
+
+static bool event_wait(struct ring_event *event, ring_move_t move,
+                       struct ring *ring, void *element, int timeout_ms) {
+    if (move(ring, element, 1))
+        return true;
+    if (timeout_ms == 0)
+        return false;
+
+    struct timespec deadline = { 0 };
+    struct timespec remaining;
+    if (timeout_ms > 0)
+        deadline = deadline_after(timeout_ms);
+
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&event->seq, __ATOMIC_ACQUIRE);
+        __atomic_add_fetch(&event->waiters, 1, __ATOMIC_SEQ_CST);
+        if (move(ring, element, 1)) {
+            __atomic_sub_fetch(&event->waiters, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+
+        bool expired = timeout_ms > 0 && !time_left(&deadline, &remaining);
+        if (!expired)
+            futex_wait(&event->seq, seq, timeout_ms > 0 ? &remaining : NULL);
+        __atomic_sub_fetch(&event->waiters, 1, __ATOMIC_RELAXED);
+
+        if (move(ring, element, 1))
+            return true;
+        if (expired)
+            return false;
+    }
+}
+
+// ---------- Ring Helpers ---------- //
+static inline size_t min_size(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+static struct ring *ring_create(size_t capacity, size_t element_size,
+                                bool sequenced) {
+    if (element_size == 0 || capacity > SIZE_MAX / 4)
+        return NULL;
+
+    size_t slots = 2;
+    while (slots < capacity)
+        slots *= 2;
+
+    size_t slot_size = element_size;
+    if (sequenced) {
+        // sequence number first, slots kept aligned for it
+        slot_size = sizeof(size_t)
+            + (element_size + sizeof(size_t) - 1) / sizeof(size_t)
+                * sizeof(size_t);
+    }
+    if (slot_size < element_size || slot_size > SIZE_MAX / slots)
+        return NULL;
+
+    void *memory;
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, sizeof(struct ring)) != 0)
+        return NULL;
+    struct ring *ring = memory;
+    memset(ring, 0, sizeof(struct ring));
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, slots * slot_size) != 0) {
+        free(ring);
+        return NULL;
+    }
+    ring->slots = memory;
+    ring->mask = slots - 1;
+    ring->element_size = element_size;
+    ring->slot_size = slot_size;
+
+    if (sequenced) {
+        for (size_t i = 0; i < slots; i++)
+            *(size_t *)(ring->slots + i * slot_size) = i;
+    }
+    return ring;
+}
+
+static void ring_destroy(struct ring *ring) {
+    if (!ring)
+        return;
+    free(ring->slots);
+    free(ring);
+}
+
+static size_t ring_size(const struct ring *ring) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    // tail may have moved on since head was read
+    return min_size(tail - head, ring->mask + 1);
+}
+
+static inline unsigned char *slot_at(struct ring *ring, size_t position) {
+    return ring->slots + (position & ring->mask) * ring->slot_size;
+}
+
+static inline size_t *slot_seq(struct ring *ring, size_t position) {
+    return (size_t *)slot_at(ring, position);
+}
+
+static inline unsigned char *slot_data(struct ring *ring, size_t position) {
+    return slot_at(ring, position) + sizeof(size_t);
+}
+
+// ---------- SPSC ---------- //
+// Copies `count` elements between `elements` and the slots from `position`.
+static void spsc_copy(struct ring *ring, size_t position, void *elements,
+                      size_t count, bool to_ring) {
+    size_t index = position & ring->mask;
+    size_t first = min_size(count, ring->mask + 1 - index);
+    unsigned char *bytes = elements;
+    unsigned char *slots = ring->slots;
+    size_t size = ring->element_size;
+
+    if (to_ring) {
+        memcpy(slots + index * size, bytes, first * size);
+        memcpy(slots, bytes + first * size, (count - first) * size);
+    } else {
+        memcpy(bytes, slots + index * size, first * size);
+        memcpy(bytes + first * size, slots, (count - first) * size);
+    }
+}
+
+static size_t spsc_push(struct ring *ring, void *elements, size_t count) {
+    size_t tail = ring->tail;
+    size_t capacity = ring->mask + 1;
+    if (capacity - (tail - ring->cached_head) < count)
+        ring->cached_head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    count = min_size(count, capacity - (tail - ring->cached_head));
+    if (count == 0)
+        return 0;
+    spsc_copy(ring, tail, elements, count, true);
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+    event_notify(&ring->not_empty);
+    return count;
+}
+
+static size_t spsc_pop(struct ring *ring, void *elements, size_t count) {
+    size_t head = ring->head;
+    if (ring->cached_tail - head < count)
+        ring->cached_tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    count = min_size(count, ring->cached_tail - head);
+    if (count == 0)
+        return 0;
+    spsc_copy(ring, head, elements, count, false);
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE);
+    event_notify(&ring->not_full);
+    return count;
+}
+
+// ---------- Sequenced Rings ---------- //
+/*
+ * Counts the consecutive slots from `position` whose sequence is
+ * `position + offset` (ready for the caller), up to `count`. When none is
+ * ready, `*behind` tells if the position is stale (another thread claimed it).
+ */
+static size_t ready_slots(struct ring *ring, size_t position, size_t offset,
+                          size_t count, bool *behind) {
+    size_t ready = 0;
+    while (ready < count) {
+        size_t expected = position + ready + offset;
+        size_t seq =
+            __atomic_load_n(slot_seq(ring, position + ready), __ATOMIC_ACQUIRE);
+        if (seq != expected) {
+            *behind = ready == 0 && (intptr_t)(seq - expected) > 0;
+            break;
+        }
+        ready++;
+    }
+    return ready;
+}
+
+static size_t seq_push(struct ring *ring, void *elements, size_t count) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t ready;
+    for (;;) {
+        bool behind = false;
+        ready = ready_slots(ring, tail, 0, count, &behind);
+        if (ready == 0 && !behind)
+            return 0; // full
+        if (ready
+            && __atomic_compare_exchange_n(&ring->tail, &tail, tail + ready,
+                                           true, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+            break;
+        if (ready == 0)
+            tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    }
+
+    const unsigned char *bytes = elements;
+    for (size_t i = 0; i < ready; i++) {
+        memcpy(slot_data(ring, tail + i), bytes + i * ring->element_size,
+               ring->element_size);
+        __atomic_store_n(slot_seq(ring, tail + i), tail + i + 1,
+                         __ATOMIC_RELEASE);
+    }
+    event_notify(&ring->not_empty);
+    return ready;
+}
+
+static void seq_release(struct ring *ring, size_t head, void *elements,
+                        size_t count) {
+    unsigned char *bytes = elements;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(bytes + i * ring->element_size, slot_data(ring, head + i),
+               ring->element_size);
+        __atomic_store_n(slot_seq(ring, head + i), head + i + ring->mask + 1,
+                         __ATOMIC_RELEASE);
+    }
+    event_notify(&ring->not_full);
+}
+
+static size_t mpmc_pop(struct ring *ring, void *elements, size_t count) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t ready;
+    for (;;) {
+        bool behind = false;
+        ready = ready_slots(ring, head, 1, count, &behind);
+        if (ready == 0 && !behind)
+            return 0; // empty
+        if (ready
+            && __atomic_compare_exchange_n(&ring->head, &head, head + ready,
+                                           true, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+            break;
+        if (ready == 0)
+            head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+
+    seq_release(ring, head, elements, ready);
+    return ready;
+}
+
+static size_t mpsc_pop(struct ring *ring, void *elements, size_t count) {
+    size_t head = ring->head;
+    bool behind = false;
+    size_t ready = ready_slots(ring, head, 1, count, &behind);
+    if (ready == 0)
+        return 0;
+
+    __atomic_store_n(&ring->head, head + ready, __ATOMIC_RELAXED);
+    seq_release(ring, head, elements, ready);
+    return ready;
+}
+
+// ---------- Ring Functions ---------- //
+#define RING_DEFINE(name, sequenced, push_impl, pop_impl)                      \
+    struct name *name##_create(size_t capacity, size_t element_size) {         \
+        return (struct name *)ring_create(capacity, element_size, sequenced);  \
+    }                                                                          \
+                                                                               \
+    void name##_destroy(struct name *ring) {                                   \
+        ring_destroy((struct ring *)ring);                                     \
+    }                                                                          \
+                                                                               \
+    bool name##_push(struct name *ring, const void *element) {                 \
+        return push_impl(&ring->ring, (void *)element, 1) == 1;                \
+    }                                                                          \
+                                                                               \
+    bool name##_pop(struct name *ring, void *element) {                        \
+        return pop_impl(&ring->ring, element, 1) == 1;                         \
+    }                                                                          \
+                                                                               \
+    size_t name##_push_n(struct name *ring, const void *elements,              \
+                         size_t count) {                                       \
+        return push_impl(&ring->ring, (void *)elements, count);                \
+    }                                                                          \
+                                                                               \
+    size_t name##_pop_n(struct name *ring, void *elements, size_t count) {     \
+        return pop_impl(&ring->ring, elements, count);                         \
+    }                                                                          \
+                                                                               \
+    bool name##_push_wait(struct name *ring, const void *element,              \
+                          int timeout_ms) {                                    \
+        return event_wait(&ring->ring.not_full, push_impl, &ring->ring,        \
+                          (void *)element, timeout_ms);                        \
+    }                                                                          \
+                                                                               \
+    bool name##_pop_wait(struct name *ring, void *element, int timeout_ms) {   \
+        return event_wait(&ring->ring.not_empty, pop_impl, &ring->ring,        \
+                          element, timeout_ms);                                \
+    }                                                                          \
+                                                                               \
+    size_t name##_size(const struct name *ring) {                              \
+        return ring_size(&ring->ring);                                         \
+    }                                                                          \
+                                                                               \
+    size_t name##_capacity(const struct name *ring) {                          \
+        return ring->ring.mask + 1;                                            \
+    }
+
+RING_DEFINE(spsc_ring, false, spsc_push, spsc_pop)
+RING_DEFINE(mpsc_ring, true, seq_push, mpsc_pop)
+RING_DEFINE(mpmc_ring, true, seq_push, mpmc_pop)
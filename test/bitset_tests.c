@@ -0,0 +1,298 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/bitset.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+TestSuite(bitset, .timeout = 10);
+
+static uint64_t xorshift(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Random bitset with about one bit out of density set, and its bools.
+static void random_fill(struct bitset *set, bool *bools, size_t density,
+                        uint64_t seed) {
+    uint64_t state = seed;
+    for (size_t i = 0; i < set->bits; i++) {
+        bools[i] = xorshift(&state) % density == 0;
+        if (bools[i])
+            bitset_set(set, i);
+    }
+}
+
+Test(bitset, set_clear_test_count) {
+    struct bitset set;
+    cr_assert(bitset_init(&set, 1000003, NULL));
+    cr_assert_eq(bitset_count(&set), 0);
+    cr_assert_eq(bitset_next(&set, 0), BITSET_NPOS);
+
+    for (size_t i = 0; i < set.bits; i += 3)
+        bitset_set(&set, i);
+    cr_assert(bitset_test(&set, 999999));
+    cr_assert_not(bitset_test(&set, 1000000));
+    cr_assert_eq(bitset_count(&set), 333335);
+
+    bitset_clear(&set, 999999);
+    bitset_flip(&set, 1000001);
+    bitset_flip(&set, 3);
+    cr_assert_not(bitset_test(&set, 3));
+    cr_assert_eq(bitset_count(&set), 333334);
+    cr_assert_eq(bitset_next(&set, 1), 6);
+    cr_assert_eq(bitset_next(&set, 999997), 1000001);
+
+    bitset_fill(&set, true);
+    cr_assert_eq(bitset_count(&set), 1000003, "Padding bits must stay zero.");
+    bitset_fill(&set, false);
+    cr_assert_eq(bitset_count(&set), 0);
+
+    bitset_deinit(&set);
+    cr_assert_null(set.words);
+}
+
+Test(bitset, resize) {
+    struct bitset set;
+    cr_assert(bitset_init(&set, 0, NULL));
+    cr_assert_eq(bitset_count(&set), 0);
+    struct bitset_iter iter = bitset_iter(&set);
+    size_t index;
+    cr_assert_not(bitset_iter_next(&iter, &index));
+
+    cr_assert(bitset_resize(&set, 100));
+    bitset_fill(&set, true);
+    cr_assert(bitset_resize(&set, 70));
+    cr_assert_eq(bitset_count(&set), 70);
+    cr_assert(bitset_resize(&set, 1000));
+    cr_assert_eq(bitset_count(&set), 70, "New bits must be cleared.");
+    cr_assert_not(bitset_test(&set, 70));
+    cr_assert(bitset_resize(&set, 0));
+    cr_assert_eq(bitset_count(&set), 0);
+    bitset_deinit(&set);
+}
+
+Test(bitset, iteration) {
+    enum { BITS = 100000 };
+    static bool bools[BITS];
+    struct bitset set;
+    cr_assert(bitset_init(&set, BITS, NULL));
+    random_fill(&set, bools, 7, 1);
+
+    struct bitset_iter iter = bitset_iter(&set);
+    size_t index;
+    size_t expected = 0;
+    while (bitset_iter_next(&iter, &index)) {
+        while (!bools[expected])
+            expected++;
+        cr_assert_eq(index, expected);
+        cr_assert_eq(bitset_next(&set, index), index);
+        expected++;
+    }
+    for (; expected < BITS; expected++)
+        cr_assert_not(bools[expected]);
+    bitset_deinit(&set);
+}
+
+Test(bitset, set_operations_match_reference) {
+    enum { BITS = 50021, SMALL = 30011 };
+    static bool a_bools[BITS], b_bools[BITS];
+    struct bitset a, b, dst;
+    cr_assert(bitset_init(&a, BITS, NULL));
+    cr_assert(bitset_init(&b, BITS, NULL));
+    random_fill(&a, a_bools, 2, 1);
+    random_fill(&b, b_bools, 3, 2);
+
+    size_t expected = 0;
+    for (size_t i = 0; i < BITS; i++)
+        expected += a_bools[i] && b_bools[i];
+    cr_assert_eq(bitset_and_count(&a, &b), expected);
+
+    void (*ops[])(struct bitset *, const struct bitset *) = {
+        bitset_and, bitset_or, bitset_xor, bitset_andnot
+    };
+    for (size_t op = 0; op < 4; op++) {
+        // same size, and a smaller destination
+        size_t sizes[] = { BITS, SMALL };
+        for (size_t s = 0; s < 2; s++) {
+            cr_assert(bitset_init(&dst, sizes[s], NULL));
+            for (size_t i = 0; i < dst.bits; i++) {
+                if (a_bools[i])
+                    bitset_set(&dst, i);
+            }
+            ops[op](&dst, &b);
+            size_t count = 0;
+            for (size_t i = 0; i < dst.bits; i++) {
+                bool x = a_bools[i];
+                bool y = b_bools[i];
+                bool want = op == 0 ? x && y
+                            : op == 1 ? x || y
+                            : op == 2 ? x != y
+                                      : x && !y;
+                cr_assert_eq(bitset_test(&dst, i), want, "op %zu bit %zu",
+                             op, i);
+                count += want;
+            }
+            cr_assert_eq(bitset_count(&dst), count);
+            bitset_deinit(&dst);
+        }
+    }
+
+    // a smaller source: and clears the rest of the destination
+    cr_assert(bitset_init(&dst, SMALL, NULL));
+    bitset_fill(&dst, true);
+    bitset_and(&a, &dst);
+    size_t count = 0;
+    for (size_t i = 0; i < SMALL; i++)
+        count += a_bools[i];
+    cr_assert_eq(bitset_count(&a), count);
+    bitset_deinit(&dst);
+
+    bitset_deinit(&a);
+    bitset_deinit(&b);
+}
+
+Test(bitset, rank_select) {
+    enum { BITS = 70001 };
+    static bool bools[BITS];
+    struct bitset set;
+    cr_assert(bitset_init(&set, BITS, NULL));
+    random_fill(&set, bools, 5, 3);
+
+    for (int indexed = 0; indexed < 2; indexed++) {
+        if (indexed)
+            cr_assert(bitset_build_rank(&set));
+        size_t rank = 0;
+        for (size_t i = 0; i <= BITS; i++) {
+            if (i % 7 == 0 || i == BITS)
+                cr_assert_eq(bitset_rank(&set, i), rank, "rank(%zu)", i);
+            if (i < BITS && bools[i]) {
+                if (rank % 3 == 0)
+                    cr_assert_eq(bitset_select(&set, rank), i);
+                rank++;
+            }
+        }
+        cr_assert_eq(bitset_select(&set, rank), BITSET_NPOS);
+        cr_assert_eq(bitset_select(&set, rank + 100), BITSET_NPOS);
+    }
+
+    // rebuilding after a modification
+    bitset_fill(&set, true);
+    cr_assert(bitset_build_rank(&set));
+    cr_assert_eq(bitset_rank(&set, 12345), 12345);
+    cr_assert_eq(bitset_select(&set, 54321), 54321);
+    bitset_deinit(&set);
+}
+
+Test(bitset, roaring_random_operations) {
+    enum { UNIVERSE = 1 << 19 }; // 8 containers
+    static bool bools[UNIVERSE];
+    struct roaring set;
+    roaring_init(&set, NULL);
+    uint64_t state = 99;
+    uint64_t count = 0;
+
+    for (int i = 0; i < 300000; i++) {
+        uint32_t value = (uint32_t)(xorshift(&state) % UNIVERSE);
+        // container 0 gets dense (bitmaps), the others stay sparse
+        if (i % 2)
+            value %= 1 << 16;
+        bool add = xorshift(&state) % 4 != 0;
+        if (i > 200000)
+            add = !add; // shrink the dense containers back to arrays
+        if (add) {
+            cr_assert(roaring_add(&set, value));
+            count += !bools[value];
+            bools[value] = true;
+        } else {
+            cr_assert_eq(roaring_remove(&set, value), bools[value]);
+            count -= bools[value];
+            bools[value] = false;
+        }
+    }
+    cr_assert_eq(roaring_count(&set), count);
+
+    struct roaring_iter iter = roaring_iter(&set);
+    uint32_t value;
+    uint32_t expected = 0;
+    while (roaring_iter_next(&iter, &value)) {
+        while (!bools[expected])
+            expected++;
+        cr_assert_eq(value, expected);
+        expected++;
+    }
+    for (; expected < UNIVERSE; expected++)
+        cr_assert_not(bools[expected]);
+    for (uint32_t v = 0; v < UNIVERSE; v += 13)
+        cr_assert_eq(roaring_contains(&set, v), bools[v]);
+    cr_assert_not(roaring_contains(&set, UINT32_MAX));
+
+    roaring_deinit(&set);
+    cr_assert_eq(roaring_count(&set), 0);
+}
+
+static void check_roaring(const struct roaring *set, const bool *bools,
+                          uint32_t universe) {
+    uint64_t count = 0;
+    for (uint32_t v = 0; v < universe; v++) {
+        cr_assert_eq(roaring_contains(set, v), bools[v], "value %u", v);
+        count += bools[v];
+    }
+    cr_assert_eq(roaring_count(set), count);
+}
+
+Test(bitset, roaring_and_or) {
+    enum { UNIVERSE = 1 << 18 };
+    static bool a_bools[UNIVERSE], b_bools[UNIVERSE], want[UNIVERSE];
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+
+    struct roaring a, b, dst;
+    roaring_init(&a, NULL);
+    roaring_init(&b, NULL);
+    roaring_init(&dst, &allocator);
+
+    // container 0: dense & dense, 1: dense & sparse, 2: sparse & sparse,
+    // 3: only in a
+    uint64_t state = 5;
+    for (uint32_t v = 0; v < UNIVERSE; v++) {
+        uint32_t container = v >> 16;
+        uint64_t r = xorshift(&state);
+        a_bools[v] = container == 2 ? r % 50 == 0 : r % 2 == 0;
+        b_bools[v] = container == 0   ? (r >> 8) % 3 == 0
+                     : container == 3 ? false
+                                      : (r >> 8) % 40 == 0;
+        if (a_bools[v])
+            cr_assert(roaring_add(&a, v));
+        if (b_bools[v])
+            cr_assert(roaring_add(&b, v));
+    }
+
+    cr_assert(roaring_and(&dst, &a, &b));
+    for (uint32_t v = 0; v < UNIVERSE; v++)
+        want[v] = a_bools[v] && b_bools[v];
+    check_roaring(&dst, want, UNIVERSE);
+
+    cr_assert(roaring_or(&dst, &a, &b));
+    for (uint32_t v = 0; v < UNIVERSE; v++)
+        want[v] = a_bools[v] || b_bools[v];
+    check_roaring(&dst, want, UNIVERSE);
+
+    // results keep working as regular sets
+    cr_assert(roaring_add(&dst, UNIVERSE + 1));
+    cr_assert(roaring_remove(&dst, UNIVERSE + 1));
+
+    struct roaring empty;
+    roaring_init(&empty, NULL);
+    cr_assert(roaring_and(&dst, &a, &empty));
+    cr_assert_eq(roaring_count(&dst), 0);
+    cr_assert(roaring_or(&dst, &empty, &b));
+    check_roaring(&dst, b_bools, UNIVERSE);
+
+    roaring_deinit(&a);
+    roaring_deinit(&b);
+    roaring_deinit(&dst);
+    arena_destroy(arena);
+}
@@ -0,0 +1,334 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/btree.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+BTREE_DECL(uint64_t, double, u64tree, btree_default_cmp)
+BTREE_DECL(const char *, int, strtree, btree_string_cmp)
+
+TestSuite(btree, .timeout = 10);
+
+// Checks the node fill, the key order and that every leaf has the same depth.
+static size_t check_node(const struct u64tree_node *node, unsigned depth,
+                         unsigned height, bool root, const uint64_t *low,
+                         const uint64_t *high) {
+    if (!root && !node->leaf)
+        cr_assert_geq(node->count + 1, u64tree_min_keys, "Inner underflow.");
+    if (!root && node->leaf)
+        cr_assert_geq(node->count, u64tree_min_keys, "Leaf underflow.");
+    cr_assert_leq(node->count, u64tree_order);
+    for (unsigned i = 0; i < node->count; i++) {
+        if (i)
+            cr_assert_lt(node->keys[i - 1], node->keys[i]);
+        if (low)
+            cr_assert_geq(node->keys[i], *low);
+        if (high)
+            cr_assert_lt(node->keys[i], *high);
+    }
+    if (node->leaf) {
+        cr_assert_eq(depth, height, "Unbalanced tree.");
+        return node->count;
+    }
+
+    size_t size = 0;
+    for (unsigned i = 0; i <= node->count; i++) {
+        size += check_node(node->u.children[i], depth + 1, height, false,
+                           i ? &node->keys[i - 1] : low,
+                           i < node->count ? &node->keys[i] : high);
+    }
+    return size;
+}
+
+static void check_tree(const struct u64tree *tree) {
+    if (!tree->root) {
+        cr_assert_eq(tree->size, 0);
+        cr_assert_eq(tree->height, 0);
+        return;
+    }
+    cr_assert_eq(check_node(tree->root, 1, tree->height, true, NULL, NULL),
+                 tree->size);
+}
+
+static uint64_t xorshift(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+Test(btree, empty_tree) {
+    struct u64tree tree;
+    u64tree_init(&tree, NULL);
+
+    cr_assert_null(u64tree_find(&tree, 42));
+    cr_assert_not(u64tree_remove(&tree, 42, NULL));
+    struct u64tree_iter iter = u64tree_first(&tree);
+    cr_assert_not(u64tree_iter_next(&iter, NULL, NULL));
+    iter = u64tree_lower_bound(&tree, 42);
+    cr_assert_not(u64tree_iter_next(&iter, NULL, NULL));
+    check_tree(&tree);
+
+    u64tree_deinit(&tree);
+}
+
+Test(btree, put_find_overwrite) {
+    struct u64tree tree;
+    u64tree_init(&tree, NULL);
+
+    for (uint64_t i = 0; i < 100000; i++)
+        cr_assert(u64tree_put(&tree, i * 7, (double)i));
+    cr_assert_eq(tree.size, 100000);
+    check_tree(&tree);
+
+    for (uint64_t i = 0; i < 100000; i++) {
+        double *value = u64tree_find(&tree, i * 7);
+        cr_assert_not_null(value);
+        cr_assert_eq(*value, (double)i);
+        cr_assert_not(u64tree_contains(&tree, i * 7 + 1));
+    }
+
+    bool inserted = true;
+    double *value = u64tree_emplace(&tree, 7, &inserted);
+    cr_assert_not(inserted);
+    cr_assert_eq(*value, 1.0);
+    cr_assert(u64tree_put(&tree, 7, -1.0));
+    cr_assert_eq(*u64tree_find(&tree, 7), -1.0);
+    cr_assert_eq(tree.size, 100000);
+
+    u64tree_deinit(&tree);
+    cr_assert_null(tree.root);
+    cr_assert_eq(tree.size, 0);
+}
+
+Test(btree, descending_inserts_and_ordered_iteration) {
+    struct u64tree tree;
+    u64tree_init(&tree, NULL);
+
+    for (uint64_t i = 50000; i-- > 0;)
+        cr_assert(u64tree_put(&tree, i, (double)i * 2));
+    check_tree(&tree);
+
+    struct u64tree_iter iter = u64tree_first(&tree);
+    const uint64_t *key;
+    double *value;
+    uint64_t expected = 0;
+    while (u64tree_iter_next(&iter, &key, &value)) {
+        cr_assert_eq(*key, expected);
+        cr_assert_eq(*value, (double)expected * 2);
+        expected++;
+    }
+    cr_assert_eq(expected, 50000);
+
+    u64tree_deinit(&tree);
+}
+
+Test(btree, random_operations_match_reference) {
+    enum { KEYS = 4096 };
+    static bool present[KEYS];
+    static double values[KEYS];
+    size_t size = 0;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    struct u64tree tree;
+    u64tree_init(&tree, NULL);
+
+    for (int i = 0; i < 200000; i++) {
+        uint64_t key = xorshift(&state) % KEYS;
+        // insert-heavy first, then remove-heavy
+        bool insert = xorshift(&state) % 100 < (i < 100000 ? 70 : 30);
+        if (insert) {
+            cr_assert(u64tree_put(&tree, key, (double)i));
+            size += !present[key];
+            present[key] = true;
+            values[key] = (double)i;
+        } else {
+            double removed = 0;
+            cr_assert_eq(u64tree_remove(&tree, key, &removed), present[key]);
+            if (present[key])
+                cr_assert_eq(removed, values[key]);
+            size -= present[key];
+            present[key] = false;
+        }
+        cr_assert_eq(tree.size, size);
+        if (i % 10000 == 0)
+            check_tree(&tree);
+    }
+    check_tree(&tree);
+
+    for (uint64_t key = 0; key < KEYS; key++) {
+        double *value = u64tree_find(&tree, key);
+        cr_assert_eq(value != NULL, present[key]);
+        if (value)
+            cr_assert_eq(*value, values[key]);
+    }
+
+    for (uint64_t key = 0; key < KEYS; key++) {
+        cr_assert_eq(u64tree_remove(&tree, key, NULL), present[key]);
+        if (key % 512 == 0)
+            check_tree(&tree);
+    }
+    cr_assert_eq(tree.size, 0);
+    cr_assert_null(tree.root);
+
+    u64tree_deinit(&tree);
+}
+
+Test(btree, lower_bound_range) {
+    struct u64tree tree;
+    u64tree_init(&tree, NULL);
+
+    for (uint64_t i = 0; i < 10000; i++)
+        cr_assert(u64tree_put(&tree, i * 10, (double)i));
+
+    for (uint64_t from = 0; from < 100005; from += 997) {
+        struct u64tree_iter iter = u64tree_lower_bound(&tree, from);
+        const uint64_t *key;
+        uint64_t expected = (from + 9) / 10 * 10;
+        size_t seen = 0;
+        while (u64tree_iter_next(&iter, &key, NULL) && *key < from + 500) {
+            cr_assert_eq(*key, expected);
+            expected += 10;
+            seen++;
+        }
+        if (from + 500 <= 99990)
+            cr_assert_eq(seen, 50);
+    }
+
+    struct u64tree_iter iter = u64tree_lower_bound(&tree, 99991);
+    cr_assert_not(u64tree_iter_next(&iter, NULL, NULL));
+
+    u64tree_deinit(&tree);
+}
+
+Test(btree, bulk_load) {
+    enum { COUNT = 100000 };
+    static struct u64tree_entry entries[COUNT];
+    for (uint64_t i = 0; i < COUNT; i++)
+        entries[i] = (struct u64tree_entry){ i * 2, (double)i };
+
+    for (size_t count = 0; count < 2000; count += 37) {
+        struct u64tree tree;
+        u64tree_init(&tree, NULL);
+        cr_assert(u64tree_bulk_load(&tree, entries, count));
+        cr_assert_eq(tree.size, count);
+        check_tree(&tree);
+        u64tree_deinit(&tree);
+    }
+
+    struct u64tree tree;
+    u64tree_init(&tree, NULL);
+    cr_assert(u64tree_bulk_load(&tree, entries, COUNT));
+    cr_assert_eq(tree.size, COUNT);
+    check_tree(&tree);
+    cr_assert_not(u64tree_bulk_load(&tree, entries, COUNT), "Tree not empty.");
+
+    for (uint64_t i = 0; i < COUNT; i++)
+        cr_assert_eq(*u64tree_find(&tree, i * 2), (double)i);
+
+    // the loaded tree keeps working with updates
+    for (uint64_t i = 0; i < COUNT; i += 3)
+        cr_assert(u64tree_put(&tree, i * 2 + 1, -1.0));
+    for (uint64_t i = 0; i < COUNT; i += 2)
+        cr_assert(u64tree_remove(&tree, i * 2, NULL));
+    check_tree(&tree);
+    cr_assert_eq(tree.size, COUNT + (COUNT + 2) / 3 - COUNT / 2);
+    u64tree_deinit(&tree);
+
+    // unsorted or duplicated input
+    u64tree_init(&tree, NULL);
+    struct u64tree_entry unsorted[] = { { 1, 0 }, { 3, 0 }, { 2, 0 } };
+    cr_assert_not(u64tree_bulk_load(&tree, unsorted, 3));
+    struct u64tree_entry duplicated[] = { { 1, 0 }, { 1, 0 } };
+    cr_assert_not(u64tree_bulk_load(&tree, duplicated, 2));
+    cr_assert_null(tree.root);
+    u64tree_deinit(&tree);
+}
+
+// Fails every allocation after a budget, counts the live blocks.
+struct failing_allocator {
+    size_t budget;
+    size_t live;
+};
+
+static void *failing_realloc(void *ctx, void *ptr, size_t old_size,
+                             size_t new_size) {
+    (void)old_size;
+    struct failing_allocator *failing = ctx;
+    if (!failing->budget)
+        return NULL;
+    failing->budget--;
+    void *block = realloc(ptr, new_size);
+    if (block && !ptr)
+        failing->live++;
+    return block;
+}
+
+static void failing_free(void *ctx, void *ptr, size_t size) {
+    (void)size;
+    struct failing_allocator *failing = ctx;
+    if (ptr)
+        failing->live--;
+    free(ptr);
+}
+
+Test(btree, bulk_load_allocation_failure) {
+    enum { COUNT = 5000 };
+    static struct u64tree_entry entries[COUNT];
+    for (uint64_t i = 0; i < COUNT; i++)
+        entries[i] = (struct u64tree_entry){ i, (double)i };
+
+    struct failing_allocator failing = { 0 };
+    struct allocator allocator = { failing_realloc, failing_free, &failing };
+    for (size_t budget = 0;; budget++) {
+        failing = (struct failing_allocator){ budget, 0 };
+        struct u64tree tree;
+        u64tree_init(&tree, &allocator);
+        bool loaded = u64tree_bulk_load(&tree, entries, COUNT);
+        if (loaded) {
+            cr_assert_eq(tree.size, COUNT);
+            check_tree(&tree);
+        } else {
+            cr_assert_null(tree.root);
+            cr_assert_eq(failing.live, 0, "Leak with budget %zu.", budget);
+        }
+        u64tree_deinit(&tree);
+        cr_assert_eq(failing.live, 0);
+        if (loaded)
+            break;
+    }
+}
+
+Test(btree, string_keys_with_arena) {
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+
+    struct strtree tree;
+    strtree_init(&tree, &allocator);
+
+    static char keys[1000][8];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "k%04d", (i * 389) % 1000);
+        cr_assert(strtree_put(&tree, keys[i], (i * 389) % 1000));
+    }
+    cr_assert_eq(tree.size, 1000);
+
+    cr_assert_eq(*strtree_find(&tree, "k0042"), 42);
+    cr_assert_null(strtree_find(&tree, "k1000"));
+
+    struct strtree_iter iter = strtree_lower_bound(&tree, "k0990");
+    const char *const *key;
+    int *value;
+    int expected = 990;
+    while (strtree_iter_next(&iter, &key, &value)) {
+        cr_assert_eq(*value, expected);
+        expected++;
+    }
+    cr_assert_eq(expected, 1000);
+
+    strtree_deinit(&tree);
+    arena_destroy(arena);
+}
@@ -0,0 +1,197 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/cache.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+TestSuite(cache, .timeout = 10);
+
+static size_t key_of(char *buffer, unsigned i) {
+    return (size_t)sprintf(buffer, "key:%u", i);
+}
+
+Test(cache, put_get_remove) {
+    struct cache *cache = cache_create(1 << 16, 4, CACHE_CLOCK);
+    cr_assert_not_null(cache);
+
+    cr_assert(cache_put(cache, "answer", 6, "42", 3, 0));
+    char value[8] = { 0 };
+    size_t size = sizeof(value);
+    cr_assert(cache_get(cache, "answer", 6, value, &size));
+    cr_assert_eq(size, 3);
+    cr_assert_str_eq(value, "42");
+
+    // replace with a longer value, read it into a short buffer
+    cr_assert(cache_put(cache, "answer", 6, "forty-two", 10, 0));
+    size = 5;
+    memset(value, 0, sizeof(value));
+    cr_assert(cache_get(cache, "answer", 6, value, &size));
+    cr_assert_eq(size, 10);
+    cr_assert_eq(memcmp(value, "forty", 5), 0);
+    cr_assert_eq(value[5], 0);
+    cr_assert(cache_get(cache, "answer", 6, NULL, NULL));
+
+    struct cache_stats stats = cache_stats_read(cache);
+    cr_assert_eq(stats.count, 1);
+    cr_assert_eq(stats.weight, 16);
+    cr_assert_eq(stats.insertions, 2);
+
+    cr_assert(cache_remove(cache, "answer", 6));
+    cr_assert_not(cache_remove(cache, "answer", 6));
+    cr_assert_not(cache_get(cache, "answer", 6, NULL, NULL));
+
+    stats = cache_stats_read(cache);
+    cr_assert_eq(stats.hits, 3);
+    cr_assert_eq(stats.misses, 1);
+    cr_assert_eq(stats.count, 0);
+    cr_assert_eq(stats.weight, 0);
+    cache_destroy(cache);
+}
+
+Test(cache, weight_bound) {
+    const enum cache_policy policies[] = { CACHE_CLOCK, CACHE_S3FIFO };
+    for (size_t p = 0; p < 2; p++) {
+        struct cache *cache = cache_create(10000, 2, policies[p]);
+        cr_assert_not_null(cache);
+        cr_assert_not(cache_put(cache, "big", 3, NULL, 0, 5001),
+                      "Entry heavier than a shard.");
+
+        char key[32];
+        for (unsigned i = 0; i < 5000; i++) {
+            size_t length = key_of(key, i);
+            cr_assert(
+                cache_put(cache, key, length, &i, sizeof(i), 10 + i % 90));
+            struct cache_stats stats = cache_stats_read(cache);
+            cr_assert_leq(stats.weight, 10000);
+        }
+        struct cache_stats stats = cache_stats_read(cache);
+        cr_assert_eq(stats.insertions, 5000);
+        cr_assert_eq(stats.evictions + stats.count, 5000);
+        cr_assert_gt(stats.weight, 9000, "Cache should be almost full.");
+
+        // most recent key is still there
+        unsigned value = 0;
+        size_t size = sizeof(value);
+        cr_assert(cache_get(cache, key, strlen(key), &value, &size));
+        cr_assert_eq(value, 4999);
+        cache_destroy(cache);
+    }
+}
+
+Test(cache, clock_second_chance) {
+    struct cache *cache = cache_create(100, 1, CACHE_CLOCK);
+    cr_assert_not_null(cache);
+    char key[32];
+    for (unsigned i = 0; i < 10; i++)
+        cr_assert(cache_put(cache, key, key_of(key, i), NULL, 0, 10));
+    cr_assert(cache_get(cache, "key:0", 5, NULL, NULL));
+
+    // key:0 was hit: key:1 is evicted instead
+    cr_assert(cache_put(cache, "new", 3, NULL, 0, 10));
+    cr_assert(cache_get(cache, "key:0", 5, NULL, NULL));
+    cr_assert_not(cache_get(cache, "key:1", 5, NULL, NULL));
+    cache_destroy(cache);
+}
+
+Test(cache, s3fifo_scan_resistance) {
+    enum { HOT = 50, SCAN = 20000 };
+    struct cache *cache = cache_create(1000, 1, CACHE_S3FIFO);
+    cr_assert_not_null(cache);
+    char key[32];
+
+    // hot keys hit twice, then a long scan of keys never read again
+    for (unsigned i = 0; i < HOT; i++)
+        cr_assert(cache_put(cache, key, key_of(key, i), NULL, 0, 10));
+    for (unsigned i = 0; i < HOT; i++)
+        cr_assert(cache_get(cache, key, key_of(key, i), NULL, NULL));
+    for (unsigned i = HOT; i < HOT + SCAN; i++) {
+        cr_assert(cache_put(cache, key, key_of(key, i), NULL, 0, 10));
+        if (i % 100 == 0) // keep the hot keys hot
+            for (unsigned j = 0; j < HOT; j++)
+                cache_get(cache, key, key_of(key, j), NULL, NULL);
+    }
+
+    unsigned kept = 0;
+    for (unsigned i = 0; i < HOT; i++)
+        kept += cache_get(cache, key, key_of(key, i), NULL, NULL);
+    cr_assert_eq(kept, HOT, "Only %u hot keys survived the scan.", kept);
+
+    // a key evicted from the small queue comes back to the main queue
+    cr_assert(cache_put(cache, "ghost", 5, NULL, 0, 10));
+    for (unsigned i = 0; i < 100; i++)
+        cr_assert(cache_put(cache, key, key_of(key, SCAN + HOT + i), NULL, 0,
+                            10));
+    cr_assert_not(cache_get(cache, "ghost", 5, NULL, NULL));
+    cr_assert(cache_put(cache, "ghost", 5, NULL, 0, 10));
+    for (unsigned i = 100; i < 300; i++)
+        cr_assert(cache_put(cache, key, key_of(key, SCAN + HOT + i), NULL, 0,
+                            10));
+    cr_assert(cache_get(cache, "ghost", 5, NULL, NULL));
+    cache_destroy(cache);
+}
+
+static char logged[512];
+
+static void capture(enum log_level level, const char *colored,
+                    const char *raw) {
+    (void)level;
+    (void)colored;
+    snprintf(logged, sizeof(logged), "%s", raw);
+}
+
+Test(cache, log_stats) {
+    struct cache *cache = cache_create(1000, 0, CACHE_S3FIFO);
+    cr_assert_not_null(cache);
+    cr_assert(cache_put(cache, "a", 1, "1", 1, 0));
+    cr_assert(cache_get(cache, "a", 1, NULL, NULL));
+    cr_assert_not(cache_get(cache, "b", 1, NULL, NULL));
+
+    logger_set_log_level(LOG_FULL);
+    logger_set_callback(capture);
+    cache_log_stats(cache, LOG_INFO, "test");
+    logger_set_callback(NULL);
+    cr_assert_not_null(strstr(logged, "cache test: 1 hits, 1 misses (50.0%"),
+                       "Unexpected message: %s", logged);
+    cr_assert_not_null(strstr(logged, "1 entries, weight 2/1000"),
+                       "Unexpected message: %s", logged);
+    cache_destroy(cache);
+}
+
+static struct cache *shared_cache;
+
+static void *worker(void *arg) {
+    unsigned seed = (unsigned)(uintptr_t)arg;
+    char key[32];
+    for (unsigned i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned k = (seed >> 16) % 2000;
+        size_t length = key_of(key, k);
+        unsigned value = 0;
+        size_t size = sizeof(value);
+        if (cache_get(shared_cache, key, length, &value, &size))
+            cr_assert_eq(value, k);
+        else
+            cache_put(shared_cache, key, length, &k, sizeof(k), 0);
+        if (i % 97 == 0)
+            cache_remove(shared_cache, key, length);
+    }
+    return NULL;
+}
+
+Test(cache, concurrent_access) {
+    enum { THREADS = 4 };
+    shared_cache = cache_create(8000, 8, CACHE_S3FIFO);
+    cr_assert_not_null(shared_cache);
+    pthread_t threads[THREADS];
+    for (uintptr_t i = 0; i < THREADS; i++)
+        cr_assert_eq(pthread_create(&threads[i], NULL, worker, (void *)i), 0);
+    for (size_t i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    struct cache_stats stats = cache_stats_read(shared_cache);
+    cr_assert_eq(stats.hits + stats.misses, THREADS * 20000);
+    cr_assert_leq(stats.weight, 8000);
+    cr_assert_gt(stats.hits, 0);
+    cache_destroy(shared_cache);
+}
@@ -0,0 +1,149 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/concurrent_map.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+TestSuite(concurrent_map, .timeout = 10);
+
+static void *int_value(uintptr_t value) {
+    return (void *)(value + 1);
+}
+
+Test(concurrent_map, put_get_remove) {
+    struct cmap *map = cmap_create(0);
+    cr_assert_not_null(map);
+
+    void *value = NULL;
+    cr_assert_not(cmap_get(map, "missing", 7, &value));
+
+    void *previous = int_value(0);
+    cr_assert(cmap_put(map, "key", 3, int_value(1), &previous));
+    cr_assert_null(previous, "A new key has no previous value.");
+    cr_assert(cmap_get(map, "key", 3, &value));
+    cr_assert_eq(value, int_value(1));
+
+    cr_assert(cmap_put(map, "key", 3, int_value(2), &previous));
+    cr_assert_eq(previous, int_value(1));
+    cr_assert_eq(cmap_size(map), 1);
+
+    cr_assert_not(cmap_get(map, "ke", 2, NULL), "Keys must be compared on their full length.");
+
+    cr_assert(cmap_remove(map, "key", 3, &value));
+    cr_assert_eq(value, int_value(2));
+    cr_assert_not(cmap_remove(map, "key", 3, NULL));
+    cr_assert_eq(cmap_size(map), 0);
+
+    cmap_destroy(map);
+    cmap_destroy(NULL);
+}
+
+Test(concurrent_map, grow_and_remove_many) {
+    struct cmap *map = cmap_create(0);
+    cr_assert_not_null(map);
+
+    for (uintptr_t i = 0; i < 50000; i++)
+        cr_assert(cmap_put(map, &i, sizeof(i), int_value(i), NULL));
+    cr_assert_eq(cmap_size(map), 50000);
+
+    for (uintptr_t i = 0; i < 50000; i++) {
+        void *value;
+        cr_assert(cmap_get(map, &i, sizeof(i), &value), "Key %lu lost after resizing.", (unsigned long)i);
+        cr_assert_eq(value, int_value(i));
+    }
+
+    for (uintptr_t i = 0; i < 50000; i += 2)
+        cr_assert(cmap_remove(map, &i, sizeof(i), NULL));
+    cr_assert_eq(cmap_size(map), 25000);
+    for (uintptr_t i = 0; i < 50000; i++)
+        cr_assert_eq(cmap_get(map, &i, sizeof(i), NULL), i % 2 == 1);
+
+    cmap_destroy(map);
+}
+
+static void count_visit(const void *key, size_t key_length, void *value, void *ctx) {
+    (void)key;
+    cr_assert_eq(key_length, sizeof(uintptr_t));
+    uintptr_t *sum = ctx;
+    *sum += (uintptr_t)value - 1;
+}
+
+Test(concurrent_map, for_each) {
+    struct cmap *map = cmap_create(1000);
+    cr_assert_not_null(map);
+
+    for (uintptr_t i = 0; i < 1000; i++)
+        cr_assert(cmap_put(map, &i, sizeof(i), int_value(i), NULL));
+
+    uintptr_t sum = 0;
+    cmap_for_each(map, count_visit, &sum);
+    cr_assert_eq(sum, 999 * 1000 / 2);
+
+    cmap_destroy(map);
+}
+
+#define WRITERS 3
+#define READERS 3
+#define KEYS 20000
+
+static struct cmap *shared_map;
+static int stop_readers;
+
+static void *writer(void *arg) {
+    uintptr_t id = (uintptr_t)arg;
+    for (uintptr_t i = id; i < KEYS; i += WRITERS) {
+        if (!cmap_put(shared_map, &i, sizeof(i), int_value(i), NULL))
+            return NULL;
+    }
+    // churn the odd keys to exercise reclamation
+    for (uintptr_t i = id; i < KEYS; i += WRITERS) {
+        if (i % 2 && !cmap_remove(shared_map, &i, sizeof(i), NULL))
+            return NULL;
+    }
+    return arg;
+}
+
+static void *reader(void *arg) {
+    uintptr_t errors = 0;
+    while (!__atomic_load_n(&stop_readers, __ATOMIC_RELAXED)) {
+        for (uintptr_t i = 0; i < KEYS; i += 7) {
+            void *value;
+            if (cmap_get(shared_map, &i, sizeof(i), &value) && value != int_value(i))
+                errors++;
+        }
+    }
+    (void)arg;
+    return (void *)errors;
+}
+
+Test(concurrent_map, concurrent_readers_writers) {
+    shared_map = cmap_create(0);
+    cr_assert_not_null(shared_map);
+
+    pthread_t writers[WRITERS];
+    pthread_t readers[READERS];
+    for (uintptr_t i = 0; i < READERS; i++)
+        pthread_create(&readers[i], NULL, reader, NULL);
+    for (uintptr_t i = 0; i < WRITERS; i++)
+        pthread_create(&writers[i], NULL, writer, (void *)(i + 1));
+
+    for (int i = 0; i < WRITERS; i++) {
+        void *ret;
+        pthread_join(writers[i], &ret);
+        cr_assert_not_null(ret, "Writer %d failed.", i);
+    }
+    __atomic_store_n(&stop_readers, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < READERS; i++) {
+        void *errors;
+        pthread_join(readers[i], &errors);
+        cr_assert_null(errors, "Reader %d saw wrong values.", i);
+    }
+
+    // writer ids start at 1: key 0 was never inserted
+    cr_assert_eq(cmap_size(shared_map), (KEYS - 1) / 2);
+    for (uintptr_t i = 1; i < KEYS; i++)
+        cr_assert_eq(cmap_get(shared_map, &i, sizeof(i), NULL), i % 2 == 0);
+
+    cmap_destroy(shared_map);
+}
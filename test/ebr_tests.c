@@ -0,0 +1,253 @@
+#include <criterion/criterion.h>
+#include <ayaztub/concurrency/ebr.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/pool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+TestSuite(ebr, .timeout = 10);
+
+struct object {
+    struct ebr_node ebr;
+    int value;
+};
+
+static int freed;
+
+static void object_free(struct ebr_node *node) {
+    __atomic_add_fetch(&freed, 1, __ATOMIC_RELAXED);
+    free(node);
+}
+
+static struct object *object_new(int value) {
+    struct object *object = malloc(sizeof(struct object));
+    cr_assert_not_null(object);
+    object->value = value;
+    return object;
+}
+
+Test(ebr, retire_and_synchronize) {
+    for (int i = 0; i < 10; i++)
+        ebr_retire(&object_new(i)->ebr, object_free);
+    cr_assert_eq(ebr_pending(), 10);
+    cr_assert_eq(freed, 0, "Objects must not be freed right away.");
+
+    ebr_synchronize();
+    cr_assert_eq(freed, 10);
+    cr_assert_eq(ebr_pending(), 0);
+}
+
+Test(ebr, batched_reclamation) {
+    for (int i = 0; i < 10 * EBR_BATCH_SIZE; i++)
+        ebr_retire(&object_new(i)->ebr, object_free);
+    cr_assert_gt(freed, 0, "Batches must be reclaimed without synchronize.");
+    cr_assert_lt(ebr_pending(), 3 * EBR_BATCH_SIZE);
+
+    ebr_synchronize();
+    cr_assert_eq(freed, 10 * EBR_BATCH_SIZE);
+}
+
+Test(ebr, synchronize_in_critical_section) {
+    ebr_enter();
+    ebr_enter();
+    ebr_retire(&object_new(0)->ebr, object_free);
+    ebr_exit();
+    ebr_synchronize(); // still inside the outer section: must not wait
+    cr_assert_eq(freed, 0);
+    ebr_exit();
+
+    ebr_synchronize();
+    cr_assert_eq(freed, 1);
+}
+
+static struct object *shared;
+static int reader_state; // 1: in critical section, 2: may exit
+
+static void *reader(void *arg) {
+    ebr_enter();
+    struct object *object = __atomic_load_n(&shared, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&reader_state, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&reader_state, __ATOMIC_ACQUIRE) != 2)
+        ;
+    intptr_t value = object->value;
+    ebr_exit();
+    (void)arg;
+    return (void *)value;
+}
+
+Test(ebr, reader_blocks_reclamation) {
+    shared = object_new(42);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, reader, NULL);
+    while (__atomic_load_n(&reader_state, __ATOMIC_ACQUIRE) != 1)
+        ;
+
+    struct object *old =
+        __atomic_exchange_n(&shared, object_new(43), __ATOMIC_ACQ_REL);
+    ebr_retire(&old->ebr, object_free);
+    for (int i = 0; i < 10; i++)
+        ebr_collect();
+    cr_assert_eq(freed, 0, "An object seen by a reader must not be freed.");
+
+    __atomic_store_n(&reader_state, 2, __ATOMIC_RELEASE);
+    void *value;
+    pthread_join(thread, &value);
+    cr_assert_eq((intptr_t)value, 42);
+
+    ebr_synchronize();
+    cr_assert_eq(freed, 1);
+    free(shared);
+}
+
+static void *retire_and_exit(void *arg) {
+    for (int i = 0; i < 5; i++)
+        ebr_retire(&object_new(i)->ebr, object_free);
+    return arg;
+}
+
+Test(ebr, exited_thread_objects) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, retire_and_exit, NULL);
+    pthread_join(thread, NULL);
+
+    ebr_synchronize();
+    cr_assert_eq(freed, 5, "Objects of exited threads must be adopted.");
+}
+
+static int new_freed;
+static int step; // handshake between the main thread and old_retirer
+
+static void new_object_free(struct ebr_node *node) {
+    __atomic_add_fetch(&new_freed, 1, __ATOMIC_RELAXED);
+    free(node);
+}
+
+static void wait_step(int value) {
+    while (__atomic_load_n(&step, __ATOMIC_ACQUIRE) != value)
+        sched_yield();
+}
+
+// Retires at three successive epochs (one per limbo list), then exits.
+static void *old_retirer(void *arg) {
+    for (int i = 0; i < 3; i++) {
+        ebr_retire(&object_new(i)->ebr, object_free);
+        __atomic_store_n(&step, 2 * i + 1, __ATOMIC_RELEASE);
+        wait_step(2 * i + 2);
+    }
+    wait_step(7);
+    return arg;
+}
+
+static void *retire_new_and_exit(void *arg) {
+    ebr_retire(&object_new(0)->ebr, new_object_free);
+    return arg;
+}
+
+static void *pinned_reader(void *arg) {
+    ebr_enter();
+    __atomic_store_n(&reader_state, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&reader_state, __ATOMIC_ACQUIRE) != 2)
+        sched_yield();
+    ebr_exit();
+    return arg;
+}
+
+// The old lists of an exiting thread must not free the newer orphans that
+// share their limbo slot.
+Test(ebr, old_orphans_keep_newer_ones) {
+    pthread_t old_thread;
+    pthread_create(&old_thread, NULL, old_retirer, NULL);
+    for (int i = 0; i < 3; i++) {
+        wait_step(2 * i + 1);
+        ebr_collect(); // next epoch
+        __atomic_store_n(&step, 2 * i + 2, __ATOMIC_RELEASE);
+    }
+    for (int i = 0; i < 3; i++)
+        ebr_collect();
+
+    pthread_t reader_thread;
+    pthread_create(&reader_thread, NULL, pinned_reader, NULL);
+    while (__atomic_load_n(&reader_state, __ATOMIC_ACQUIRE) != 1)
+        ;
+    // orphans at the epoch of the reader and the next one
+    for (int i = 0; i < 2; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, retire_new_and_exit, NULL);
+        pthread_join(thread, NULL);
+        ebr_collect();
+    }
+
+    __atomic_store_n(&step, 7, __ATOMIC_RELEASE);
+    pthread_join(old_thread, NULL);
+    ebr_collect();
+    cr_assert_eq(new_freed, 0, "Orphans seen by a reader must not be freed.");
+
+    __atomic_store_n(&reader_state, 2, __ATOMIC_RELEASE);
+    pthread_join(reader_thread, NULL);
+    ebr_synchronize();
+    cr_assert_eq(new_freed, 2);
+    cr_assert_eq(freed, 3);
+}
+
+Test(ebr, retire_pool_and_arena) {
+    struct pool *pool = pool_create(sizeof(int));
+    cr_assert_not_null(pool);
+    int *object = pool_alloc(pool);
+    cr_assert_not_null(object);
+    cr_assert(ebr_retire_ptr(object, ebr_free_pool_object, pool));
+
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+    cr_assert_not_null(arena_alloc(arena, 100));
+    cr_assert(ebr_retire_ptr(arena, ebr_free_arena, NULL));
+    cr_assert(ebr_retire_ptr(malloc(10), ebr_free_malloc, NULL));
+    cr_assert_eq(ebr_pending(), 3);
+
+    ebr_synchronize();
+    cr_assert_eq(ebr_pending(), 0);
+
+    struct pool_stats stats;
+    pool_flush(pool);
+    pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.slab_objects, 0, "The object must be back in its pool.");
+    pool_destroy(pool);
+}
+
+#define THREADS 4
+#define ROUNDS 20000
+
+static void *swapper(void *arg) {
+    for (int i = 0; i < ROUNDS; i++) {
+        ebr_enter();
+        struct object *object = __atomic_load_n(&shared, __ATOMIC_ACQUIRE);
+        int value = object->value;
+        ebr_exit();
+        if (value < 0)
+            return NULL;
+
+        struct object *old =
+            __atomic_exchange_n(&shared, object_new(i), __ATOMIC_ACQ_REL);
+        ebr_retire(&old->ebr, object_free);
+    }
+    return arg;
+}
+
+Test(ebr, concurrent_swaps) {
+    shared = object_new(0);
+
+    pthread_t threads[THREADS];
+    for (uintptr_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, swapper, (void *)(i + 1));
+    for (int i = 0; i < THREADS; i++) {
+        void *ret;
+        pthread_join(threads[i], &ret);
+        cr_assert_not_null(ret);
+    }
+
+    ebr_synchronize();
+    cr_assert_eq(freed, THREADS * ROUNDS);
+    free(shared);
+}
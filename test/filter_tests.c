@@ -0,0 +1,213 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/filter.h>
+#include <ayaztub/data_structures/hashmap.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+TestSuite(filter, .timeout = 10);
+
+// Items i and absent items (i | 1 << 40) hashed like real keys.
+static uint64_t item(uint64_t i) {
+    return hashmap_hash_u64(i);
+}
+
+static uint64_t absent(uint64_t i) {
+    return hashmap_hash_u64(i | UINT64_C(1) << 40);
+}
+
+Test(filter, bloom_membership) {
+    enum { COUNT = 100000 };
+    struct bloom filter;
+    cr_assert(bloom_init(&filter, COUNT, 10, NULL));
+    for (uint64_t i = 0; i < COUNT; i++)
+        bloom_add(&filter, item(i));
+
+    for (uint64_t i = 0; i < COUNT; i++)
+        cr_assert(bloom_contains(&filter, item(i)), "False negative.");
+    size_t false_positives = 0;
+    for (uint64_t i = 0; i < COUNT; i++)
+        false_positives += bloom_contains(&filter, absent(i));
+    cr_assert_lt(false_positives, COUNT / 50, "%zu false positives.",
+                 false_positives);
+
+    bloom_deinit(&filter);
+}
+
+Test(filter, bloom_batch) {
+    enum { COUNT = 10000 };
+    static uint64_t hashes[COUNT];
+    static bool results[COUNT];
+    struct bloom filter;
+    cr_assert(bloom_init(&filter, COUNT, 12, NULL));
+    for (uint64_t i = 0; i < COUNT; i++) {
+        hashes[i] = i % 2 ? item(i) : absent(i);
+        if (i % 2)
+            bloom_add(&filter, item(i));
+    }
+
+    size_t hits = bloom_contains_batch(&filter, hashes, COUNT, results);
+    size_t expected = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        cr_assert_eq(results[i], bloom_contains(&filter, hashes[i]));
+        expected += results[i];
+    }
+    cr_assert_eq(hits, expected);
+    cr_assert_geq(hits, COUNT / 2);
+    cr_assert_eq(bloom_contains_batch(&filter, hashes, COUNT, NULL), hits);
+    bloom_deinit(&filter);
+}
+
+Test(filter, bloom_serialization) {
+    struct bloom filter;
+    cr_assert(bloom_init(&filter, 5000, 10, NULL));
+    for (uint64_t i = 0; i < 5000; i++)
+        bloom_add(&filter, item(i));
+
+    size_t size = bloom_serialized_size(&filter);
+    cr_assert_eq(size % 64, 0);
+    uint64_t *buffer = malloc(size + 8);
+    cr_assert_not_null(buffer);
+    cr_assert_not(bloom_serialize(&filter, buffer, size - 1));
+    cr_assert(bloom_serialize(&filter, buffer, size));
+
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+    struct bloom view, copy;
+    cr_assert(bloom_view(&view, buffer, size));
+    cr_assert(bloom_load(&copy, buffer, size, &allocator));
+    for (uint64_t i = 0; i < 20000; i++) {
+        uint64_t hash = i < 5000 ? item(i) : absent(i);
+        bool expected = bloom_contains(&filter, hash);
+        cr_assert_eq(bloom_contains(&view, hash), expected);
+        cr_assert_eq(bloom_contains(&copy, hash), expected);
+    }
+    bloom_add(&copy, absent(1));
+    cr_assert(bloom_contains(&copy, absent(1)));
+    bloom_deinit(&view);
+    bloom_deinit(&copy);
+
+    // invalid data
+    cr_assert_not(bloom_view(&view, buffer, size - 8), "Truncated.");
+    cr_assert_not(bloom_view(&view, (char *)buffer + 4, size), "Misaligned.");
+    memmove((char *)buffer + 1, buffer, size);
+    cr_assert(bloom_load(&copy, (char *)buffer + 1, size, NULL),
+              "Load accepts unaligned data.");
+    bloom_deinit(&copy);
+    ((char *)buffer)[1] = 'X';
+    cr_assert_not(bloom_load(&copy, (char *)buffer + 1, size, NULL),
+                  "Bad magic.");
+
+    struct cuckoo cuckoo;
+    cr_assert(bloom_serialize(&filter, buffer, size));
+    cr_assert_not(cuckoo_view(&cuckoo, buffer, size), "Wrong filter kind.");
+
+    free(buffer);
+    arena_destroy(arena);
+    bloom_deinit(&filter);
+}
+
+Test(filter, cuckoo_membership_and_removal) {
+    enum { COUNT = 100000 };
+    struct cuckoo filter;
+    cr_assert(cuckoo_init(&filter, COUNT, NULL));
+    for (uint64_t i = 0; i < COUNT; i++)
+        cr_assert(cuckoo_add(&filter, item(i)), "Full at %lu.",
+                  (unsigned long)i);
+    cr_assert_eq(filter.count, COUNT);
+
+    for (uint64_t i = 0; i < COUNT; i++)
+        cr_assert(cuckoo_contains(&filter, item(i)), "False negative.");
+    size_t false_positives = 0;
+    for (uint64_t i = 0; i < COUNT; i++)
+        false_positives += cuckoo_contains(&filter, absent(i));
+    cr_assert_lt(false_positives, COUNT / 1000, "%zu false positives.",
+                 false_positives);
+
+    for (uint64_t i = 0; i < COUNT; i += 2)
+        cr_assert(cuckoo_remove(&filter, item(i)));
+    cr_assert_eq(filter.count, COUNT / 2);
+    size_t still_there = 0;
+    for (uint64_t i = 0; i < COUNT; i++) {
+        if (i % 2)
+            cr_assert(cuckoo_contains(&filter, item(i)), "False negative.");
+        else
+            still_there += cuckoo_contains(&filter, item(i));
+    }
+    cr_assert_lt(still_there, COUNT / 1000);
+
+    cuckoo_deinit(&filter);
+}
+
+Test(filter, cuckoo_full_and_duplicates) {
+    struct cuckoo filter;
+    cr_assert(cuckoo_init(&filter, 1000, NULL));
+    uint64_t added = 0;
+    while (cuckoo_add(&filter, item(added)))
+        added++;
+    cr_assert_geq(added, 1000, "Full at %lu.", (unsigned long)added);
+    cr_assert_eq(filter.count, added);
+    for (uint64_t i = 0; i < added; i++)
+        cr_assert(cuckoo_contains(&filter, item(i)), "Lost item %lu.",
+                  (unsigned long)i);
+
+    // room again after a removal
+    cr_assert(cuckoo_remove(&filter, item(0)));
+    cr_assert(cuckoo_add(&filter, item(0)));
+    for (uint64_t i = 0; i < added; i++)
+        cr_assert(cuckoo_contains(&filter, item(i)));
+    cuckoo_deinit(&filter);
+
+    cr_assert(cuckoo_init(&filter, 1000, NULL));
+    cr_assert(cuckoo_add(&filter, item(7)));
+    cr_assert(cuckoo_add(&filter, item(7)));
+    cr_assert(cuckoo_remove(&filter, item(7)));
+    cr_assert(cuckoo_contains(&filter, item(7)));
+    cr_assert(cuckoo_remove(&filter, item(7)));
+    cr_assert_not(cuckoo_contains(&filter, item(7)));
+    cr_assert_not(cuckoo_remove(&filter, item(7)));
+    cuckoo_deinit(&filter);
+}
+
+Test(filter, cuckoo_batch_and_serialization) {
+    enum { COUNT = 20000 };
+    static uint64_t hashes[COUNT];
+    static bool results[COUNT];
+    struct cuckoo filter;
+    cr_assert(cuckoo_init(&filter, COUNT, NULL));
+    for (uint64_t i = 0; i < COUNT; i++) {
+        hashes[i] = i % 3 ? absent(i) : item(i);
+        if (i % 3 == 0)
+            cr_assert(cuckoo_add(&filter, item(i)));
+    }
+
+    size_t hits = cuckoo_contains_batch(&filter, hashes, COUNT, results);
+    for (size_t i = 0; i < COUNT; i++)
+        cr_assert_eq(results[i], cuckoo_contains(&filter, hashes[i]));
+    cr_assert_geq(hits, (COUNT + 2) / 3);
+
+    size_t size = cuckoo_serialized_size(&filter);
+    uint64_t *buffer = malloc(size);
+    cr_assert_not_null(buffer);
+    cr_assert(cuckoo_serialize(&filter, buffer, size));
+
+    struct cuckoo view, copy;
+    cr_assert(cuckoo_view(&view, buffer, size));
+    cr_assert(cuckoo_load(&copy, buffer, size, NULL));
+    cr_assert_eq(view.count, filter.count);
+    cr_assert_eq(cuckoo_contains_batch(&view, hashes, COUNT, NULL), hits);
+    cr_assert_eq(cuckoo_contains_batch(&copy, hashes, COUNT, NULL), hits);
+
+    // the copy is independent from the original
+    cr_assert(cuckoo_remove(&copy, item(0)));
+    cr_assert(cuckoo_contains(&filter, item(0)));
+    cuckoo_deinit(&copy);
+    cuckoo_deinit(&view);
+
+    struct bloom bloom;
+    cr_assert_not(bloom_view(&bloom, buffer, size), "Wrong filter kind.");
+    free(buffer);
+    cuckoo_deinit(&filter);
+}
@@ -0,0 +1,190 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/hashmap.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+HASHMAP_DECL(uint64_t, uint64_t, u64map, hashmap_hash_u64, hashmap_default_eq)
+HASHMAP_DECL(const char *, int, strmap, hashmap_hash_string, hashmap_string_eq)
+
+// Every key collides: forces long probe sequences and tombstones.
+static inline uint64_t bad_hash(uint64_t key) {
+    return key & 0x7f;
+}
+
+HASHMAP_DECL(uint64_t, int, badmap, bad_hash, hashmap_default_eq)
+
+TestSuite(hashmap, .timeout = 5);
+
+Test(hashmap, empty_map) {
+    struct u64map map;
+    u64map_init(&map, NULL);
+
+    cr_assert_null(u64map_find(&map, 42));
+    cr_assert_not(u64map_remove(&map, 42, NULL));
+    size_t iter = 0;
+    cr_assert_null(u64map_next(&map, &iter));
+
+    u64map_clear(&map);
+    u64map_deinit(&map);
+}
+
+Test(hashmap, put_find_overwrite) {
+    struct u64map map;
+    u64map_init(&map, NULL);
+
+    for (uint64_t i = 0; i < 100000; i++)
+        cr_assert(u64map_put(&map, i * 7, i));
+    cr_assert_eq(map.size, 100000);
+    cr_assert_leq(map.size, map.capacity - map.capacity / 8, "Load factor exceeded.");
+
+    for (uint64_t i = 0; i < 100000; i++) {
+        uint64_t *value = u64map_find(&map, i * 7);
+        cr_assert_not_null(value, "Key %lu not found.", (unsigned long)(i * 7));
+        cr_assert_eq(*value, i);
+        cr_assert_not(u64map_contains(&map, i * 7 + 1));
+    }
+
+    cr_assert(u64map_put(&map, 7, 1234));
+    cr_assert_eq(map.size, 100000, "Overwriting must not add an entry.");
+    cr_assert_eq(*u64map_find(&map, 7), 1234);
+
+    u64map_deinit(&map);
+}
+
+Test(hashmap, emplace) {
+    struct u64map map;
+    u64map_init(&map, NULL);
+
+    bool inserted;
+    uint64_t *value = u64map_emplace(&map, 1, &inserted);
+    cr_assert_not_null(value);
+    cr_assert(inserted);
+    *value = 10;
+
+    value = u64map_emplace(&map, 1, &inserted);
+    cr_assert_not(inserted);
+    cr_assert_eq(*value, 10);
+
+    u64map_deinit(&map);
+}
+
+Test(hashmap, remove_and_reinsert) {
+    struct u64map map;
+    u64map_init(&map, NULL);
+
+    for (uint64_t i = 0; i < 10000; i++)
+        cr_assert(u64map_put(&map, i, i + 1));
+
+    for (uint64_t i = 0; i < 10000; i += 2) {
+        uint64_t value = 0;
+        cr_assert(u64map_remove(&map, i, &value));
+        cr_assert_eq(value, i + 1);
+    }
+    cr_assert_eq(map.size, 5000);
+
+    for (uint64_t i = 0; i < 10000; i++)
+        cr_assert_eq(u64map_contains(&map, i), i % 2 == 1, "Wrong membership for %lu.", (unsigned long)i);
+
+    // churn: tombstones must be purged instead of growing the table forever
+    size_t capacity = map.capacity;
+    for (int round = 0; round < 50; round++) {
+        for (uint64_t i = 0; i < 10000; i += 2)
+            cr_assert(u64map_put(&map, 100000 + round * 10000 + i, i));
+        for (uint64_t i = 0; i < 10000; i += 2)
+            cr_assert(u64map_remove(&map, 100000 + round * 10000 + i, NULL));
+    }
+    cr_assert_eq(map.size, 5000);
+    cr_assert_leq(map.capacity, 2 * capacity, "Churn should not grow the table forever.");
+
+    u64map_deinit(&map);
+}
+
+Test(hashmap, colliding_hashes) {
+    struct badmap map;
+    badmap_init(&map, NULL);
+
+    for (uint64_t i = 0; i < 2000; i++)
+        cr_assert(badmap_put(&map, i, (int)i));
+    for (uint64_t i = 0; i < 2000; i += 3)
+        cr_assert(badmap_remove(&map, i, NULL));
+    for (uint64_t i = 0; i < 2000; i++) {
+        int *value = badmap_find(&map, i);
+        if (i % 3 == 0) {
+            cr_assert_null(value);
+        } else {
+            cr_assert_not_null(value);
+            cr_assert_eq(*value, (int)i);
+        }
+    }
+    for (uint64_t i = 0; i < 2000; i += 3)
+        cr_assert(badmap_put(&map, i, -1));
+    cr_assert_eq(map.size, 2000);
+
+    badmap_deinit(&map);
+}
+
+Test(hashmap, string_keys_and_iteration) {
+    struct strmap map;
+    strmap_init(&map, NULL);
+
+    static char keys[500][16];
+    for (int i = 0; i < 500; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key-%d", i);
+        cr_assert(strmap_put(&map, keys[i], i));
+    }
+
+    char lookup[16];
+    snprintf(lookup, sizeof(lookup), "key-%d", 123);
+    cr_assert_not_null(strmap_find(&map, lookup), "Lookup must compare string contents.");
+    cr_assert_eq(*strmap_find(&map, lookup), 123);
+
+    long sum = 0;
+    size_t count = 0;
+    size_t iter = 0;
+    struct strmap_entry *entry;
+    while ((entry = strmap_next(&map, &iter))) {
+        sum += entry->value;
+        count++;
+    }
+    cr_assert_eq(count, 500);
+    cr_assert_eq(sum, 499 * 500 / 2);
+
+    strmap_clear(&map);
+    cr_assert_eq(map.size, 0);
+    cr_assert_null(strmap_find(&map, lookup));
+
+    strmap_deinit(&map);
+}
+
+Test(hashmap, reserve_and_arena) {
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+
+    struct u64map map;
+    u64map_init(&map, &allocator);
+    cr_assert(u64map_reserve(&map, 1000));
+    size_t capacity = map.capacity;
+    cr_assert_geq(capacity - capacity / 8, 1000);
+
+    for (uint64_t i = 0; i < 1000; i++)
+        cr_assert(u64map_put(&map, i, i));
+    cr_assert_eq(map.capacity, capacity, "Reserved map must not rehash.");
+
+    u64map_deinit(&map);
+    arena_destroy(arena);
+}
+
+Test(hashmap, group_helpers) {
+    uint8_t ctrl[HASHMAP_GROUP_WIDTH];
+    memset(ctrl, HASHMAP_CTRL_EMPTY, sizeof(ctrl));
+    ctrl[3] = 0x11;
+    ctrl[9] = 0x11;
+    ctrl[10] = HASHMAP_CTRL_DELETED;
+
+    cr_assert_eq(hashmap_group_match(ctrl, 0x11), (1u << 3) | (1u << 9));
+    cr_assert_eq(hashmap_group_match_empty(ctrl), 0xffffu & ~((1u << 3) | (1u << 9) | (1u << 10)));
+    cr_assert_eq(hashmap_group_match_free(ctrl), 0xffffu & ~((1u << 3) | (1u << 9)));
+}
@@ -0,0 +1,252 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/heap.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct job {
+    uint64_t deadline;
+    int id;
+};
+
+#define job_less(a, b) ((a).deadline < (b).deadline)
+#define u64_greater(a, b) ((a) > (b))
+
+HEAP_DECL(uint64_t, u64heap, heap_default_less)
+HEAP_DECL_ARITY(uint64_t, u64binheap, heap_default_less, 2)
+HEAP_DECL_ARITY(uint64_t, u64maxheap, u64_greater, 8)
+INDEXED_HEAP_DECL(uint64_t, u64iheap, heap_default_less)
+INDEXED_HEAP_DECL_ARITY(struct job, job_queue, job_less, 3)
+
+TestSuite(heap, .timeout = 10);
+
+static uint64_t xorshift(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+Test(heap, empty_heap) {
+    struct u64heap heap;
+    u64heap_init(&heap, NULL);
+    cr_assert_null(u64heap_top(&heap));
+    cr_assert_not(u64heap_pop(&heap, NULL));
+    cr_assert(u64heap_push_batch(&heap, NULL, 0));
+    u64heap_deinit(&heap);
+
+    struct u64iheap iheap;
+    u64iheap_init(&iheap, NULL);
+    cr_assert_null(u64iheap_top(&iheap, NULL));
+    cr_assert_not(u64iheap_pop(&iheap, NULL, NULL));
+    cr_assert_not(u64iheap_contains(&iheap, 0));
+    cr_assert_null(u64iheap_get(&iheap, 0));
+    cr_assert_not(u64iheap_update(&iheap, 0, 1));
+    cr_assert_not(u64iheap_remove(&iheap, 0, NULL));
+    u64iheap_deinit(&iheap);
+}
+
+Test(heap, heap_sort_matches_qsort) {
+    enum { COUNT = 50000 };
+    static uint64_t values[COUNT];
+    uint64_t state = 42;
+    for (size_t i = 0; i < COUNT; i++)
+        values[i] = xorshift(&state) % 10000; // with duplicates
+
+    struct u64heap heap;
+    struct u64binheap binheap;
+    struct u64maxheap maxheap;
+    u64heap_init(&heap, NULL);
+    u64binheap_init(&binheap, NULL);
+    u64maxheap_init(&maxheap, NULL);
+    for (size_t i = 0; i < COUNT; i++) {
+        cr_assert(u64heap_push(&heap, values[i]));
+        cr_assert(u64binheap_push(&binheap, values[i]));
+        cr_assert(u64maxheap_push(&maxheap, values[i]));
+    }
+    cr_assert_eq(heap.size, COUNT);
+
+    qsort(values, COUNT, sizeof(uint64_t), cmp_u64);
+    for (size_t i = 0; i < COUNT; i++) {
+        uint64_t value = 0;
+        cr_assert_eq(*u64heap_top(&heap), values[i]);
+        cr_assert(u64heap_pop(&heap, &value));
+        cr_assert_eq(value, values[i]);
+        cr_assert(u64binheap_pop(&binheap, &value));
+        cr_assert_eq(value, values[i]);
+        cr_assert(u64maxheap_pop(&maxheap, &value));
+        cr_assert_eq(value, values[COUNT - 1 - i]);
+    }
+    cr_assert_eq(heap.size, 0);
+
+    u64heap_deinit(&heap);
+    u64binheap_deinit(&binheap);
+    u64maxheap_deinit(&maxheap);
+}
+
+Test(heap, push_batch_and_replace_top) {
+    enum { COUNT = 10000 };
+    static uint64_t values[COUNT];
+    uint64_t state = 7;
+    for (size_t i = 0; i < COUNT; i++)
+        values[i] = xorshift(&state) % 100000;
+
+    struct u64heap heap;
+    u64heap_init(&heap, NULL);
+    // heapified batch, then batches small enough to be sifted one by one
+    cr_assert(u64heap_push_batch(&heap, values, COUNT / 2));
+    for (size_t i = COUNT / 2; i < COUNT; i += 100)
+        cr_assert(u64heap_push_batch(&heap, values + i, 100));
+    cr_assert_eq(heap.size, COUNT);
+
+    qsort(values, COUNT, sizeof(uint64_t), cmp_u64);
+    // replacing the top with a bigger value keeps the order
+    u64heap_replace_top(&heap, UINT64_MAX);
+    for (size_t i = 1; i < COUNT; i++) {
+        uint64_t value;
+        cr_assert(u64heap_pop(&heap, &value));
+        cr_assert_eq(value, values[i]);
+    }
+    cr_assert_eq(*u64heap_top(&heap), UINT64_MAX);
+
+    u64heap_clear(&heap);
+    cr_assert_null(u64heap_top(&heap));
+    u64heap_deinit(&heap);
+}
+
+Test(heap, indexed_random_operations) {
+    enum { OPS = 100000, HANDLES = 4096 };
+    static uint64_t expected[HANDLES];
+    static bool alive[HANDLES];
+    size_t size = 0;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    struct u64iheap heap;
+    u64iheap_init(&heap, NULL);
+
+    for (int i = 0; i < OPS; i++) {
+        uint64_t op = xorshift(&state) % 10;
+        uint64_t value = xorshift(&state) % 1000000;
+        if (op < 4 && size < HANDLES) {
+            uint32_t handle = u64iheap_push(&heap, value);
+            cr_assert_lt(handle, HANDLES);
+            cr_assert_not(alive[handle], "Handle in use.");
+            alive[handle] = true;
+            expected[handle] = value;
+            size++;
+        } else if (op < 6 && size) {
+            uint64_t popped;
+            uint32_t handle;
+            cr_assert(u64iheap_pop(&heap, &popped, &handle));
+            cr_assert(alive[handle]);
+            cr_assert_eq(popped, expected[handle]);
+            for (uint32_t h = 0; h < HANDLES; h += 97) {
+                if (alive[h])
+                    cr_assert_geq(expected[h], popped);
+            }
+            alive[handle] = false;
+            size--;
+        } else {
+            uint32_t handle = (uint32_t)(xorshift(&state) % HANDLES);
+            cr_assert_eq(u64iheap_contains(&heap, handle), alive[handle]);
+            if (!alive[handle])
+                continue;
+            cr_assert_eq(*u64iheap_get(&heap, handle), expected[handle]);
+            if (op < 8) {
+                cr_assert(u64iheap_update(&heap, handle, value));
+                expected[handle] = value;
+            } else if (op < 9) {
+                value = expected[handle] / 2;
+                cr_assert(u64iheap_decrease_key(&heap, handle, value));
+                expected[handle] = value;
+            } else {
+                uint64_t removed;
+                cr_assert(u64iheap_remove(&heap, handle, &removed));
+                cr_assert_eq(removed, expected[handle]);
+                alive[handle] = false;
+                size--;
+            }
+        }
+        cr_assert_eq(heap.size, size);
+    }
+
+    uint64_t previous = 0;
+    uint64_t value;
+    while (u64iheap_pop(&heap, &value, NULL)) {
+        cr_assert_geq(value, previous);
+        previous = value;
+    }
+    u64iheap_deinit(&heap);
+}
+
+Test(heap, indexed_push_batch) {
+    enum { COUNT = 5000 };
+    static uint64_t values[COUNT];
+    static uint32_t handles[COUNT];
+    for (size_t i = 0; i < COUNT; i++)
+        values[i] = (i * 7919) % COUNT;
+
+    struct u64iheap heap;
+    u64iheap_init(&heap, NULL);
+    cr_assert(u64iheap_push_batch(&heap, values, COUNT, handles));
+    cr_assert(u64iheap_push_batch(&heap, values, 10, NULL));
+    for (size_t i = 0; i < COUNT; i++)
+        cr_assert_eq(*u64iheap_get(&heap, handles[i]), values[i]);
+
+    // move the largest value on top
+    cr_assert(u64iheap_decrease_key(&heap, handles[1], 0));
+    uint32_t handle;
+    cr_assert_eq(*u64iheap_top(&heap, &handle), 0);
+    cr_assert(handle == handles[1] || values[handle] == 0);
+
+    size_t popped = 0;
+    uint64_t previous = 0;
+    uint64_t value;
+    while (u64iheap_pop(&heap, &value, NULL)) {
+        cr_assert_geq(value, previous);
+        previous = value;
+        popped++;
+    }
+    cr_assert_eq(popped, COUNT + 10);
+    u64iheap_deinit(&heap);
+}
+
+Test(heap, indexed_struct_with_arena) {
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+
+    struct job_queue queue;
+    job_queue_init(&queue, &allocator);
+    uint32_t handles[100];
+    for (int i = 0; i < 100; i++) {
+        handles[i] = job_queue_push(&queue, (struct job){ 1000 - i, i });
+        cr_assert_neq(handles[i], HEAP_INVALID_HANDLE);
+    }
+    // job 0 has the latest deadline, make it the earliest
+    cr_assert(job_queue_decrease_key(&queue, handles[0],
+                                     (struct job){ 1, 0 }));
+    // job 99 has the earliest deadline, make it the latest
+    cr_assert(job_queue_update(&queue, handles[99],
+                               (struct job){ 5000, 99 }));
+
+    struct job job;
+    cr_assert(job_queue_pop(&queue, &job, NULL));
+    cr_assert_eq(job.id, 0);
+    for (int i = 98; i >= 1; i--) {
+        cr_assert(job_queue_pop(&queue, &job, NULL));
+        cr_assert_eq(job.id, i);
+    }
+    cr_assert(job_queue_pop(&queue, &job, NULL));
+    cr_assert_eq(job.id, 99);
+    cr_assert_not(job_queue_pop(&queue, &job, NULL));
+
+    job_queue_deinit(&queue);
+    arena_destroy(arena);
+}
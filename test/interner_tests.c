@@ -0,0 +1,101 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/interner.h>
+#include <pthread.h>
+#include <stdio.h>
+
+TestSuite(interner, .timeout = 10);
+
+Test(interner, intern_and_lookup) {
+    struct interner *interner = interner_create(0);
+    cr_assert_not_null(interner);
+    cr_assert_eq(interner_count(interner), 0);
+
+    const char *first = NULL;
+    const char *second = NULL;
+    uint32_t id = interner_intern_cstr(interner, "logger.c", &first);
+    cr_assert_eq(id, 0);
+    cr_assert_eq(interner_intern_cstr(interner, "main", NULL), 1);
+    cr_assert_eq(interner_intern_cstr(interner, "logger.c", &second), id);
+    cr_assert_eq(first, second, "Interned strings must be stable pointers.");
+    cr_assert_str_eq(first, "logger.c");
+
+    size_t size = 0;
+    cr_assert_str_eq(interner_str(interner, 1, &size), "main");
+    cr_assert_eq(size, 4);
+    cr_assert_null(interner_str(interner, 2, NULL));
+    cr_assert_eq(interner_find(interner, "main", 4), 1);
+    cr_assert_eq(interner_find(interner, "mai", 3), INTERNER_INVALID_ID);
+    cr_assert_eq(interner_count(interner), 2);
+
+    // embedded null bytes and empty strings are distinct keys
+    cr_assert_eq(interner_intern(interner, "a\0b", 3, NULL), 2);
+    cr_assert_eq(interner_intern(interner, "a", 1, NULL), 3);
+    cr_assert_eq(interner_intern(interner, "", 0, NULL), 4);
+    cr_assert_eq(interner_find(interner, "", 0), 4);
+
+    interner_destroy(interner);
+    interner_destroy(NULL);
+}
+
+Test(interner, growth) {
+    struct interner *interner = interner_create(10);
+    cr_assert_not_null(interner);
+
+    enum { COUNT = 20000 };
+    char name[32];
+    const char *pointers[COUNT];
+    for (uint32_t i = 0; i < COUNT; i++) {
+        snprintf(name, sizeof(name), "metric.%u", i);
+        cr_assert_eq(interner_intern_cstr(interner, name, &pointers[i]), i);
+    }
+    for (uint32_t i = 0; i < COUNT; i++) {
+        snprintf(name, sizeof(name), "metric.%u", i);
+        cr_assert_eq(interner_find(interner, name, strlen(name)), i);
+        cr_assert_eq(interner_str(interner, i, NULL), pointers[i]);
+        cr_assert_str_eq(pointers[i], name);
+    }
+    cr_assert_eq(interner_count(interner), COUNT);
+    interner_destroy(interner);
+}
+
+#define THREADS 4
+#define NAMES 5000
+
+static struct interner *shared;
+static uint32_t ids[THREADS][NAMES];
+
+static void *intern_all(void *arg) {
+    uintptr_t thread = (uintptr_t)arg;
+    char name[32];
+    for (uint32_t i = 0; i < NAMES; i++) {
+        // every thread interns the same names, in a different order
+        uint32_t n = (i * 7 + (uint32_t)thread * 1237) % NAMES;
+        snprintf(name, sizeof(name), "key-%u", n);
+        ids[thread][n] = interner_intern_cstr(shared, name, NULL);
+
+        uint32_t id = ids[thread][n];
+        const char *str = interner_str(shared, id, NULL);
+        if (!str || strcmp(str, name))
+            ids[thread][n] = INTERNER_INVALID_ID;
+    }
+    return NULL;
+}
+
+Test(interner, concurrent) {
+    shared = interner_create(0);
+    cr_assert_not_null(shared);
+
+    pthread_t threads[THREADS];
+    for (uintptr_t i = 0; i < THREADS; i++)
+        cr_assert_eq(pthread_create(&threads[i], NULL, intern_all, (void *)i), 0);
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    cr_assert_eq(interner_count(shared), NAMES);
+    for (uint32_t n = 0; n < NAMES; n++) {
+        cr_assert_neq(ids[0][n], INTERNER_INVALID_ID);
+        for (int t = 1; t < THREADS; t++)
+            cr_assert_eq(ids[t][n], ids[0][n], "Name %u got several IDs.", n);
+    }
+    interner_destroy(shared);
+}
@@ -0,0 +1,198 @@
+#include <criterion/criterion.h>
+#include <ayaztub/core_utils/io.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+TestSuite(io, .timeout = 10);
+
+static uint64_t rng_state = 7;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Random text, with lines of 0 to max_line characters.
+static void random_text(char *text, size_t size, unsigned max_line) {
+    for (size_t i = 0; i < size; i++)
+        text[i] = (char)('a' + next_random() % 26);
+    for (size_t i = 0; i < size; i += next_random() % (max_line + 1) + 1)
+        text[i] = '\n';
+}
+
+static void check_lines(const char *text, size_t size) {
+    struct line_iter iter;
+    struct strview line;
+    line_iter_init(&iter, text, size);
+
+    size_t start = 0;
+    size_t lines = 0;
+    while (start < size) {
+        const char *newline = memchr(text + start, '\n', size - start);
+        size_t end = newline ? (size_t)(newline - text) : size;
+        cr_assert(line_iter_next(&iter, &line), "Missing line %zu.", lines);
+        cr_assert_eq(line.data, text + start, "Line %zu start.", lines);
+        cr_assert_eq(line.size, end - start, "Line %zu size.", lines);
+        start = end + 1;
+        lines++;
+    }
+    cr_assert_not(line_iter_next(&iter, &line), "Extra line.");
+    cr_assert_not(line_iter_next(&iter, &line));
+}
+
+Test(io, line_iter_edge_cases) {
+    check_lines("", 0);
+    check_lines("a", 1);
+    check_lines("\n", 1);
+    check_lines("a\n", 2);
+    check_lines("a\n\nb", 4);
+    check_lines("\n\n\n", 3);
+
+    char text[300];
+    memset(text, 'x', sizeof(text));
+    check_lines(text, 64);
+    check_lines(text, sizeof(text));
+    text[63] = '\n';
+    text[64] = '\n';
+    text[199] = '\n';
+    check_lines(text, 64);
+    check_lines(text, 65);
+    check_lines(text, 200);
+    check_lines(text, sizeof(text));
+}
+
+Test(io, line_iter_random) {
+    static char text[100000];
+    const unsigned max_lines[] = { 0, 3, 50, 200, 5000 };
+    for (size_t m = 0; m < sizeof(max_lines) / sizeof(max_lines[0]); m++) {
+        random_text(text, sizeof(text), max_lines[m]);
+        check_lines(text, sizeof(text));
+        check_lines(text + 3, sizeof(text) - 10); // unaligned
+    }
+}
+
+Test(io, find_and_count_newlines) {
+    static char text[10000];
+    random_text(text, sizeof(text), 100);
+    for (size_t offset = 0; offset < 200; offset += 13) {
+        for (size_t size = 0; size < 1000; size += 37) {
+            const char *data = text + offset;
+            const char *found = memchr(data, '\n', size);
+            size_t expected = found ? (size_t)(found - data) : size;
+            cr_assert_eq(io_find_newline(data, size), expected);
+
+            size_t count = 0;
+            for (size_t i = 0; i < size; i++)
+                count += data[i] == '\n';
+            cr_assert_eq(io_count_newlines(data, size), count);
+        }
+    }
+    char none[200];
+    memset(none, '-', sizeof(none));
+    cr_assert_eq(io_find_newline(none, sizeof(none)), sizeof(none));
+    cr_assert_eq(io_count_newlines(none, sizeof(none)), 0);
+}
+
+Test(io, mapped_file) {
+    char path[] = "/tmp/ayaztub_io_test_XXXXXX";
+    int fd = mkstemp(path);
+    cr_assert_geq(fd, 0);
+
+    struct mapped_file file;
+    cr_assert(mapped_file_open(&file, path, MAPPED_FILE_SEQUENTIAL));
+    cr_assert_eq(file.size, 0, "Empty file.");
+
+    const char first[] = "first line\nsecond line\n";
+    cr_assert_eq(write(fd, first, sizeof(first) - 1),
+                 (ssize_t)sizeof(first) - 1);
+    cr_assert(mapped_file_refresh(&file));
+    cr_assert_eq(file.size, sizeof(first) - 1);
+    cr_assert_eq(memcmp(file.data, first, file.size), 0);
+    cr_assert(mapped_file_advise(&file, 5, 100, MAPPED_FILE_WILLNEED));
+
+    static char more[200000];
+    random_text(more, sizeof(more), 80);
+    cr_assert_eq(write(fd, more, sizeof(more)), (ssize_t)sizeof(more));
+    cr_assert(mapped_file_refresh(&file));
+    cr_assert_eq(file.size, sizeof(first) - 1 + sizeof(more));
+    cr_assert_eq(memcmp(file.data + sizeof(first) - 1, more, sizeof(more)),
+                 0);
+    cr_assert_eq(io_count_newlines(file.data, file.size),
+                 2 + io_count_newlines(more, sizeof(more)));
+    check_lines(file.data, file.size);
+    mapped_file_close(&file);
+
+    cr_assert(mapped_file_open(&file, path,
+                               MAPPED_FILE_RANDOM | MAPPED_FILE_HUGEPAGE));
+    cr_assert_eq(file.size, sizeof(first) - 1 + sizeof(more));
+    mapped_file_close(&file);
+
+    close(fd);
+    unlink(path);
+    errno = 0;
+    cr_assert_not(mapped_file_open(&file, path, MAPPED_FILE_NORMAL));
+    cr_assert_eq(errno, ENOENT);
+}
+
+Test(io, chunk_writer) {
+    char path[] = "/tmp/ayaztub_io_test_XXXXXX";
+    int fd = mkstemp(path);
+    cr_assert_geq(fd, 0);
+    close(fd);
+
+    struct chunk_writer writer;
+    cr_assert(chunk_writer_open(&writer, path, false, 16));
+    static char expected[4096];
+    size_t size = 0;
+
+    // small, exact, larger than the buffer, lines and reserved room
+    const char *parts[] = { "abc", "0123456789abcdef", "x",
+                            "a line longer than the sixteen bytes buffer" };
+    for (unsigned round = 0; round < 20; round++) {
+        for (size_t i = 0; i < 4; i++) {
+            size_t length = strlen(parts[i]);
+            cr_assert(chunk_writer_write(&writer, parts[i], length));
+            memcpy(expected + size, parts[i], length);
+            size += length;
+        }
+        cr_assert(chunk_writer_write_line(&writer, STRVIEW_LIT("line")));
+        memcpy(expected + size, "line\n", 5);
+        size += 5;
+        cr_assert(chunk_writer_write_line(
+            &writer, STRVIEW_LIT("a long line, longer than the buffer")));
+        memcpy(expected + size, "a long line, longer than the buffer\n", 36);
+        size += 36;
+
+        char *room = chunk_writer_reserve(&writer, 10);
+        cr_assert_not_null(room);
+        int n = snprintf(room, 10, "%u;", round);
+        chunk_writer_commit(&writer, (size_t)n);
+        size += (size_t)sprintf(expected + size, "%u;", round);
+    }
+    cr_assert_null(chunk_writer_reserve(&writer, 17));
+    cr_assert(chunk_writer_flush(&writer));
+    cr_assert_eq(writer.written, size);
+    cr_assert(chunk_writer_close(&writer));
+
+    struct mapped_file file;
+    cr_assert(mapped_file_open(&file, path, MAPPED_FILE_NORMAL));
+    cr_assert_eq(file.size, size);
+    cr_assert_eq(memcmp(file.data, expected, size), 0);
+    mapped_file_close(&file);
+
+    // appending keeps the previous content
+    cr_assert(chunk_writer_open(&writer, path, true, 0));
+    cr_assert(chunk_writer_write(&writer, "end", 3));
+    cr_assert(chunk_writer_close(&writer));
+    cr_assert(mapped_file_open(&file, path, MAPPED_FILE_NORMAL));
+    cr_assert_eq(file.size, size + 3);
+    cr_assert_eq(memcmp(file.data + size, "end", 3), 0);
+    mapped_file_close(&file);
+    unlink(path);
+}
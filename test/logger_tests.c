@@ -1,6 +1,7 @@
 #include <criterion/criterion.h>
 #include <criterion/redirect.h>
 #include <ayaztub/core_utils/logger.h>
+#include <ayaztub/core_utils/lz4.h>
 #include <unistd.h>
 #include <signal.h>
 #include <stdio.h>
@@ -8,6 +9,11 @@
 #include <time.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 
 // Mock implementation of exit()
 void exit(int status) {
@@ -350,3 +356,785 @@ Test(logger, format_options) {
     logger_close_file();
     remove(test_file);
 }
+
+// Test thread names in the log prefix
+Test(logger, thread_name) {
+    const char *test_file = "test_thread_name.log";
+    remove(test_file);
+
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    logger_set_format_options(false, true, false);
+
+    logger_set_thread_name("a-very-long-worker-name");
+    LOG(LOG_INFO, "Named thread");
+    logger_set_thread_name(NULL);
+    LOG(LOG_INFO, "Unnamed thread");
+
+    cr_assert(file_contains(test_file, "[a-very-long-wor] "), "Thread name is missing or not truncated.");
+    cr_assert(file_contains(test_file, "] Unnamed thread"));
+    cr_assert_not(file_contains(test_file, "wor] Unnamed thread"), "Thread id must be back after reset.");
+
+    logger_close_file();
+    remove(test_file);
+}
+
+// Reads a whole file (null terminated), NULL on error
+static char *read_file(const char *filename, long *size) {
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = malloc(*size + 1);
+    if (data && fread(data, 1, *size, file) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    if (data)
+        data[*size] = '\0';
+    fclose(file);
+    return data;
+}
+
+// Test the sidecar time index of the log file
+Test(logger, time_index) {
+    const char *test_file = "test_time_index.log";
+    const char *index_file = "test_time_index.log" LOGGER_INDEX_SUFFIX;
+    remove(test_file);
+    remove(index_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_index(10, 0);
+    time_t start = time(NULL);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    for (int i = 0; i < 95; i++)
+        LOG(LOG_INFO, "record %d", i);
+    logger_close_file();
+    time_t stop = time(NULL);
+
+    // a header, then an entry every 10 records, at their line start
+    long log_size;
+    long index_size;
+    char *log = read_file(test_file, &log_size);
+    int64_t *index = (int64_t *)read_file(index_file, &index_size);
+    cr_assert(log && index);
+    cr_assert_eq(index_size, 11 * 2 * sizeof(int64_t));
+    for (int i = 1; i <= 10; i++) {
+        int64_t time = index[2 * i];
+        uint64_t offset = (uint64_t)index[2 * i + 1];
+        cr_assert(time >= start && time <= stop, "Bad time of entry %d.", i);
+        cr_assert(i == 1 || time >= index[2 * i - 2], "Decreasing times.");
+        cr_assert(offset < (uint64_t)log_size);
+        cr_assert(offset == 0 || log[offset - 1] == '\n');
+        char expected[32];
+        snprintf(expected, sizeof(expected), "] record %d\n", (i - 1) * 10);
+        char *line_end = strchr(log + offset, '\n') + 1;
+        cr_assert(!strncmp(line_end - strlen(expected), expected,
+                           strlen(expected)), "Entry %d is not record %d.",
+                  i, (i - 1) * 10);
+    }
+    uint64_t last_offset = (uint64_t)index[21];
+
+    uint64_t begin;
+    uint64_t end;
+    cr_assert(logger_index_lookup(index_file, start, stop, &begin, &end));
+    cr_assert(begin == 0 && end == UINT64_MAX);
+    cr_assert(logger_index_lookup(index_file, stop + 1, stop + 9, &begin, &end));
+    cr_assert(begin == last_offset && end == UINT64_MAX);
+    cr_assert(logger_index_lookup(index_file, 0, start - 1, &begin, &end));
+    cr_assert(begin == 0 && end == 0);
+    cr_assert_not(logger_index_lookup(test_file, 0, stop, &begin, &end), "Not an index.");
+    free(index);
+
+    // reopening continues the index, here every 200 bytes
+    logger_set_index(0, 200);
+    cr_assert(logger_set_log_file(test_file), "Failed to reopen log file.");
+    for (int i = 0; i < 5; i++)
+        LOG(LOG_INFO, "more %d", i);
+    logger_close_file();
+    logger_set_index(0, 0);
+
+    index = (int64_t *)read_file(index_file, &index_size);
+    cr_assert(index);
+    cr_assert_gt(index_size, 11 * 2 * sizeof(int64_t));
+    cr_assert_eq((uint64_t)index[23], (uint64_t)log_size, "First new record must be indexed.");
+
+    free(index);
+    free(log);
+    remove(test_file);
+    remove(index_file);
+}
+
+// Test the asynchronous file sink: everything written, in order
+Test(logger, async_file) {
+    const char *test_file = "test_async_file.log";
+    remove(test_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    cr_assert(logger_start_async(&(struct logger_async_options){ .capacity = 8 }));
+    cr_assert_not(logger_start_async(NULL), "Already started.");
+    for (int i = 0; i < 1000; i++) {
+        if (i % 10 == 0)
+            LOG(LOG_ERROR, "async %d", i);
+        else
+            LOG(LOG_INFO, "async %d", i);
+    }
+    logger_flush();
+    cr_assert_eq(file_count_lines(test_file), 1000, "Flushed records are missing.");
+    logger_stop_async();
+
+    struct logger_async_stats stats = logger_async_stats_read();
+    cr_assert_eq(stats.written, 1000);
+    cr_assert_eq(stats.dropped + stats.spilled, 0);
+
+    long size;
+    char *log = read_file(test_file, &size);
+    cr_assert(log);
+    const char *line = log;
+    for (int i = 0; i < 1000; i++) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "] async %d\n", i);
+        const char *end = strchr(line, '\n') + 1;
+        cr_assert(end - line > (long)strlen(expected)
+                  && !strncmp(end - strlen(expected), expected, strlen(expected)),
+                  "Record %d out of order.", i);
+        line = end;
+    }
+    free(log);
+
+    LOG(LOG_INFO, "synchronous again");
+    cr_assert(file_contains(test_file, "] synchronous again"));
+    logger_close_file();
+
+    // without a log file, the queued records are lost, not written
+    cr_assert(logger_start_async(NULL));
+    for (int i = 0; i < 10; i++)
+        LOG(LOG_INFO, "nowhere %d", i);
+    logger_stop_async();
+    stats = logger_async_stats_read();
+    cr_assert_eq(stats.written, 0);
+    cr_assert_eq(stats.dropped, 10);
+    remove(test_file);
+}
+
+static void *log_without_context(void *arg) {
+    (void)arg;
+    LOG(LOG_INFO, "other thread");
+    return NULL;
+}
+
+// Test the thread context, shown by the records of its thread only
+Test(logger, context) {
+    const char *test_file = "test_context.log";
+    remove(test_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    LOG(LOG_INFO, "no context");
+    cr_assert(logger_context_push("request_id", "42"));
+    LOG(LOG_INFO, "one pair");
+    cr_assert(logger_context_pushf("user", "%s-%d", "bob", 7));
+    LOG(LOG_INFO, "two pairs");
+    pthread_t thread;
+    pthread_create(&thread, NULL, log_without_context, NULL);
+    pthread_join(thread, NULL);
+    logger_context_pop();
+    LOG(LOG_INFO, "popped");
+    logger_context_pop();
+    logger_context_pop(); // empty: nothing to pop
+    LOGGER_CONTEXT("scope", "block") {
+        LOG(LOG_INFO, "scoped");
+    }
+    LOG(LOG_INFO, "after the scope");
+
+    // full: refused pairs are still popped in order
+    char value[LOGGER_CONTEXT_SIZE];
+    memset(value, 'v', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    cr_assert(logger_context_push("a", "1"));
+    cr_assert_not(logger_context_push("big", value));
+    for (int i = 1; i < LOGGER_CONTEXT_DEPTH; i++)
+        cr_assert_eq(logger_context_pushf("k", "%d", i), i < LOGGER_CONTEXT_DEPTH - 1);
+    cr_assert_not(logger_context_push("deep", "1"));
+    for (int i = 0; i < LOGGER_CONTEXT_DEPTH; i++)
+        logger_context_pop();
+    LOG(LOG_INFO, "only a");
+    logger_context_clear();
+    LOG(LOG_INFO, "cleared");
+    logger_close_file();
+
+    cr_assert(file_contains(test_file, "] no context"));
+    cr_assert(file_contains(test_file, "] {request_id=42} one pair"));
+    cr_assert(file_contains(test_file, "] {request_id=42 user=bob-7} two pairs"));
+    cr_assert(file_contains(test_file, "] other thread"));
+    cr_assert(file_contains(test_file, "] {request_id=42} popped"));
+    cr_assert(file_contains(test_file, "] {scope=block} scoped"));
+    cr_assert(file_contains(test_file, "] after the scope"));
+    cr_assert(file_contains(test_file, "] {a=1} only a"));
+    cr_assert(file_contains(test_file, "] cleared"));
+    cr_assert_not(file_contains(test_file, "big="));
+    remove(test_file);
+}
+
+// Decompresses a log file made of frames, checking that records do not span
+// frames.
+static char *read_compressed_file(const char *filename, size_t *size,
+                                  size_t *frames) {
+    long file_size;
+    char *file = read_file(filename, &file_size);
+    cr_assert(file);
+    size_t capacity = 1 << 20;
+    char *text = malloc(capacity);
+    cr_assert(text);
+    *size = 0;
+    *frames = 0;
+    for (long position = 0; position < file_size;) {
+        size_t consumed;
+        size_t produced;
+        cr_assert(lz4_frame_decompress(file + position,
+                                       (size_t)(file_size - position),
+                                       text + *size, capacity - *size,
+                                       &consumed, &produced),
+                  "Bad frame at %ld.", position);
+        cr_assert(produced > 0 && text[*size + produced - 1] == '\n',
+                  "Frame %zu splits a record.", *frames);
+        position += (long)consumed;
+        *size += produced;
+        (*frames)++;
+    }
+    free(file);
+    return text;
+}
+
+// Test the compressed log file: LZ4 frames of whole records
+Test(logger, compressed_file) {
+    const char *test_file = "test_compressed.log";
+    const char *index_file = "test_compressed.log" LOGGER_INDEX_SUFFIX;
+    remove(test_file);
+    remove(index_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    logger_set_index(1, 0);
+    logger_set_compression(1); // at least 4KB
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    for (int i = 0; i < 500; i++)
+        LOG(LOG_INFO, "compressed %d", i);
+    logger_flush(); // writes the last frame
+    cr_assert(logger_start_async(NULL));
+    for (int i = 500; i < 1000; i++)
+        LOG(LOG_INFO, "compressed %d", i);
+    logger_stop_async();
+    logger_close_file();
+    logger_set_compression(0);
+    logger_set_index(0, 0);
+    cr_assert_eq(access(index_file, F_OK), -1, "Compressed files have no index.");
+
+    size_t size;
+    size_t frames;
+    char *text = read_compressed_file(test_file, &size, &frames);
+    long file_size;
+    free(read_file(test_file, &file_size));
+    cr_assert_gt(frames, 2);
+    cr_assert_lt((size_t)file_size, size / 2, "Records should compress.");
+    const char *line = text;
+    for (int i = 0; i < 1000; i++) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "] compressed %d\n", i);
+        const char *end = memchr(line, '\n', size - (size_t)(line - text)) + 1;
+        cr_assert(!strncmp(end - strlen(expected), expected, strlen(expected)),
+                  "Record %d is missing.", i);
+        line = end;
+    }
+    cr_assert_eq(line, text + size);
+    free(text);
+    remove(test_file);
+}
+
+// Test the framed records, their recovery after a torn write
+Test(logger, framed_file) {
+    const char *test_file = "test_framed.log";
+    remove(test_file);
+    cr_assert_eq(logger_crc32c("123456789", 9, 0), 0xE3069283U);
+    cr_assert_eq(logger_crc32c("56789", 5, logger_crc32c("1234", 4, 0)),
+                 0xE3069283U);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    logger_set_framing(true);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    for (int i = 0; i < 100; i++)
+        LOG(LOG_INFO, "framed %d", i);
+    logger_close_file();
+
+    long size;
+    char *log = read_file(test_file, &size);
+    cr_assert(log);
+    struct logger_record record;
+    long position = 0;
+    for (int i = 0; i < 100; i++) {
+        size_t length = logger_record_read(log + position,
+                                           (size_t)(size - position), &record);
+        cr_assert_gt(length, 0, "Record %d is invalid.", i);
+        cr_assert_eq(record.sequence, (uint64_t)i + 1);
+        char expected[32];
+        int expected_size = snprintf(expected, sizeof(expected),
+                                     "] framed %d\n", i);
+        cr_assert(record.size > (size_t)expected_size
+                  && !memcmp(record.text + record.size - expected_size,
+                             expected, (size_t)expected_size),
+                  "Record %d has the wrong text.", i);
+        position += (long)length;
+    }
+    cr_assert_eq(position, size);
+
+    // a stale copy of a record and a torn record at the end, as after a crash
+    size_t first = logger_record_read(log, (size_t)size, &record);
+    size_t stale =
+        logger_record_read(log + first, (size_t)size - first, &record);
+    cr_assert_eq(record.sequence, 2);
+    cr_assert_eq(record.writer, (uint64_t)getpid());
+    FILE *file = fopen(test_file, "ab");
+    cr_assert(file);
+    fwrite(log + first, 1, stale, file);
+    fwrite(log, 1, 20, file);
+    fclose(file);
+    struct logger_recovery recovery;
+    cr_assert(logger_recover(test_file, false, &recovery));
+    cr_assert_eq(recovery.records, 100);
+    cr_assert_eq(recovery.sequence, 100);
+    cr_assert_eq(recovery.skipped, 0);
+    cr_assert_eq(recovery.valid_size, (uint64_t)size);
+    cr_assert_eq(recovery.file_size, (uint64_t)size + stale + 20);
+
+    // reopening leaves them to the readers, the writer numbers from 1 again
+    cr_assert(logger_set_log_file(test_file), "Failed to reopen log file.");
+    LOG(LOG_INFO, "after the crash");
+    logger_close_file();
+    cr_assert(logger_recover(test_file, false, &recovery));
+    cr_assert_eq(recovery.records, 101);
+    cr_assert_eq(recovery.sequence, 1);
+    cr_assert_eq(recovery.skipped, stale + 20);
+    cr_assert_eq(recovery.valid_size, recovery.file_size);
+
+    // a corrupted byte only invalidates its record
+    char *corrupted = read_file(test_file, &size);
+    cr_assert(corrupted);
+    position = 0;
+    for (int i = 0; i < 50; i++)
+        position += (long)logger_record_read(corrupted + position,
+                                             (size_t)(size - position),
+                                             &record);
+    size_t length = logger_record_read(corrupted + position,
+                                       (size_t)(size - position), &record);
+    corrupted[position + 30] ^= 1;
+    file = fopen(test_file, "wb");
+    cr_assert(file);
+    fwrite(corrupted, 1, (size_t)size, file);
+    fwrite(corrupted, 1, 20, file); // torn
+    fclose(file);
+    cr_assert(logger_recover(test_file, true, &recovery));
+    cr_assert_eq(recovery.records, 100);
+    cr_assert_eq(recovery.skipped, length + stale + 20);
+    cr_assert_eq(recovery.valid_size, (uint64_t)size);
+    free(read_file(test_file, &size));
+    cr_assert_eq((uint64_t)size, recovery.valid_size, "The file should be cut.");
+    free(corrupted);
+    free(log);
+
+    // opening does not take a plain file for a framed one
+    file = fopen(test_file, "w");
+    cr_assert(file);
+    fputs("plain line\n", file);
+    fclose(file);
+    cr_assert_not(logger_set_log_file(test_file), "Not a framed file.");
+    cr_assert(file_contains(test_file, "plain line"));
+
+    // not a framed file: left as is
+    logger_set_framing(false);
+    cr_assert(logger_set_log_file(test_file), "Failed to reopen log file.");
+    logger_close_file();
+    file = fopen(test_file, "w");
+    cr_assert(file);
+    fputs("plain line\n", file);
+    fclose(file);
+    cr_assert_not(logger_recover(test_file, true, &recovery));
+    cr_assert(file_contains(test_file, "plain line"));
+    remove(test_file);
+}
+
+// Test a framed file written by a process and its forked child
+Test(logger, framed_file_fork) {
+    const char *test_file = "test_framed_fork.log";
+    remove(test_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    logger_set_framing(true);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    LOG(LOG_INFO, "before the fork");
+    pid_t child = fork();
+    cr_assert_geq(child, 0);
+    for (int i = 0; i < 3; i++)
+        LOG(LOG_INFO, "%s %d", child ? "parent" : "child", i);
+    if (child == 0)
+        _exit(0);
+    waitpid(child, NULL, 0);
+    logger_close_file();
+
+    struct logger_recovery recovery;
+    cr_assert(logger_recover(test_file, false, &recovery));
+    cr_assert_eq(recovery.records, 7);
+    cr_assert_eq(recovery.skipped, 0);
+    cr_assert_eq(recovery.valid_size, recovery.file_size);
+
+    // the child numbers its records from 1, under its pid
+    long size;
+    char *log = read_file(test_file, &size);
+    cr_assert(log);
+    struct logger_record record;
+    unsigned child_records = 0;
+    for (long position = 0; position < size;) {
+        size_t length = logger_record_read(log + position,
+                                           (size_t)(size - position), &record);
+        cr_assert_gt(length, 0);
+        if (record.writer == (uint64_t)child)
+            cr_assert_eq(record.sequence, ++child_records);
+        else
+            cr_assert_eq(record.writer, (uint64_t)getpid());
+        position += (long)length;
+    }
+    cr_assert_eq(child_records, 3);
+
+    // reopening keeps the records of every writer
+    cr_assert(logger_set_log_file(test_file), "Failed to reopen log file.");
+    logger_close_file();
+    free(read_file(test_file, &size));
+    cr_assert_eq((uint64_t)size, recovery.file_size);
+    logger_set_framing(false);
+    free(log);
+    remove(test_file);
+}
+
+struct pipe_reader {
+    int fd;
+    char *data;
+    size_t size;
+};
+
+static void *read_pipe(void *arg) {
+    struct pipe_reader *reader = arg;
+    size_t capacity = 1 << 20;
+    reader->data = malloc(capacity);
+    ssize_t n;
+    while ((n = read(reader->fd, reader->data + reader->size,
+                     capacity - reader->size - 1)) > 0) {
+        reader->size += n;
+        if (capacity - reader->size < 4096)
+            reader->data = realloc(reader->data, capacity *= 2);
+    }
+    reader->data[reader->size] = '\0';
+    return NULL;
+}
+
+static size_t count_in(const char *text, const char *pattern) {
+    size_t count = 0;
+    for (const char *p = text; (p = strstr(p, pattern)); p++)
+        count++;
+    return count;
+}
+
+/*
+ * Logs 3000 records (every 100th is an ERROR) to a full pipe nobody reads yet,
+ * as a stalled disk, and returns what the writer thread wrote once unblocked.
+ */
+static char *log_to_stalled_pipe(const struct logger_async_options *options,
+                                 struct logger_async_stats *stats) {
+    int fds[2];
+    cr_assert_eq(pipe(fds), 0);
+    // fill the pipe: the first write of the writer thread blocks
+    char filler[4096];
+    memset(filler, '-', sizeof(filler));
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    while (write(fds[1], filler, sizeof(filler)) > 0)
+        continue;
+    while (write(fds[1], filler, 1) > 0)
+        continue;
+    fcntl(fds[1], F_SETFL, 0);
+    FILE *file = fdopen(fds[1], "w");
+    cr_assert(file);
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    logger_set_log_fileno(file);
+    cr_assert(logger_start_async(options));
+
+    for (int i = 0; i < 3000; i++) {
+        if (i % 100 == 0)
+            LOG(LOG_ERROR, "error %d %0100d", i, 0);
+        else
+            LOG(LOG_INFO, "info %d %0100d", i, 0);
+    }
+    *stats = logger_async_stats_read();
+    cr_assert_eq(stats->blocked, 0, "Log calls must not wait.");
+
+    struct pipe_reader reader = { fds[0], NULL, 0 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, read_pipe, &reader);
+    logger_stop_async();
+    *stats = logger_async_stats_read();
+    logger_close_file();
+    pthread_join(thread, NULL);
+    close(fds[0]);
+
+    // the priority lane never loses a record
+    cr_assert_eq(count_in(reader.data, "] error "), 30);
+    cr_assert_eq(stats->written, count_in(reader.data, "] error ")
+                                     + count_in(reader.data, "] info "));
+    return reader.data;
+}
+
+Test(logger, async_drop_newest) {
+    struct logger_async_stats stats;
+    char *output = log_to_stalled_pipe(
+        &(struct logger_async_options){ .capacity = 32,
+                                        .overflow = LOGGER_DROP_NEWEST },
+        &stats);
+    cr_assert_gt(stats.dropped, 0);
+    cr_assert_eq(stats.written + stats.dropped, 3000);
+    cr_assert(strstr(output, "] info 1 "), "Oldest records are kept.");
+    cr_assert_null(strstr(output, "] info 2999 "));
+    // the reports add up to the dropped records
+    unsigned long reported = 0;
+    const char *report = output;
+    while ((report = strstr(report, "logger: "))) {
+        report += strlen("logger: ");
+        reported += strtoul(report, NULL, 10);
+    }
+    cr_assert_eq(reported, stats.dropped, "Missing drop report.");
+    free(output);
+}
+
+// Under a flood, the drops are reported once per period, not per batch.
+Test(logger, async_report_rate) {
+    struct logger_async_stats stats;
+    char *output = log_to_stalled_pipe(
+        &(struct logger_async_options){ .capacity = 32,
+                                        .overflow = LOGGER_DROP_NEWEST,
+                                        .report_ms = 60000 },
+        &stats);
+    cr_assert_gt(stats.dropped, 0);
+    cr_assert_eq(count_in(output, "logger: "), 1, "One report when stopped.");
+    char expected[64];
+    snprintf(expected, sizeof(expected), "logger: %" PRIu64 " records dropped",
+             stats.dropped);
+    cr_assert(strstr(output, expected), "Missing drop report.");
+    free(output);
+}
+
+Test(logger, async_drop_oldest) {
+    struct logger_async_stats stats;
+    char *output = log_to_stalled_pipe(
+        &(struct logger_async_options){ .capacity = 32,
+                                        .overflow = LOGGER_DROP_OLDEST },
+        &stats);
+    cr_assert_gt(stats.dropped, 0);
+    cr_assert_eq(stats.written + stats.dropped, 3000);
+    cr_assert(strstr(output, "] info 2999 "), "Newest records are kept.");
+    free(output);
+}
+
+Test(logger, async_spill) {
+    const char *spill_file = "test_async_spill.log";
+    remove(spill_file);
+    struct logger_async_stats stats;
+    char *output = log_to_stalled_pipe(
+        &(struct logger_async_options){ .capacity = 32,
+                                        .overflow = LOGGER_SPILL,
+                                        .spill_file = spill_file },
+        &stats);
+    cr_assert_gt(stats.spilled, 0);
+    cr_assert_eq(stats.dropped, 0);
+    cr_assert_eq(stats.written + stats.spilled, 3000);
+    cr_assert_eq(file_count_lines(spill_file), (int)stats.spilled);
+    cr_assert_not(file_contains(spill_file, "] error "));
+    free(output);
+    remove(spill_file);
+
+    cr_assert_not(logger_start_async(&(struct logger_async_options){
+                      .overflow = LOGGER_SPILL }),
+                  "Spilling needs a file.");
+}
+
+// A crash while the writer thread is stuck on the disk still terminates.
+Test(logger, async_crash_with_stalled_writer, .timeout = 4) {
+    pid_t child = fork();
+    cr_assert_geq(child, 0);
+    if (child == 0) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            _exit(1);
+        char filler[4096];
+        memset(filler, '-', sizeof(filler));
+        fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        while (write(fds[1], filler, sizeof(filler)) > 0)
+            continue;
+        while (write(fds[1], filler, 1) > 0)
+            continue;
+        fcntl(fds[1], F_SETFL, 0);
+        logger_set_log_fileno(fdopen(fds[1], "w"));
+        if (!logger_start_async(NULL))
+            _exit(1);
+        LOG(LOG_INFO, "blocks the writer");
+        usleep(100000);
+        LOG(LOG_INFO, "still queued");
+        abort();
+    }
+
+    int status = 0;
+    for (int i = 0; i < 200 && !waitpid(child, &status, WNOHANG); i++)
+        usleep(10000);
+    if (!WIFSIGNALED(status)) {
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+    }
+    cr_assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT,
+              "The signal handler hangs.");
+}
+
+// Test the shared ring: forked workers logging through the parent collector
+Test(logger, shm_fork) {
+    const char *test_file = "test_shm_fork.log";
+    remove(test_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    cr_assert(logger_shm_create(NULL, 2000));
+    cr_assert_not(logger_shm_create(NULL, 0), "A ring is already used.");
+    cr_assert(logger_shm_start_collector());
+
+    pid_t children[4];
+    for (int c = 0; c < 4; c++) {
+        children[c] = fork();
+        cr_assert_geq(children[c], 0);
+        if (children[c] == 0) {
+            for (int i = 0; i < 300; i++)
+                LOG(LOG_INFO, "child %d record %d", c, i);
+            _exit(0);
+        }
+    }
+    LOG(LOG_INFO, "parent record");
+    for (int c = 0; c < 4; c++)
+        waitpid(children[c], NULL, 0);
+    logger_shm_detach();
+
+    struct logger_shm_stats stats = logger_shm_stats_read();
+    cr_assert_eq(stats.written, 1201);
+    cr_assert_eq(stats.dropped + stats.lost, 0);
+    cr_assert_eq(file_count_lines(test_file), 1201);
+
+    // the records of every process keep their order
+    FILE *file = fopen(test_file, "r");
+    cr_assert(file);
+    int next[4] = { 0 };
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        int c;
+        int i;
+        const char *record = strstr(buffer, "] child ");
+        if (record && sscanf(record, "] child %d record %d", &c, &i) == 2) {
+            cr_assert_eq(i, next[c], "Child %d record %d out of order.", c, i);
+            next[c]++;
+        }
+    }
+    fclose(file);
+    cr_assert(file_contains(test_file, "] parent record"));
+
+    logger_close_file();
+    remove(test_file);
+}
+
+// Writers killed in the middle of their records never stop the collector
+Test(logger, shm_killed_writers) {
+    const char *test_file = "test_shm_killed.log";
+    remove(test_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    cr_assert(logger_shm_create(NULL, 64));
+    cr_assert(logger_shm_start_collector());
+
+    for (int c = 0; c < 10; c++) {
+        pid_t child = fork();
+        cr_assert_geq(child, 0);
+        if (child == 0) {
+            for (int i = 0;; i++)
+                LOG(LOG_INFO, "child %d record %d", c, i);
+        }
+        usleep(2000);
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+    }
+    usleep(100000); // room in the ring
+    LOG(LOG_INFO, "parent record");
+    logger_shm_detach(); // the remaining records, without waiting for the dead
+
+    struct logger_shm_stats stats = logger_shm_stats_read();
+    cr_assert_leq(stats.lost, 10);
+    cr_assert(file_contains(test_file, "] parent record"));
+    logger_close_file();
+    remove(test_file);
+}
+
+// Test a named ring, attached by another process, and its dropped records
+Test(logger, shm_named_drop) {
+    const char *test_file = "test_shm_named.log";
+    char name[64];
+    snprintf(name, sizeof(name), "/ayaztub_logger_test_%d", (int)getpid());
+    remove(test_file);
+
+    logger_set_log_level(LOG_INFO);
+    logger_set_format_options(false, false, false);
+    cr_assert(logger_set_log_file(test_file), "Failed to set log file.");
+    cr_assert(logger_shm_create(name, 8));
+
+    pid_t child = fork();
+    cr_assert_geq(child, 0);
+    if (child == 0) {
+        logger_shm_detach(); // the inherited mapping, without unlinking
+        if (!logger_shm_attach(name))
+            _exit(1);
+        for (int i = 0; i < 20; i++)
+            LOG(LOG_INFO, "drop %d", i);
+        LOG(LOG_ERROR, "never dropped"); // written directly
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    cr_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Attach failed.");
+    cr_assert_eq(logger_shm_stats_read().dropped, 12);
+
+    // nobody collected yet: the oldest records wait in the ring
+    cr_assert(logger_shm_start_collector());
+    logger_shm_detach();
+    struct logger_shm_stats stats = logger_shm_stats_read();
+    cr_assert_eq(stats.written, 8);
+    cr_assert_eq(stats.dropped, 12);
+    cr_assert(file_contains(test_file, "] drop 0"));
+    cr_assert(file_contains(test_file, "] drop 7"));
+    cr_assert_not(file_contains(test_file, "] drop 8"));
+    cr_assert(file_contains(test_file, "] never dropped"));
+    cr_assert(file_contains(test_file, "logger: 12 records dropped"), "Missing drop report.");
+
+    errno = 0;
+    cr_assert_not(logger_shm_attach(name), "The creator removes the name.");
+    cr_assert_eq(errno, ENOENT);
+
+    logger_close_file();
+    remove(test_file);
+}
@@ -0,0 +1,165 @@
+#include <criterion/criterion.h>
+#include <ayaztub/core_utils/logger.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Runs ayaztub-logscan (LOGSCAN_PATH, given by the build) on test logs.
+
+TestSuite(logscan, .timeout = 30);
+
+static const char *const levels[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+
+enum { RECORDS = 60000 };
+
+// Synthetic log: one record per second from 2026-01-01 00:00:00.
+static void write_log(const char *path) {
+    FILE *file = fopen(path, "w");
+    cr_assert_not_null(file);
+    for (unsigned i = 0; i < RECORDS; i++) {
+        fprintf(file, "2026-01-01 %02u:%02u:%02u [%s] [src/%s.c:%u:%s()] ",
+                i / 3600, i / 60 % 60, i % 60,
+                levels[i % 4], i % 3 ? "server" : "client", 10 + i % 5,
+                i % 2 ? "handle" : "send");
+        if (i % 10 == 0)
+            fprintf(file, "[main thread] ");
+        else
+            fprintf(file, "[worker-%u] ", i % 2);
+        fprintf(file, "request %u done\n", i);
+        if (i % 1000 == 0)
+            fprintf(file, "  backtrace frame %u\n", i);
+    }
+    fclose(file);
+}
+
+static long run(const char *args, const char *path) {
+    char command[1024];
+    snprintf(command, sizeof(command), "%s --count %s %s", LOGSCAN_PATH, args,
+             path);
+    FILE *output = popen(command, "r");
+    cr_assert_not_null(output);
+    long count = -1;
+    cr_assert_eq(fscanf(output, "%ld", &count), 1, "No count: %s", command);
+    pclose(output);
+    return count;
+}
+
+static void expect(const char *args, const char *path, long expected) {
+    cr_assert_eq(run(args, path), expected, "%s", args);
+    char parallel[512];
+    snprintf(parallel, sizeof(parallel), "-j 4 %s", args);
+    cr_assert_eq(run(parallel, path), expected, "%s", parallel);
+}
+
+Test(logscan, filters) {
+    char path[] = "/tmp/ayaztub_logscan_XXXXXX";
+    int fd = mkstemp(path);
+    cr_assert_geq(fd, 0);
+    close(fd);
+    write_log(path);
+
+    expect("", path, RECORDS + RECORDS / 1000);
+    expect("--level DEBUG", path, RECORDS);
+    expect("--level error", path, RECORDS / 4);
+    expect("-l WARN", path, RECORDS / 2);
+    expect("--file client.c", path, RECORDS / 3);
+    expect("--file src/client.c:12", path, RECORDS / 15);
+    expect("--file ient.c", path, 0);
+    expect("--func send --level ERROR", path, RECORDS / 4);
+    expect("--thread 'main thread'", path, RECORDS / 10);
+    expect("--thread worker-1", path, RECORDS / 2);
+    expect("--grep 'request 4242 '", path, 1);
+    expect("--grep frame", path, RECORDS / 1000);
+    expect("--grep frame --level INFO", path, 0);
+    expect("--grep 'done' --thread worker-0", path, RECORDS * 4 / 10);
+
+    // one record per second: 00:10:00 to 00:19:59, then the whole hour 01
+    expect("--since '2026-01-01 00:10' --until '2026-01-01 00:19'", path,
+           600);
+    expect("--since '2026-01-01 01' --until '2026-01-01 01'", path, 3600);
+    expect("--since '2026-01-01 16:39:59'", path, 1);
+    expect("--until '2025'", path, 0);
+    expect("--since '2026-01-01 00:00:30' --until '2026-01-01 00:00:59' "
+           "--level ERROR",
+           path, 7);
+    unlink(path);
+}
+
+Test(logscan, logger_output) {
+    char path[] = "/tmp/ayaztub_logscan_XXXXXX";
+    int fd = mkstemp(path);
+    cr_assert_geq(fd, 0);
+    close(fd);
+
+    logger_set_log_level(LOG_FULL);
+    logger_set_format_options(true, true, false);
+    logger_set_index(1, 0);
+    cr_assert(logger_set_log_file(path));
+    LOG(LOG_ERROR, "disk %s is full", "sda");
+    LOG(LOG_INFO, "disk %s is fine", "sdb");
+    logger_set_thread_name("flusher");
+    LOG(LOG_WARN, "flush took %d ms", 1200);
+    LOGGER_CONTEXT("request_id", "42") {
+        logger_context_push("user", "bob");
+        LOG(LOG_INFO, "request [%d] started", 42);
+        logger_context_pop();
+    }
+    logger_close_file();
+
+    expect("--level ERROR --grep disk", path, 1);
+    expect("--level INFO --grep disk", path, 2);
+    expect("--file logscan_tests.c --thread flusher", path, 2);
+    expect("--thread flusher --level ERROR", path, 0);
+    expect("--context request_id=42", path, 1);
+    expect("--context user --thread flusher", path, 1);
+    expect("--context request_id=4", path, 0);
+    expect("--context bob", path, 0);
+    expect("--grep '[42] started' --context user=bob", path, 1);
+    // searched with the time index
+    expect("--since 2000 --until 3000", path, 4);
+    expect("--since 2999", path, 0);
+    expect("--until 2000", path, 0);
+    unlink(path);
+    char index_path[sizeof(path) + sizeof(LOGGER_INDEX_SUFFIX)];
+    snprintf(index_path, sizeof(index_path), "%s" LOGGER_INDEX_SUFFIX, path);
+    unlink(index_path);
+}
+
+Test(logscan, framed_file) {
+    char path[] = "/tmp/ayaztub_logscan_XXXXXX";
+    int fd = mkstemp(path);
+    cr_assert_geq(fd, 0);
+    close(fd);
+
+    logger_set_log_level(LOG_FULL);
+    logger_set_format_options(true, true, false);
+    logger_set_index(0, 0);
+    logger_set_framing(true);
+    cr_assert(logger_set_log_file(path));
+    for (int i = 0; i < 100; ++i)
+        LOG(i % 10 ? LOG_INFO : LOG_ERROR, "request %d done", i);
+    logger_close_file();
+    logger_set_framing(false);
+
+    expect("", path, 100);
+    expect("--level ERROR", path, 10);
+    expect("--grep 'request 42 '", path, 1);
+    expect("--grep 'request 9' --level ERROR", path, 1);
+    expect("--since 2000", path, 100);
+    expect("--until 2000", path, 0);
+
+    // torn bytes between the records are skipped
+    FILE *file = fopen(path, "ab");
+    cr_assert_not_null(file);
+    fputs("torn", file);
+    fclose(file);
+    logger_set_framing(true);
+    cr_assert(logger_set_log_file(path));
+    LOG(LOG_ERROR, "request %d done", 100);
+    logger_close_file();
+    logger_set_framing(false);
+    expect("--level ERROR", path, 11);
+    expect("--grep torn", path, 0);
+    unlink(path);
+}
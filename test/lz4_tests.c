@@ -0,0 +1,221 @@
+#include <criterion/criterion.h>
+#include <ayaztub/core_utils/lz4.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+TestSuite(lz4, .timeout = 10);
+
+static uint64_t rng_state = 11;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Log like text: lines made of a few words, so that matches are frequent.
+static void random_text(char *text, size_t size) {
+    static const char *const words[] = { "request ", "done ", "[INFO] ",
+                                         "worker-1 ", "2026-01-01 ", "disk " };
+    size_t i = 0;
+    while (i < size) {
+        const char *word = words[next_random() % 6];
+        for (; *word && i < size; ++word)
+            text[i++] = next_random() % 16 ? *word : '\n';
+    }
+}
+
+static void check_block(const char *data, size_t size) {
+    size_t capacity = lz4_compress_bound(size);
+    char *block = malloc(capacity);
+    char *copy = malloc(size + 1);
+    cr_assert(block && copy);
+    size_t compressed = lz4_compress_block(data, size, block, capacity);
+    cr_assert_gt(compressed, 0, "Compression of %zu bytes.", size);
+    cr_assert_leq(compressed, capacity);
+
+    size_t produced;
+    cr_assert(lz4_decompress_block(block, compressed, copy, size + 1,
+                                   &produced));
+    cr_assert_eq(produced, size);
+    cr_assert(size == 0 || memcmp(copy, data, size) == 0);
+    if (size) // no room for the last byte
+        cr_assert_not(lz4_decompress_block(block, compressed, copy, size - 1,
+                                           &produced));
+    free(block);
+    free(copy);
+}
+
+static size_t check_frame(const char *data, size_t size) {
+    size_t capacity = lz4_frame_bound(size);
+    char *frame = malloc(capacity);
+    char *copy = malloc(size + 1);
+    cr_assert(frame && copy);
+    size_t frame_size = lz4_frame_compress(data, size, frame, capacity);
+    cr_assert_gt(frame_size, 0);
+    cr_assert_leq(frame_size, capacity);
+
+    uint64_t content_size;
+    cr_assert(lz4_frame_content_size(frame, frame_size, &content_size));
+    cr_assert_eq(content_size, size);
+    size_t consumed;
+    size_t produced;
+    cr_assert(lz4_frame_decompress(frame, frame_size, copy, size + 1,
+                                   &consumed, &produced));
+    cr_assert_eq(consumed, frame_size);
+    cr_assert_eq(produced, size);
+    cr_assert(size == 0 || memcmp(copy, data, size) == 0);
+    free(frame);
+    free(copy);
+    return frame_size;
+}
+
+Test(lz4, xxh32) {
+    cr_assert_eq(lz4_xxh32("", 0, 0), 0x02CC5D05U);
+    cr_assert_eq(lz4_xxh32("abc", 3, 0), 0x32D153FFU);
+    cr_assert_eq(lz4_xxh32("Nobody inspects the spammish repetition", 39, 0),
+                 0xE2293B2FU);
+}
+
+Test(lz4, blocks) {
+    enum { SIZE = 300000 };
+    char *data = malloc(SIZE);
+    cr_assert_not_null(data);
+
+    check_block("", 0);
+    check_block("a", 1);
+    check_block("abcabcabcabcab", 14);
+    memset(data, 'x', SIZE); // long matches and overlapping copies
+    check_block(data, SIZE);
+    random_text(data, SIZE);
+    for (size_t size = 1; size < 200; ++size)
+        check_block(data, size);
+    check_block(data, SIZE);
+    for (size_t i = 0; i < SIZE; ++i) // incompressible
+        data[i] = (char)next_random();
+    check_block(data, SIZE);
+    free(data);
+
+    char block[64];
+    cr_assert_eq(lz4_compress_block("abc", 3, block, 4), 0); // too small
+}
+
+Test(lz4, frames) {
+    enum { SIZE = 1 << 20 };
+    char *data = malloc(SIZE);
+    cr_assert_not_null(data);
+
+    check_frame("", 0);
+    random_text(data, SIZE);
+    size_t size = check_frame(data, SIZE);
+    cr_assert_lt(size, SIZE / 2, "Log text should compress: %zu.", size);
+    for (size_t i = 0; i < SIZE; ++i)
+        data[i] = (char)next_random();
+    size = check_frame(data, SIZE);
+    cr_assert_leq(size, SIZE + 23, "Stored frame: %zu.", size);
+    free(data);
+
+    char frame[64];
+    cr_assert_eq(lz4_frame_compress("abc", 3, frame, 8), 0);
+}
+
+// Frames written by the lz4 tool: checksums, content size, skippable frames.
+Test(lz4, reference_frames) {
+    static const unsigned char reference[] = {
+        0x50, 0x2a, 0x4d, 0x18, 0x03, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03,
+        0x04, 0x22, 0x4d, 0x18, 0x74, 0x40, 0xbd, 0x10, 0x00, 0x00, 0x00,
+        0x6f, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x06, 0x00, 0x06, 0x50,
+        0x65, 0x6c, 0x6c, 0x6f, 0x0a, 0x1f, 0x7a, 0xf8, 0x92, 0x00, 0x00,
+        0x00, 0x00, 0x53, 0xce, 0x99, 0x36
+    };
+    const char text[] = "hello hello hello hello hello hello\n";
+    char copy[64];
+    size_t consumed;
+    size_t produced;
+    cr_assert(lz4_frame_decompress(reference, sizeof(reference), copy,
+                                   sizeof(copy), &consumed, &produced));
+    cr_assert_eq(consumed, 11);
+    cr_assert_eq(produced, 0);
+    cr_assert(lz4_frame_decompress(reference + consumed,
+                                   sizeof(reference) - consumed, copy,
+                                   sizeof(copy), &consumed, &produced));
+    cr_assert_eq(consumed, sizeof(reference) - 11);
+    cr_assert_eq(produced, sizeof(text) - 1);
+    cr_assert_arr_eq(copy, text, produced);
+
+    uint64_t content_size;
+    cr_assert_not(lz4_frame_content_size(reference + 11, consumed,
+                                         &content_size));
+
+    unsigned char corrupted[sizeof(reference) - 11];
+    for (size_t i = 0; i < sizeof(corrupted); ++i) {
+        memcpy(corrupted, reference + 11, sizeof(corrupted));
+        corrupted[i] ^= 0x10;
+        cr_assert_not(lz4_frame_decompress(corrupted, sizeof(corrupted), copy,
+                                           sizeof(copy), &consumed,
+                                           &produced),
+                      "Corrupted byte %zu.", i);
+    }
+}
+
+Test(lz4, concatenated_frames) {
+    enum { SIZE = 50000, FRAMES = 5 };
+    char *data = malloc(SIZE * FRAMES);
+    char *frames = malloc(lz4_frame_bound(SIZE) * FRAMES);
+    char *copy = malloc(SIZE * FRAMES);
+    cr_assert(data && frames && copy);
+    random_text(data, SIZE * FRAMES);
+
+    size_t size = 0;
+    for (size_t i = 0; i < FRAMES; ++i)
+        size += lz4_frame_compress(data + i * SIZE, SIZE, frames + size,
+                                   lz4_frame_bound(SIZE));
+    size_t position = 0;
+    size_t output = 0;
+    while (position < size) {
+        size_t consumed;
+        size_t produced;
+        cr_assert(lz4_frame_decompress(frames + position, size - position,
+                                       copy + output, SIZE * FRAMES - output,
+                                       &consumed, &produced));
+        position += consumed;
+        output += produced;
+    }
+    cr_assert_eq(output, SIZE * FRAMES);
+    cr_assert_arr_eq(copy, data, output);
+
+    // a truncated file only loses its last frame
+    size_t consumed;
+    size_t produced;
+    cr_assert_not(lz4_frame_decompress(frames, size / FRAMES / 2, copy, SIZE,
+                                       &consumed, &produced));
+    free(data);
+    free(frames);
+    free(copy);
+}
+
+// Corrupted blocks are rejected or decoded within bounds, never overflow.
+Test(lz4, corrupted_blocks) {
+    enum { SIZE = 4096 };
+    char data[SIZE];
+    char block[SIZE * 2];
+    char copy[SIZE];
+    random_text(data, SIZE);
+    size_t size = lz4_compress_block(data, SIZE, block, sizeof(block));
+    cr_assert_gt(size, 0);
+    for (unsigned i = 0; i < 2000; ++i) {
+        char corrupted[SIZE * 2];
+        memcpy(corrupted, block, size);
+        corrupted[next_random() % size] ^= (char)(1 + next_random() % 255);
+        size_t produced = 0;
+        if (lz4_decompress_block(corrupted, size, copy, sizeof(copy),
+                                 &produced))
+            cr_assert_leq(produced, sizeof(copy));
+        cr_assert_not(lz4_decompress_block(corrupted, next_random() % size,
+                                           copy, sizeof(copy), &produced)
+                          && produced == SIZE
+                          && memcmp(copy, data, SIZE) == 0);
+    }
+}
@@ -0,0 +1,163 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/pool.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+struct object {
+    int id;
+    char payload[60];
+};
+
+POOL_DECL(struct object, object)
+
+TestSuite(pool, .timeout = 5);
+
+Test(pool, create_invalid_sizes) {
+    cr_assert_null(pool_create(0), "Zero sized objects must be rejected.");
+    cr_assert_null(pool_create(POOL_SLAB_SIZE), "Objects bigger than a slab must be rejected.");
+}
+
+Test(pool, alloc_free_alignment) {
+    struct pool *pool = pool_create(3);
+    cr_assert_not_null(pool);
+
+    for (int i = 0; i < 100; i++) {
+        void *ptr = pool_alloc(pool);
+        cr_assert_not_null(ptr);
+        cr_assert_eq((uintptr_t)ptr % sizeof(void *), 0, "Object is not aligned.");
+        pool_free(pool, ptr);
+    }
+
+    struct pool_stats stats;
+    pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.object_size, sizeof(void *), "Small objects must be rounded to a pointer size.");
+
+    pool_destroy(pool);
+}
+
+Test(pool, distinct_objects) {
+    struct pool *pool = object_pool_create();
+    cr_assert_not_null(pool);
+
+    enum { COUNT = 5000 };
+    static struct object *objects[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        objects[i] = object_pool_alloc(pool);
+        cr_assert_not_null(objects[i]);
+        objects[i]->id = i;
+        memset(objects[i]->payload, i & 0xff, sizeof(objects[i]->payload));
+    }
+
+    for (int i = 0; i < COUNT; i++) {
+        cr_assert_eq(objects[i]->id, i, "Object %d was overwritten.", i);
+        cr_assert_eq((unsigned char)objects[i]->payload[59], (unsigned char)(i & 0xff));
+    }
+
+    struct pool_stats stats;
+    pool_get_stats(pool, &stats);
+    cr_assert_geq(stats.slabs * stats.objects_per_slab, COUNT);
+
+    for (int i = 0; i < COUNT; i++)
+        object_pool_free(pool, objects[i]);
+
+    pool_destroy(pool);
+}
+
+Test(pool, trim_releases_empty_slabs) {
+    struct pool *pool = pool_create(128);
+    cr_assert_not_null(pool);
+
+    enum { COUNT = 2000 };
+    static void *objects[COUNT];
+    for (int i = 0; i < COUNT; i++)
+        objects[i] = pool_alloc(pool);
+    for (int i = 0; i < COUNT; i++)
+        pool_free(pool, objects[i]);
+
+    struct pool_stats stats;
+    pool_get_stats(pool, &stats);
+    cr_assert_gt(stats.slabs, 1, "Test needs several slabs.");
+
+    pool_flush(pool);
+    cr_assert_eq(pool_trim(pool), stats.slabs, "All slabs should be empty.");
+
+    pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.slabs, 0);
+    cr_assert_eq(stats.empty_slabs, 0);
+    cr_assert_eq(stats.slab_objects, 0);
+
+    // the pool must still be usable after a trim
+    void *ptr = pool_alloc(pool);
+    cr_assert_not_null(ptr);
+    pool_free(pool, ptr);
+
+    pool_destroy(pool);
+}
+
+Test(pool, free_null) {
+    struct pool *pool = pool_create(16);
+    cr_assert_not_null(pool);
+    pool_free(pool, NULL);
+    pool_destroy(pool);
+    pool_destroy(NULL);
+}
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+struct exchange {
+    struct pool *pool;
+    void *objects[PER_THREAD];
+};
+
+static void *producer(void *arg) {
+    struct exchange *ex = arg;
+    for (int i = 0; i < PER_THREAD; i++) {
+        ex->objects[i] = pool_alloc(ex->pool);
+        if (!ex->objects[i])
+            return NULL;
+        memset(ex->objects[i], 0xab, 32);
+    }
+    return ex;
+}
+
+static void *consumer(void *arg) {
+    struct exchange *ex = arg;
+    for (int i = 0; i < PER_THREAD; i++)
+        pool_free(ex->pool, ex->objects[i]);
+    return ex;
+}
+
+Test(pool, cross_thread_frees) {
+    struct pool *pool = pool_create(32);
+    cr_assert_not_null(pool);
+
+    static struct exchange exchanges[THREADS];
+    pthread_t threads[THREADS];
+
+    for (int i = 0; i < THREADS; i++) {
+        exchanges[i].pool = pool;
+        pthread_create(&threads[i], NULL, producer, &exchanges[i]);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        void *ret;
+        pthread_join(threads[i], &ret);
+        cr_assert_not_null(ret, "Allocation failed in thread %d.", i);
+    }
+
+    // free every object on another thread than the allocating one
+    for (int i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, consumer, &exchanges[(i + 1) % THREADS]);
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    // thread caches were given back at thread exit
+    pool_trim(pool);
+    struct pool_stats stats;
+    pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.slab_objects, 0, "Some objects were lost.");
+    cr_assert_eq(stats.slabs, 0, "Some slabs were not reclaimed.");
+
+    pool_destroy(pool);
+}
@@ -0,0 +1,180 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/ring_buffer.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+TestSuite(ring_buffer, .timeout = 10);
+
+Test(ring_buffer, create_invalid) {
+    cr_assert_null(spsc_ring_create(16, 0), "Zero sized elements must be rejected.");
+    cr_assert_null(mpmc_ring_create(SIZE_MAX, 8));
+
+    struct mpsc_ring *ring = mpsc_ring_create(100, 3);
+    cr_assert_not_null(ring);
+    cr_assert_eq(mpsc_ring_capacity(ring), 128, "Capacity must be rounded to a power of two.");
+    mpsc_ring_destroy(ring);
+    mpsc_ring_destroy(NULL);
+}
+
+#define FIFO_TEST(name)                                                       \
+    Test(ring_buffer, name##_fifo) {                                          \
+        struct name *ring = name##_create(8, sizeof(int));                    \
+        cr_assert_not_null(ring);                                             \
+                                                                              \
+        int value = -1;                                                       \
+        cr_assert_not(name##_pop(ring, &value));                              \
+        for (int round = 0; round < 3; round++) {                             \
+            for (int i = 0; i < 8; i++)                                       \
+                cr_assert(name##_push(ring, &i));                             \
+            cr_assert_not(name##_push(ring, &value), "The ring is full.");    \
+            cr_assert_eq(name##_size(ring), 8);                               \
+            for (int i = 0; i < 8; i++) {                                     \
+                cr_assert(name##_pop(ring, &value));                          \
+                cr_assert_eq(value, i);                                       \
+            }                                                                 \
+            cr_assert_eq(name##_size(ring), 0);                               \
+        }                                                                     \
+                                                                              \
+        int values[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };            \
+        int out[12] = { 0 };                                                  \
+        cr_assert_eq(name##_push_n(ring, values, 5), 5);                      \
+        cr_assert_eq(name##_pop_n(ring, out, 3), 3);                          \
+        /* wraps around the end of the slots */                               \
+        cr_assert_eq(name##_push_n(ring, values + 5, 7), 6);                  \
+        cr_assert_eq(name##_pop_n(ring, out + 3, 12), 8);                     \
+        cr_assert_eq(memcmp(out, values, 11 * sizeof(int)), 0);               \
+                                                                              \
+        cr_assert_not(name##_pop_wait(ring, &value, 20), "Must time out.");   \
+        name##_destroy(ring);                                                 \
+    }
+
+FIFO_TEST(spsc_ring)
+FIFO_TEST(mpsc_ring)
+FIFO_TEST(mpmc_ring)
+
+#define ITEMS 200000
+
+static void *spsc_producer(void *arg) {
+    struct spsc_ring *ring = arg;
+    uint64_t batch[16];
+    for (uint64_t i = 0; i < ITEMS;) {
+        size_t count = 0;
+        while (count < 16 && i + count < ITEMS) {
+            batch[count] = i + count;
+            count++;
+        }
+        size_t pushed = spsc_ring_push_n(ring, batch, count);
+        if (pushed == 0)
+            spsc_ring_push_wait(ring, &batch[pushed++], RING_WAIT_FOREVER);
+        i += pushed;
+    }
+    return NULL;
+}
+
+Test(ring_buffer, spsc_threads) {
+    struct spsc_ring *ring = spsc_ring_create(64, sizeof(uint64_t));
+    cr_assert_not_null(ring);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, spsc_producer, ring);
+    for (uint64_t i = 0; i < ITEMS; i++) {
+        uint64_t value;
+        cr_assert(spsc_ring_pop_wait(ring, &value, RING_WAIT_FOREVER));
+        cr_assert_eq(value, i, "Elements must come out in order.");
+    }
+    pthread_join(thread, NULL);
+    spsc_ring_destroy(ring);
+}
+
+#define PRODUCERS 3
+#define CONSUMERS 3
+
+struct shared {
+    struct mpmc_ring *mpmc;
+    struct mpsc_ring *mpsc;
+    uint64_t sum;
+};
+
+static void *mpmc_producer(void *arg) {
+    struct shared *shared = arg;
+    for (uint64_t i = 1; i <= ITEMS / PRODUCERS; i++)
+        mpmc_ring_push_wait(shared->mpmc, &i, RING_WAIT_FOREVER);
+    return NULL;
+}
+
+static void *mpmc_consumer(void *arg) {
+    struct shared *shared = arg;
+    uint64_t values[8];
+    for (;;) {
+        size_t count = mpmc_ring_pop_n(shared->mpmc, values, 8);
+        if (count == 0 && !mpmc_ring_pop_wait(shared->mpmc, values, 200))
+            return NULL;
+        if (count == 0)
+            count = 1;
+        for (size_t i = 0; i < count; i++)
+            __atomic_add_fetch(&shared->sum, values[i], __ATOMIC_RELAXED);
+    }
+}
+
+Test(ring_buffer, mpmc_threads) {
+    struct shared shared = { .mpmc = mpmc_ring_create(32, sizeof(uint64_t)) };
+    cr_assert_not_null(shared.mpmc);
+
+    pthread_t producers[PRODUCERS];
+    pthread_t consumers[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; i++)
+        pthread_create(&consumers[i], NULL, mpmc_consumer, &shared);
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_create(&producers[i], NULL, mpmc_producer, &shared);
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+    for (int i = 0; i < CONSUMERS; i++)
+        pthread_join(consumers[i], NULL);
+
+    uint64_t per_producer = ITEMS / PRODUCERS;
+    cr_assert_eq(shared.sum, PRODUCERS * per_producer * (per_producer + 1) / 2,
+                 "Every element must be consumed exactly once.");
+    mpmc_ring_destroy(shared.mpmc);
+}
+
+static void *mpsc_producer(void *arg) {
+    struct shared *shared = arg;
+    for (uint64_t i = 1; i <= ITEMS / PRODUCERS; i++) {
+        while (!mpsc_ring_push(shared->mpsc, &i))
+            ;
+    }
+    return NULL;
+}
+
+Test(ring_buffer, mpsc_threads) {
+    struct shared shared = { .mpsc = mpsc_ring_create(32, sizeof(uint64_t)) };
+    cr_assert_not_null(shared.mpsc);
+
+    pthread_t producers[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_create(&producers[i], NULL, mpsc_producer, &shared);
+
+    uint64_t per_producer = ITEMS / PRODUCERS;
+    uint64_t last[PRODUCERS] = { 0 };
+    for (uint64_t received = 0; received < PRODUCERS * per_producer;) {
+        uint64_t value;
+        cr_assert(mpsc_ring_pop_wait(shared.mpsc, &value, RING_WAIT_FOREVER));
+        shared.sum += value;
+        received++;
+        // values of one producer are increasing, find a matching stream
+        bool matched = false;
+        for (int i = 0; i < PRODUCERS && !matched; i++) {
+            if (last[i] + 1 == value) {
+                last[i] = value;
+                matched = true;
+            }
+        }
+        cr_assert(matched, "Per-producer order must be kept.");
+    }
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+
+    cr_assert_eq(shared.sum, PRODUCERS * per_producer * (per_producer + 1) / 2);
+    mpsc_ring_destroy(shared.mpsc);
+}
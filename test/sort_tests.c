@@ -0,0 +1,222 @@
+#include <criterion/criterion.h>
+#include <ayaztub/concurrency/thread_pool.h>
+#include <ayaztub/core_utils/sort.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+TestSuite(sort, .timeout = 30);
+
+static uint64_t rng_state = 42;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int compare_int(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_ullong(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+struct record {
+    int key;
+    unsigned id;
+};
+
+#define record_less(a, b) ((a).key < (b).key)
+
+SORT_DECL(struct record, record, record_less)
+SORT_DECL(int, int_asc, sort_default_less)
+
+enum pattern { RANDOM, SORTED, REVERSED, EQUAL, FEW_VALUES, SAWTOOTH, PIPE };
+
+static void fill(int *array, size_t count, enum pattern pattern) {
+    for (size_t i = 0; i < count; i++) {
+        switch (pattern) {
+        case RANDOM: array[i] = (int)next_random(); break;
+        case SORTED: array[i] = (int)i; break;
+        case REVERSED: array[i] = (int)(count - i); break;
+        case EQUAL: array[i] = 7; break;
+        case FEW_VALUES: array[i] = (int)(next_random() % 4) - 2; break;
+        case SAWTOOTH: array[i] = (int)(i % 100); break;
+        case PIPE: array[i] = (int)(i < count / 2 ? i : count - i); break;
+        }
+    }
+}
+
+Test(sort, pdqsort_patterns) {
+    enum { COUNT = 20000 };
+    static int array[COUNT];
+    static int expected[COUNT];
+    const size_t sizes[] = { 0, 1, 2, 23, 25, 129, 1000, COUNT };
+    for (int pattern = RANDOM; pattern <= PIPE; pattern++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            size_t count = sizes[s];
+            fill(array, count, (enum pattern)pattern);
+            memcpy(expected, array, count * sizeof(int));
+            qsort(expected, count, sizeof(int), compare_int);
+            int_asc_sort(array, count);
+            cr_assert_eq(memcmp(array, expected, count * sizeof(int)), 0,
+                         "Pattern %d, %zu elements not sorted.", pattern,
+                         count);
+        }
+    }
+}
+
+Test(sort, pdqsort_records) {
+    enum { COUNT = 5000 };
+    static struct record records[COUNT];
+    for (unsigned i = 0; i < COUNT; i++)
+        records[i] = (struct record){ (int)(next_random() % 500), i };
+    record_sort(records, COUNT);
+
+    static bool seen[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        if (i > 0)
+            cr_assert_leq(records[i - 1].key, records[i].key);
+        cr_assert_not(seen[records[i].id], "Record duplicated.");
+        seen[records[i].id] = true;
+    }
+}
+
+Test(sort, radix_integers) {
+    enum { COUNT = 30000 };
+    static int ints[COUNT];
+    static int expected[COUNT];
+    const size_t sizes[] = { 0, 1, 100, 255, 256, COUNT };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t count = sizes[s];
+        fill(ints, count, RANDOM);
+        for (size_t i = 0; i < count; i += 7)
+            ints[i] = i % 2 ? INT_MIN : INT_MAX;
+        memcpy(expected, ints, count * sizeof(int));
+        qsort(expected, count, sizeof(int), compare_int);
+        radix_sort_int(ints, count);
+        cr_assert_eq(memcmp(ints, expected, count * sizeof(int)), 0,
+                     "%zu ints not sorted.", count);
+    }
+
+    static unsigned long long longs[COUNT];
+    static unsigned long long expected_longs[COUNT];
+    for (size_t i = 0; i < COUNT; i++)
+        longs[i] = i % 3 ? next_random() : next_random() >> 40;
+    memcpy(expected_longs, longs, sizeof(longs));
+    qsort(expected_longs, COUNT, sizeof(longs[0]), compare_ullong);
+    radix_sort_ullong(longs, COUNT);
+    cr_assert_eq(memcmp(longs, expected_longs, sizeof(longs)), 0);
+
+    static signed char bytes[COUNT];
+    for (size_t i = 0; i < COUNT; i++)
+        bytes[i] = (signed char)next_random();
+    radix_sort_schar(bytes, COUNT);
+    for (size_t i = 1; i < COUNT; i++)
+        cr_assert_leq(bytes[i - 1], bytes[i]);
+
+    static short shorts[COUNT];
+    for (size_t i = 0; i < COUNT; i++)
+        shorts[i] = (short)(next_random() % 1000) - 500;
+    radix_sort_short(shorts, COUNT);
+    for (size_t i = 1; i < COUNT; i++)
+        cr_assert_leq(shorts[i - 1], shorts[i]);
+}
+
+Test(sort, radix_floats) {
+    enum { COUNT = 1000 };
+    static double doubles[COUNT];
+    for (size_t i = 0; i < COUNT; i++)
+        doubles[i] = ((double)(next_random() % 2000000) - 1e6) / 7.0;
+    doubles[10] = INFINITY;
+    doubles[20] = -INFINITY;
+    doubles[30] = -0.0;
+    doubles[40] = 0.0;
+    doubles[50] = 1e-310; // subnormal
+    static double expected[COUNT];
+    memcpy(expected, doubles, sizeof(doubles));
+    qsort(expected, COUNT, sizeof(double), compare_double);
+    radix_sort_double(doubles, COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+        cr_assert(doubles[i] == expected[i], "Mismatch at %zu.", i);
+    cr_assert_eq(doubles[0], -INFINITY);
+    cr_assert_eq(doubles[COUNT - 1], INFINITY);
+
+    // total order: -0.0 before +0.0, NaN last
+    float floats[] = { 1.5f, NAN, 0.0f, -0.0f, -2.0f };
+    radix_sort_float(floats, 5);
+    cr_assert_eq(floats[0], -2.0f);
+    cr_assert(floats[1] == 0.0f && signbit(floats[1]));
+    cr_assert(floats[2] == 0.0f && !signbit(floats[2]));
+    cr_assert_eq(floats[3], 1.5f);
+    cr_assert(isnan(floats[4]));
+}
+
+Test(sort, radix_key_values_stable) {
+    const size_t sizes[] = { 10, 5000 };
+    for (size_t s = 0; s < 2; s++) {
+        size_t count = sizes[s];
+        unsigned *keys = malloc(count * sizeof(unsigned));
+        size_t *values = malloc(count * sizeof(size_t));
+        cr_assert(keys && values);
+        for (size_t i = 0; i < count; i++) {
+            keys[i] = (unsigned)(next_random() % 50);
+            values[i] = i;
+        }
+        cr_assert(radix_sort_uint_kv(keys, values, count));
+        for (size_t i = 1; i < count; i++) {
+            cr_assert_leq(keys[i - 1], keys[i]);
+            if (keys[i - 1] == keys[i])
+                cr_assert_lt(values[i - 1], values[i], "Sort not stable.");
+        }
+        free(keys);
+        free(values);
+    }
+}
+
+Test(sort, parallel) {
+    enum { COUNT = 1 << 20 };
+    struct thread_pool_options options = { .threads = 3 };
+    struct thread_pool *pool = thread_pool_create(&options);
+    cr_assert_not_null(pool);
+
+    int *ints = malloc(COUNT * sizeof(int));
+    int *expected = malloc(COUNT * sizeof(int));
+    cr_assert(ints && expected);
+    for (int pattern = RANDOM; pattern <= PIPE; pattern++) {
+        fill(ints, COUNT, (enum pattern)pattern);
+        memcpy(expected, ints, COUNT * sizeof(int));
+        qsort(expected, COUNT, sizeof(int), compare_int);
+        parallel_sort_int(pool, ints, COUNT);
+        cr_assert_eq(memcmp(ints, expected, COUNT * sizeof(int)), 0,
+                     "Pattern %d not sorted.", pattern);
+    }
+    free(ints);
+    free(expected);
+
+    double *doubles = malloc(COUNT * sizeof(double));
+    cr_assert_not_null(doubles);
+    for (size_t i = 0; i < COUNT; i++)
+        doubles[i] = (double)(int64_t)next_random() / 3.0;
+    parallel_sort_double(pool, doubles, COUNT);
+    for (size_t i = 1; i < COUNT; i++)
+        cr_assert_leq(doubles[i - 1], doubles[i]);
+    free(doubles);
+
+    thread_pool_destroy(pool);
+}
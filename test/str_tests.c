@@ -0,0 +1,182 @@
+#include <criterion/criterion.h>
+#include <ayaztub/core_utils/str.h>
+#include <ayaztub/data_structures/arena.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+TestSuite(str, .timeout = 5);
+
+static size_t naive_find(const char *haystack, size_t size, const char *needle,
+                         size_t needle_size) {
+    for (size_t i = 0; i + needle_size <= size; i++) {
+        if (!memcmp(haystack + i, needle, needle_size))
+            return i;
+    }
+    return STRVIEW_NPOS;
+}
+
+Test(str, find) {
+    struct strview text = STRVIEW_LIT("the quick brown fox jumps over the lazy dog, again and again");
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("the")), 0);
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("lazy")), 35);
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("again")), 45);
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("g, a")), 42);
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("x")), 18);
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("")), 0);
+    cr_assert_eq(strview_find(text, STRVIEW_LIT("cat")), STRVIEW_NPOS);
+    cr_assert_eq(strview_find(STRVIEW_LIT("ab"), STRVIEW_LIT("abc")), STRVIEW_NPOS);
+    cr_assert_eq(strview_find_char(text, 'q'), 4);
+    cr_assert_eq(strview_find_char(strview_make(NULL, 0), 'q'), STRVIEW_NPOS);
+
+    // compare with a naive search on random text, crossing every block edge
+    srand(42);
+    char haystack[300];
+    for (size_t i = 0; i < sizeof(haystack); i++)
+        haystack[i] = (char)('a' + rand() % 3);
+    for (size_t size = 2; size < 8; size++) {
+        for (size_t start = 0; start + size <= sizeof(haystack); start += 7) {
+            struct strview needle = strview_make(haystack + start, size);
+            for (size_t length = 0; length < sizeof(haystack); length += 37) {
+                struct strview view = strview_make(haystack, length);
+                cr_assert_eq(strview_find(view, needle),
+                             naive_find(haystack, length, needle.data, size));
+            }
+        }
+    }
+}
+
+Test(str, find_any_of) {
+    struct strview text = STRVIEW_LIT("key_with_a_long_name_and_no_separator = value; other");
+    cr_assert_eq(strview_find_any_of(text, STRVIEW_LIT(" =;")), 37);
+    cr_assert_eq(strview_find_any_of(text, STRVIEW_LIT(";")), 45);
+    cr_assert_eq(strview_find_any_of(text, STRVIEW_LIT("#!")), STRVIEW_NPOS);
+    cr_assert_eq(strview_find_any_of(text, STRVIEW_LIT("")), STRVIEW_NPOS);
+    cr_assert_eq(strview_find_any_of(text, STRVIEW_LIT("0123456789ABCDEFGHIJv")), 40,
+                 "Sets bigger than a SIMD block must work.");
+    cr_assert_eq(strview_find_any_of(STRVIEW_LIT("abc\xff"), STRVIEW_LIT("\xff\x01")), 3);
+}
+
+Test(str, split) {
+    struct strview rest = STRVIEW_LIT("a,,bc,");
+    const char *expected[] = { "a", "", "bc", "" };
+    struct strview token;
+    size_t count = 0;
+    while (strview_split(&rest, ',', &token)) {
+        cr_assert_lt(count, 4);
+        cr_assert(strview_eq(token, strview_from_cstr(expected[count])),
+                  "Token %zu is '" STRVIEW_FMT "'.", count, STRVIEW_ARG(token));
+        count++;
+    }
+    cr_assert_eq(count, 4);
+    cr_assert_null(rest.data);
+
+    rest = STRVIEW_LIT(" key = value;x");
+    cr_assert(strview_split_any(&rest, STRVIEW_LIT("=;"), &token));
+    cr_assert(strview_eq(strview_trim(token), STRVIEW_LIT("key")));
+    cr_assert(strview_split_any(&rest, STRVIEW_LIT("=;"), &token));
+    cr_assert(strview_eq(strview_trim(token), STRVIEW_LIT("value")));
+    cr_assert(strview_split_any(&rest, STRVIEW_LIT("=;"), &token));
+    cr_assert(strview_eq(token, STRVIEW_LIT("x")));
+    cr_assert_not(strview_split_any(&rest, STRVIEW_LIT("=;"), &token));
+}
+
+Test(str, compare) {
+    struct strview a = STRVIEW_LIT("Content-Type: Application/JSON; charset=UTF-8");
+    struct strview b = STRVIEW_LIT("content-type: application/json; CHARSET=utf-8");
+    cr_assert(strview_eq_nocase(a, b));
+    cr_assert_not(strview_eq(a, b));
+    cr_assert_eq(strview_cmp_nocase(a, b), 0);
+    cr_assert_lt(strview_cmp_nocase(STRVIEW_LIT("content-type: application/jsoN; charset=utf-7"), b), 0);
+    cr_assert_gt(strview_cmp_nocase(b, STRVIEW_LIT("CONTENT")), 0);
+    cr_assert_not(strview_eq_nocase(STRVIEW_LIT("@[`{"), STRVIEW_LIT("`{@[")));
+    cr_assert(strview_eq_nocase(STRVIEW_LIT("\xc9T\xc9"), STRVIEW_LIT("\xc9t\xc9")));
+
+    cr_assert(strview_starts_with(a, STRVIEW_LIT("Content")));
+    cr_assert(strview_ends_with(a, STRVIEW_LIT("UTF-8")));
+    cr_assert_not(strview_ends_with(STRVIEW_LIT("8"), STRVIEW_LIT("UTF-8")));
+    cr_assert(strview_eq(strview_substr(a, 14, 11), STRVIEW_LIT("Application")));
+    cr_assert_eq(strview_substr(a, 100, 5).size, 0);
+    cr_assert(strview_eq(strview_trim(STRVIEW_LIT(" \t\n ")), STRVIEW_LIT("")));
+}
+
+Test(str, builder) {
+    struct strbuf buf;
+    strbuf_init(&buf, NULL);
+    cr_assert_str_eq(strbuf_cstr(&buf), "");
+
+    for (int i = 0; i < 1000; i++)
+        cr_assert(strbuf_append_char(&buf, (char)('a' + i % 26)));
+    cr_assert_eq(buf.size, 1000);
+    cr_assert_eq(strlen(strbuf_cstr(&buf)), 1000);
+    cr_assert_geq(buf.capacity, 1001);
+
+    strbuf_clear(&buf);
+    cr_assert(strbuf_append_cstr(&buf, "n="));
+    cr_assert(strbuf_append_int(&buf, -1234567));
+    cr_assert(strbuf_append(&buf, STRVIEW_LIT(" ")));
+    cr_assert(strbuf_appendf(&buf, "%s-%03d", "fmt", 7));
+    cr_assert_str_eq(strbuf_cstr(&buf), "n=-1234567 fmt-007");
+    cr_assert(strview_eq(strbuf_view(&buf), STRVIEW_LIT("n=-1234567 fmt-007")));
+
+    char long_text[500];
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    cr_assert(strbuf_appendf(&buf, "%s", long_text));
+    cr_assert_eq(buf.size, 18 + 499);
+    strbuf_deinit(&buf);
+    cr_assert_null(buf.data);
+}
+
+Test(str, numbers) {
+    static const long long ints[] = { 0, 7, -7, 10, 99, 100, 12345, -100000, LLONG_MAX, LLONG_MIN };
+    static const double doubles[] = { 0.0, 1.5, -2.25, 3.14159, 0.001, 999.9996, 123456789.125, -0.75 };
+    struct strbuf buf;
+    strbuf_init(&buf, NULL);
+    char expected[64];
+
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        strbuf_clear(&buf);
+        cr_assert(strbuf_append_int(&buf, ints[i]));
+        snprintf(expected, sizeof(expected), "%lld", ints[i]);
+        cr_assert_str_eq(strbuf_cstr(&buf), expected);
+    }
+    strbuf_clear(&buf);
+    cr_assert(strbuf_append_uint(&buf, ULLONG_MAX));
+    snprintf(expected, sizeof(expected), "%llu", ULLONG_MAX);
+    cr_assert_str_eq(strbuf_cstr(&buf), expected);
+
+    for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++) {
+        for (unsigned precision = 0; precision < 12; precision += 3) {
+            strbuf_clear(&buf);
+            cr_assert(strbuf_append_double(&buf, doubles[i], precision));
+            snprintf(expected, sizeof(expected), "%.*f", (int)precision, doubles[i]);
+            cr_assert_str_eq(strbuf_cstr(&buf), expected);
+        }
+    }
+    strbuf_clear(&buf);
+    cr_assert(strbuf_append_double(&buf, 0.0 / 0.0, 2));
+    cr_assert(strbuf_append_double(&buf, 1e300 * 1e300, 2));
+    cr_assert(strbuf_append_double(&buf, 1e20, 1));
+    cr_assert_str_eq(strbuf_cstr(&buf), "naninf100000000000000000000.0");
+    strbuf_deinit(&buf);
+}
+
+Test(str, arena_builder) {
+    struct arena *arena = arena_create(4096);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+
+    struct strbuf buf;
+    strbuf_init(&buf, &allocator);
+    for (int i = 0; i < 500; i++) {
+        cr_assert(strbuf_append_uint(&buf, (unsigned)i));
+        cr_assert(strbuf_append_char(&buf, ','));
+    }
+    cr_assert(strview_starts_with(strbuf_view(&buf), STRVIEW_LIT("0,1,2,3,")));
+    cr_assert(strview_ends_with(strbuf_view(&buf), STRVIEW_LIT("498,499,")));
+    cr_assert_lt(arena_reserved(arena), 3 * 4096, "The last allocation must grow in place.");
+
+    strbuf_deinit(&buf);
+    arena_destroy(arena);
+}
@@ -0,0 +1,171 @@
+#include <criterion/criterion.h>
+#include <ayaztub/concurrency/sync.h>
+#include <pthread.h>
+#include <stdint.h>
+
+TestSuite(sync, .timeout = 10);
+
+#define THREADS 4
+#define ITERATIONS 20000
+
+static void run_threads(void *(*func)(void *), void *arg) {
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++)
+        cr_assert_eq(pthread_create(&threads[i], NULL, func, arg), 0);
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+}
+
+static struct sync_mutex mutex = SYNC_MUTEX_INITIALIZER;
+static struct ticket_lock ticket = TICKET_LOCK_INITIALIZER;
+static struct mcs_lock mcs = MCS_LOCK_INITIALIZER;
+static unsigned long counter;
+
+static void *mutex_increment(UNUSED void *arg) {
+    for (int i = 0; i < ITERATIONS; i++) {
+        sync_mutex_lock(&mutex);
+        counter++;
+        sync_mutex_unlock(&mutex);
+    }
+    return NULL;
+}
+
+static void *ticket_increment(UNUSED void *arg) {
+    for (int i = 0; i < ITERATIONS; i++) {
+        ticket_lock_acquire(&ticket);
+        counter++;
+        ticket_lock_release(&ticket);
+    }
+    return NULL;
+}
+
+static void *mcs_increment(UNUSED void *arg) {
+    for (int i = 0; i < ITERATIONS; i++) {
+        struct mcs_node node;
+        mcs_lock_acquire(&mcs, &node);
+        counter++;
+        mcs_lock_release(&mcs, &node);
+    }
+    return NULL;
+}
+
+Test(sync, mutual_exclusion) {
+    counter = 0;
+    run_threads(mutex_increment, NULL);
+    cr_assert_eq(counter, THREADS * ITERATIONS);
+    cr_assert_geq(sync_stats_read(&mutex.stats).acquisitions,
+                  THREADS * ITERATIONS);
+
+    counter = 0;
+    run_threads(ticket_increment, NULL);
+    cr_assert_eq(counter, THREADS * ITERATIONS);
+
+    counter = 0;
+    run_threads(mcs_increment, NULL);
+    cr_assert_eq(counter, THREADS * ITERATIONS);
+}
+
+Test(sync, stats) {
+    struct sync_mutex lock = SYNC_MUTEX_INITIALIZER;
+    for (int i = 0; i < 10; i++) {
+        sync_mutex_lock(&lock);
+        sync_mutex_unlock(&lock);
+    }
+    struct sync_stats stats = sync_stats_read(&lock.stats);
+    cr_assert_eq(stats.acquisitions, 10);
+    cr_assert_eq(stats.contentions, 0);
+    cr_assert_eq(stats.sleeps, 0);
+
+    cr_assert(sync_mutex_trylock(&lock));
+    cr_assert_not(sync_mutex_trylock(&lock));
+    sync_mutex_unlock(&lock);
+    cr_assert_eq(sync_stats_read(&lock.stats).acquisitions, 11);
+
+    struct sync_stats before = sync_stats_read(&ticket.stats);
+    run_threads(ticket_increment, NULL);
+    struct sync_stats after = sync_stats_read(&ticket.stats);
+    cr_assert_eq(after.acquisitions - before.acquisitions,
+                 THREADS * ITERATIONS);
+    cr_assert_leq(after.contentions, after.acquisitions);
+}
+
+struct pair {
+    struct sync_rwlock lock;
+    unsigned long a;
+    unsigned long b;
+    bool torn;
+};
+
+static void *rwlock_worker(void *arg) {
+    struct pair *pair = arg;
+    for (int i = 0; i < ITERATIONS; i++) {
+        if (i % 100 == 0) {
+            sync_rwlock_write_lock(&pair->lock);
+            pair->a++;
+            pair->b = pair->a * 2;
+            sync_rwlock_write_unlock(&pair->lock);
+        } else {
+            sync_rwlock_read_lock(&pair->lock);
+            if (pair->b != pair->a * 2)
+                pair->torn = true;
+            sync_rwlock_read_unlock(&pair->lock);
+        }
+    }
+    return NULL;
+}
+
+Test(sync, rwlock) {
+    static struct pair pair = { SYNC_RWLOCK_INITIALIZER, 0, 0, false };
+    run_threads(rwlock_worker, &pair);
+    cr_assert_not(pair.torn, "Readers must not see a write in progress.");
+    cr_assert_eq(pair.a, THREADS * ITERATIONS / 100);
+
+    struct sync_stats stats = sync_rwlock_stats(&pair.lock);
+    cr_assert_eq(stats.acquisitions, THREADS * ITERATIONS);
+}
+
+static struct seqlock seqlock = SEQLOCK_INITIALIZER;
+static unsigned long first, second;
+static bool stop;
+
+static void *seqlock_writer(UNUSED void *arg) {
+    for (unsigned long i = 1; i <= ITERATIONS; i++) {
+        seqlock_write_lock(&seqlock);
+        __atomic_store_n(&first, i, __ATOMIC_RELAXED);
+        __atomic_store_n(&second, ~i, __ATOMIC_RELAXED);
+        seqlock_write_unlock(&seqlock);
+    }
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *seqlock_reader(void *arg) {
+    bool *torn = arg;
+    while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+        unsigned sequence;
+        unsigned long a, b;
+        do {
+            sequence = seqlock_read_begin(&seqlock);
+            a = __atomic_load_n(&first, __ATOMIC_RELAXED);
+            b = __atomic_load_n(&second, __ATOMIC_RELAXED);
+        } while (seqlock_read_retry(&seqlock, sequence));
+        if (a != ~b)
+            *torn = true;
+    }
+    return NULL;
+}
+
+Test(sync, seqlock) {
+    first = 0;
+    second = ~0UL;
+    bool torn = false;
+    pthread_t reader, writer;
+    cr_assert_eq(pthread_create(&reader, NULL, seqlock_reader, &torn), 0);
+    cr_assert_eq(pthread_create(&writer, NULL, seqlock_writer, NULL), 0);
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+
+    cr_assert_not(torn, "Readers must retry on concurrent writes.");
+    cr_assert_eq(first, ITERATIONS);
+    cr_assert_eq(seqlock.sequence, 2 * ITERATIONS);
+}
@@ -0,0 +1,165 @@
+#include <criterion/criterion.h>
+#include <ayaztub/concurrency/thread_pool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+TestSuite(thread_pool, .timeout = 10);
+
+static struct thread_pool *create_pool(size_t threads) {
+    struct thread_pool_options options = { .threads = threads, .name = "test" };
+    struct thread_pool *pool = thread_pool_create(&options);
+    cr_assert_not_null(pool);
+    cr_assert_eq(thread_pool_size(pool), threads);
+    return pool;
+}
+
+static size_t counter;
+
+static void *increment(void *arg) {
+    __atomic_add_fetch(&counter, (uintptr_t)arg, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+Test(thread_pool, submit_and_destroy_waits) {
+    struct thread_pool *pool = create_pool(4);
+    cr_assert_eq(thread_pool_worker_index(pool), -1);
+
+    for (int i = 0; i < 10000; i++)
+        cr_assert(thread_pool_submit(pool, increment, (void *)1));
+    thread_pool_destroy(pool);
+    cr_assert_eq(counter, 10000, "Destroy must wait for every task.");
+
+    thread_pool_destroy(NULL);
+    struct thread_pool *defaults = thread_pool_create(NULL);
+    cr_assert_not_null(defaults);
+    cr_assert_gt(thread_pool_size(defaults), 0);
+    thread_pool_destroy(defaults);
+}
+
+static void *square(void *arg) {
+    uintptr_t value = (uintptr_t)arg;
+    return (void *)(value * value);
+}
+
+static void *add(void *result, void *ctx) {
+    return (void *)((uintptr_t)result + (uintptr_t)ctx);
+}
+
+Test(thread_pool, futures_and_continuations) {
+    struct thread_pool *pool = create_pool(3);
+
+    struct task_future *futures[100];
+    for (uintptr_t i = 0; i < 100; i++) {
+        futures[i] = thread_pool_async(pool, square, (void *)i);
+        cr_assert_not_null(futures[i]);
+    }
+
+    struct task_future *chained = task_future_then(futures[9], add, (void *)19);
+    cr_assert_not_null(chained);
+    struct task_future *twice = task_future_then(chained, add, (void *)1);
+    cr_assert_not_null(twice);
+
+    for (uintptr_t i = 0; i < 100; i++) {
+        cr_assert_eq((uintptr_t)task_future_wait(futures[i]), i * i);
+        void *result = NULL;
+        cr_assert(task_future_ready(futures[i], &result));
+        cr_assert_eq((uintptr_t)result, i * i);
+    }
+    cr_assert_eq((uintptr_t)task_future_wait(twice), 101);
+
+    // continuation of an already completed future
+    struct task_future *late = task_future_then(futures[2], add, (void *)2);
+    cr_assert_not_null(late);
+    cr_assert_eq((uintptr_t)task_future_wait(late), 6);
+
+    for (int i = 0; i < 100; i++)
+        task_future_destroy(futures[i]);
+    task_future_destroy(chained);
+    task_future_destroy(twice);
+    task_future_destroy(late);
+    thread_pool_destroy(pool);
+}
+
+#define VALUES 1000000
+
+struct loop_ctx {
+    uint8_t *hits;
+    size_t calls;
+};
+
+static void mark(size_t begin, size_t end, void *ctx) {
+    struct loop_ctx *loop = ctx;
+    __atomic_add_fetch(&loop->calls, 1, __ATOMIC_RELAXED);
+    for (size_t i = begin; i < end; i++)
+        loop->hits[i]++;
+}
+
+Test(thread_pool, parallel_for) {
+    struct thread_pool *pool = create_pool(4);
+    struct loop_ctx loop = { .hits = calloc(VALUES, 1) };
+    cr_assert_not_null(loop.hits);
+
+    thread_pool_parallel_for(pool, 0, VALUES, 0, mark, &loop);
+    for (size_t i = 0; i < VALUES; i++)
+        cr_assert_eq(loop.hits[i], 1, "Index %zu processed %d times.", i, loop.hits[i]);
+    cr_assert_gt(loop.calls, 1, "The range must be split.");
+
+    loop.calls = 0;
+    thread_pool_parallel_for(pool, 10, 20, 3, mark, &loop);
+    cr_assert_geq(loop.calls, 4, "Sub-ranges must not exceed the grain.");
+    thread_pool_parallel_for(pool, 5, 5, 0, mark, &loop);
+
+    free(loop.hits);
+    thread_pool_destroy(pool);
+}
+
+struct fib_ctx {
+    struct thread_pool *pool;
+    uintptr_t n;
+};
+
+static void *fib(void *arg) {
+    struct fib_ctx *ctx = arg;
+    if (ctx->n < 12) {
+        uintptr_t a = 0, b = 1;
+        for (uintptr_t i = 0; i < ctx->n; i++) {
+            uintptr_t next = a + b;
+            a = b;
+            b = next;
+        }
+        return (void *)a;
+    }
+
+    // nested tasks land in the worker deque and get stolen by the others
+    struct fib_ctx left = { ctx->pool, ctx->n - 1 };
+    struct fib_ctx right = { ctx->pool, ctx->n - 2 };
+    struct task_future *future = thread_pool_async(ctx->pool, fib, &left);
+    if (!future)
+        return NULL;
+    uintptr_t result = (uintptr_t)fib(&right);
+    result += (uintptr_t)task_future_wait(future);
+    task_future_destroy(future);
+    return (void *)result;
+}
+
+static void *worker_index(void *arg) {
+    return (void *)thread_pool_worker_index(arg);
+}
+
+Test(thread_pool, nested_tasks) {
+    struct thread_pool *pool = create_pool(2);
+
+    struct task_future *index = thread_pool_async(pool, worker_index, pool);
+    cr_assert_not_null(index);
+    long worker = (long)task_future_wait(index);
+    cr_assert(worker >= 0 && worker < 2);
+    task_future_destroy(index);
+
+    struct fib_ctx ctx = { pool, 25 };
+    struct task_future *future = thread_pool_async(pool, fib, &ctx);
+    cr_assert_not_null(future);
+    cr_assert_eq((uintptr_t)task_future_wait(future), 75025);
+    task_future_destroy(future);
+
+    thread_pool_destroy(pool);
+}
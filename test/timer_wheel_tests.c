@@ -0,0 +1,229 @@
+#include <criterion/criterion.h>
+#include <ayaztub/concurrency/timer_wheel.h>
+#include <stdlib.h>
+#include <time.h>
+
+TestSuite(timer_wheel, .timeout = 10);
+
+struct probe {
+    struct timer timer;
+    uint64_t expected;
+    uint64_t fired_at;
+    unsigned fired;
+};
+
+static struct timer_wheel *wheel;
+static uint64_t previous_now;
+
+static void record(struct timer *timer, void *ctx) {
+    struct probe *probe = ctx;
+    cr_assert_eq(timer, &probe->timer);
+    probe->fired_at = timer_wheel_now(wheel);
+    probe->fired++;
+}
+
+Test(timer_wheel, exact_expiry) {
+    wheel = timer_wheel_create();
+    cr_assert_not_null(wheel);
+
+    static const uint64_t delays[] = { 1, 2, 63, 64, 65, 4095, 4096, 4097, 300000, 1 << 24, 5000000000ULL };
+    enum { COUNT = sizeof(delays) / sizeof(delays[0]) };
+    struct probe probes[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        timer_init(&probes[i].timer, record, &probes[i]);
+        probes[i].expected = delays[i];
+        probes[i].fired = 0;
+        timer_wheel_add(wheel, &probes[i].timer, delays[i], 0);
+        cr_assert(timer_pending(&probes[i].timer));
+    }
+    cr_assert_eq(timer_wheel_count(wheel), COUNT);
+
+    // jumping by the next expiry bound must never skip past an expiry
+    size_t steps = 0;
+    while (timer_wheel_count(wheel)) {
+        uint64_t delay = timer_wheel_next_expiry(wheel);
+        cr_assert_neq(delay, UINT64_MAX);
+        timer_wheel_advance(wheel, delay);
+        steps++;
+    }
+    cr_assert_lt(steps, 200, "Empty slots must be skipped.");
+    for (size_t i = 0; i < COUNT; i++) {
+        cr_assert_eq(probes[i].fired, 1);
+        cr_assert_eq(probes[i].fired_at, probes[i].expected, "Timer %zu fired at %lu.", i, (unsigned long)probes[i].fired_at);
+        cr_assert_not(timer_pending(&probes[i].timer));
+    }
+    timer_wheel_destroy(wheel);
+}
+
+Test(timer_wheel, cancel_and_rearm) {
+    wheel = timer_wheel_create();
+    cr_assert_not_null(wheel);
+
+    struct probe a = { .fired = 0 }, b = { .fired = 0 };
+    timer_init(&a.timer, record, &a);
+    timer_init(&b.timer, record, &b);
+    timer_wheel_add(wheel, &a.timer, 10, 0);
+    timer_wheel_add(wheel, &b.timer, 10, 0);
+    cr_assert(timer_wheel_cancel(wheel, &a.timer));
+    cr_assert_not(timer_wheel_cancel(wheel, &a.timer));
+    timer_wheel_add(wheel, &b.timer, 100, 0); // re-arm a pending timer
+    cr_assert_eq(timer_wheel_count(wheel), 1);
+
+    cr_assert_eq(timer_wheel_advance(wheel, 99), 0);
+    cr_assert_eq(timer_wheel_advance(wheel, 1), 1);
+    cr_assert_eq(a.fired, 0);
+    cr_assert_eq(b.fired_at, 100);
+
+    // delay 0 expires on the next tick, a big jump expires everything
+    timer_wheel_add(wheel, &a.timer, 0, 0);
+    timer_wheel_add(wheel, &b.timer, 1000000, 0);
+    cr_assert_eq(timer_wheel_advance(wheel, 5000000), 2);
+    cr_assert_eq(a.fired_at, 5000100);
+    cr_assert_eq(timer_wheel_count(wheel), 0);
+    timer_wheel_destroy(wheel);
+}
+
+static struct probe periodic;
+
+static void periodic_tick(struct timer *timer, void *ctx) {
+    record(timer, ctx);
+    cr_assert(timer_pending(timer), "Periodic timers are re-armed before the callback.");
+    if (periodic.fired == 5)
+        timer_wheel_cancel(wheel, timer);
+}
+
+Test(timer_wheel, periodic) {
+    wheel = timer_wheel_create();
+    cr_assert_not_null(wheel);
+
+    periodic.fired = 0;
+    timer_init(&periodic.timer, periodic_tick, &periodic);
+    timer_wheel_add(wheel, &periodic.timer, 7, 10);
+    for (uint64_t tick = 1; tick <= 100; tick++) {
+        timer_wheel_advance(wheel, 1);
+        if (periodic.fired && periodic.fired < 5 && periodic.fired_at == tick)
+            cr_assert_eq(tick, 7 + 10 * (periodic.fired - 1));
+    }
+    cr_assert_eq(periodic.fired, 5);
+    cr_assert_eq(periodic.fired_at, 47);
+    cr_assert_eq(timer_wheel_count(wheel), 0);
+    timer_wheel_destroy(wheel);
+}
+
+// Periods past the last tick saturate instead of wrapping to a past expiry.
+Test(timer_wheel, periodic_overflow) {
+    wheel = timer_wheel_create();
+    cr_assert_not_null(wheel);
+
+    struct probe probe = { 0 };
+    timer_init(&probe.timer, record, &probe);
+    timer_wheel_add(wheel, &probe.timer, 10, UINT64_MAX - 5);
+    cr_assert_eq(timer_wheel_advance(wheel, 10), 1);
+    cr_assert(timer_pending(&probe.timer));
+
+    cr_assert_eq(timer_wheel_advance(wheel, UINT64_MAX), 1);
+    cr_assert_eq(probe.fired_at, UINT64_MAX);
+    cr_assert_not(timer_pending(&probe.timer), "No tick after the last one.");
+    cr_assert_eq(timer_wheel_count(wheel), 0);
+    timer_wheel_destroy(wheel);
+}
+
+// Timers added once the clock saturated never fire, but stay consistent.
+Test(timer_wheel, add_at_last_tick) {
+    wheel = timer_wheel_create();
+    cr_assert_not_null(wheel);
+
+    struct probe probe = { 0 };
+    timer_init(&probe.timer, record, &probe);
+    cr_assert_eq(timer_wheel_advance(wheel, UINT64_MAX), 0);
+    cr_assert_eq(timer_wheel_now(wheel), UINT64_MAX);
+
+    timer_wheel_add(wheel, &probe.timer, 10, 0);
+    cr_assert(timer_pending(&probe.timer));
+    cr_assert_eq(timer_wheel_count(wheel), 1);
+    cr_assert_eq(timer_wheel_next_expiry(wheel), UINT64_MAX);
+    cr_assert_eq(timer_wheel_advance(wheel, 1), 0);
+    cr_assert_eq(probe.fired, 0);
+
+    timer_wheel_add(wheel, &probe.timer, 0, 5); // re-armed in place
+    cr_assert_eq(timer_wheel_count(wheel), 1);
+    cr_assert(timer_wheel_cancel(wheel, &probe.timer));
+    cr_assert_not(timer_pending(&probe.timer));
+    cr_assert_eq(timer_wheel_count(wheel), 0);
+    timer_wheel_destroy(wheel);
+}
+
+static void check_window(struct timer *timer, void *ctx) {
+    struct probe *probe = ctx;
+    (void)timer;
+    probe->fired++;
+    probe->fired_at = timer_wheel_now(wheel);
+    cr_assert(previous_now < probe->expected && probe->expected <= probe->fired_at,
+              "Timer due at %lu fired in (%lu, %lu].", (unsigned long)probe->expected,
+              (unsigned long)previous_now, (unsigned long)probe->fired_at);
+}
+
+Test(timer_wheel, random) {
+    wheel = timer_wheel_create();
+    cr_assert_not_null(wheel);
+    srand(7);
+
+    enum { COUNT = 5000 };
+    static struct probe probes[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        timer_init(&probes[i].timer, check_window, &probes[i]);
+        probes[i].fired = 0;
+        uint64_t delay = 1 + (uint64_t)rand() % (i % 2 ? 1000 : 3000000);
+        probes[i].expected = timer_wheel_now(wheel) + delay;
+        timer_wheel_add(wheel, &probes[i].timer, delay, 0);
+        if (i % 10 == 0) {
+            previous_now = timer_wheel_now(wheel);
+            timer_wheel_advance(wheel, (uint64_t)rand() % 500);
+        }
+    }
+    while (timer_wheel_count(wheel)) {
+        previous_now = timer_wheel_now(wheel);
+        timer_wheel_advance(wheel, 1 + (uint64_t)rand() % 20000);
+    }
+    for (size_t i = 0; i < COUNT; i++)
+        cr_assert_eq(probes[i].fired, 1, "Timer %zu fired %u times.", i, probes[i].fired);
+    timer_wheel_destroy(wheel);
+}
+
+static unsigned thread_fired;
+
+static void thread_tick(struct timer *timer, void *ctx) {
+    (void)timer;
+    (void)ctx;
+    __atomic_add_fetch(&thread_fired, 1, __ATOMIC_RELAXED);
+}
+
+static void sleep_ms(long ms) {
+    struct timespec delay = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+
+Test(timer_wheel, timer_thread) {
+    struct timer_thread *timers = timer_thread_create(0);
+    cr_assert_not_null(timers);
+
+    struct timer once, never, periodic_timer;
+    timer_init(&once, thread_tick, NULL);
+    timer_init(&never, thread_tick, NULL);
+    timer_init(&periodic_timer, thread_tick, NULL);
+    timer_thread_add(timers, &never, 60000, 0);
+    timer_thread_add(timers, &once, 20, 0);
+    timer_thread_add(timers, &periodic_timer, 5, 5);
+
+    sleep_ms(100);
+    cr_assert(timer_thread_cancel(timers, &periodic_timer));
+    unsigned fired = __atomic_load_n(&thread_fired, __ATOMIC_RELAXED);
+    cr_assert_geq(fired, 3, "Only %u expiries after 100ms.", fired);
+    sleep_ms(20);
+    cr_assert_eq(__atomic_load_n(&thread_fired, __ATOMIC_RELAXED), fired, "Cancelled timers must not fire.");
+
+    cr_assert_not(timer_thread_cancel(timers, &once));
+    cr_assert(timer_thread_cancel(timers, &never));
+    timer_thread_destroy(timers);
+    timer_thread_destroy(NULL);
+}
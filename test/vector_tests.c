@@ -0,0 +1,216 @@
+#include <criterion/criterion.h>
+#include <ayaztub/data_structures/arena.h>
+#include <ayaztub/data_structures/vector.h>
+#include <stdint.h>
+#include <string.h>
+
+VEC_DECL(int, ivec)
+VEC_DECL_INLINE(char *, svec, 2)
+
+struct point {
+    double x;
+    double y;
+};
+
+VEC_DECL(struct point, pvec)
+
+TestSuite(vector, .timeout = 1);
+
+Test(vector, inline_storage) {
+    struct ivec vec;
+    ivec_init(&vec, NULL);
+
+    cr_assert_eq(vec.capacity, VEC_INLINE_BYTES / sizeof(int));
+    for (int i = 0; i < (int)VEC_INLINE_CAPACITY(int); i++)
+        cr_assert(ivec_push(&vec, i));
+    cr_assert(ivec_is_inline(&vec), "Vector should not allocate while the inline storage is not full.");
+
+    cr_assert(ivec_push(&vec, 42));
+    cr_assert_not(ivec_is_inline(&vec), "Vector should have moved to the heap.");
+    for (int i = 0; i < (int)VEC_INLINE_CAPACITY(int); i++)
+        cr_assert_eq(*ivec_at(&vec, i), i);
+    cr_assert_eq(*ivec_at(&vec, VEC_INLINE_CAPACITY(int)), 42);
+    cr_assert_null(ivec_at(&vec, vec.length));
+
+    ivec_deinit(&vec);
+    cr_assert(ivec_is_inline(&vec));
+    cr_assert_eq(vec.length, 0);
+}
+
+Test(vector, push_pop_growth) {
+    struct ivec vec;
+    ivec_init(&vec, NULL);
+
+    size_t reallocations = 0;
+    size_t capacity = vec.capacity;
+    for (int i = 0; i < 100000; i++) {
+        cr_assert(ivec_push(&vec, i));
+        if (vec.capacity != capacity) {
+            cr_assert_geq(vec.capacity, capacity + capacity / 2, "Growth must be geometric.");
+            capacity = vec.capacity;
+            reallocations++;
+        }
+    }
+    cr_assert_lt(reallocations, 40, "Too many reallocations: %zu.", reallocations);
+
+    for (int i = 99999; i >= 0; i--)
+        cr_assert_eq(ivec_pop(&vec), i);
+    cr_assert_eq(vec.length, 0);
+
+    ivec_deinit(&vec);
+}
+
+Test(vector, append_insert_erase) {
+    struct ivec vec;
+    ivec_init(&vec, NULL);
+
+    int values[100];
+    for (int i = 0; i < 100; i++)
+        values[i] = i;
+
+    cr_assert(ivec_append(&vec, values, 50));
+    cr_assert(ivec_append(&vec, values + 80, 20));
+    cr_assert(ivec_insert(&vec, 50, values + 50, 30));
+    cr_assert_eq(vec.length, 100);
+    cr_assert_arr_eq(vec.data, values, sizeof(values));
+
+    cr_assert_not(ivec_insert(&vec, 101, values, 1), "Insertion after the end must fail.");
+
+    ivec_erase(&vec, 10, 80);
+    cr_assert_eq(vec.length, 20);
+    cr_assert_arr_eq(vec.data, values, 10 * sizeof(int));
+    cr_assert_arr_eq(vec.data + 10, values + 90, 10 * sizeof(int));
+
+    ivec_erase(&vec, 15, 1000);
+    cr_assert_eq(vec.length, 15);
+    ivec_erase(&vec, 15, 1);
+    cr_assert_eq(vec.length, 15);
+
+    cr_assert(ivec_insert(&vec, 0, values + 99, 1));
+    cr_assert_eq(vec.data[0], 99);
+    cr_assert_eq(vec.data[1], 0);
+
+    ivec_deinit(&vec);
+}
+
+Test(vector, shrink_to_fit) {
+    struct ivec vec;
+    ivec_init(&vec, NULL);
+
+    for (int i = 0; i < 1000; i++)
+        cr_assert(ivec_push(&vec, i));
+    ivec_erase(&vec, 500, 500);
+    cr_assert(ivec_shrink_to_fit(&vec));
+    cr_assert_eq(vec.capacity, 500);
+    cr_assert_eq(vec.data[499], 499);
+
+    ivec_erase(&vec, 2, 500);
+    cr_assert(ivec_shrink_to_fit(&vec));
+    cr_assert(ivec_is_inline(&vec), "Small vectors must go back to the inline storage.");
+    cr_assert_eq(vec.data[0], 0);
+    cr_assert_eq(vec.data[1], 1);
+
+    ivec_deinit(&vec);
+}
+
+Test(vector, pointer_and_struct_elements) {
+    struct svec strings;
+    svec_init(&strings, NULL);
+    char *words[] = { "hello", "small", "vector" };
+    cr_assert(svec_append(&strings, words, 3));
+    cr_assert_str_eq(*svec_at(&strings, 2), "vector");
+    svec_deinit(&strings);
+
+    struct pvec points;
+    pvec_init(&points, NULL);
+    for (int i = 0; i < 10; i++) {
+        struct point p = { i, -i };
+        cr_assert(pvec_push(&points, p));
+    }
+    struct pvec_view view = pvec_view(&points);
+    cr_assert_eq(view.length, 10);
+    cr_assert_float_eq(view.data[9].y, -9.0, 1e-9);
+    pvec_deinit(&points);
+}
+
+Test(vector, arena_allocator) {
+    struct arena *arena = arena_create(4096);
+    cr_assert_not_null(arena);
+    struct allocator allocator = arena_allocator(arena);
+
+    struct ivec vec;
+    ivec_init(&vec, &allocator);
+    for (int i = 0; i < 10000; i++)
+        cr_assert(ivec_push(&vec, i));
+    for (int i = 0; i < 10000; i++)
+        cr_assert_eq(vec.data[i], i);
+
+    // the vector is the only arena user: it must have grown in place
+    cr_assert_lt(arena_reserved(arena), 4 * 10000 * sizeof(int), "Arena wasted too much memory: %zu.", arena_reserved(arena));
+
+    ivec_deinit(&vec);
+    arena_destroy(arena);
+}
+
+Test(vector, overflow) {
+    struct ivec vec;
+    ivec_init(&vec, NULL);
+    cr_assert_not(ivec_reserve(&vec, SIZE_MAX / 2), "Reserve must fail on size overflow.");
+    cr_assert(ivec_is_inline(&vec));
+    ivec_deinit(&vec);
+}
+
+TestSuite(arena, .timeout = 1);
+
+Test(arena, alloc_alignment) {
+    struct arena *arena = arena_create(0);
+    cr_assert_not_null(arena);
+
+    char *previous = NULL;
+    for (size_t i = 1; i < 1000; i++) {
+        char *ptr = arena_alloc(arena, i);
+        cr_assert_not_null(ptr);
+        cr_assert_eq((uintptr_t)ptr % ARENA_ALIGNMENT, 0);
+        memset(ptr, (int)i, i);
+        if (previous)
+            cr_assert_eq((unsigned char)previous[0], (unsigned char)(i - 1), "Allocations overlap.");
+        previous = ptr;
+    }
+
+    arena_destroy(arena);
+}
+
+Test(arena, big_allocations_and_reset) {
+    struct arena *arena = arena_create(1024);
+    cr_assert_not_null(arena);
+
+    void *small = arena_alloc(arena, 16);
+    void *big = arena_alloc(arena, 100000);
+    cr_assert_not_null(small);
+    cr_assert_not_null(big);
+    cr_assert_geq(arena_reserved(arena), 100000 + 1024);
+
+    arena_reset(arena);
+    cr_assert_eq(arena_reserved(arena), 1024, "Reset must keep only the first block.");
+    cr_assert_eq(arena_alloc(arena, 16), small, "Reset arena must reuse its first block.");
+
+    arena_destroy(arena);
+}
+
+Test(arena, realloc_last_in_place) {
+    struct arena *arena = arena_create(1024);
+    cr_assert_not_null(arena);
+
+    char *first = arena_alloc(arena, 10);
+    strcpy(first, "hello");
+    char *grown = arena_realloc(arena, first, 10, 500);
+    cr_assert_eq(grown, first, "The last allocation must grow in place.");
+
+    char *other = arena_alloc(arena, 10);
+    cr_assert_not_null(other);
+    char *moved = arena_realloc(arena, first, 500, 600);
+    cr_assert_neq(moved, first, "Only the last allocation can grow in place.");
+    cr_assert_str_eq(moved, "hello");
+
+    arena_destroy(arena);
+}
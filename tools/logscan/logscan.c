@@ -0,0 +1,678 @@
+#ifdef __linux__
+#    define _GNU_SOURCE
+#endif // __linux__
+
+#include <ayaztub/concurrency/thread_pool.h>
+#include <ayaztub/core_utils/io.h>
+#include <ayaztub/core_utils/logger.h>
+#include <ayaztub/core_utils/str.h>
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * ayaztub-logscan: filters the records of log files written by the logger.
+ *
+ * Design:
+ * - Records are lines in the raw format of the logger:
+ *   `[date ][LEVEL] [file:line:func()] [thread] {context} message`, where
+ *   the date (`YYYY-MM-DD HH:MM:SS`), the thread and the context (`key=value`
+ *   pairs, see logger_context_push()) are optional. Lines that are not
+ *   records (backtraces, foreign lines) only match when the only filter is
+ *   the substring.
+ * - Dates have a fixed width, so time bounds are compared as strings. A bound
+ *   can be a prefix (`2026-10-17 12` is the whole hour). Files are assumed
+ *   chronological: the first and last records in the time range are found
+ *   with a binary search on the file offsets, and only this range is read.
+ * - With a time index next to the file (see logger_set_index()), the binary
+ *   search only covers the offsets between the index entries around the
+ *   bound, so a lookup in a huge cold file reads a few pages.
+ * - The range is cut in chunks at line boundaries, scanned in parallel on a
+ *   thread pool, a wave of chunks at a time. Every chunk collects its matches
+ *   in its own buffer, and the buffers are written in the file order.
+ * - With a substring, the chunk is searched for the substring first (SSE2)
+ *   and only the lines holding it are parsed. Otherwise, lines are split with
+ *   the SIMD line iterator.
+ * - Framed files (see logger_set_framing()) are recognized by the record at
+ *   their start. Their records are decoded in order with logger_record_read()
+ *   on the calling thread, without the binary search (the dates are filtered
+ *   record by record); torn bytes between records are skipped.
+ */
+
+#define CHUNK_SIZE (4 << 20)
+#define DATE_SIZE 19 // YYYY-MM-DD HH:MM:SS
+
+enum exit_status { MATCHED = 0, NO_MATCH = 1, FAILURE = 2 };
+
+struct filter {
+    enum log_level level; /**< most verbose level shown */
+    struct strview since; /**< date prefix, empty for no bound */
+    struct strview until; /**< date prefix, empty for no bound */
+    struct strview file;
+    size_t line; /**< 0 for any line */
+    struct strview func;
+    struct strview thread;
+    struct strview context; /**< `key=value` pair, or key */
+    struct strview text; /**< substring of the message */
+    bool structural; /**< filters needing a parsed record */
+    bool count_only;
+};
+
+struct record {
+    struct strview date; /**< empty if the logger did not show it */
+    enum log_level level;
+    struct strview file;
+    size_t line;
+    struct strview func;
+    struct strview thread; /**< empty if the logger did not show it */
+    struct strview context; /**< empty without context */
+    struct strview message;
+};
+
+// ---------- Parsing ---------- //
+static const char *const level_names[] = {
+    [LOG_FATAL] = "FATAL", [LOG_ERROR] = "ERROR", [LOG_TIMEOUT] = "TIMEOUT",
+    [LOG_WARN] = "WARN",   [LOG_INFO] = "INFO",   [LOG_TRACE] = "TRACE",
+    [LOG_DEBUG] = "DEBUG",
+};
+
+static bool parse_level(struct strview name, enum log_level *level) {
+    for (int i = LOG_FATAL; i <= LOG_DEBUG; ++i) {
+        if (strview_eq_nocase(name, strview_from_cstr(level_names[i]))) {
+            *level = (enum log_level)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_date(struct strview line) {
+    if (line.size < DATE_SIZE + 1)
+        return false;
+    const char *d = line.data;
+    return d[4] == '-' && d[7] == '-' && d[10] == ' ' && d[13] == ':'
+           && d[16] == ':' && d[19] == ' ' && d[0] >= '0' && d[0] <= '9';
+}
+
+static bool parse_size(struct strview digits, size_t *value) {
+    if (!digits.size)
+        return false;
+    *value = 0;
+    for (size_t i = 0; i < digits.size; ++i) {
+        if (digits.data[i] < '0' || digits.data[i] > '9')
+            return false;
+        *value = *value * 10 + (size_t)(digits.data[i] - '0');
+    }
+    return true;
+}
+
+// Splits a view at the last occurrence of c (false if absent).
+static bool split_last(struct strview view, char c, struct strview *before,
+                       struct strview *after) {
+    for (size_t i = view.size; i-- > 0;) {
+        if (view.data[i] == c) {
+            *before = strview_prefix(view, i);
+            *after = strview_substr(view, i + 1, SIZE_MAX);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_record(struct strview line, struct record *record) {
+    struct strview rest = line;
+    record->date = strview_make(NULL, 0);
+    if (is_date(rest)) {
+        record->date = strview_prefix(rest, DATE_SIZE);
+        rest = strview_substr(rest, DATE_SIZE + 1, SIZE_MAX);
+    }
+
+    // [LEVEL]
+    if (!rest.size || rest.data[0] != '[')
+        return false;
+    size_t close = strview_find_char(rest, ']');
+    if (close == STRVIEW_NPOS
+        || !parse_level(strview_substr(rest, 1, close - 1), &record->level))
+        return false;
+    rest = strview_substr(rest, close + 1, SIZE_MAX);
+
+    // [file:line:func()]
+    if (!strview_starts_with(rest, STRVIEW_LIT(" [")))
+        return false;
+    size_t end = strview_find(rest, STRVIEW_LIT("()]"));
+    if (end == STRVIEW_NPOS)
+        return false;
+    struct strview location = strview_substr(rest, 2, end - 2);
+    struct strview number;
+    if (!split_last(location, ':', &location, &record->func)
+        || !split_last(location, ':', &record->file, &number)
+        || !parse_size(number, &record->line))
+        return false;
+    rest = strview_substr(rest, end + 3, SIZE_MAX);
+    if (rest.size && rest.data[0] == ' ')
+        rest = strview_substr(rest, 1, SIZE_MAX);
+
+    // [thread]
+    record->thread = strview_make(NULL, 0);
+    if (rest.size && rest.data[0] == '[') {
+        size_t thread_end = strview_find(rest, STRVIEW_LIT("] "));
+        if (thread_end != STRVIEW_NPOS) {
+            record->thread = strview_substr(rest, 1, thread_end - 1);
+            rest = strview_substr(rest, thread_end + 2, SIZE_MAX);
+        }
+    }
+
+    // {context}
+    record->context = strview_make(NULL, 0);
+    if (rest.size && rest.data[0] == '{') {
+        size_t context_end = strview_find(rest, STRVIEW_LIT("} "));
+        if (context_end != STRVIEW_NPOS) {
+            record->context = strview_substr(rest, 1, context_end - 1);
+            rest = strview_substr(rest, context_end + 2, SIZE_MAX);
+        }
+    }
+    record->message = rest;
+    return true;
+}
+
+// ---------- Matching ---------- //
+static int compare_date(struct strview date, struct strview bound) {
+    size_t size = bound.size < DATE_SIZE ? bound.size : DATE_SIZE;
+    return memcmp(date.data, bound.data, size);
+}
+
+static bool file_matches(struct strview file, struct strview pattern) {
+    if (strview_eq(file, pattern))
+        return true;
+    return file.size > pattern.size && strview_ends_with(file, pattern)
+           && file.data[file.size - pattern.size - 1] == '/';
+}
+
+// Whether the context holds the pair `key=value` (or the key, without '=').
+static bool context_matches(struct strview context, struct strview pattern) {
+    bool key_only = strview_find_char(pattern, '=') == STRVIEW_NPOS;
+    struct strview pair;
+    while (strview_split(&context, ' ', &pair)) {
+        if (key_only ? pair.size > pattern.size
+                           && strview_starts_with(pair, pattern)
+                           && pair.data[pattern.size] == '='
+                     : strview_eq(pair, pattern))
+            return true;
+    }
+    return false;
+}
+
+static bool matches(const struct filter *filter, struct strview line) {
+    struct record record;
+    if (!parse_record(line, &record)) {
+        return !filter->structural
+               && strview_find(line, filter->text) != STRVIEW_NPOS;
+    }
+
+    if (record.level > filter->level)
+        return false;
+    if (filter->since.size || filter->until.size) {
+        if (!record.date.size)
+            return false;
+        if (filter->since.size && compare_date(record.date, filter->since) < 0)
+            return false;
+        if (filter->until.size && compare_date(record.date, filter->until) > 0)
+            return false;
+    }
+    if (filter->file.size && !file_matches(record.file, filter->file))
+        return false;
+    if (filter->line && record.line != filter->line)
+        return false;
+    if (filter->func.size && !strview_eq(record.func, filter->func))
+        return false;
+    if (filter->thread.size && !strview_eq(record.thread, filter->thread))
+        return false;
+    if (filter->context.size
+        && !context_matches(record.context, filter->context))
+        return false;
+    return !filter->text.size
+           || strview_find(record.message, filter->text) != STRVIEW_NPOS;
+}
+
+// ---------- Time Range Seeking ---------- //
+
+// Start of the first line at or after offset.
+static size_t line_start(const char *data, size_t size, size_t offset) {
+    if (offset == 0 || data[offset - 1] == '\n')
+        return offset;
+    size_t newline = io_find_newline(data + offset, size - offset);
+    return newline == size - offset ? size : offset + newline + 1;
+}
+
+// Date of the first dated record at or after offset (false if none).
+static bool date_after(const char *data, size_t size, size_t offset,
+                       struct strview *date) {
+    struct line_iter iter;
+    struct strview line;
+    line_iter_init(&iter, data + offset, size - offset);
+    for (unsigned tries = 0; tries < 64 && line_iter_next(&iter, &line);
+         ++tries) {
+        if (is_date(line)) {
+            *date = strview_prefix(line, DATE_SIZE);
+            return true;
+        }
+    }
+    return false;
+}
+
+// First and last second of a date prefix, in local time like the logger.
+static bool date_times(struct strview bound, time_t *first, time_t *last) {
+    static const char *const templates[] = { "0000-01-01 00:00:00",
+                                             "9999-12-31 23:59:59" };
+    time_t *times[] = { first, last };
+    size_t size = bound.size < DATE_SIZE ? bound.size : DATE_SIZE;
+    for (unsigned i = 0; i < 2; ++i) {
+        char date[DATE_SIZE + 1];
+        memcpy(date, templates[i], sizeof(date));
+        memcpy(date, bound.data, size);
+        struct tm tm = { 0 };
+        if (sscanf(date, "%4d-%2d-%2d %2d:%2d:%2d", &tm.tm_year, &tm.tm_mon,
+                   &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec)
+            != 6)
+            return false;
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_isdst = -1;
+        *times[i] = mktime(&tm);
+        if (*times[i] == (time_t)-1)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Offsets around the records of a bound, from the time index of the logger
+ * (LOGGER_INDEX_SUFFIX), or the whole file without index.
+ */
+static void index_window(const char *path, struct strview bound, size_t size,
+                         size_t *low, size_t *high) {
+    *low = 0;
+    *high = size;
+    time_t first;
+    time_t last;
+    size_t length = strlen(path);
+    char *index_path = malloc(length + sizeof(LOGGER_INDEX_SUFFIX));
+    if (!index_path || !date_times(bound, &first, &last)) {
+        free(index_path);
+        return;
+    }
+    memcpy(index_path, path, length);
+    memcpy(index_path + length, LOGGER_INDEX_SUFFIX,
+           sizeof(LOGGER_INDEX_SUFFIX));
+
+    uint64_t begin;
+    uint64_t end;
+    if (logger_index_lookup(index_path, first, last, &begin, &end)
+        && begin <= size) { // else the index is not the file's one
+        *low = (size_t)begin;
+        *high = end < size ? (size_t)end : size;
+    }
+    free(index_path);
+}
+
+/*
+ * First line start whose next dated record is after the bound: dates >= bound
+ * (strict = false) or dates > bound (strict = true), searched in [low, high].
+ */
+static size_t seek_date(const char *data, size_t size, struct strview bound,
+                        bool strict, size_t low, size_t high) {
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        size_t start = line_start(data, size, mid);
+        struct strview date;
+        bool after = !date_after(data, size, start, &date);
+        if (!after) {
+            int cmp = compare_date(date, bound);
+            after = strict ? cmp > 0 : cmp >= 0;
+        }
+        if (after)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return line_start(data, size, low);
+}
+
+// ---------- Scanning ---------- //
+struct chunk {
+    size_t begin;
+    size_t end;
+    struct strbuf output;
+    size_t matches;
+    bool failed;
+};
+
+struct scan {
+    const struct filter *filter;
+    const char *data;
+    struct chunk *chunks;
+};
+
+static void emit(const struct filter *filter, struct chunk *chunk,
+                 struct strview line) {
+    chunk->matches++;
+    if (!filter->count_only
+        && !(strbuf_append(&chunk->output, line)
+             && strbuf_append_char(&chunk->output, '\n')))
+        chunk->failed = true;
+}
+
+static void scan_chunk(const struct filter *filter, const char *data,
+                       struct chunk *chunk) {
+    struct strview view =
+        strview_make(data + chunk->begin, chunk->end - chunk->begin);
+
+    if (!filter->text.size) {
+        struct line_iter iter;
+        struct strview line;
+        line_iter_init(&iter, view.data, view.size);
+        while (line_iter_next(&iter, &line))
+            if (matches(filter, line))
+                emit(filter, chunk, line);
+        return;
+    }
+
+    // only parse the lines holding the substring
+    size_t pos = 0;
+    while (pos < view.size) {
+        size_t hit = strview_find(strview_substr(view, pos, SIZE_MAX),
+                                  filter->text);
+        if (hit == STRVIEW_NPOS)
+            break;
+        hit += pos;
+        size_t start = hit;
+        while (start > pos && view.data[start - 1] != '\n')
+            start--;
+        size_t end = hit + io_find_newline(view.data + hit, view.size - hit);
+        struct strview line = strview_make(view.data + start, end - start);
+        if (matches(filter, line))
+            emit(filter, chunk, line);
+        pos = end + 1;
+    }
+}
+
+static void scan_chunks(size_t begin, size_t end, void *ctx) {
+    struct scan *scan = ctx;
+    for (size_t i = begin; i < end; ++i)
+        scan_chunk(scan->filter, scan->data, &scan->chunks[i]);
+}
+
+static bool scan_framed(const struct filter *filter, const char *data,
+                        size_t size, struct chunk_writer *out,
+                        size_t *total) {
+    struct chunk chunk = { 0 };
+    strbuf_init(&chunk.output, NULL);
+    bool ok = true;
+    size_t position = 0;
+    while (ok && !chunk.failed && position < size) {
+        struct logger_record record;
+        size_t length =
+            logger_record_read(data + position, size - position, &record);
+        if (!length) {
+            position++; // torn bytes, look for the next record
+            continue;
+        }
+        position += length;
+        struct strview line = strview_make(record.text, record.size);
+        if (line.size && line.data[line.size - 1] == '\n')
+            line.size--;
+        if (matches(filter, line))
+            emit(filter, &chunk, line);
+        if (chunk.output.size >= CHUNK_SIZE) {
+            ok = chunk_writer_write(out, chunk.output.data, chunk.output.size);
+            strbuf_clear(&chunk.output);
+        }
+    }
+    ok = ok && !chunk.failed
+         && (!chunk.output.size
+             || chunk_writer_write(out, chunk.output.data,
+                                   chunk.output.size));
+    *total += chunk.matches;
+    strbuf_deinit(&chunk.output);
+    return ok;
+}
+
+static bool scan_file(const struct filter *filter, const char *path,
+                      struct thread_pool *pool, struct chunk_writer *out,
+                      size_t *matches) {
+    struct mapped_file file;
+    if (!mapped_file_open(&file, path, MAPPED_FILE_SEQUENTIAL)) {
+        fprintf(stderr, "ayaztub-logscan: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct logger_record first;
+    if (file.size && logger_record_read(file.data, file.size, &first)) {
+        bool ok = scan_framed(filter, file.data, file.size, out, matches);
+        if (!ok)
+            fprintf(stderr, "ayaztub-logscan: %s: write failed\n", path);
+        mapped_file_close(&file);
+        return ok;
+    }
+
+    size_t begin = 0;
+    size_t end = file.size;
+    size_t low;
+    size_t high;
+    if (filter->since.size) {
+        index_window(path, filter->since, file.size, &low, &high);
+        begin = seek_date(file.data, file.size, filter->since, false, low,
+                          high);
+    }
+    if (filter->until.size) {
+        index_window(path, filter->until, file.size, &low, &high);
+        end = seek_date(file.data, file.size, filter->until, true, low, high);
+    }
+    if (end < begin)
+        end = begin;
+
+    size_t wave = pool ? 4 * (thread_pool_size(pool) + 1) : 1;
+    struct chunk *chunks = calloc(wave, sizeof(struct chunk));
+    bool ok = chunks != NULL;
+    for (size_t i = 0; ok && i < wave; ++i)
+        strbuf_init(&chunks[i].output, NULL);
+
+    while (ok && begin < end) {
+        size_t count = 0;
+        for (; count < wave && begin < end; ++count) {
+            size_t chunk_end =
+                end - begin > CHUNK_SIZE
+                    ? line_start(file.data, end, begin + CHUNK_SIZE)
+                    : end;
+            struct chunk *chunk = &chunks[count];
+            chunk->begin = begin;
+            chunk->end = chunk_end;
+            chunk->matches = 0;
+            strbuf_clear(&chunk->output);
+            begin = chunk_end;
+        }
+        mapped_file_advise(&file, begin, wave * CHUNK_SIZE,
+                           MAPPED_FILE_WILLNEED); // next wave
+
+        struct scan scan = { filter, file.data, chunks };
+        if (pool)
+            thread_pool_parallel_for(pool, 0, count, 1, scan_chunks, &scan);
+        else
+            scan_chunks(0, count, &scan);
+
+        for (size_t i = 0; ok && i < count; ++i) {
+            *matches += chunks[i].matches;
+            struct strbuf *output = &chunks[i].output;
+            ok = !chunks[i].failed
+                 && (!output->size
+                     || chunk_writer_write(out, output->data, output->size));
+        }
+    }
+    if (!ok)
+        fprintf(stderr, "ayaztub-logscan: %s: %s\n", path,
+                chunks ? "write failed" : "out of memory");
+
+    for (size_t i = 0; chunks && i < wave; ++i)
+        strbuf_deinit(&chunks[i].output);
+    free(chunks);
+    mapped_file_close(&file);
+    return ok;
+}
+
+// ---------- Command Line ---------- //
+static void usage(FILE *stream) {
+    fprintf(stream,
+            "Usage: ayaztub-logscan [OPTION]... FILE...\n"
+            "Print the records of logger files matching all the filters.\n"
+            "\n"
+            "  -l, --level LEVEL    records at least as severe as LEVEL\n"
+            "                       (FATAL, ERROR, TIMEOUT, WARN, INFO, "
+            "TRACE, DEBUG)\n"
+            "  -s, --since DATE     records at or after DATE (prefix of\n"
+            "                       YYYY-MM-DD HH:MM:SS)\n"
+            "  -u, --until DATE     records at or before DATE (prefix)\n"
+            "  -f, --file FILE[:N]  records logged from FILE (at line N)\n"
+            "  -F, --func NAME      records logged from function NAME\n"
+            "  -t, --thread NAME    records logged by thread NAME\n"
+            "  -C, --context K[=V]  records whose context holds K=V (or K)\n"
+            "  -g, --grep TEXT      records whose message contains TEXT\n"
+            "  -c, --count          only print the number of records\n"
+            "  -j, --jobs N         scan with N threads (default: CPUs)\n"
+            "  -h, --help           print this help\n"
+            "\n"
+            "Exit status is 0 if a record matched, 1 if none, 2 on error.\n");
+}
+
+static bool parse_file_filter(char *arg, struct filter *filter) {
+    struct strview view = strview_from_cstr(arg);
+    struct strview file;
+    struct strview number;
+    if (split_last(view, ':', &file, &number)
+        && parse_size(number, &filter->line)) {
+        view = file;
+    }
+    filter->file = view;
+    return view.size > 0;
+}
+
+int main(int argc, char **argv) {
+    static const struct option options[] = {
+        { "level", required_argument, NULL, 'l' },
+        { "since", required_argument, NULL, 's' },
+        { "until", required_argument, NULL, 'u' },
+        { "file", required_argument, NULL, 'f' },
+        { "func", required_argument, NULL, 'F' },
+        { "thread", required_argument, NULL, 't' },
+        { "context", required_argument, NULL, 'C' },
+        { "grep", required_argument, NULL, 'g' },
+        { "count", no_argument, NULL, 'c' },
+        { "jobs", required_argument, NULL, 'j' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    struct filter filter = { .level = LOG_DEBUG };
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt_long(argc, argv, "l:s:u:f:F:t:C:g:cj:h", options,
+                              NULL))
+           != -1) {
+        switch (opt) {
+        case 'l':
+            if (!parse_level(strview_from_cstr(optarg), &filter.level)) {
+                fprintf(stderr, "ayaztub-logscan: invalid level '%s'\n",
+                        optarg);
+                return FAILURE;
+            }
+            filter.structural = true;
+            break;
+        case 's':
+            filter.since = strview_from_cstr(optarg);
+            filter.structural = true;
+            break;
+        case 'u':
+            filter.until = strview_from_cstr(optarg);
+            filter.structural = true;
+            break;
+        case 'f':
+            if (!parse_file_filter(optarg, &filter)) {
+                fprintf(stderr, "ayaztub-logscan: invalid file '%s'\n",
+                        optarg);
+                return FAILURE;
+            }
+            filter.structural = true;
+            break;
+        case 'F':
+            filter.func = strview_from_cstr(optarg);
+            filter.structural = true;
+            break;
+        case 't':
+            filter.thread = strview_from_cstr(optarg);
+            filter.structural = true;
+            break;
+        case 'C':
+            filter.context = strview_from_cstr(optarg);
+            filter.structural = true;
+            break;
+        case 'g':
+            filter.text = strview_from_cstr(optarg);
+            break;
+        case 'c':
+            filter.count_only = true;
+            break;
+        case 'j':
+            jobs = strtol(optarg, NULL, 10);
+            if (jobs < 1) {
+                fprintf(stderr, "ayaztub-logscan: invalid jobs '%s'\n",
+                        optarg);
+                return FAILURE;
+            }
+            break;
+        case 'h':
+            usage(stdout);
+            return MATCHED;
+        default:
+            usage(stderr);
+            return FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        usage(stderr);
+        return FAILURE;
+    }
+
+    // the calling thread scans too
+    struct thread_pool *pool = NULL;
+    if (jobs > 1) {
+        struct thread_pool_options pool_options = {
+            .threads = (size_t)jobs - 1,
+            .name = "logscan",
+        };
+        pool = thread_pool_create(&pool_options);
+    }
+
+    struct chunk_writer out;
+    if (!chunk_writer_init_fd(&out, STDOUT_FILENO, 0)) {
+        fprintf(stderr, "ayaztub-logscan: out of memory\n");
+        thread_pool_destroy(pool);
+        return FAILURE;
+    }
+
+    bool ok = true;
+    size_t matches = 0;
+    for (int i = optind; i < argc; ++i)
+        ok &= scan_file(&filter, argv[i], pool, &out, &matches);
+    if (filter.count_only)
+        fprintf(stdout, "%zu\n", matches); // nothing buffered in out
+    ok &= chunk_writer_close(&out);
+    thread_pool_destroy(pool);
+
+    if (!ok)
+        return FAILURE;
+    return matches ? MATCHED : NO_MATCH;
+}